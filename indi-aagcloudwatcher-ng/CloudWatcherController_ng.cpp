@@ -29,12 +29,17 @@ Anemometer code contributed by Joao Bento.
 #include "indiweather.h"
 #include "connectionplugins/connectionserial.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstring>
 #include <iostream>
 
 #define READ_TIMEOUT 5
 
+// ms between two sampling cycles, leaves the port to the commands of the driver
+#define SAMPLING_PAUSE 100
+
 /******************************************************************/
 /* PUBLIC MEMBERS                                                */
 /******************************************************************/
@@ -47,6 +52,11 @@ CloudWatcherController::CloudWatcherController(bool verbose) : verbose(verbose)
 {
 }
 
+CloudWatcherController::~CloudWatcherController()
+{
+    stopSampling();
+}
+
 const char *CloudWatcherController::getDeviceName()
 {
     return "AAG Cloud Watcher NG";
@@ -59,11 +69,14 @@ void CloudWatcherController::setPortFD(int newPortFD)
 
 void CloudWatcherController::setAnemometerType(enum ANEMOMETER_TYPE type)
 {
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
     anemometerType = type;
 }
 
 bool CloudWatcherController::checkCloudWatcher()
 {
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
+
     sendCloudwatcherCommand("A!");
 
     char inputBuffer[BLOCK_SIZE * 2];
@@ -90,6 +103,8 @@ bool CloudWatcherController::checkCloudWatcher()
 
 bool CloudWatcherController::getSwitchStatus(int *switchStatus)
 {
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
+
     sendCloudwatcherCommand("F!");
 
     char inputBuffer[BLOCK_SIZE * 2];
@@ -119,145 +134,115 @@ bool CloudWatcherController::getSwitchStatus(int *switchStatus)
 
 bool CloudWatcherController::getAllData(CloudWatcherData *cwd)
 {
-    int skyTemperature[NUMBER_OF_READS] = {0};
-    int sensorTemperature[NUMBER_OF_READS] = {0};
-    int rainFrequency[NUMBER_OF_READS] = {0};
-    int internalSupplyVoltage[NUMBER_OF_READS] = {0};
-    int ambientTemperature[NUMBER_OF_READS] = {0};
-    int ldrValue[NUMBER_OF_READS] = {0};
-    int rainSensorTemperature[NUMBER_OF_READS] = {0};
-    int windSpeed[NUMBER_OF_READS] = {0};
-    int humidity[NUMBER_OF_READS] = {0};
-    int pressure[NUMBER_OF_READS] = {0};
+    SlidingWindowStats readings[SAMPLE_COUNT];
+    int sample[SAMPLE_COUNT] = {0};
 
-    int check = 0;
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
 
     totalReadings++;
 
-    timeval begin;
-    gettimeofday(&begin, nullptr);
+    auto begin = std::chrono::steady_clock::now();
 
     for (int i = 0; i < NUMBER_OF_READS; i++)
     {
-        check = getIRSkyTemperature(&skyTemperature[i]);
-
-        if (!check)
+        if (!readSample(sample))
         {
-            LOG_ERROR( "ERROR in getIRSkyTemperature" );
             return false;
         }
 
-        check = getIRSensorTemperature(&sensorTemperature[i]);
-
-        if (!check)
-        {
-            LOG_ERROR( "ERROR in getIRSensorTemperature" );
-            return false;
-        }
-
-        check = getRainFrequency(&rainFrequency[i]);
-        if (!check)
+        for (int j = 0; j < SAMPLE_COUNT; j++)
         {
-            LOG_ERROR( "ERROR in getIRSensorTemperature" );
-            return false;
+            readings[j].add(sample[j]);
         }
+    }
 
-        check = getValues(&internalSupplyVoltage[i], &ambientTemperature[i], &ldrValue[i], &rainSensorTemperature[i]);
-
-        if (!check)
-        {
-            LOG_ERROR( "ERROR in getValues" );
-            return false;
-        }
+    std::chrono::duration<float> rc = std::chrono::steady_clock::now() - begin;
 
-        check = getWindSpeed(&windSpeed[i]);
+    cwd->readCycle = rc.count();
 
-        if (!check)
-        {
-            LOG_ERROR( "ERROR in getWindSpeed" );
-            return false;
-        }
+    aggregate(readings, cwd);
+    cwd->totalReadings = totalReadings;
 
-        if (m_FirmwareVersion >= 5.6)
-        {
-            check = getHumidity(&humidity[i]);
+    return readStatus(cwd);
+}
 
-            if (!check)
-            {
-                LOG_ERROR( "ERROR in getHumidity" );
-                return false;
-            }
-        }
+bool CloudWatcherController::startSampling(int window)
+{
+    stopSampling();
 
-        if (m_FirmwareVersion >= 5.8)
+    {
+        std::lock_guard<std::mutex> lock(sampleMutex);
+        for (auto &w : windows)
         {
-
-            check = getPressure(&pressure[i]);
-
-            if (!check)
-            {
-                LOG_ERROR( "ERROR in getPressure" );
-                return false;
-            }
+            w.resize(window);
+            w.clear();
         }
+        samplingFailed = sampleReady = false;
     }
 
-    timeval end;
-    gettimeofday(&end, nullptr);
+    try
+    {
+        samplingThread = std::thread(&CloudWatcherController::samplingLoop, this);
+    }
+    catch (const std::system_error &e)
+    {
+        LOGF_ERROR("Cannot start sampling thread: %s", e.what());
+        return false;
+    }
 
-    float rc = float(end.tv_sec - begin.tv_sec) + float(end.tv_usec - begin.tv_usec) / 1000000.0;
+    return true;
+}
 
-    cwd->readCycle = rc;
+void CloudWatcherController::stopSampling()
+{
+    {
+        std::lock_guard<std::mutex> lock(sampleMutex);
+        samplingQuit = true;
+    }
+    sampleCondition.notify_all();
 
-    cwd->sky             = aggregateInts(skyTemperature, NUMBER_OF_READS);
-    cwd->sensor          = aggregateInts(sensorTemperature, NUMBER_OF_READS);
-    cwd->rain            = aggregateInts(rainFrequency, NUMBER_OF_READS);
-    cwd->supply          = aggregateInts(internalSupplyVoltage, NUMBER_OF_READS);
-    cwd->ambient         = aggregateInts(ambientTemperature, NUMBER_OF_READS);
-    cwd->ldr             = aggregateInts(ldrValue, NUMBER_OF_READS);
-    cwd->rainTemperature = aggregateInts(rainSensorTemperature, NUMBER_OF_READS);
-    cwd->windSpeed       = aggregateInts(windSpeed, NUMBER_OF_READS);
-    if (m_FirmwareVersion >= 5.6)
-        cwd->humidity        = aggregateInts(humidity, NUMBER_OF_READS);
-    else
-        cwd->humidity = -1;
-    if (m_FirmwareVersion >= 5.8)
-        cwd->pressure        = aggregateInts(pressure, NUMBER_OF_READS);
-    else
-        cwd->pressure = -1;
-    cwd->totalReadings   = totalReadings;
+    if (samplingThread.joinable())
+    {
+        samplingThread.join();
+    }
 
-    check = getIRErrors(&cwd->firstByteErrors, &cwd->commandByteErrors, &cwd->secondByteErrors, &cwd->pecByteErrors);
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    samplingQuit = false;
+}
 
-    if (!check)
+void CloudWatcherController::setSamplingWindow(int window)
+{
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    for (auto &w : windows)
     {
-        LOG_DEBUG( "ERROR in getIRErrors" );
-        return false;
+        w.resize(window);
     }
+}
 
-    cwd->internalErrors = cwd->firstByteErrors + cwd->commandByteErrors + cwd->secondByteErrors + cwd->pecByteErrors;
-
-    check = getPWMDutyCycle(&cwd->rainHeater);
+CloudWatcherController::SamplingStatus CloudWatcherController::getSampledData(CloudWatcherData *cwd)
+{
+    std::lock_guard<std::mutex> lock(sampleMutex);
 
-    if (!check)
+    if (samplingFailed)
     {
-        LOG_DEBUG( "ERROR in getPWMDutyCycle" );
-        return false;
+        samplingFailed = false;
+        return SAMPLING_ERROR;
     }
 
-    check = getSwitchStatus(&cwd->switchStatus);
-
-    if (!check)
+    if (!sampleReady)
     {
-        LOG_DEBUG( "ERROR in getSwitchStatus" );
-        return false;
+        return SAMPLING_NO_DATA;
     }
 
-    return true;
+    *cwd        = sampled;
+    sampleReady = false;
+    return SAMPLING_NEW_DATA;
 }
 
 bool CloudWatcherController::getConstants(CloudWatcherConstants *cwc)
 {
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
+
     bool r = getFirmwareVersion(m_FirmwareVersion);
 
     if (!r)
@@ -301,6 +286,8 @@ bool CloudWatcherController::getConstants(CloudWatcherConstants *cwc)
 
 bool CloudWatcherController::closeSwitch()
 {
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
+
     sendCloudwatcherCommand("G!");
 
     char inputBuffer[BLOCK_SIZE * 2];
@@ -322,6 +309,8 @@ bool CloudWatcherController::closeSwitch()
 
 bool CloudWatcherController::openSwitch()
 {
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
+
     sendCloudwatcherCommand("H!");
 
     char inputBuffer[BLOCK_SIZE * 2];
@@ -353,6 +342,8 @@ bool CloudWatcherController::setPWMDutyCycle(int pwmDutyCycle)
         pwmDutyCycle = 1023;
     }
 
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
+
     int newPWM = pwmDutyCycle;
 
     char message[7] = "Pxxxx!";
@@ -400,6 +391,155 @@ bool CloudWatcherController::setPWMDutyCycle(int pwmDutyCycle)
 /******************************************************************/
 /* PRIVATE MEMBERS                                                */
 /******************************************************************/
+void CloudWatcherController::samplingLoop()
+{
+    std::unique_lock<std::mutex> lock(sampleMutex);
+
+    while (!samplingQuit)
+    {
+        lock.unlock();
+
+        int sample[SAMPLE_COUNT] = {0};
+        CloudWatcherData status {};
+
+        auto begin = std::chrono::steady_clock::now();
+        bool check = readSample(sample) && readStatus(&status);
+        std::chrono::duration<float> rc = std::chrono::steady_clock::now() - begin;
+
+        lock.lock();
+
+        if (check)
+        {
+            for (int i = 0; i < SAMPLE_COUNT; i++)
+            {
+                windows[i].add(sample[i]);
+            }
+
+            // Nothing is published before the first burst is complete, as in getAllData()
+            if (windows[0].count() >= std::min(windows[0].size(), int(NUMBER_OF_READS)))
+            {
+                sampled = status;
+                aggregate(windows, &sampled);
+                sampled.readCycle     = rc.count();
+                sampled.totalReadings = ++totalReadings;
+                sampleReady           = true;
+            }
+            samplingFailed = false;
+        }
+        else
+        {
+            samplingFailed = true;
+        }
+
+        sampleCondition.wait_for(lock, std::chrono::milliseconds(SAMPLING_PAUSE), [this]()
+        {
+            return samplingQuit;
+        });
+    }
+}
+
+bool CloudWatcherController::readSample(int sample[SAMPLE_COUNT])
+{
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
+
+    if (!getIRSkyTemperature(&sample[SAMPLE_SKY]))
+    {
+        LOG_ERROR( "ERROR in getIRSkyTemperature" );
+        return false;
+    }
+
+    if (!getIRSensorTemperature(&sample[SAMPLE_SENSOR]))
+    {
+        LOG_ERROR( "ERROR in getIRSensorTemperature" );
+        return false;
+    }
+
+    if (!getRainFrequency(&sample[SAMPLE_RAIN]))
+    {
+        LOG_ERROR( "ERROR in getRainFrequency" );
+        return false;
+    }
+
+    if (!getValues(&sample[SAMPLE_SUPPLY], &sample[SAMPLE_AMBIENT], &sample[SAMPLE_LDR], &sample[SAMPLE_RAIN_TEMPERATURE]))
+    {
+        LOG_ERROR( "ERROR in getValues" );
+        return false;
+    }
+
+    if (!getWindSpeed(&sample[SAMPLE_WIND_SPEED]))
+    {
+        LOG_ERROR( "ERROR in getWindSpeed" );
+        return false;
+    }
+
+    if (m_FirmwareVersion >= 5.6 && !getHumidity(&sample[SAMPLE_HUMIDITY]))
+    {
+        LOG_ERROR( "ERROR in getHumidity" );
+        return false;
+    }
+
+    if (m_FirmwareVersion >= 5.8 && !getPressure(&sample[SAMPLE_PRESSURE]))
+    {
+        LOG_ERROR( "ERROR in getPressure" );
+        return false;
+    }
+
+    return true;
+}
+
+bool CloudWatcherController::readStatus(CloudWatcherData *cwd)
+{
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
+
+    int check = getIRErrors(&cwd->firstByteErrors, &cwd->commandByteErrors, &cwd->secondByteErrors, &cwd->pecByteErrors);
+
+    if (!check)
+    {
+        LOG_DEBUG( "ERROR in getIRErrors" );
+        return false;
+    }
+
+    cwd->internalErrors = cwd->firstByteErrors + cwd->commandByteErrors + cwd->secondByteErrors + cwd->pecByteErrors;
+
+    check = getPWMDutyCycle(&cwd->rainHeater);
+
+    if (!check)
+    {
+        LOG_DEBUG( "ERROR in getPWMDutyCycle" );
+        return false;
+    }
+
+    check = getSwitchStatus(&cwd->switchStatus);
+
+    if (!check)
+    {
+        LOG_DEBUG( "ERROR in getSwitchStatus" );
+        return false;
+    }
+
+    return true;
+}
+
+void CloudWatcherController::aggregate(const SlidingWindowStats readings[SAMPLE_COUNT], CloudWatcherData *cwd)
+{
+    cwd->sky             = int(readings[SAMPLE_SKY].aggregate());
+    cwd->sensor          = int(readings[SAMPLE_SENSOR].aggregate());
+    cwd->rain            = int(readings[SAMPLE_RAIN].aggregate());
+    cwd->supply          = int(readings[SAMPLE_SUPPLY].aggregate());
+    cwd->ambient         = int(readings[SAMPLE_AMBIENT].aggregate());
+    cwd->ldr             = int(readings[SAMPLE_LDR].aggregate());
+    cwd->rainTemperature = int(readings[SAMPLE_RAIN_TEMPERATURE].aggregate());
+    cwd->windSpeed       = int(readings[SAMPLE_WIND_SPEED].aggregate());
+    if (m_FirmwareVersion >= 5.6)
+        cwd->humidity        = int(readings[SAMPLE_HUMIDITY].aggregate());
+    else
+        cwd->humidity = -1;
+    if (m_FirmwareVersion >= 5.8)
+        cwd->pressure        = int(readings[SAMPLE_PRESSURE].aggregate());
+    else
+        cwd->pressure = -1;
+}
+
 bool CloudWatcherController::getFirmwareVersion(double &version)
 {
     if (m_FirmwareVersion == 0)
@@ -842,62 +982,113 @@ bool CloudWatcherController::getIRErrors(int *firstAddressByteErrors, int *comma
     return true;
 }
 
-float CloudWatcherController::aggregateFloats(float values[], int numberOfValues)
+SlidingWindowStats::SlidingWindowStats(int size) : values(std::max(size, 1), 0)
 {
-    float average = 0.0;
+}
 
-    for (int i = 0; i < numberOfValues; i++)
+void SlidingWindowStats::resize(int size)
+{
+    size = std::max(size, 1);
+    if (size == this->size())
     {
-        //    printMessage("%f\n", values[i]);
-
-        average += values[i];
+        return;
     }
 
-    average /= numberOfValues;
+    // Oldest first, so the newest readings stay in the window
+    const int capacity = this->size();
+    std::vector<int> newest;
+    for (int i = std::max(0, n - size); i < n; i++)
+    {
+        newest.push_back(values[(head - n + i + capacity) % capacity]);
+    }
 
-    float stdD = 0.0;
+    values.assign(size, 0);
+    clear();
 
-    for (int i = 0; i < numberOfValues; i++)
+    for (int value : newest)
     {
-        stdD += (values[i] - average) * (values[i] - average);
+        add(value);
     }
+}
 
-    stdD /= numberOfValues;
+void SlidingWindowStats::clear()
+{
+    head = n = 0;
+    m = m2 = 0;
+}
 
-    stdD = sqrt(stdD);
+void SlidingWindowStats::add(int value)
+{
+    if (n < size())
+    {
+        values[head] = value;
+        head         = (head + 1) % size();
+        n++;
 
-    //  printMessage("Average: %f, stdD: %f\n", average, stdD);
+        double delta = value - m;
+        m += delta / n;
+        m2 += delta * (value - m);
+    }
+    else
+    {
+        int oldest   = values[head];
+        values[head] = value;
+        head         = (head + 1) % size();
 
-    float newAverage  = 0.0;
-    int numberOfItems = 0;
+        double newMean = m + double(value - oldest) / n;
+        m2 += double(value - oldest) * (value - newMean + oldest - m);
+        m = newMean;
 
-    for (int i = 0; i < numberOfValues; i++)
-    {
-        if (fabs(values[i] - average) <= stdD)
+        if (head == 0)
         {
-            //      printMessage("%f\n", fabs(values[i] - average));
-            newAverage += values[i];
-            numberOfItems++;
+            recompute();
         }
     }
 
-    newAverage /= numberOfItems;
+    if (m2 < 0)
+    {
+        m2 = 0;
+    }
+}
 
-    printMessage("New average: %f\n", newAverage);
+void SlidingWindowStats::recompute()
+{
+    m = m2 = 0;
+    for (int i = 0; i < n; i++)
+    {
+        double delta = values[i] - m;
+        m += delta / (i + 1);
+        m2 += delta * (values[i] - m);
+    }
+}
 
-    return newAverage;
+double SlidingWindowStats::stdDev() const
+{
+    return n > 0 ? sqrt(m2 / n) : 0;
 }
 
-int CloudWatcherController::aggregateInts(int values[], int numberOfValues)
+float SlidingWindowStats::aggregate() const
 {
-    float newValues[numberOfValues];
+    if (n == 0)
+    {
+        return 0;
+    }
 
-    for (int i = 0; i < numberOfValues; i++)
+    double deviation = stdDev();
+    double sum       = 0;
+    int items        = 0;
+
+    // The filled slots are always the first n ones
+    for (int i = 0; i < n; i++)
     {
-        newValues[i] = (float)values[i];
+        if (fabs(values[i] - m) <= deviation)
+        {
+            sum += values[i];
+            items++;
+        }
     }
 
-    return (int)aggregateFloats(newValues, numberOfValues);
+    return items > 0 ? float(sum / items) : float(m);
 }
 
 bool CloudWatcherController::checkValidMessage(char *buffer, int nBlocks)
@@ -24,6 +24,12 @@ Anemometer code contributed by Joao Bento.
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 /**
  *  A struct to group and send all AAG Cloud Watcher constants
  */
@@ -69,7 +75,7 @@ struct CloudWatcherData
     int rainHeater; ///< PWM Duty Cycle
     int rainTemperature; ///< Rain sensor temperature (used as ambient temperature in models where there is no ambient temperature sensor)
     int ldr;               ///< Ambient light sensor
-    float readCycle;       ///< Time used in the readings
+    float readCycle;       ///< Time used in the readings (a single sampling cycle when sampling continuously)
     int totalReadings;     ///< Total number of readings taken by the Cloud Watcher Controller
     int internalErrors;    ///< Total number of internal errors
     int firstByteErrors;   ///< First byte errors count
@@ -82,6 +88,79 @@ struct CloudWatcherData
     int pressure;          ///< atmospheric pressure
 };
 
+/**
+ * A sliding window over the last readings of one sensor. Mean and variance are kept up to
+ * date with Welford's update as readings enter and leave the window, so a new reading costs
+ * O(1) instead of a pass over the window.
+ */
+
+class SlidingWindowStats
+{
+    public:
+        /**
+        * A constructor.
+        * @param size the number of readings kept in the window
+        */
+        explicit SlidingWindowStats(int size = 5);
+
+        /**
+        * Changes the size of the window. The newest readings that fit are kept.
+        * @param size the new number of readings kept in the window
+        */
+        void resize(int size);
+
+        /**
+        * Forgets all readings
+        */
+        void clear();
+
+        /**
+        * Adds a reading, replacing the oldest one if the window is full
+        * @param value the new reading
+        */
+        void add(int value);
+
+        int size() const
+        {
+            return static_cast<int>(values.size());
+        }
+
+        int count() const
+        {
+            return n;
+        }
+
+        double mean() const
+        {
+            return m;
+        }
+
+        /**
+        * @return the (population) standard deviation of the readings in the window
+        */
+        double stdDev() const;
+
+        /**
+        * Averages only the readings within [mean - deviation, mean + deviation], like the
+        * filter described in the AAG documents.
+        * @return the aggregated value, 0 if the window is empty
+        */
+        float aggregate() const;
+
+    private:
+        /**
+        * Computes mean and variance again from the readings, so the rounding errors of the
+        * incremental update do not pile up.
+        */
+        void recompute();
+
+        std::vector<int> values;
+        int head = 0;   ///< Where the next reading goes
+        int n    = 0;   ///< Number of readings in the window
+        double m  = 0;  ///< Mean
+        double m2 = 0;  ///< Sum of squared differences from the mean
+};
+
 /**
  * A class  to communicate with the AAG Cloud Watcher. It is responsible to
  * send and recieve all the commands specified in the AAG Cloud Watcher
@@ -106,7 +185,17 @@ class CloudWatcherController
         /**
         * A destructor
         */
-        virtual ~CloudWatcherController() = default;
+        virtual ~CloudWatcherController();
+
+        /**
+        * The result of getSampledData()
+        */
+        enum SamplingStatus
+        {
+            SAMPLING_NO_DATA,  ///< No new aggregate since the last call
+            SAMPLING_NEW_DATA, ///< A new aggregate has been stored
+            SAMPLING_ERROR     ///< The device could not be read since the last call
+        };
 
         const char *getDeviceName();
 
@@ -147,6 +236,36 @@ class CloudWatcherController
         */
         bool getAllData(CloudWatcherData * cwd);
 
+        /**
+        * Starts reading the AAG Cloud Watcher continuously on a thread of its own. Every
+        * reading goes into a sliding window per sensor and a new aggregate is available after
+        * each sampling cycle, see getSampledData(). Other commands can still be sent while
+        * sampling, they are served between two sampling cycles.
+        * @param window the number of readings aggregated per sensor
+        * @return true if the sampling thread has been started. false otherwise.
+        */
+        bool startSampling(int window);
+
+        /**
+        * Stops the sampling thread started by startSampling(). Must be called before the
+        * connection is closed.
+        */
+        void stopSampling();
+
+        /**
+        * Changes the number of readings aggregated per sensor. The newest readings that fit
+        * into the new window are kept.
+        * @param window the number of readings aggregated per sensor
+        */
+        void setSamplingWindow(int window);
+
+        /**
+        * Gets the newest aggregate of the sampling thread without waiting for the device.
+        * @param cwd where the dynamic data of the AAG Cloud Watcher will be stored.
+        * @return SAMPLING_NEW_DATA if cwd has been filled with an aggregate not returned before.
+        */
+        SamplingStatus getSampledData(CloudWatcherData * cwd);
+
         /**
         * Gets all constants from the AAG Cloud Watcher. Some of the constants are
         * retrieved from the device (from firmware version >3.0)
@@ -205,10 +324,47 @@ class CloudWatcherController
         const static int BLOCK_SIZE = 15;
 
         /**
-        * Number of reads to aggregate for the cloudwatcher data
+        * Number of reads to aggregate for the cloudwatcher data. The sampling thread does not
+        * publish anything before it has this many readings (or a full window if smaller).
         */
         const static int NUMBER_OF_READS = 5;
 
+        /**
+        * The sensors read in every sampling cycle
+        */
+        enum
+        {
+            SAMPLE_SKY,
+            SAMPLE_SENSOR,
+            SAMPLE_RAIN,
+            SAMPLE_SUPPLY,
+            SAMPLE_AMBIENT,
+            SAMPLE_LDR,
+            SAMPLE_RAIN_TEMPERATURE,
+            SAMPLE_WIND_SPEED,
+            SAMPLE_HUMIDITY,
+            SAMPLE_PRESSURE,
+            SAMPLE_COUNT
+        };
+
+        /**
+        * Serializes the commands to the device between the sampling thread and the driver.
+        * Recursive as public commands are also part of a sampling cycle.
+        */
+        std::recursive_mutex portMutex;
+
+        /**
+        * Sampling thread state, guarded by sampleMutex
+        */
+        std::thread samplingThread;
+        std::mutex sampleMutex;
+        std::condition_variable sampleCondition;
+        bool samplingQuit = false;
+        bool samplingFailed = false;
+        bool sampleReady = false;
+        SlidingWindowStats windows[SAMPLE_COUNT];
+        CloudWatcherData sampled {};
+
         /**
         * Hard coded constant. May be changed with internal device constants.
         * @see getElectricalConstants()
@@ -263,7 +419,7 @@ class CloudWatcherController
         /**
         * The total number of readings performed by the controller
         */
-        int totalReadings = 0;
+        std::atomic<int> totalReadings {0};
 
         /**
         * Print a buffer of chars. Just for debugging
@@ -327,24 +483,30 @@ class CloudWatcherController
         bool getSerialNumber(int *serialNumber);
 
         /**
-        * Performs an aggregation of the values stored in a float array. It computes
-        * average and standard deviation of the array and averages only the values
-        * within [average - deviation, average + deviation]
-        * @param values the values to be aggregated
-        * @param numberOfValues the size of values
-        * @return the aggregated value
+        * Reads every sensor of the AAG Cloud Watcher once.
+        * @param sample where the readings will be stored, indexed by SAMPLE_*
+        * @return true if succesfully read. false otherwise.
+        */
+        bool readSample(int sample[SAMPLE_COUNT]);
+
+        /**
+        * Reads the error counters, the PWM Duty Cycle and the switch status.
+        * @param cwd where the values will be stored
+        * @return true if succesfully read. false otherwise.
+        */
+        bool readStatus(CloudWatcherData *cwd);
+
+        /**
+        * Stores the aggregates of the sensor windows into cwd
+        * @param readings the sensor windows, indexed by SAMPLE_*
+        * @param cwd where the aggregated values will be stored
         */
-        float aggregateFloats(float values[], int numberOfValues);
+        void aggregate(const SlidingWindowStats readings[SAMPLE_COUNT], CloudWatcherData *cwd);
 
         /**
-        * Performs an aggregation of the values stored in a int array. It computes
-        * average and standard deviation of the array and averages only the values
-        * within [average - deviation, average + deviation]
-        * @param values the values to be aggregated
-        * @param numberOfValues the size of values
-        * @return the aggregated value
+        * The sampling thread
         */
-        int aggregateInts(int values[], int numberOfValues);
+        void samplingLoop();
 
         /**
         * Reads the current IR Sky Temperature value of the AAG Cloud Watcher
@@ -71,7 +71,9 @@ bool AAGCloudWatcher::Handshake()
 
         if (m_FirmwareVersion >= 5.6)
             addParameter("WEATHER_HUMIDITY", "Relative Humidity (%)", 0, 100, 10);
-        return true;
+
+        INumberVectorProperty *nvp = getNumber("sampling");
+        return cwc->startSampling(int(getNumberValueFromVector(nvp, "window")));
     }
     else
     {
@@ -82,6 +84,14 @@ bool AAGCloudWatcher::Handshake()
 }
 
 
+bool AAGCloudWatcher::Disconnect()
+{
+    // The sampling thread must be done with the port before it is closed
+    cwc->stopSampling();
+
+    return INDI::Weather::Disconnect();
+}
+
 /**********************************************************************
 ** Initialize all properties & set default values.
 **********************************************************************/
@@ -107,12 +117,24 @@ bool AAGCloudWatcher::initProperties()
 
 IPState AAGCloudWatcher::updateWeather()
 {
-    if (!sendData())
+    CloudWatcherData data;
+
+    switch (cwc->getSampledData(&data))
     {
-        LOG_ERROR("Can not get data from device");
-        return IPS_ALERT;
+        case CloudWatcherController::SAMPLING_NO_DATA:
+            // The sampling thread has no new aggregate yet, it is checked again shortly
+            return IPS_BUSY;
+
+        case CloudWatcherController::SAMPLING_ERROR:
+            LOG_ERROR("Can not get data from device");
+            return IPS_ALERT;
+
+        case CloudWatcherController::SAMPLING_NEW_DATA:
+            break;
     }
 
+    sendData(data);
+
     heatingAlgorithm();
 
     return IPS_OK;
@@ -222,6 +244,20 @@ bool AAGCloudWatcher::ISNewNumber(const char *dev, const char *name, double valu
         return true;
     }
 
+    if (!strcmp(nvp->name, "sampling"))
+    {
+        IUUpdateNumber(nvp, values, names, n);
+
+        int window = int(getNumberValueFromVector(nvp, "window"));
+        cwc->setSamplingWindow(window);
+        LOGF_DEBUG("Aggregating the last %d readings of each sensor", window);
+
+        nvp->s = IPS_OK;
+        IDSetNumber(nvp, nullptr);
+
+        return true;
+    }
+
     if (!strcmp(nvp->name, "skyCorrection"))
     {
         for (int i = 0; i < 5; i++)
@@ -584,13 +620,8 @@ bool AAGCloudWatcher::heatingAlgorithm()
     return true;
 }
 
-bool AAGCloudWatcher::sendData()
+bool AAGCloudWatcher::sendData(const CloudWatcherData &data)
 {
-    CloudWatcherData data;
-
-    if (cwc->getAllData(&data) == 0)
-        return false;
-
     INumberVectorProperty *nvp = getNumber("readings");
     nvp->np[RAW_SENSOR_SUPPLY].value = data.supply;
     nvp->np[RAW_SENSOR_SKY].value = data.sky;
@@ -47,13 +47,14 @@ class AAGCloudWatcher : public INDI::Weather
         virtual bool ISNewSwitch(const char *dev, const char *name, ISState *states, char *names[], int n) override;
 
         virtual const char *getDefaultName() override;
-        bool sendData();
+        bool sendData(const CloudWatcherData &data);
         float getRefreshPeriod();
         float getLastReadPeriod();
         bool heatingAlgorithm();
 
     protected:
         virtual bool Handshake() override;
+        virtual bool Disconnect() override;
         virtual IPState updateWeather() override;
 
     private:
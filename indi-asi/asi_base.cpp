@@ -25,6 +25,7 @@
 
 #include "config.h"
 
+#include <pixelshuffle.h>
 #include <stream/streammanager.h>
 #include <indielapsedtimer.h>
 
@@ -32,6 +33,7 @@
 #include <cmath>
 #include <vector>
 #include <map>
+#include <thread>
 #include <unistd.h>
 
 #define MAX_EXP_RETRIES         3
@@ -40,6 +42,9 @@
 #define TEMP_THRESHOLD          .25  /* Differential temperature threshold (C)*/
 
 #define CONTROL_TAB "Controls"
+#define STREAM_TAB  "Streaming"
+
+#define STREAM_BUFFER_SLOTS     4   /* Default number of frames in the video frame ring */
 
 static bool warn_roi_height = true;
 static bool warn_roi_width = true;
@@ -67,12 +72,20 @@ void ASIBase::workerStreamVideo(const std::atomic_bool &isAboutToQuit)
         LOGF_ERROR("Failed to start video capture (%s).", Helpers::toString(ret));
     }
 
+    // Capture into the ring while the streamer encodes/records the previous frames
+    uint32_t totalBytes = PrimaryCCD.getFrameBufferSize();
+    mFrameRing.reset(static_cast<size_t>(StreamBufferNP[0].getValue()), totalBytes);
+    updateDroppedFrames();
+
+    std::thread streamer(&ASIBase::workerStreamFrames, this);
+
+    uint8_t *targetFrame = mFrameRing.writeBuffer();
+    int waitMS           = static_cast<int>((ExposureRequest * 2000.0) + 500);
+    uint64_t lastDropped = 0;
+    INDI::ElapsedTimer droppedTimer;
+
     while (!isAboutToQuit)
     {
-        uint8_t *targetFrame = PrimaryCCD.getFrameBuffer();
-        uint32_t totalBytes  = PrimaryCCD.getFrameBufferSize();
-        int waitMS           = static_cast<int>((ExposureRequest * 2000.0) + 500);
-
         ret = ASIGetVideoData(mCameraInfo.CameraID, targetFrame, totalBytes, waitMS);
         if (ret != ASI_SUCCESS)
         {
@@ -87,14 +100,48 @@ void ASIBase::workerStreamVideo(const std::atomic_bool &isAboutToQuit)
             continue;
         }
 
-        if (mCurrentVideoFormat == ASI_IMG_RGB24)
-            for (uint32_t i = 0; i < totalBytes; i += 3)
-                std::swap(targetFrame[i], targetFrame[i + 2]);
+        targetFrame = mFrameRing.commit(totalBytes);
 
-        Streamer->newFrame(targetFrame, totalBytes);
+        // Do not flood clients, report drops at most once per second
+        if (droppedTimer.hasExpired(1000))
+        {
+            if (mFrameRing.dropped() != lastDropped)
+            {
+                lastDropped = mFrameRing.dropped();
+                updateDroppedFrames();
+            }
+            droppedTimer.start();
+        }
     }
 
     ASIStopVideoCapture(mCameraInfo.CameraID);
+
+    mFrameRing.stop();
+    streamer.join();
+
+    if (mFrameRing.dropped() > 0)
+        LOGF_DEBUG("Video stream stopped, %llu frame(s) dropped.", static_cast<unsigned long long>(mFrameRing.dropped()));
+    updateDroppedFrames();
+}
+
+void ASIBase::workerStreamFrames()
+{
+    size_t totalBytes = 0;
+    while (uint8_t *frame = mFrameRing.acquire(&totalBytes))
+    {
+        if (mCurrentVideoFormat == ASI_IMG_RGB24)
+            PixelShuffle::swapRB24(frame, totalBytes / 3);
+
+        Streamer->newFrame(frame, totalBytes);
+        mFrameRing.release();
+    }
+}
+
+void ASIBase::updateDroppedFrames()
+{
+    StreamDroppedNP[0].setValue(mFrameRing.dropped());
+    StreamDroppedNP.setState(mFrameRing.dropped() > 0 ? IPS_BUSY : IPS_OK);
+    StreamDroppedNP.apply();
 }
 
 void ASIBase::workerBlinkExposure(const std::atomic_bool &isAboutToQuit, int blinks, float duration)
@@ -337,6 +384,16 @@ bool ASIBase::initProperties()
     BlinkNP[BLINK_DURATION].fill("BLINK_DURATION", "Blink duration",         "%2.3f", 0,  60, 0.001, 0);
     BlinkNP.fill(getDeviceName(), "BLINK", "Blink", CONTROL_TAB, IP_RW, 60, IPS_IDLE);
 
+    StreamBufferNP[0].fill("SLOTS", "Frames", "%2.0f", 2, 32, 1, STREAM_BUFFER_SLOTS);
+    StreamBufferNP.fill(getDeviceName(), "STREAM_BUFFER", "Frame Buffer", STREAM_TAB, IP_RW, 60, IPS_IDLE);
+
+    StreamPolicySP[FrameRing::DROP_OLDEST].fill("DROP_OLDEST", "Drop oldest", ISS_ON);
+    StreamPolicySP[FrameRing::DROP_NEWEST].fill("DROP_NEWEST", "Drop newest", ISS_OFF);
+    StreamPolicySP.fill(getDeviceName(), "STREAM_DROP_POLICY", "Overflow", STREAM_TAB, IP_RW, ISR_1OFMANY, 60, IPS_IDLE);
+
+    StreamDroppedNP[0].fill("DROPPED", "Frames", "%.f", 0, 1e12, 0, 0);
+    StreamDroppedNP.fill(getDeviceName(), "STREAM_DROPPED", "Dropped", STREAM_TAB, IP_RO, 60, IPS_IDLE);
+
     IUSaveText(&BayerT[2], getBayerString());
 
     ADCDepthNP[0].fill("BITS", "Bits", "%2.0f", 0, 32, 1, mCameraInfo.BitDepth);
@@ -462,6 +519,13 @@ bool ASIBase::updateProperties()
         }
 
         defineProperty(BlinkNP);
+
+        defineProperty(StreamBufferNP);
+        loadConfig(true, StreamBufferNP.getName());
+        defineProperty(StreamPolicySP);
+        loadConfig(true, StreamPolicySP.getName());
+        defineProperty(StreamDroppedNP);
+
         defineProperty(ADCDepthNP);
         defineProperty(SDKVersionSP);
         if (!mSerialNumber.empty())
@@ -495,6 +559,11 @@ bool ASIBase::updateProperties()
             deleteProperty(VideoFormatSP.getName());
 
         deleteProperty(BlinkNP.getName());
+
+        deleteProperty(StreamBufferNP.getName());
+        deleteProperty(StreamPolicySP.getName());
+        deleteProperty(StreamDroppedNP.getName());
+
         deleteProperty(SDKVersionSP.getName());
         if (!mSerialNumber.empty())
         {
@@ -558,6 +627,7 @@ bool ASIBase::Disconnect()
 
     mWorker.quit();
     Streamer->setStream(false);
+    mFrameRing.clear();
 
     if (isSimulation() == false)
     {
@@ -778,6 +848,21 @@ bool ASIBase::ISNewNumber(const char *dev, const char *name, double values[], ch
             BlinkNP.apply();
             return true;
         }
+
+        if (StreamBufferNP.isNameMatch(name))
+        {
+            if (Streamer->isBusy())
+            {
+                LOG_ERROR("Cannot change frame buffer while streaming/recording.");
+                StreamBufferNP.setState(IPS_ALERT);
+                StreamBufferNP.apply();
+                return true;
+            }
+
+            StreamBufferNP.setState(StreamBufferNP.update(values, names, n) ? IPS_OK : IPS_ALERT);
+            StreamBufferNP.apply();
+            return true;
+        }
     }
 
     return INDI::CCD::ISNewNumber(dev, name, values, names, n);
@@ -859,6 +944,21 @@ bool ASIBase::ISNewSwitch(const char *dev, const char *name, ISState *states, ch
             return true;
         }
 
+        if (StreamPolicySP.isNameMatch(name))
+        {
+            if (StreamPolicySP.update(states, names, n) == false)
+            {
+                StreamPolicySP.setState(IPS_ALERT);
+                StreamPolicySP.apply();
+                return true;
+            }
+
+            mFrameRing.setPolicy(static_cast<FrameRing::Policy>(StreamPolicySP.findOnSwitchIndex()));
+            StreamPolicySP.setState(IPS_OK);
+            StreamPolicySP.apply();
+            return true;
+        }
+
         /* Cooler */
         if (CoolerSP.isNameMatch(name))
         {
@@ -1138,14 +1238,11 @@ int ASIBase::grabImage(float duration)
     int nChannels = (type == ASI_IMG_RGB24) ? 3 : 1;
     size_t nTotalBytes = subW * subH * nChannels * (PrimaryCCD.getBPP() / 8);
 
+    // Packed BGR is read into a scratch buffer kept across exposures, then split into planes
     if (type == ASI_IMG_RGB24)
     {
-        buffer = static_cast<uint8_t *>(malloc(nTotalBytes));
-        if (buffer == nullptr)
-        {
-            LOGF_ERROR("%s: %d malloc failed (RGB 24).", getDeviceName());
-            return -1;
-        }
+        mRGBBuffer.resize(nTotalBytes);
+        buffer = mRGBBuffer.data();
     }
 
     ret = ASIGetDataAfterExp(mCameraInfo.CameraID, buffer, nTotalBytes);
@@ -1155,8 +1252,6 @@ int ASIBase::grabImage(float duration)
             "Failed to get data after exposure (%dx%d #%d channels) (%s).",
             subW, subH, nChannels, Helpers::toString(ret)
         );
-        if (type == ASI_IMG_RGB24)
-            free(buffer);
         return -1;
     }
 
@@ -1166,17 +1261,7 @@ int ASIBase::grabImage(float duration)
         uint8_t *dstG = image + subW * subH;
         uint8_t *dstB = image + subW * subH * 2;
 
-        const uint8_t *src = buffer;
-        const uint8_t *end = buffer + subW * subH * 3;
-
-        while (src != end)
-        {
-            *dstB++ = *src++;
-            *dstG++ = *src++;
-            *dstR++ = *src++;
-        }
-
-        free(buffer);
+        PixelShuffle::split24(buffer, dstB, dstG, dstR, subW * subH);
     }
     guard.unlock();
 
@@ -1535,6 +1620,8 @@ bool ASIBase::saveConfigItems(FILE *fp)
         VideoFormatSP.save(fp);
 
     BlinkNP.save(fp);
+    StreamBufferNP.save(fp);
+    StreamPolicySP.save(fp);
 
     return true;
 }
@@ -28,6 +28,7 @@
 #include "indipropertynumber.h"
 #include "indipropertytext.h"
 #include "indisinglethreadpool.h"
+#include "framering.h"
 
 #include <vector>
 
@@ -86,6 +87,7 @@ class ASIBase : public INDI::CCD
     protected:
         INDI::SingleThreadPool mWorker;
         void workerStreamVideo(const std::atomic_bool &isAboutToQuit);
+        void workerStreamFrames();
         void workerBlinkExposure(const std::atomic_bool &isAboutToQuit, int blinks, float duration);
         void workerExposure(const std::atomic_bool &isAboutToQuit, float duration);
 
@@ -132,6 +134,9 @@ class ASIBase : public INDI::CCD
         /** Can the camera flip the image horizontally and vertically */
         bool hasFlipControl();
 
+        /** Publish the number of video frames dropped by the frame ring */
+        void updateDroppedFrames();
+
         /** Additional Properties to INDI::CCD */
         INDI::PropertyNumber  CoolerNP {1};
         INDI::PropertySwitch  CoolerSP {2};
@@ -159,6 +164,16 @@ class ASIBase : public INDI::CCD
             FLIP_VERTICAL
         };
 
+        /** Video frame ring between capture and streamer */
+        INDI::PropertyNumber  StreamBufferNP {1};
+        INDI::PropertySwitch  StreamPolicySP {2};
+        INDI::PropertyNumber  StreamDroppedNP {1};
+
+        FrameRing mFrameRing;
+
+        /** Scratch buffer for packed RGB24 exposures */
+        std::vector<uint8_t> mRGBBuffer;
+
         std::string mCameraName, mCameraID, mSerialNumber, mNickname;
         ASI_CAMERA_INFO mCameraInfo;
         uint8_t mExposureRetry {0};
@@ -0,0 +1,189 @@
+/*
+    ASI Camera Frame Ring
+
+    Copyright (C) 2026 agent (agent@local)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "framering.h"
+
+#include <algorithm>
+
+void FrameRing::reset(size_t slotCount, size_t slotSize)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    // producer + consumer need at least one slot each
+    slotCount = std::max<size_t>(slotCount, 2);
+
+    mSlots.resize(slotCount);
+    for (auto &slot : mSlots)
+        slot.resize(slotSize);
+
+    mSlotSize.assign(slotCount, 0);
+
+    mFree.clear();
+    mFree.reserve(slotCount);
+    for (size_t i = slotCount; i > 1; --i)
+        mFree.push_back(i - 1);
+
+    mQueue.assign(slotCount, 0);
+    mQueueHead  = 0;
+    mQueueCount = 0;
+
+    mWriteSlot = 0;
+    mReading   = false;
+    mStopped   = false;
+    mDropped   = 0;
+}
+
+void FrameRing::clear()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mSlots.clear();
+    mSlots.shrink_to_fit();
+    mSlotSize.clear();
+    mFree.clear();
+    mQueue.clear();
+    mQueueHead  = 0;
+    mQueueCount = 0;
+    mReading    = false;
+}
+
+void FrameRing::setPolicy(Policy policy)
+{
+    mPolicy = policy;
+}
+
+FrameRing::Policy FrameRing::policy() const
+{
+    return mPolicy;
+}
+
+uint8_t *FrameRing::writeBuffer()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    return mSlots.empty() ? nullptr : mSlots[mWriteSlot].data();
+}
+
+size_t FrameRing::popFree()
+{
+    size_t slot = mFree.back();
+    mFree.pop_back();
+    return slot;
+}
+
+uint8_t *FrameRing::commit(size_t size)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (mSlots.empty())
+        return nullptr;
+
+    mSlotSize[mWriteSlot] = size;
+
+    size_t nextSlot;
+    if (!mFree.empty())
+    {
+        nextSlot = popFree();
+    }
+    else if (mPolicy == DROP_OLDEST && mQueueCount > 0)
+    {
+        // recycle the oldest frame nobody has looked at yet
+        nextSlot = mQueue[mQueueHead];
+        mQueueHead = (mQueueHead + 1) % mQueue.size();
+        --mQueueCount;
+        ++mDropped;
+    }
+    else
+    {
+        // discard the frame just captured and overwrite it
+        ++mDropped;
+        return mSlots[mWriteSlot].data();
+    }
+
+    mQueue[(mQueueHead + mQueueCount) % mQueue.size()] = mWriteSlot;
+    ++mQueueCount;
+    mWriteSlot = nextSlot;
+
+    lock.unlock();
+    mCondition.notify_one();
+
+    return mSlots[nextSlot].data();
+}
+
+uint8_t *FrameRing::acquire(size_t *size)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    mCondition.wait(lock, [this] { return mStopped || mQueueCount > 0; });
+
+    if (mStopped)
+        return nullptr;
+
+    mReadSlot  = mQueue[mQueueHead];
+    mQueueHead = (mQueueHead + 1) % mQueue.size();
+    --mQueueCount;
+    mReading   = true;
+
+    if (size != nullptr)
+        *size = mSlotSize[mReadSlot];
+
+    return mSlots[mReadSlot].data();
+}
+
+void FrameRing::release()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (!mReading)
+        return;
+
+    mReading = false;
+    mFree.push_back(mReadSlot);
+}
+
+void FrameRing::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mStopped = true;
+    }
+    mCondition.notify_all();
+}
+
+size_t FrameRing::slotCount() const
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    return mSlots.size();
+}
+
+size_t FrameRing::slotSize() const
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    return mSlots.empty() ? 0 : mSlots.front().size();
+}
+
+size_t FrameRing::queued() const
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    return mQueueCount;
+}
+
+uint64_t FrameRing::dropped() const
+{
+    return mDropped;
+}
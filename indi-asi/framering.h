@@ -0,0 +1,114 @@
+/*
+    ASI Camera Frame Ring
+
+    Copyright (C) 2026 agent (agent@local)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Preallocated N-slot frame buffer shared by a single producer (capture)
+ * and a single consumer (streamer).
+ *
+ * The producer always owns exactly one slot which it fills in place, the consumer
+ * holds at most one slot while encoding/recording it. The remaining slots are either
+ * free or queued in capture order. When no free slot is left on commit, the selected
+ * policy decides which frame is discarded. No memory is allocated after reset().
+ */
+class FrameRing
+{
+    public:
+        enum Policy
+        {
+            DROP_OLDEST,
+            DROP_NEWEST
+        };
+
+    public:
+        FrameRing() = default;
+        FrameRing(const FrameRing &) = delete;
+        FrameRing &operator=(const FrameRing &) = delete;
+
+    public:
+        /** Allocate (or reuse) slotCount slots of slotSize bytes, drop all queued frames and counters. */
+        void reset(size_t slotCount, size_t slotSize);
+
+        /** Release all slot memory. */
+        void clear();
+
+        void setPolicy(Policy policy);
+        Policy policy() const;
+
+    public: // producer
+        /** Buffer the producer should fill next. Valid until commit(). */
+        uint8_t *writeBuffer();
+
+        /** Queue the filled write buffer and return the next one to fill. */
+        uint8_t *commit(size_t size);
+
+    public: // consumer
+        /**
+         * Block until a frame is queued or the ring is stopped.
+         * @return pointer to the oldest queued frame or nullptr when stopped.
+         */
+        uint8_t *acquire(size_t *size);
+
+        /** Return the slot obtained by acquire() to the free pool. */
+        void release();
+
+        /** Wake up the consumer and make acquire() return nullptr. */
+        void stop();
+
+    public:
+        size_t slotCount() const;
+        size_t slotSize() const;
+        size_t queued() const;
+        uint64_t dropped() const;
+
+    protected:
+        size_t popFree();
+
+    protected:
+        std::vector<std::vector<uint8_t>> mSlots;
+        std::vector<size_t> mSlotSize;
+
+        // free slot stack
+        std::vector<size_t> mFree;
+
+        // circular queue of filled slots, oldest first
+        std::vector<size_t> mQueue;
+        size_t mQueueHead {0};
+        size_t mQueueCount {0};
+
+        size_t mWriteSlot {0};
+        size_t mReadSlot {0};
+        bool mReading {false};
+        bool mStopped {false};
+
+        std::atomic<Policy> mPolicy {DROP_OLDEST};
+        std::atomic<uint64_t> mDropped {0};
+
+        mutable std::mutex mMutex;
+        std::condition_variable mCondition;
+};
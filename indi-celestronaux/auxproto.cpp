@@ -24,6 +24,9 @@
 #include "auxproto.h"
 
 #include <indilogger.h>
+
+#include <algorithm>
+#include <chrono>
 #include <math.h>
 #include <string.h>
 #include <unistd.h>
@@ -38,6 +41,12 @@ int MAX_CMD_LEN = 32;
 
 uint8_t AUXCommand::DEBUG_LEVEL = 0;
 char AUXCommand::DEVICE_NAME[64] = {0};
+bool AUXCommand::DEBUG_ENABLED = false;
+
+const size_t AUXFramer::MAX_PACKET;
+const size_t AUXFramer::CAPACITY;
+const size_t AUXMultiplexer::MAX_REQUESTS;
+
 //////////////////////////////////////////////////
 /////// Utility functions
 //////////////////////////////////////////////////
@@ -47,6 +56,9 @@ char AUXCommand::DEVICE_NAME[64] = {0};
 /////////////////////////////////////////////////////////////////////////////////////
 void logBytes(unsigned char *buf, int n, const char *deviceName, uint32_t debugLevel)
 {
+    if (!AUXCommand::DEBUG_ENABLED)
+        return;
+
     char hex_buffer[BUFFER_SIZE] = {0};
     for (int i = 0; i < n; i++)
         sprintf(hex_buffer + 3 * i, "%02X ", buf[i]);
@@ -62,6 +74,9 @@ void logBytes(unsigned char *buf, int n, const char *deviceName, uint32_t debugL
 /////////////////////////////////////////////////////////////////////////////////////
 void AUXCommand::logResponse()
 {
+    if (!DEBUG_ENABLED)
+        return;
+
     char hex_buffer[BUFFER_SIZE] = {0}, part1[BUFFER_SIZE] = {0}, part2[BUFFER_SIZE] = {0}, part3[BUFFER_SIZE] = {0};
     for (size_t i = 0; i < m_Data.size(); i++)
         sprintf(hex_buffer + 3 * i, "%02X ", m_Data[i]);
@@ -99,6 +114,9 @@ void AUXCommand::logResponse()
 /////////////////////////////////////////////////////////////////////////////////////
 void AUXCommand::logCommand()
 {
+    if (!DEBUG_ENABLED)
+        return;
+
     char hex_buffer[BUFFER_SIZE] = {0}, part1[BUFFER_SIZE] = {0}, part2[BUFFER_SIZE] = {0}, part3[BUFFER_SIZE] = {0};
     for (size_t i = 0; i < m_Data.size(); i++)
         sprintf(hex_buffer + 3 * i, "%02X ", m_Data[i]);
@@ -139,6 +157,14 @@ void AUXCommand::setDebugInfo(const char *deviceName, uint8_t debugLevel)
     strncpy(DEVICE_NAME, deviceName, 64);
     DEBUG_LEVEL = debugLevel;
 }
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+void AUXCommand::setDebugEnabled(bool enabled)
+{
+    DEBUG_ENABLED = enabled;
+}
 ////////////////////////////////////////////////
 //////  AUXCommand class
 ////////////////////////////////////////////////
@@ -365,7 +391,7 @@ void AUXCommand::fillBuf(AUXBuffer &buf)
     {
         buf[i + 5] = m_Data[i];
     }
-    buf.back() = checksum(buf);
+    buf.back() = checksum(buf.data());
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -400,10 +426,44 @@ void AUXCommand::parseBuf(AUXBuffer buf, bool do_checksum)
         m_Data  = AUXBuffer(buf.begin() + 5, buf.end());
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+void AUXCommand::parseBuf(const uint8_t *buf, size_t size, bool do_checksum)
+{
+    len           = buf[1];
+    m_Source      = (AUXTargets)buf[2];
+    m_Destination = (AUXTargets)buf[3];
+    m_Command     = (AUXCommands)buf[4];
+    // The data buffer keeps its capacity, no allocation for usual packets
+    if (do_checksum)
+    {
+        m_Data.assign(buf + 5, buf + size - 1);
+        valid = (checksum(buf) == buf[size - 1]);
+        if (valid == false)
+        {
+            DEBUGFDEVICE(DEVICE_NAME, DEBUG_LEVEL, "Checksum error: %02x vs. %02x", checksum(buf), buf[size - 1]);
+        }
+    }
+    else
+    {
+        m_Data.assign(buf + 5, buf + size);
+        valid = true;
+    }
+}
+
 /////////////////////////////////////////////////////////////////////////////////////
 ///
 /////////////////////////////////////////////////////////////////////////////////////
 unsigned char AUXCommand::checksum(AUXBuffer buf)
+{
+    return checksum(buf.data());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+unsigned char AUXCommand::checksum(const uint8_t *buf)
 {
     int l  = buf[1];
     int cs = 0;
@@ -465,3 +525,206 @@ void AUXCommand::setData(uint32_t value, uint8_t bytes)
             break;
     }
 }
+
+////////////////////////////////////////////////
+//////  AUXFramer class
+////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+size_t AUXFramer::writable(uint8_t **ptr)
+{
+    size_t tail = (m_Head + m_Size) & (CAPACITY - 1);
+    *ptr = m_Ring + tail;
+    // Up to the end of the ring or to the head, whichever comes first
+    return std::min(CAPACITY - m_Size, CAPACITY - tail);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+void AUXFramer::commit(size_t n)
+{
+    m_Size += std::min(n, CAPACITY - m_Size);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+size_t AUXFramer::push(const uint8_t *data, size_t n)
+{
+    size_t copied = 0;
+    while (copied < n)
+    {
+        uint8_t *ptr;
+        size_t chunk = std::min(writable(&ptr), n - copied);
+        if (chunk == 0)
+            break;
+        memcpy(ptr, data + copied, chunk);
+        commit(chunk);
+        copied += chunk;
+    }
+    return copied;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+size_t AUXFramer::next(uint8_t *packet)
+{
+    for (;;)
+    {
+        // Look for the preamble
+        while (m_Size > 0 && peek(0) != 0x3b)
+        {
+            drop(1);
+            m_DroppedBytes++;
+        }
+
+        if (m_Size < 2)
+            return 0;
+
+        // Source, destination and command at least
+        size_t length = peek(1);
+        if (length < 3)
+        {
+            drop(1);
+            m_DroppedBytes++;
+            continue;
+        }
+
+        size_t size = length + 3;
+        if (m_Size < size)
+            return 0;
+
+        for (size_t i = 0; i < size; i++)
+            packet[i] = peek(i);
+
+        if (AUXCommand::checksum(packet) != packet[size - 1])
+        {
+            // Not a packet after all, or a corrupted one: resync after this preamble
+            drop(1);
+            m_DroppedBytes++;
+            m_ChecksumErrors++;
+            continue;
+        }
+
+        drop(size);
+        return size;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+void AUXFramer::clear()
+{
+    m_Head = 0;
+    m_Size = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+void AUXFramer::drop(size_t n)
+{
+    n = std::min(n, m_Size);
+    m_Head = (m_Head + n) & (CAPACITY - 1);
+    m_Size -= n;
+}
+
+////////////////////////////////////////////////
+//////  AUXMultiplexer class
+////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+AUXMultiplexer::AUXMultiplexer(AUXFramer &framer, Writer writer, Reader reader, Handler handler)
+    : m_Framer(framer), m_Writer(writer), m_Reader(reader), m_Handler(handler)
+{
+    m_Output.reserve(MAX_REQUESTS * 16);
+    m_Packet.reserve(AUXFramer::MAX_PACKET);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+bool AUXMultiplexer::add(AUXCommand &command)
+{
+    if (m_Count >= MAX_REQUESTS)
+        return false;
+
+    command.logCommand();
+    command.fillBuf(m_Packet);
+    m_Output.insert(m_Output.end(), m_Packet.begin(), m_Packet.end());
+
+    Request &request = m_Requests[m_Count++];
+    request.source      = command.source();
+    request.destination = command.destination();
+    request.command     = command.command();
+    request.replied     = false;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+bool AUXMultiplexer::run(int timeout)
+{
+    if (m_Count == 0)
+        return true;
+
+    if (!m_Writer(m_Output))
+        return false;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    size_t waiting = m_Count;
+    uint8_t packet[AUXFramer::MAX_PACKET];
+
+    while (waiting > 0)
+    {
+        int remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0)
+            break;
+
+        uint8_t *ptr;
+        size_t room = m_Framer.writable(&ptr);
+        int n = m_Reader(ptr, room, remaining);
+        if (n < 0)
+            break;
+        m_Framer.commit(n);
+
+        size_t size;
+        while ((size = m_Framer.next(packet)) > 0)
+        {
+            m_Response.parseBuf(packet, size);
+            m_Handler(m_Response);
+
+            // The reply comes from the device the request went to, and goes back to the requester
+            for (size_t i = 0; i < m_Count; i++)
+            {
+                Request &request = m_Requests[i];
+                if (!request.replied && m_Response.source() == request.destination &&
+                        m_Response.destination() == request.source && m_Response.command() == request.command)
+                {
+                    request.replied = true;
+                    waiting--;
+                    break;
+                }
+            }
+        }
+    }
+
+    return waiting == 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+void AUXMultiplexer::clear()
+{
+    m_Output.clear();
+    m_Count = 0;
+}
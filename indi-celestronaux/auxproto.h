@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include <functional>
 #include <vector>
 #include <stddef.h>
 #include <stdint.h>
@@ -98,6 +99,13 @@ class AUXCommand
         void fillBuf(AUXBuffer &buf);
         void parseBuf(AUXBuffer buf);
         void parseBuf(AUXBuffer buf, bool do_checksum);
+        /**
+         * @brief parseBuf Parse a complete packet in place, reusing the data buffer.
+         * @param buf Packet from the 0x3b preamble up to, and including, the checksum.
+         * @param size Packet size in bytes.
+         * @param do_checksum Verify the checksum, HC passthrough replies have none.
+         */
+        void parseBuf(const uint8_t *buf, size_t size, bool do_checksum = true);
 
         ///////////////////////////////////////////////////////////////////////////////
         /// Getters
@@ -142,6 +150,7 @@ class AUXCommand
         /// Check sum
         ///////////////////////////////////////////////////////////////////////////////
         uint8_t checksum(AUXBuffer buf);
+        static uint8_t checksum(const uint8_t *buf);
 
         ///////////////////////////////////////////////////////////////////////////////
         /// Logging
@@ -152,9 +161,12 @@ class AUXCommand
         void logResponse();
         void logCommand();
         static void setDebugInfo(const char *deviceName, uint8_t debugLevel);
+        static void setDebugEnabled(bool enabled);
 
         static uint8_t DEBUG_LEVEL;
         static char DEVICE_NAME[64];
+        // Packets are only formatted for the log while debugging is on
+        static bool DEBUG_ENABLED;
 
     private:
         uint8_t len {0};
@@ -167,3 +179,138 @@ class AUXCommand
 
 
 };
+
+/**
+ * @brief The AUXFramer class splits a byte stream into AUX packets.
+ *
+ * Bytes are added as they come, in chunks of any size, into a fixed ring: a read can go straight
+ * into it through writable() and commit(). next() returns the complete packets one by one.
+ * Bytes before a 0x3b preamble are skipped, and a packet with a bad checksum is dropped by
+ * looking for the next preamble after its own. Nothing is allocated.
+ */
+class AUXFramer
+{
+    public:
+        // 0x3b, length, length bytes (source, destination, command, data) and checksum
+        static const size_t MAX_PACKET = 3 + 255;
+
+        /**
+         * @brief writable Get the free space at the end of the ring.
+         * @param ptr Set to where the next bytes are to be written.
+         * @return Number of bytes that can be written at ptr, at least one after next() returned 0.
+         */
+        size_t writable(uint8_t **ptr);
+        /**
+         * @brief commit Add n bytes written at the pointer returned by writable().
+         */
+        void commit(size_t n);
+        /**
+         * @brief push Copy bytes into the ring.
+         * @return Number of bytes copied, less than n if the ring is full.
+         */
+        size_t push(const uint8_t *data, size_t n);
+        /**
+         * @brief next Extract the next complete packet.
+         * @param packet Receives the packet, must hold MAX_PACKET bytes.
+         * @return Packet size, 0 if there is no complete packet yet.
+         */
+        size_t next(uint8_t *packet);
+        void clear();
+
+        size_t pending() const
+        {
+            return m_Size;
+        }
+        uint32_t checksumErrors() const
+        {
+            return m_ChecksumErrors;
+        }
+        uint32_t droppedBytes() const
+        {
+            return m_DroppedBytes;
+        }
+
+    private:
+        static const size_t CAPACITY = 1024;
+
+        uint8_t peek(size_t i) const
+        {
+            return m_Ring[(m_Head + i) & (CAPACITY - 1)];
+        }
+        void drop(size_t n);
+
+        uint8_t m_Ring[CAPACITY];
+        size_t m_Head {0};
+        size_t m_Size {0};
+        uint32_t m_ChecksumErrors {0};
+        uint32_t m_DroppedBytes {0};
+};
+
+/**
+ * @brief The AUXMultiplexer class keeps several AUX requests in flight.
+ *
+ * The queued requests go out back to back in a single write, and the replies are matched to
+ * them by source and command in whatever order they come. Every packet read goes to the handler,
+ * replies, echoes and messages between other devices alike, just like single requests do.
+ * Only for links where the AUX bus is reached directly: the HC passthrough and the half-duplex
+ * PC port take one request at a time.
+ */
+class AUXMultiplexer
+{
+    public:
+        static const size_t MAX_REQUESTS = 8;
+
+        // Write the buffer, true if all of it was written
+        typedef std::function<bool(const AUXBuffer &buf)> Writer;
+        // Read up to size bytes, waiting at most timeout ms: bytes read, 0 if none, -1 on error
+        typedef std::function<int(uint8_t *buf, size_t size, int timeout)> Reader;
+        typedef std::function<void(AUXCommand &cmd)> Handler;
+
+        AUXMultiplexer(AUXFramer &framer, Writer writer, Reader reader, Handler handler);
+
+        /**
+         * @brief add Queue a request for the next run().
+         * @return False if MAX_REQUESTS are queued already.
+         */
+        bool add(AUXCommand &command);
+        /**
+         * @brief run Send the queued requests and wait for their replies.
+         * @param timeout Time to wait for all the replies in ms.
+         * @return True if every request got its reply.
+         */
+        bool run(int timeout);
+        /**
+         * @brief clear Drop the queued requests.
+         */
+        void clear();
+
+        size_t size() const
+        {
+            return m_Count;
+        }
+        bool replied(size_t i) const
+        {
+            return m_Requests[i].replied;
+        }
+
+    private:
+        struct Request
+        {
+            AUXTargets source;
+            AUXTargets destination;
+            AUXCommands command;
+            bool replied;
+        };
+
+        AUXFramer &m_Framer;
+        Writer m_Writer;
+        Reader m_Reader;
+        Handler m_Handler;
+
+        Request m_Requests[MAX_REQUESTS];
+        size_t m_Count {0};
+        // Queued packets, and the last response, reused from run to run
+        AUXBuffer m_Output;
+        AUXBuffer m_Packet;
+        AUXCommand m_Response;
+};
@@ -29,6 +29,7 @@
 #include <termios.h>
 #include <unistd.h>
 #include <arpa/inet.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <thread>
 #include <chrono>
@@ -61,7 +62,11 @@ double anglediff(double a, double b)
 CelestronAUX::CelestronAUX()
     : ScopeStatus(IDLE),
       DBG_CAUX(INDI::Logger::getInstance().addDebugLevel("AUX", "CAUX")),
-      DBG_SERIAL(INDI::Logger::getInstance().addDebugLevel("Serial", "CSER"))
+      DBG_SERIAL(INDI::Logger::getInstance().addDebugLevel("Serial", "CSER")),
+      m_Multiplexer(m_Framer,
+                    [this](const AUXBuffer & buf) { return writePipeline(buf); },
+                    [this](uint8_t *buf, size_t size, int timeout) { return readPipeline(buf, size, timeout); },
+                    [this](AUXCommand & m) { processResponse(m); })
 {
     setVersion(CAUX_VERSION_MAJOR, CAUX_VERSION_MINOR);
     SetTelescopeCapability(TELESCOPE_CAN_PARK |
@@ -95,6 +100,8 @@ bool CelestronAUX::Handshake()
     LOGF_DEBUG("CAUX: connect %d (%s)", PortFD, (getActiveConnection() == serialConnection) ? "serial" : "net");
     if (PortFD > 0)
     {
+        m_Framer.clear();
+
         if (getActiveConnection() == serialConnection)
         {
             if (PortTypeSP[PORT_AUX_PC].getState() == ISS_ON)
@@ -172,6 +179,15 @@ bool CelestronAUX::Disconnect()
     return INDI::Telescope::Disconnect();
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+void CelestronAUX::debugTriggered(bool enable)
+{
+    // Packets are formatted for the log only while debugging
+    AUXCommand::setDebugEnabled(enable);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////
 ///
 /////////////////////////////////////////////////////////////////////////////////////
@@ -1048,26 +1064,10 @@ bool CelestronAUX::ReadScopeStatus()
     if (!isConnected())
         return false;
 
-    if (!getStatus(AXIS_AZ))
-        return false;
-    if (!getStatus(AXIS_ALT))
-        return false;
-
     double axis1 = EncoderNP[AXIS_AZ].getValue();
     double axis2 = EncoderNP[AXIS_ALT].getValue();
 
-    if (!getEncoder(AXIS_AZ))
-    {
-        if (EncoderNP.getState() != IPS_ALERT)
-        {
-            EncoderNP.setState(IPS_ALERT);
-            AngleNP.setState(IPS_ALERT);
-            EncoderNP.apply();
-            AngleNP.apply();
-        }
-        return false;
-    }
-    if (!getEncoder(AXIS_ALT))
+    if (!getAxes(true))
     {
         if (EncoderNP.getState() != IPS_ALERT)
         {
@@ -1332,9 +1332,7 @@ bool CelestronAUX::Goto(double ra, double dec)
 bool CelestronAUX::Sync(double ra, double dec)
 {
     // Compute a telescope direction vector from the current encoders
-    if (!getEncoder(AXIS_AZ))
-        return false;
-    if (!getEncoder(AXIS_ALT))
+    if (!getAxes(false))
         return false;
 
 
@@ -2197,6 +2195,39 @@ bool CelestronAUX::getEncoder(INDI_HO_AXIS axis)
     return true;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+bool CelestronAUX::getAxes(bool status)
+{
+    if (!canPipeline())
+    {
+        if (status && !(getStatus(AXIS_AZ) && getStatus(AXIS_ALT)))
+            return false;
+        return getEncoder(AXIS_AZ) && getEncoder(AXIS_ALT);
+    }
+
+    m_Multiplexer.clear();
+    for (INDI_HO_AXIS axis : {AXIS_AZ, AXIS_ALT})
+    {
+        AUXTargets target = (axis == AXIS_AZ) ? AZM : ALT;
+        if (status && m_AxisStatus[axis] == SLEWING && ScopeStatus != SLEWING_MANUAL)
+        {
+            AUXCommand command(MC_SLEW_DONE, APP, target);
+            m_Multiplexer.add(command);
+        }
+        AUXCommand command(MC_GET_POSITION, APP, target);
+        m_Multiplexer.add(command);
+    }
+
+    if (!m_Multiplexer.run(PIPELINE_TIMEOUT))
+    {
+        LOG_DEBUG("Not all replies to the status poll came in.");
+        return false;
+    }
+    return true;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////
 /// This is simple GPS emulation for HC.
 /// If HC asks for the GPS we reply with data from our GPS/Site info.
@@ -2462,12 +2493,12 @@ bool CelestronAUX::processResponse(AUXCommand &m)
 /////////////////////////////////////////////////////////////////////////////////////
 ///
 /////////////////////////////////////////////////////////////////////////////////////
-bool CelestronAUX::serialReadResponse(AUXCommand c)
+bool CelestronAUX::serialReadResponse(const AUXCommand &c)
 {
     int n;
-    unsigned char buf[32];
-    char hexbuf[24];
-    AUXCommand cmd;
+    uint8_t buf[AUXFramer::MAX_PACKET];
+    char hexbuf[AUXFramer::MAX_PACKET * 3 + 1];
+    size_t size;
 
     // We are not connected. Nothing to do.
     if ( PortFD <= 0 )
@@ -2476,30 +2507,29 @@ bool CelestronAUX::serialReadResponse(AUXCommand c)
     if (m_IsRTSCTS || !m_isHandController)
     {
         // if connected to AUX or PC ports, receive AUX command response.
-        // search for packet preamble (0x3b)
-        do
+        // Read whatever the port has, at least one byte, until the framer finds a whole packet.
+        while ((size = nextPacket(buf)) == 0)
         {
-            if (aux_tty_read((char*)buf, 1, READ_TIMEOUT, &n) != TTY_OK)
+            int available = 0;
+            if (ioctl(PortFD, FIONREAD, &available) == -1 || available < 1)
+                available = 1;
+
+            uint8_t *ptr;
+            size_t room = m_Framer.writable(&ptr);
+            if (aux_tty_read(reinterpret_cast<char *>(ptr), std::min<size_t>(available, room), READ_TIMEOUT, &n) != TTY_OK)
+            {
+                LOG_DEBUG("Did not got whole packet. Dropping out.");
                 return false;
+            }
+            m_Framer.commit(n);
         }
-        while (buf[0] != 0x3b);
 
-        // packet preamble is found, now read packet length.
-        if (aux_tty_read((char*)(buf + 1), 1, READ_TIMEOUT, &n) != TTY_OK)
-            return false;
-
-        // now packet length is known, read the rest of the packet.
-        if (aux_tty_read((char*)(buf + 2), buf[1] + 1, READ_TIMEOUT, &n)
-                != TTY_OK || n != buf[1] + 1)
+        if (isDebug())
         {
-            LOG_DEBUG("Did not got whole packet. Dropping out.");
-            return false;
+            hex_dump(hexbuf, buf, size);
+            DEBUGF(DBG_SERIAL, "RES <%s>", hexbuf);
         }
-
-        AUXBuffer b(buf, buf + (n + 2));
-        hex_dump(hexbuf, b, b.size());
-        DEBUGF(DBG_SERIAL, "RES <%s>", hexbuf);
-        cmd.parseBuf(b);
+        m_Response.parseBuf(buf, size);
     }
     else
     {
@@ -2514,8 +2544,7 @@ bool CelestronAUX::serialReadResponse(AUXCommand c)
         if (buf[response_data_size + 5] != '#')
         {
             LOGF_ERROR("Resp. char %d is %2.2x ascii %c", n, buf[n + 5], (char)buf[n + 5]);
-            AUXBuffer b(buf, buf + (response_data_size + 5));
-            hex_dump(hexbuf, b, b.size());
+            hex_dump(hexbuf, buf, response_data_size + 5);
             LOGF_ERROR("RES <%s>", hexbuf);
             return false;
         }
@@ -2526,20 +2555,16 @@ bool CelestronAUX::serialReadResponse(AUXCommand c)
         buf[3] = c.source();
         buf[4] = c.command();
 
-        AUXBuffer b(buf, buf + (response_data_size + 5));
-        hex_dump(hexbuf, b, b.size());
-        DEBUGF(DBG_SERIAL, "RES (%d B): <%s>", (int)b.size(), hexbuf);
-        cmd.parseBuf(b, false);
+        size = response_data_size + 5;
+        if (isDebug())
+        {
+            hex_dump(hexbuf, buf, size);
+            DEBUGF(DBG_SERIAL, "RES (%d B): <%s>", (int)size, hexbuf);
+        }
+        m_Response.parseBuf(buf, size, false);
     }
 
-    // Got the packet, process it
-    // n:length field >=3
-    // The buffer of n+2>=5 bytes contains:
-    // 0x3b <n>=3> <from> <to> <type> <n-3 bytes> <xsum>
-
-    DEBUGF(DBG_SERIAL, "Got %d bytes:  ; payload length field: %d ; MSG:", n, buf[1]);
-    logBytes(buf, n + 2, getDeviceName(), DBG_SERIAL);
-    processResponse(cmd);
+    processResponse(m_Response);
     return true;
 }
 
@@ -2548,9 +2573,9 @@ bool CelestronAUX::serialReadResponse(AUXCommand c)
 /////////////////////////////////////////////////////////////////////////////////////
 bool CelestronAUX::tcpReadResponse()
 {
-    int n, i;
-    unsigned char buf[BUFFER_SIZE] = {0};
-    AUXCommand cmd;
+    int n;
+    uint8_t buf[AUXFramer::MAX_PACKET];
+    size_t size;
 
     // We are not connected. Nothing to do.
     if ( PortFD <= 0 )
@@ -2561,59 +2586,52 @@ bool CelestronAUX::tcpReadResponse()
     tv.tv_usec = 50000;
     setsockopt(PortFD, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(struct timeval));
 
-    // Drain the channel
-    while ((n = recv(PortFD, buf, sizeof(buf), MSG_DONTWAIT | MSG_PEEK)) > 0)
+    // Drain the channel. A partial packet stays in the framer until the rest comes in.
+    for (;;)
     {
-        //        DEBUGF(DBG_CAUX, "Got %d bytes: ", n);
-        //        for (i = 0; i < n; i++)
-        //            IDLog("%02x ", buf[i]);
+        uint8_t *ptr;
+        size_t room = m_Framer.writable(&ptr);
+        if ((n = recv(PortFD, ptr, room, MSG_DONTWAIT)) <= 0)
+            break;
+        m_Framer.commit(n);
 
-        for (i = 0; i < n;)
+        while ((size = nextPacket(buf)) > 0)
         {
-            if (buf[i] == 0x3b)
+            if (isDebug())
             {
-                int shft;
-                shft = i + buf[i + 1] + 3;
-                if (shft <= n)
-                {
-                    AUXBuffer b(buf + i, buf + shft);
-                    cmd.parseBuf(b);
-
-                    char hexbuf[32 * 3] = {0};
-                    hex_dump(hexbuf, b, b.size());
-                    DEBUGF(DBG_SERIAL, "RES <%s>", hexbuf);
-
-                    processResponse(cmd);
-                }
-                else
-                {
-                    DEBUGF(DBG_SERIAL, "Partial message recv. dropping (i=%d %d/%d)", i, shft, n);
-                    logBytes(buf + i, n - i, getDeviceName(), DBG_SERIAL);
-                    recv(PortFD, buf, n, MSG_DONTWAIT);
-                    break;
-                }
-                i = shft;
-            }
-            else
-            {
-                i++;
+                char hexbuf[AUXFramer::MAX_PACKET * 3 + 1];
+                hex_dump(hexbuf, buf, size);
+                DEBUGF(DBG_SERIAL, "RES <%s>", hexbuf);
             }
-        }
-        // Actually consume data we parsed. Leave the rest for later.
-        if (i > 0)
-        {
-            n = recv(PortFD, buf, i, MSG_DONTWAIT);
-            //DEBUGF(DBG_CAUX, "Consumed %d/%d bytes", n, i);
+            m_Response.parseBuf(buf, size);
+            processResponse(m_Response);
         }
     }
     return true;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+size_t CelestronAUX::nextPacket(uint8_t *packet)
+{
+    size_t size = m_Framer.next(packet);
+
+    if (m_Framer.checksumErrors() != m_ChecksumErrors)
+    {
+        DEBUGF(DBG_SERIAL, "Skipped %u invalid packet(s), %u bytes dropped so far.", m_Framer.checksumErrors() - m_ChecksumErrors,
+               m_Framer.droppedBytes());
+        m_ChecksumErrors = m_Framer.checksumErrors();
+    }
+
+    return size;
+}
+
 
 /////////////////////////////////////////////////////////////////////////////////////
 ///
 /////////////////////////////////////////////////////////////////////////////////////
-bool CelestronAUX::readAUXResponse(AUXCommand c)
+bool CelestronAUX::readAUXResponse(const AUXCommand &c)
 {
     if (getActiveConnection() == serialConnection)
         return serialReadResponse(c);
@@ -2624,7 +2642,7 @@ bool CelestronAUX::readAUXResponse(AUXCommand c)
 /////////////////////////////////////////////////////////////////////////////////////
 ///
 /////////////////////////////////////////////////////////////////////////////////////
-int CelestronAUX::sendBuffer(AUXBuffer buf)
+int CelestronAUX::sendBuffer(const AUXBuffer &buf)
 {
     if ( PortFD > 0 )
     {
@@ -2639,9 +2657,12 @@ int CelestronAUX::sendBuffer(AUXBuffer buf)
         if ((unsigned)n != buf.size())
             LOGF_WARN("sendBuffer: incomplete send n=%d size=%d", n, (int)buf.size());
 
-        char hexbuf[32 * 3] = {0};
-        hex_dump(hexbuf, buf, buf.size());
-        DEBUGF(DBG_SERIAL, "CMD <%s>", hexbuf);
+        if (isDebug())
+        {
+            char hexbuf[AUXFramer::MAX_PACKET * 3 + 1] = {0};
+            hex_dump(hexbuf, buf.data(), std::min(buf.size(), AUXFramer::MAX_PACKET));
+            DEBUGF(DBG_SERIAL, "CMD <%s>", hexbuf);
+        }
 
         return n;
     }
@@ -2649,6 +2670,73 @@ int CelestronAUX::sendBuffer(AUXBuffer buf)
         return 0;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+/// Requests can be pipelined where the AUX bus is reached directly: the network and
+/// the USB or AUX port. The HC passthrough takes one command at a time, and the PC
+/// port is half duplex.
+/////////////////////////////////////////////////////////////////////////////////////
+bool CelestronAUX::canPipeline()
+{
+    if (getActiveConnection() != serialConnection)
+        return true;
+    return !m_IsRTSCTS && !m_isHandController;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+bool CelestronAUX::writePipeline(const AUXBuffer &buf)
+{
+    int n;
+
+    if (PortFD <= 0)
+        return false;
+
+    if (getActiveConnection() == serialConnection)
+    {
+        m_Framer.clear();
+        tcflush(PortFD, TCIOFLUSH);
+    }
+
+    // No delay after writing, the replies are waited for
+    if (aux_tty_write((char*)buf.data(), buf.size(), CTS_TIMEOUT, &n) != TTY_OK)
+        return false;
+
+    if (isDebug())
+    {
+        char hexbuf[AUXFramer::MAX_PACKET * 3 + 1] = {0};
+        hex_dump(hexbuf, buf.data(), std::min(buf.size(), AUXFramer::MAX_PACKET));
+        DEBUGF(DBG_SERIAL, "CMD <%s>", hexbuf);
+    }
+
+    return (unsigned)n == buf.size();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+int CelestronAUX::readPipeline(uint8_t *buf, size_t size, int timeout)
+{
+    if (PortFD <= 0)
+        return -1;
+
+    struct pollfd pfd;
+    pfd.fd = PortFD;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int rc = poll(&pfd, 1, timeout);
+    if (rc < 0)
+        return (errno == EINTR) ? 0 : -1;
+    if (rc == 0)
+        return 0;
+
+    ssize_t n = read(PortFD, buf, size);
+    if (n < 0)
+        return (errno == EINTR || errno == EAGAIN) ? 0 : -1;
+    return static_cast<int>(n);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////
 ///
 /////////////////////////////////////////////////////////////////////////////////////
@@ -2681,6 +2769,9 @@ bool CelestronAUX::sendAUXCommand(AUXCommand &command)
         buf[7] = response_data_size = command.responseDataSize();
     }
 
+    // Whatever is left over from before belongs to no response of this command
+    if (getActiveConnection() == serialConnection)
+        m_Framer.clear();
     tcflush(PortFD, TCIOFLUSH);
     return (sendBuffer(buf) == static_cast<int>(buf.size()));
 }
@@ -2896,7 +2987,7 @@ bool CelestronAUX::tty_set_speed(speed_t speed)
 /////////////////////////////////////////////////////////////////////////////////////
 ///
 /////////////////////////////////////////////////////////////////////////////////////
-void CelestronAUX::hex_dump(char *buf, AUXBuffer data, size_t size)
+void CelestronAUX::hex_dump(char *buf, const uint8_t *data, size_t size)
 {
     for (size_t i = 0; i < size; i++)
         sprintf(buf + 3 * i, "%02X ", data[i]);
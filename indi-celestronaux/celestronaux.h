@@ -104,6 +104,7 @@ class CelestronAUX :
         virtual bool saveConfigItems(FILE *fp) override;
         virtual bool Handshake() override;
         virtual bool Disconnect() override;
+        virtual void debugTriggered(bool enable) override;
 
         virtual const char *getDefaultName() override;
         INDI::IHorizontalCoordinates AltAzFromRaDec(double ra, double dec, double ts);
@@ -191,6 +192,11 @@ class CelestronAUX :
 
         bool getStatus(INDI_HO_AXIS axis);
         bool getEncoder(INDI_HO_AXIS axis);
+        /**
+         * @brief getAxes Read the encoders of both axes, and their slew status if slewing.
+         * @note Both motor controllers are asked at once when the link allows it.
+         */
+        bool getAxes(bool status);
 
         /////////////////////////////////////////////////////////////////////////////////////
         /// Coord Wrap
@@ -211,7 +217,7 @@ class CelestronAUX :
         }
         bool getVersion(AUXTargets target);
         void getVersions();
-        void hex_dump(char *buf, AUXBuffer data, size_t size);
+        void hex_dump(char *buf, const uint8_t *data, size_t size);
 
 
         double AzimuthToDegrees(double degree);
@@ -276,11 +282,15 @@ class CelestronAUX :
         bool sendAUXCommand(AUXCommand &command);
         void closeConnection();
         void emulateGPS(AUXCommand &m);
-        bool serialReadResponse(AUXCommand c);
+        bool serialReadResponse(const AUXCommand &c);
         bool tcpReadResponse();
-        bool readAUXResponse(AUXCommand c);
+        bool readAUXResponse(const AUXCommand &c);
         bool processResponse(AUXCommand &cmd);
-        int sendBuffer(AUXBuffer buf);
+        size_t nextPacket(uint8_t *packet);
+        int sendBuffer(const AUXBuffer &buf);
+        bool canPipeline();
+        bool writePipeline(const AUXBuffer &buf);
+        int readPipeline(uint8_t *buf, size_t size, int timeout);
         void formatVersionString(char *s, int n, uint8_t *verBuf);
 
         // GPS Emulation
@@ -324,6 +334,12 @@ class CelestronAUX :
         bool m_IsRTSCTS {false};
         bool m_isHandController {false};
 
+        // Incoming bytes, and the last response parsed from them
+        AUXFramer m_Framer;
+        AUXCommand m_Response;
+        uint32_t m_ChecksumErrors {0};
+        AUXMultiplexer m_Multiplexer;
+
         ///////////////////////////////////////////////////////////////////////////////
         /// Celestron AUX Properties
         ///////////////////////////////////////////////////////////////////////////////
@@ -430,6 +446,8 @@ class CelestronAUX :
         static constexpr uint8_t READ_TIMEOUT {1};
         // ms
         static constexpr uint8_t CTS_TIMEOUT {100};
+        // ms, for all the replies of pipelined requests
+        static constexpr uint16_t PIPELINE_TIMEOUT {1000};
         // Coord Wrap
         static constexpr const char *CORDWRAP_TAB {"Coord Wrap"};
         static constexpr const char *MOUNTINFO_TAB {"Mount Info"};
@@ -0,0 +1,291 @@
+/*
+    C++ port of the NexStarScope class of nse_telescope.py, for the unit tests.
+
+    Only the scope itself and the commands the driver sends, no curses display
+    and no WiFly command mode. Positions are fractions of a revolution like in
+    the python version, and handleMsg() answers a message the same way: each
+    command is echoed, followed by the reply of the addressed device if it
+    knows the command.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+class NexStarScope
+{
+    public:
+        typedef std::vector<uint8_t> Bytes;
+
+        static const uint8_t MC_AZM = 0x10;
+        static const uint8_t MC_ALT = 0x11;
+
+        explicit NexStarScope(double ALT = 0.0, double AZM = 0.0) : alt(ALT), azm(fmod1(AZM)), trg_alt(ALT), trg_azm(fmod1(AZM))
+        {
+        }
+
+        static uint8_t makeChecksum(const uint8_t *data, size_t size)
+        {
+            int cs = 0;
+            for (size_t i = 0; i < size; i++)
+                cs += data[i];
+            return static_cast<uint8_t>((~cs + 1) & 0xFF);
+        }
+
+        static double unpackInt3(const Bytes &d)
+        {
+            if (d.size() < 3)
+                return 0;
+            return ((d[0] << 16) | (d[1] << 8) | d[2]) / 16777216.0;
+        }
+
+        static Bytes packInt3(double f)
+        {
+            uint32_t v = static_cast<uint32_t>(static_cast<int32_t>(f * 16777216.0));
+            return Bytes { static_cast<uint8_t>(v >> 16), static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v) };
+        }
+
+        // React to a message, may hold several commands
+        Bytes handleMsg(const Bytes &msg)
+        {
+            Bytes resp;
+            // Commands start with ';' (0x3b) followed by their length, like split_cmds()
+            for (size_t p = 0; p + 1 < msg.size();)
+            {
+                if (msg[p] != 0x3b)
+                {
+                    p++;
+                    continue;
+                }
+                size_t end = p + msg[p + 1] + 3;
+                if (end > msg.size())
+                    break;
+                Bytes r = handleCmd(Bytes(msg.begin() + p + 1, msg.begin() + end));
+                resp.insert(resp.end(), r.begin(), r.end());
+                p = end;
+            }
+            return resp;
+        }
+
+        void tick(double interval)
+        {
+            double eps = 1e-6;
+            double maxrate = 5.0 / 360;
+            if (last_cmd == GOTO_FAST)
+                eps *= 100;
+
+            alt += (alt_rate + alt_guiderate) * interval;
+            azm = fmod1(azm + (azm_rate + azm_guiderate) * interval);
+            if (slewing && go)
+            {
+                // AZM
+                double r = trg_azm - azm;
+                if (std::fabs(r) > 0.5)
+                    r = -r;
+                double s = r > 0 ? 1 : -1;
+                double mr = std::min(maxrate, std::fabs(azm_rate));
+                if (mr * interval > std::fabs(r))
+                    mr /= 2;
+                azm_rate = s * mr;
+
+                // ALT
+                r = trg_alt - alt;
+                s = r > 0 ? 1 : -1;
+                mr = std::min(maxrate, std::fabs(alt_rate));
+                if (mr * interval > std::fabs(r))
+                    mr /= 2;
+                alt_rate = s * mr;
+            }
+
+            if (std::fabs(azm_rate) < eps && std::fabs(alt_rate) < eps)
+            {
+                slewing = false;
+                go = false;
+            }
+            if (std::fabs(azm_rate) < eps)
+                azm_rate = 0;
+            if (std::fabs(alt_rate) < eps)
+                alt_rate = 0;
+        }
+
+        double alt, azm;
+        double trg_alt, trg_azm;
+        double alt_rate {0}, azm_rate {0};
+        double alt_guiderate {0}, azm_guiderate {0};
+        bool slewing {false};
+        bool go {false};
+        bool cordwrap {false};
+        double cordwrap_pos {0};
+        // Commands that got a reply, echoes left out
+        int replies {0};
+
+    private:
+        enum LastCommand { NONE, GOTO_FAST, GOTO_SLOW, MOVE };
+
+        static double fmod1(double f)
+        {
+            f = std::fmod(f, 1.0);
+            return f < 0 ? f + 1.0 : f;
+        }
+
+        // cmd is the command without the leading ';': len, from, to, command, data, checksum
+        Bytes handleCmd(const Bytes &cmd)
+        {
+            if (cmd.size() < 5 || makeChecksum(cmd.data(), cmd.size() - 1) != cmd.back())
+                return Bytes();
+
+            uint8_t f = cmd[1], t = cmd[2], c = cmd[3];
+            Bytes d(cmd.begin() + 4, cmd.end() - 1);
+
+            Bytes resp { 0x3b };
+            resp.insert(resp.end(), cmd.begin(), cmd.end());
+
+            Bytes r;
+            bool known = (t == MC_AZM || t == MC_ALT) ? mcCommand(c, d, t, r) : otherCommand(c, t, r);
+            if (known)
+            {
+                Bytes packet { static_cast<uint8_t>(r.size() + 3), t, f, c };
+                packet.insert(packet.end(), r.begin(), r.end());
+                resp.push_back(0x3b);
+                resp.insert(resp.end(), packet.begin(), packet.end());
+                resp.push_back(makeChecksum(packet.data(), packet.size()));
+                replies++;
+            }
+            return resp;
+        }
+
+        bool mcCommand(uint8_t c, const Bytes &d, uint8_t rcv, Bytes &r)
+        {
+            switch (c)
+            {
+                case 0x01: // MC_GET_POSITION
+                    r = packInt3(rcv == MC_ALT ? alt : azm);
+                    return true;
+                case 0x02: // MC_GOTO_FAST
+                    gotoFast(d, rcv);
+                    return true;
+                case 0x04: // MC_SET_POSITION
+                case 0x0b: // MC_LEVEL_START
+                case 0x19: // MC_SEEK_INDEX
+                    return true;
+                case 0x06: // MC_SET_POS_GUIDERATE
+                case 0x07: // MC_SET_NEG_GUIDERATE
+                {
+                    // The 1.1 factor is experimental to fit the actual hardware
+                    double a = 1.1 * (16777216.0 / 1000 / 360 / 60 / 60) * unpackInt3(d);
+                    (rcv == MC_ALT ? alt_guiderate : azm_guiderate) = (c == 0x06) ? a : -a;
+                    return true;
+                }
+                case 0x13: // MC_SLEW_DONE
+                    r = Bytes { static_cast<uint8_t>((rcv == MC_ALT ? alt_rate : azm_rate) != 0 ? 0x00 : 0xff) };
+                    return true;
+                case 0x17: // MC_GOTO_SLOW
+                    gotoSlow(d, rcv);
+                    return true;
+                case 0x18: // MC_AT_INDEX
+                    r = Bytes { 0x00 };
+                    return true;
+                case 0x24: // MC_MOVE_POS
+                case 0x25: // MC_MOVE_NEG
+                {
+                    static const double RATES[] = { 0, 1. / (360 * 60), 2. / (360 * 60), 5. / (360 * 60), 15. / (360 * 60),
+                                                    30. / (360 * 60), 1. / 360, 2. / 360, 5. / 360, 10. / 360
+                                                  };
+                    last_cmd = MOVE;
+                    slewing = true;
+                    go = false;
+                    double rate = (!d.empty() && d[0] < 10) ? RATES[d[0]] : 0;
+                    (rcv == MC_ALT ? alt_rate : azm_rate) = (c == 0x24) ? rate : -rate;
+                    return true;
+                }
+                case 0x38: // MC_ENABLE_CORDWRAP
+                    cordwrap = true;
+                    return true;
+                case 0x39: // MC_DISABLE_CORDWRAP
+                    cordwrap = false;
+                    return true;
+                case 0x3a: // MC_SET_CORDWRAP_POS
+                    cordwrap_pos = unpackInt3(d);
+                    return true;
+                case 0x3b: // MC_POLL_CORDWRAP
+                    r = Bytes { static_cast<uint8_t>(cordwrap ? 0xff : 0x00) };
+                    return true;
+                case 0x3c: // MC_GET_CORDWRAP_POS
+                    r = packInt3(cordwrap_pos);
+                    return true;
+                case 0x47: // MC_GET_AUTOGUIDE_RATE
+                    r = Bytes { 0xf0 };
+                    return true;
+                case 0xfe: // GET_VER
+                    r = Bytes { 7, 11, 5100 / 256, 5100 % 256 };
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        bool otherCommand(uint8_t c, uint8_t rcv, Bytes &r)
+        {
+            if (c != 0xfe)
+                return false;
+            // GET_VER answers with an empty reply from devices without a version
+            if (rcv == 0x01)
+                r = Bytes { 1, 0, 0, 1 };
+            else if (rcv == 0x04 || rcv == 0x0d)
+                r = Bytes { 5, 28, 5300 / 256, 5300 % 256 };
+            return true;
+        }
+
+        void startGoto(LastCommand command)
+        {
+            last_cmd = command;
+            slewing = true;
+            go = true;
+            alt_guiderate = 0;
+            azm_guiderate = 0;
+        }
+
+        void gotoFast(const Bytes &d, uint8_t rcv)
+        {
+            startGoto(GOTO_FAST);
+            double r = 4000 / 360e3;
+            double a = unpackInt3(d);
+            if (rcv == MC_ALT)
+            {
+                trg_alt = a;
+                alt_rate = (a - alt < 0) ? -r : r;
+            }
+            else
+            {
+                trg_azm = fmod1(a);
+                if (trg_azm - azm < 0)
+                    r = -r;
+                if (std::fabs(trg_azm - azm) > 0.5)
+                    r = -r;
+                azm_rate = r;
+            }
+        }
+
+        void gotoSlow(const Bytes &d, uint8_t rcv)
+        {
+            startGoto(GOTO_SLOW);
+            double r = 0.2 / 360;
+            double a = unpackInt3(d);
+            if (rcv == MC_ALT)
+            {
+                trg_alt = a;
+                alt_rate = (alt < a) ? r : -r;
+            }
+            else
+            {
+                trg_azm = fmod1(a);
+                double f = std::fabs(azm - trg_azm) < 0.5 ? 1 : -1;
+                azm_rate = (azm < trg_azm) ? f * r : -f * r;
+            }
+        }
+
+        LastCommand last_cmd {NONE};
+};
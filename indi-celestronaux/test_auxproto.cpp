@@ -0,0 +1,345 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <deque>
+#include <random>
+
+#include "auxproto.h"
+#include "simulator/nse_telescope.h"
+
+// Traffic through the WiFi module, commands are echoed before the reply:
+// GET_VER to AZM, MC_GET_POSITION to ALT, MC_SLEW_DONE to AZM, MC_GOTO_FAST to AZM
+static const uint8_t capture[] =
+{
+    0x3b, 0x03, 0x20, 0x10, 0xfe, 0xcf,
+    0x3b, 0x07, 0x10, 0x20, 0xfe, 0x07, 0x11, 0x00, 0x00, 0xb3,
+    0x3b, 0x03, 0x20, 0x11, 0x01, 0xcb,
+    0x3b, 0x06, 0x11, 0x20, 0x01, 0x12, 0x34, 0x56, 0x2c,
+    0x3b, 0x03, 0x20, 0x10, 0x13, 0xba,
+    0x3b, 0x04, 0x10, 0x20, 0x13, 0xff, 0xba,
+    0x3b, 0x06, 0x20, 0x10, 0x02, 0x40, 0x00, 0x00, 0x88,
+    0x3b, 0x03, 0x10, 0x20, 0x02, 0xcb,
+};
+
+static const size_t captureSizes[] = { 6, 10, 6, 9, 6, 7, 9, 6 };
+
+// Feed the capture in chunks of random size, the way reads return it
+static std::vector<std::vector<uint8_t>> replay(AUXFramer &framer, const uint8_t *data, size_t size, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> chunk(1, 16);
+    std::vector<std::vector<uint8_t>> packets;
+    uint8_t packet[AUXFramer::MAX_PACKET];
+
+    for (size_t offset = 0; offset < size;)
+    {
+        uint8_t *ptr;
+        size_t n = std::min({chunk(rng), size - offset, framer.writable(&ptr)});
+        std::copy(data + offset, data + offset + n, ptr);
+        framer.commit(n);
+        offset += n;
+
+        size_t length;
+        while ((length = framer.next(packet)) > 0)
+            packets.emplace_back(packet, packet + length);
+    }
+    return packets;
+}
+
+TEST(CelestronAUX, framer_replay)
+{
+    for (unsigned seed = 0; seed < 100; seed++)
+    {
+        AUXFramer framer;
+        auto packets = replay(framer, capture, sizeof(capture), seed);
+
+        ASSERT_EQ(packets.size(), 8u);
+        const uint8_t *expected = capture;
+        for (size_t i = 0; i < packets.size(); i++)
+        {
+            ASSERT_EQ(packets[i].size(), captureSizes[i]);
+            EXPECT_TRUE(std::equal(packets[i].begin(), packets[i].end(), expected));
+            expected += captureSizes[i];
+        }
+        EXPECT_EQ(framer.pending(), 0u);
+        EXPECT_EQ(framer.droppedBytes(), 0u);
+        EXPECT_EQ(framer.checksumErrors(), 0u);
+    }
+}
+
+TEST(CelestronAUX, framer_parse)
+{
+    AUXFramer framer;
+    auto packets = replay(framer, capture, sizeof(capture), 1);
+    ASSERT_EQ(packets.size(), 8u);
+
+    AUXCommand cmd;
+    cmd.parseBuf(packets[1].data(), packets[1].size());
+    EXPECT_EQ(cmd.source(), AZM);
+    EXPECT_EQ(cmd.destination(), APP);
+    EXPECT_EQ(cmd.command(), GET_VER);
+    ASSERT_EQ(cmd.dataSize(), 4u);
+    EXPECT_EQ(cmd.data()[0], 7);
+    EXPECT_EQ(cmd.data()[1], 17);
+
+    cmd.parseBuf(packets[3].data(), packets[3].size());
+    EXPECT_EQ(cmd.source(), ALT);
+    EXPECT_EQ(cmd.command(), MC_GET_POSITION);
+    EXPECT_EQ(cmd.getData(), 0x123456u);
+
+    cmd.parseBuf(packets[7].data(), packets[7].size());
+    EXPECT_EQ(cmd.command(), MC_GOTO_FAST);
+    EXPECT_EQ(cmd.dataSize(), 0u);
+}
+
+TEST(CelestronAUX, framer_resync)
+{
+    // Line noise, a preamble with a short length and a corrupted position reply
+    std::vector<uint8_t> stream { 0x00, 0x45, 0x3b, 0x01 };
+    stream.insert(stream.end(), capture, capture + 22);
+    std::vector<uint8_t> corrupted(capture + 22, capture + 31);
+    corrupted[6] ^= 0x01;
+    stream.insert(stream.end(), corrupted.begin(), corrupted.end());
+    stream.insert(stream.end(), capture + 31, capture + sizeof(capture));
+
+    for (unsigned seed = 0; seed < 100; seed++)
+    {
+        AUXFramer framer;
+        auto packets = replay(framer, stream.data(), stream.size(), seed);
+
+        ASSERT_EQ(packets.size(), 7u);
+        EXPECT_EQ(packets[2].size(), 6u);
+        EXPECT_TRUE(std::equal(packets[3].begin(), packets[3].end(), capture + 31));
+        EXPECT_EQ(framer.checksumErrors(), 1u);
+        EXPECT_EQ(framer.droppedBytes(), 4u + corrupted.size());
+        EXPECT_EQ(framer.pending(), 0u);
+    }
+}
+
+TEST(CelestronAUX, framer_partial)
+{
+    AUXFramer framer;
+    uint8_t packet[AUXFramer::MAX_PACKET];
+
+    // A partial packet waits for the rest
+    EXPECT_EQ(framer.push(capture, 8), 8u);
+    EXPECT_EQ(framer.next(packet), 6u);
+    EXPECT_EQ(framer.next(packet), 0u);
+    EXPECT_EQ(framer.pending(), 2u);
+
+    EXPECT_EQ(framer.push(capture + 8, 8), 8u);
+    EXPECT_EQ(framer.next(packet), 10u);
+    EXPECT_EQ(packet[4], 0xfe);
+    EXPECT_EQ(framer.pending(), 0u);
+
+    framer.push(capture, 3);
+    framer.clear();
+    EXPECT_EQ(framer.pending(), 0u);
+    EXPECT_EQ(framer.next(packet), 0u);
+}
+
+TEST(CelestronAUX, framer_wrap)
+{
+    // Long sessions go round the ring many times
+    AUXFramer framer;
+    size_t count = 0;
+    for (unsigned seed = 0; seed < 200; seed++)
+        count += replay(framer, capture, sizeof(capture), seed).size();
+
+    EXPECT_EQ(count, 200u * 8);
+    EXPECT_EQ(framer.droppedBytes(), 0u);
+    EXPECT_EQ(framer.checksumErrors(), 0u);
+}
+
+// Link to the simulated scope with a fixed delay from a write to its replies, on a simulated clock
+struct SimulatedLink
+{
+    NexStarScope scope {0.1, 0.25};
+    double latency {20};
+    double clock {0};
+    bool reverse {false};
+    std::deque<std::pair<double, NexStarScope::Bytes>> inflight;
+
+    bool write(const AUXBuffer &buf)
+    {
+        NexStarScope::Bytes resp = scope.handleMsg(buf);
+        if (reverse)
+        {
+            // The devices answer in any order
+            AUXFramer framer;
+            uint8_t packet[AUXFramer::MAX_PACKET];
+            std::vector<NexStarScope::Bytes> packets;
+            size_t size;
+            framer.push(resp.data(), resp.size());
+            while ((size = framer.next(packet)) > 0)
+                packets.emplace_back(packet, packet + size);
+            resp.clear();
+            for (auto it = packets.rbegin(); it != packets.rend(); ++it)
+                resp.insert(resp.end(), it->begin(), it->end());
+        }
+        inflight.emplace_back(clock + latency, resp);
+        return true;
+    }
+
+    int read(uint8_t *buf, size_t size, int timeout)
+    {
+        if (inflight.empty() || inflight.front().first > clock + timeout)
+        {
+            clock += timeout;
+            return 0;
+        }
+
+        clock = std::max(clock, inflight.front().first);
+        NexStarScope::Bytes &data = inflight.front().second;
+        size_t n = std::min(size, data.size());
+        std::copy(data.begin(), data.begin() + n, buf);
+        data.erase(data.begin(), data.begin() + n);
+        if (data.empty())
+            inflight.pop_front();
+        return n;
+    }
+};
+
+struct Poller
+{
+    SimulatedLink link;
+    AUXFramer framer;
+    AUXMultiplexer mux;
+    uint32_t position[2] {0, 0};
+    uint8_t slewDone[2] {0, 0};
+    int packets {0};
+
+    Poller() : mux(framer,
+                       [this](const AUXBuffer & buf)
+    {
+        return link.write(buf);
+    },
+    [this](uint8_t *buf, size_t size, int timeout)
+    {
+        return link.read(buf, size, timeout);
+    },
+    [this](AUXCommand & m)
+    {
+        handle(m);
+    })
+    {
+    }
+
+    void handle(AUXCommand &m)
+    {
+        packets++;
+        if (m.destination() != APP || (m.source() != AZM && m.source() != ALT))
+            return;
+        int axis = m.source() == AZM ? 0 : 1;
+        if (m.command() == MC_GET_POSITION)
+            position[axis] = m.getData();
+        else if (m.command() == MC_SLEW_DONE)
+            slewDone[axis] = m.getData();
+    }
+
+    void add(AUXCommands command, AUXTargets target)
+    {
+        AUXCommand cmd(command, APP, target);
+        ASSERT_TRUE(mux.add(cmd));
+    }
+
+    uint32_t expected(double f)
+    {
+        return static_cast<uint32_t>(f * 16777216.0);
+    }
+};
+
+TEST(CelestronAUX, multiplexer_poll)
+{
+    Poller poller;
+    poller.add(MC_SLEW_DONE, AZM);
+    poller.add(MC_SLEW_DONE, ALT);
+    poller.add(MC_GET_POSITION, AZM);
+    poller.add(MC_GET_POSITION, ALT);
+
+    ASSERT_TRUE(poller.mux.run(1000));
+    for (size_t i = 0; i < poller.mux.size(); i++)
+        EXPECT_TRUE(poller.mux.replied(i));
+
+    EXPECT_EQ(poller.position[0], poller.expected(poller.link.scope.azm));
+    EXPECT_EQ(poller.position[1], poller.expected(poller.link.scope.alt));
+    EXPECT_EQ(poller.slewDone[0], 0xff);
+    EXPECT_EQ(poller.slewDone[1], 0xff);
+    // Echoes go to the handler too
+    EXPECT_EQ(poller.packets, 8);
+    // All in one round trip
+    EXPECT_DOUBLE_EQ(poller.link.clock, poller.link.latency);
+}
+
+TEST(CelestronAUX, multiplexer_pipelining)
+{
+    const AUXCommands commands[] = { MC_SLEW_DONE, MC_SLEW_DONE, MC_GET_POSITION, MC_GET_POSITION };
+    const AUXTargets targets[] = { AZM, ALT, AZM, ALT };
+
+    // One request at a time, the way the driver polled before
+    Poller sequential;
+    for (int i = 0; i < 4; i++)
+    {
+        sequential.mux.clear();
+        sequential.add(commands[i], targets[i]);
+        ASSERT_TRUE(sequential.mux.run(1000));
+    }
+
+    Poller pipelined;
+    for (int i = 0; i < 4; i++)
+        pipelined.add(commands[i], targets[i]);
+    ASSERT_TRUE(pipelined.mux.run(1000));
+
+    EXPECT_EQ(pipelined.position[0], sequential.position[0]);
+    EXPECT_EQ(pipelined.position[1], sequential.position[1]);
+    EXPECT_LE(pipelined.link.clock * 2, sequential.link.clock);
+}
+
+TEST(CelestronAUX, multiplexer_demux)
+{
+    // Replies in reverse order still go to the right requests, during a goto
+    Poller poller;
+    poller.link.reverse = true;
+
+    AUXCommand gotoAlt(MC_GOTO_FAST, APP, ALT);
+    gotoAlt.setData(poller.expected(0.2));
+    ASSERT_TRUE(poller.mux.add(gotoAlt));
+    ASSERT_TRUE(poller.mux.run(1000));
+    poller.link.scope.tick(0.5);
+
+    poller.mux.clear();
+    poller.add(MC_GET_POSITION, AZM);
+    poller.add(MC_GET_POSITION, ALT);
+    poller.add(MC_SLEW_DONE, AZM);
+    poller.add(MC_SLEW_DONE, ALT);
+    ASSERT_TRUE(poller.mux.run(1000));
+
+    EXPECT_EQ(poller.position[0], poller.expected(poller.link.scope.azm));
+    EXPECT_EQ(poller.position[1], poller.expected(poller.link.scope.alt));
+    EXPECT_NE(poller.position[0], poller.position[1]);
+    EXPECT_EQ(poller.slewDone[0], 0xff);
+    EXPECT_EQ(poller.slewDone[1], 0x00);
+}
+
+TEST(CelestronAUX, multiplexer_timeout)
+{
+    // The simulator does not answer MC_SET_AUTOGUIDE_RATE, only echoes it
+    Poller poller;
+    poller.add(MC_GET_POSITION, AZM);
+    poller.add(MC_SET_AUTOGUIDE_RATE, ALT);
+    poller.add(MC_GET_POSITION, ALT);
+
+    EXPECT_FALSE(poller.mux.run(20));
+    EXPECT_TRUE(poller.mux.replied(0));
+    EXPECT_FALSE(poller.mux.replied(1));
+    EXPECT_TRUE(poller.mux.replied(2));
+    EXPECT_EQ(poller.position[1], poller.expected(poller.link.scope.alt));
+
+    // Full queue
+    poller.mux.clear();
+    for (size_t i = 0; i < AUXMultiplexer::MAX_REQUESTS; i++)
+        poller.add(MC_GET_POSITION, AZM);
+    AUXCommand extra(MC_GET_POSITION, APP, ALT);
+    EXPECT_FALSE(poller.mux.add(extra));
+    EXPECT_TRUE(poller.mux.run(1000));
+}
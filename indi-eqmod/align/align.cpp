@@ -30,47 +30,9 @@ using namespace INDI;
     IDLog("Matrix %s:\n%g %g %g\n%g %g %g\n%g %g %g\n", name, in[0][0], in[0][1], in[0][2], in[1][0], in[1][1], \
           in[1][2], in[2][0], in[2][1], in[2][2])
 
-void inverse_matrix_3x3(double in[3][3], double out[3][3])
-{
-    double det;
-    double a, b, c, d, e, f, g, h, i;
-    a   = in[0][0];
-    b   = in[0][1];
-    c   = in[0][2];
-    d   = in[1][0];
-    e   = in[1][1];
-    f   = in[1][2];
-    g   = in[2][0];
-    h   = in[2][1];
-    i   = in[2][2];
-    det = (a * e * i) + (b * f * g) + (c * d * h) - (c * e * g) - (f * h * a) - (i * b * d);
-    /* if (abs(det) < 0.000001) {
-    IDLog("Align: Matrix determinant is lower than 0.000001 (%g)\n", det);
-    det=0.000001;
-    }*/
-    out[0][0] = (e * i - f * h) / det;
-    out[0][1] = (c * h - b * i) / det;
-    out[0][2] = (b * f - c * e) / det;
-    out[1][0] = (f * g - d * i) / det;
-    out[1][1] = (a * i - c * g) / det;
-    out[1][2] = (c * d - a * f) / det;
-    out[2][0] = (d * h - e * g) / det;
-    out[2][1] = (b * g - a * h) / det;
-    out[2][2] = (a * e - b * d) / det;
-}
-
-void mult_matrix_3x3(double in1[3][3], double in2[3][3], double out[3][3])
-{
-    for (int i = 0; i < 3; i++)
-    {
-        for (int j = 0; j < 3; j++)
-        {
-            out[i][j] = 0.0;
-            for (int k = 0; k < 3; k++)
-                out[i][j] += in1[i][k] * in2[k][j];
-        }
-    }
-}
+// Above this many sync points, the nearest one is searched in the HTM cells around the position first
+#define NEAREST_PREFILTER_POINTS 500
+#define NEAREST_PREFILTER_RADIUS (10.0 * M_PI / 180.0)
 
 // We declare an auto pointer to Align.
 //std::unique_ptr<Align> align(0);
@@ -190,11 +152,9 @@ void Align::AlignNStar(double jd, IGeographicCoordinates *position, double curre
     pointset->AltAzFromRaDec(currentRA, currentDEC, jd, &pointalt, &pointaz, position);
     //sortedpoints=pointset->ComputeDistances(pointalt, pointaz, PointSet::None, ingoto);
 
-    std::vector<HtmID> face;
-    face = pointset->findFace(currentRA, currentDEC, jd, pointalt, pointaz, position, ingoto);
+    const PointSet::FaceEntry *face = pointset->locateFace(pointalt, pointaz, ingoto);
 
-    //if (sortedpoints->size() < 2) {
-    if (face.size() < 3)
+    if (face == nullptr)
     {
         //IDLog("AlignNstar: only %d points in set - using Nearest mode\n", sortedpoints->size());
         AlignNearest(jd, position, currentRA, currentDEC, alignedRA, alignedDEC, ingoto);
@@ -202,96 +162,12 @@ void Align::AlignNStar(double jd, IGeographicCoordinates *position, double curre
     else
     {
         /* Taki's Algorithm (p33): http://www.geocities.jp/toshimi_taki/matrix/matrix_method_rev_e.pdf */
-        //std::set<PointSet::Distance>::iterator it = sortedpoints->begin();
-        //PointSet::Point *point = pointset->getPoint(it->htmID);
-        std::vector<HtmID>::iterator it = face.begin();
-        PointSet::Point *point          = pointset->getPoint(*it);
-        double celestialMatrix[3][3];
-        double invcelestialMatrix[3][3];
-        double telescopeMatrix[3][3];
-        double T[3][3];
-        double invT[3][3];
+        /* T and its inverse are computed once per face, see PointSet::buildFaceTable */
+        const double (&T)[3][3]    = face->T;
+        const double (&invT)[3][3] = face->invT;
         double l, m, n;
         double L, M, N;
-        //int max=(sortedpoints->size() == 2)?2:3;
-        int max = 3;
 
-        for (int i = 0; i < max; i++)
-        {
-            //IDLog("Align NStar: align point %d htm = %s, telescope alt=%g az=%g\n", i, point->htmname, point->telescopeALT, point->telescopeAZ);
-
-            celestialMatrix[0][i] =
-                cos(point->aligndata.targetDEC * M_PI / 180.0) *
-                cos(((range24(point->aligndata.targetRA - point->aligndata.lst) * 360) / 24.0) * M_PI /
-                    180.0);
-            celestialMatrix[1][i] =
-                cos(point->aligndata.targetDEC * M_PI / 180.0) *
-                sin(((range24(point->aligndata.targetRA - point->aligndata.lst) * 360) / 24.0) * M_PI /
-                    180.0);
-            celestialMatrix[2][i] = sin(point->aligndata.targetDEC * M_PI / 180.0);
-
-            /*
-            telescopeMatrix[0][i]=cos(point->aligndata.telescopeDEC * M_PI / 180.0) *
-            cos(((pointset->range24(point->aligndata.telescopeRA - point->aligndata.lst) * 360) / 24.0) * M_PI / 180.0);
-                 telescopeMatrix[1][i]=cos(point->aligndata.telescopeDEC * M_PI / 180.0) *
-            sin(((pointset->range24(point->aligndata.telescopeRA - point->aligndata.lst) * 360) / 24.0) * M_PI / 180.0);
-                 telescopeMatrix[2][i]=sin(point->aligndata.telescopeDEC * M_PI / 180.0);
-                 */
-            /*
-            celestialMatrix[0][i]=cos(point->celestialALT * M_PI / 180.0) *
-            cos(point->celestialAZ * M_PI / 180.0);
-                 celestialMatrix[1][i]=cos(point->celestialALT * M_PI / 180.0) *
-            sin(point->celestialAZ * M_PI / 180.0);
-                 celestialMatrix[2][i]=sin(point->celestialALT * M_PI / 180.0);
-                 */
-            telescopeMatrix[0][i] = cos(point->telescopeALT * M_PI / 180.0) *
-                                    cos(range360(-180.0 - point->telescopeAZ) * M_PI / 180.0);
-            telescopeMatrix[1][i] = cos(point->telescopeALT * M_PI / 180.0) *
-                                    sin(range360(-180.0 - point->telescopeAZ) * M_PI / 180.0);
-            telescopeMatrix[2][i] = sin(point->telescopeALT * M_PI / 180.0);
-            it++;
-            //point = pointset->getPoint(it->htmID);
-            point = pointset->getPoint(*it);
-        }
-
-        //if (sortedpoints->size() == 2) {
-        if (face.size() == 2)
-        {
-            /* compute vector product of the two points */
-            /* and insert it in the set */
-            double norm = 1.0;
-            celestialMatrix[0][2] =
-                celestialMatrix[1][0] * celestialMatrix[2][1] - celestialMatrix[2][0] * celestialMatrix[1][1];
-            celestialMatrix[1][2] =
-                celestialMatrix[2][0] * celestialMatrix[0][1] - celestialMatrix[0][0] * celestialMatrix[2][1];
-            celestialMatrix[2][2] =
-                celestialMatrix[0][0] * celestialMatrix[1][1] - celestialMatrix[1][0] * celestialMatrix[0][1];
-            norm = sqrt(celestialMatrix[0][2] * celestialMatrix[0][2] + celestialMatrix[1][2] * celestialMatrix[1][2] +
-                        celestialMatrix[2][2] * celestialMatrix[2][2]);
-            celestialMatrix[0][2] = celestialMatrix[0][2] / norm;
-            celestialMatrix[1][2] = celestialMatrix[1][2] / norm;
-            celestialMatrix[2][2] = celestialMatrix[2][2] / norm;
-
-            telescopeMatrix[0][2] =
-                telescopeMatrix[1][0] * telescopeMatrix[2][1] - telescopeMatrix[2][0] * telescopeMatrix[1][1];
-            telescopeMatrix[1][2] =
-                telescopeMatrix[2][0] * telescopeMatrix[0][1] - telescopeMatrix[0][0] * telescopeMatrix[2][1];
-            telescopeMatrix[2][2] =
-                telescopeMatrix[0][0] * telescopeMatrix[1][1] - telescopeMatrix[1][0] * telescopeMatrix[0][1];
-            norm = sqrt(telescopeMatrix[0][2] * telescopeMatrix[0][2] + telescopeMatrix[1][2] * telescopeMatrix[1][2] +
-                        telescopeMatrix[2][2] * telescopeMatrix[2][2]);
-            telescopeMatrix[0][2] = telescopeMatrix[0][2] / norm;
-            telescopeMatrix[1][2] = telescopeMatrix[1][2] / norm;
-            telescopeMatrix[2][2] = telescopeMatrix[2][2] / norm;
-        }
-        //MATRIX_LOG("celestialMatrix", celestialMatrix);
-        //MATRIX_LOG("telescopeMatrix", telescopeMatrix);
-        inverse_matrix_3x3(celestialMatrix, invcelestialMatrix);
-        //MATRIX_LOG("invcelestialMatrix", invcelestialMatrix);
-        mult_matrix_3x3(telescopeMatrix, invcelestialMatrix, T);
-        inverse_matrix_3x3(T, invT);
-        //MATRIX_LOG("T", T);
-        //MATRIX_LOG("invT", invT);
         if (!(ingoto))
         {
             double lst = 0;
@@ -397,10 +273,10 @@ void Align::AlignNearest(double jd, INDI::IGeographicCoordinates *position, doub
     //double pointaz = (pointset->range24(lst - currentRA - 12.0) * 360.0) / 24.0;
     //double pointalt = currentDEC + pointset->lat;
     double pointaz, pointalt;
-    std::set<PointSet::Distance, bool (*)(PointSet::Distance, PointSet::Distance)> *sortedpoints;
     pointset->AltAzFromRaDec(currentRA, currentDEC, jd, &pointalt, &pointaz, position);
-    sortedpoints = pointset->ComputeDistances(pointalt, pointaz, PointSet::None, ingoto);
-    if (sortedpoints->empty())
+    if ((pointset->getNbPoints() < NEAREST_PREFILTER_POINTS ||
+            pointset->findNearest(pointalt, pointaz, ingoto, 1, nearestpoints, NEAREST_PREFILTER_RADIUS) == 0) &&
+            pointset->findNearest(pointalt, pointaz, ingoto, 1, nearestpoints) == 0)
     {
         *alignedRA  = currentRA;
         *alignedDEC = currentDEC;
@@ -408,7 +284,7 @@ void Align::AlignNearest(double jd, INDI::IGeographicCoordinates *position, doub
     }
     else
     {
-        PointSet::Point *point = pointset->getPoint(sortedpoints->begin()->htmID);
+        PointSet::Point *point = pointset->getPoint(nearestpoints[0].htmID);
         if (lastnearestindex != point->index)
             LOGF_INFO("Align: current point is %d\n", point->index);
         lastnearestindex = point->index;
@@ -52,6 +52,7 @@ class Align
         double currentdeltaRA, currentdeltaDEC;
 
         int lastnearestindex;
+        std::vector<PointSet::Distance> nearestpoints;
 
     public:
         Align(INDI::Telescope *);
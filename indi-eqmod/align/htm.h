@@ -69,6 +69,8 @@ int cc_startpane(double *v1, double *v2, double *v3, double xin, double yin, dou
 int cc_parseVectors(char *spec, int *level, double *ra, double *dec);
 uint64 cc_vector2ID(double x, double y, double z, int depth);
 uint64 cc_radec2ID(double ra, double dec, int depth);
+int cc_IDlevel(uint64 htmid);
+int cc_name2Triangle(char *name, double *v0, double *v1, double *v2);
 /* int cc_esolve(double *v1, double *v2,
 		double ax, double ay, double az, double d);*/
 
@@ -24,10 +24,59 @@
 #include <libnova/sidereal_time.h>
 #include <libnova/transform.h>
 
+#include <algorithm>
 #include <math.h>
 #include <string.h>
 #include <wordexp.h>
 
+// Level of the HTM trixels indexing the triangulation faces and the sync points (8 * 4^4 = 2048 trixels of ~5 degrees)
+#define HTM_INDEX_LEVEL 4
+#define HTM_INDEX_CELLS (8ULL << (2 * HTM_INDEX_LEVEL))
+// HTM ID of the first trixel at HTM_INDEX_LEVEL (S000...)
+#define HTM_INDEX_FIRST_ID (8ULL << (2 * HTM_INDEX_LEVEL))
+
+void inverse_matrix_3x3(double in[3][3], double out[3][3])
+{
+    double det;
+    double a, b, c, d, e, f, g, h, i;
+    a   = in[0][0];
+    b   = in[0][1];
+    c   = in[0][2];
+    d   = in[1][0];
+    e   = in[1][1];
+    f   = in[1][2];
+    g   = in[2][0];
+    h   = in[2][1];
+    i   = in[2][2];
+    det = (a * e * i) + (b * f * g) + (c * d * h) - (c * e * g) - (f * h * a) - (i * b * d);
+    /* if (abs(det) < 0.000001) {
+    IDLog("Align: Matrix determinant is lower than 0.000001 (%g)\n", det);
+    det=0.000001;
+    }*/
+    out[0][0] = (e * i - f * h) / det;
+    out[0][1] = (c * h - b * i) / det;
+    out[0][2] = (b * f - c * e) / det;
+    out[1][0] = (f * g - d * i) / det;
+    out[1][1] = (a * i - c * g) / det;
+    out[1][2] = (c * d - a * f) / det;
+    out[2][0] = (d * h - e * g) / det;
+    out[2][1] = (b * g - a * h) / det;
+    out[2][2] = (a * e - b * d) / det;
+}
+
+void mult_matrix_3x3(double in1[3][3], double in2[3][3], double out[3][3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            out[i][j] = 0.0;
+            for (int k = 0; k < 3; k++)
+                out[i][j] += in1[i][k] * in2[k][j];
+        }
+    }
+}
+
 void PointSet::AltAzFromRaDec(double ra, double dec, double jd, double *alt, double *az, INDI::IGeographicCoordinates *pos)
 {
     INDI::IEquatorialCoordinates lnradec;
@@ -121,6 +170,8 @@ PointSet::PointSet(INDI::Telescope *t)
     telescope  = t;
     lnalignpos = nullptr;
     PointSetInitialized = false;
+    PointSetMap   = nullptr;
+    Triangulation = nullptr;
 }
 
 const char *PointSet::getDeviceName()
@@ -198,6 +249,8 @@ void PointSet::AddPoint(AlignData aligndata, INDI::IGeographicCoordinates *pos)
     point.index = getNbPoints();
     PointSetMap->insert(std::pair<HtmID, Point>(point.htmID, point));
     Triangulation->AddPoint(point.htmID);
+    faceTableValid  = false;
+    pointTableValid = false;
     LOGF_INFO("Align Pointset: added point %d alt = %g az = %g\n", point.index,
               point.celestialALT, point.celestialAZ);
     LOGF_INFO("Align Triangulate: number of faces is %d\n", Triangulation->getFaces().size());
@@ -234,7 +287,11 @@ void PointSet::Init()
 
 void PointSet::Reset()
 {
-    current.clear();
+    faceTable.clear();
+    faceTableValid   = false;
+    currentFaceIndex = -1;
+    pointIDs.clear();
+    pointTableValid = false;
     if (PointSetMap)
     {
         PointSetMap->clear();
@@ -315,6 +372,8 @@ char *PointSet::LoadDataFile(const char *filename)
     lnalignpos->longitude = lon;
     lnalignpos->latitude = lat;
     PointSetMap->clear();
+    faceTableValid  = false;
+    pointTableValid = false;
     alignxml     = nextXMLEle(sitexml, 1);
     aligndata.jd = -1.0;
     while (alignxml)
@@ -513,46 +572,449 @@ bool PointSet::isPointInside(Point *p, std::vector<HtmID> f, bool ingoto)
     return true;
 }
 
+/* Unit vector of an alt/az position, as computed for the points in AddPoint */
+static void altAzVector(double alt, double az, double v[3])
+{
+    double horangle = range360(-180.0 - az) * M_PI / 180.0;
+    double altangle = alt * M_PI / 180.0;
+    v[0]            = cos(altangle) * cos(horangle);
+    v[1]            = cos(altangle) * sin(horangle);
+    v[2]            = sin(altangle);
+}
+
+/* Same as scalarTripleProduct, on plain vectors */
+static double tripleProduct(const double p[3], const double e1[3], const double e2[3])
+{
+    return (p[0] * e1[1] * e2[2]) + (p[2] * e1[0] * e2[1]) + (p[1] * e1[2] * e2[0]) - (p[2] * e1[1] * e2[0]) -
+           (p[0] * e1[2] * e2[1]) - (p[1] * e1[0] * e2[2]);
+}
+
+/* Same as isPointInside, on the vertices of a face table entry */
+static bool isInsideFace(const double p[3], const double v[3][3])
+{
+    bool left  = false;
+    bool right = false;
+    if (tripleProduct(p, v[2], v[0]) < 0)
+        left = true;
+    else
+        right = true;
+    if (tripleProduct(p, v[0], v[1]) < 0)
+        left = true;
+    else
+        right = true;
+    if (left && right)
+        return false;
+    if (tripleProduct(p, v[1], v[2]) < 0)
+        left = true;
+    else
+        right = true;
+    return !(left && right);
+}
+
+/* Spherical cap: the unit vector of its center and its angular radius */
+typedef struct Cap
+{
+    double c[3];
+    double r;
+} Cap;
+
+static bool makeCap(const double v0[3], const double v1[3], const double v2[3], Cap *cap)
+{
+    const double *v[3] = { v0, v1, v2 };
+    double norm;
+    cap->c[0] = v0[0] + v1[0] + v2[0];
+    cap->c[1] = v0[1] + v1[1] + v2[1];
+    cap->c[2] = v0[2] + v1[2] + v2[2];
+    norm      = sqrt(cap->c[0] * cap->c[0] + cap->c[1] * cap->c[1] + cap->c[2] * cap->c[2]);
+    if (norm < 1E-9)
+        return false;
+    cap->c[0] /= norm;
+    cap->c[1] /= norm;
+    cap->c[2] /= norm;
+    cap->r = 0.0;
+    for (int i = 0; i < 3; i++)
+    {
+        double d = cap->c[0] * v[i][0] + cap->c[1] * v[i][1] + cap->c[2] * v[i][2];
+        cap->r   = std::max(cap->r, acos(std::min(1.0, std::max(-1.0, d))));
+    }
+    return true;
+}
+
+static bool capsOverlap(const Cap &a, const Cap &b)
+{
+    double d = a.c[0] * b.c[0] + a.c[1] * b.c[1] + a.c[2] * b.c[2];
+    return acos(std::min(1.0, std::max(-1.0, d))) <= a.r + b.r + 1E-9;
+}
+
+/* Appends the trixels of level HTM_INDEX_LEVEL below trixel id overlapping one of the caps */
+static void collectCells(const double v0[3], const double v1[3], const double v2[3], HtmID id, int level,
+                         const Cap caps[2], std::vector<uint32_t> &cells)
+{
+    Cap trixel;
+    double w0[3], w1[3], w2[3];
+    double dtmp;
+    makeCap(v0, v1, v2, &trixel);
+    if (!capsOverlap(trixel, caps[0]) && !capsOverlap(trixel, caps[1]))
+        return;
+    if (level == HTM_INDEX_LEVEL)
+    {
+        cells.push_back(id - HTM_INDEX_FIRST_ID);
+        return;
+    }
+    /* children numbered as in cc_vector2ID */
+    m4_midpoint(v0, v1, w2, dtmp);
+    m4_midpoint(v1, v2, w0, dtmp);
+    m4_midpoint(v2, v0, w1, dtmp);
+    collectCells(v0, w2, w1, id * 4 + 0, level + 1, caps, cells);
+    collectCells(v1, w0, w2, id * 4 + 1, level + 1, caps, cells);
+    collectCells(v2, w1, w0, id * 4 + 2, level + 1, caps, cells);
+    collectCells(w0, w1, w2, id * 4 + 3, level + 1, caps, cells);
+}
+
+/* Bounding caps of all the trixels down to HTM_INDEX_LEVEL, level after level, in HTM ID order within a level */
+static void fillTrixelCaps(const double v0[3], const double v1[3], const double v2[3], HtmID id, int level,
+                           std::vector<Cap> &caps)
+{
+    double w0[3], w1[3], w2[3];
+    double dtmp;
+    /* 8 + 32 + ... trixels in the levels above, minus the first ID of this level */
+    size_t offset = ((8ULL << (2 * level)) - 8) / 3 - (8ULL << (2 * level));
+    makeCap(v0, v1, v2, &caps[offset + id]);
+    if (level == HTM_INDEX_LEVEL)
+        return;
+    m4_midpoint(v0, v1, w2, dtmp);
+    m4_midpoint(v1, v2, w0, dtmp);
+    m4_midpoint(v2, v0, w1, dtmp);
+    fillTrixelCaps(v0, w2, w1, id * 4 + 0, level + 1, caps);
+    fillTrixelCaps(v1, w0, w2, id * 4 + 1, level + 1, caps);
+    fillTrixelCaps(v2, w1, w0, id * 4 + 2, level + 1, caps);
+    fillTrixelCaps(w0, w1, w2, id * 4 + 3, level + 1, caps);
+}
+
+static const std::vector<Cap> &trixelCaps()
+{
+    static const std::vector<Cap> caps = []()
+    {
+        std::vector<Cap> c(((8ULL << (2 * (HTM_INDEX_LEVEL + 1))) - 8) / 3);
+        for (HtmID id = 8; id < 16; id++)
+        {
+            HtmName name;
+            double v0[3], v1[3], v2[3];
+            cc_ID2name(name, id);
+            cc_name2Triangle(name, v0, v1, v2);
+            fillTrixelCaps(v0, v1, v2, id, 0, c);
+        }
+        return c;
+    }();
+    return caps;
+}
+
+/* Appends the trixels of level HTM_INDEX_LEVEL below trixel id overlapping the cap */
+static void collectCapCells(const Cap &cap, HtmID id, int level, const Cap *caps, std::vector<uint32_t> &cells)
+{
+    size_t offset      = ((8ULL << (2 * level)) - 8) / 3 - (8ULL << (2 * level));
+    const Cap &trixel  = caps[offset + id];
+    double d           = cap.c[0] * trixel.c[0] + cap.c[1] * trixel.c[1] + cap.c[2] * trixel.c[2];
+    if (cap.r + trixel.r < M_PI && d < cos(cap.r + trixel.r + 1E-9))
+        return;
+    if (level == HTM_INDEX_LEVEL)
+    {
+        cells.push_back(id - HTM_INDEX_FIRST_ID);
+        return;
+    }
+    for (int child = 0; child < 4; child++)
+        collectCapCells(cap, id * 4 + child, level + 1, caps, cells);
+}
+
+void PointSet::buildFaceIndex(int which)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> entries;
+    std::vector<uint32_t> cells;
+
+    for (uint32_t f = 0; f < faceTable.size(); f++)
+    {
+        const double(*v)[3] = (which == 0) ? faceTable[f].telescope : faceTable[f].celestial;
+        Cap caps[2];
+        double det = v[0][0] * (v[1][1] * v[2][2] - v[1][2] * v[2][1]) - v[0][1] * (v[1][0] * v[2][2] - v[1][2] * v[2][0]) +
+                     v[0][2] * (v[1][0] * v[2][1] - v[1][1] * v[2][0]);
+
+        cells.clear();
+        if (fabs(det) < 1E-12 || !makeCap(v[0], v[1], v[2], &caps[0]) || caps[0].r >= M_PI / 2)
+        {
+            /* degenerate or huge face, no cheap bound: it goes everywhere */
+            for (uint32_t c = 0; c < HTM_INDEX_CELLS; c++)
+                cells.push_back(c);
+        }
+        else
+        {
+            /* isPointInside also accepts the points of the opposite cone */
+            caps[1]      = caps[0];
+            caps[1].c[0] = -caps[0].c[0];
+            caps[1].c[1] = -caps[0].c[1];
+            caps[1].c[2] = -caps[0].c[2];
+            for (HtmID id = 8; id < 16; id++)
+            {
+                HtmName name;
+                double v0[3], v1[3], v2[3];
+                cc_ID2name(name, id);
+                cc_name2Triangle(name, v0, v1, v2);
+                collectCells(v0, v1, v2, id, 0, caps, cells);
+            }
+        }
+        for (uint32_t c : cells)
+            entries.push_back(std::make_pair(c, f));
+    }
+
+    /* counting sort by trixel, faces stay in table order within a trixel */
+    cellStart[which].assign(HTM_INDEX_CELLS + 1, 0);
+    for (auto &e : entries)
+        cellStart[which][e.first + 1]++;
+    for (uint32_t c = 0; c < HTM_INDEX_CELLS; c++)
+        cellStart[which][c + 1] += cellStart[which][c];
+    cellFaces[which].resize(entries.size());
+    std::vector<uint32_t> fill(cellStart[which].begin(), cellStart[which].end() - 1);
+    for (auto &e : entries)
+        cellFaces[which][fill[e.first]++] = e.second;
+}
+
+void PointSet::buildFaceTable()
+{
+    std::vector<Face *> faces = Triangulation->getFaces();
+
+    faceTable.clear();
+    faceTable.reserve(faces.size());
+    for (Face *face : faces)
+    {
+        FaceEntry entry;
+        double celestialMatrix[3][3];
+        double invcelestialMatrix[3][3];
+        double telescopeMatrix[3][3];
+
+        /* Taki's Algorithm (p33): http://www.geocities.jp/toshimi_taki/matrix/matrix_method_rev_e.pdf */
+        for (int i = 0; i < 3; i++)
+        {
+            Point *point = &PointSetMap->at(face->v[i]);
+            entry.v[i]   = face->v[i];
+
+            entry.celestial[i][0] = point->cx;
+            entry.celestial[i][1] = point->cy;
+            entry.celestial[i][2] = point->cz;
+            entry.telescope[i][0] = point->tx;
+            entry.telescope[i][1] = point->ty;
+            entry.telescope[i][2] = point->tz;
+
+            celestialMatrix[0][i] =
+                cos(point->aligndata.targetDEC * M_PI / 180.0) *
+                cos(((range24(point->aligndata.targetRA - point->aligndata.lst) * 360) / 24.0) * M_PI / 180.0);
+            celestialMatrix[1][i] =
+                cos(point->aligndata.targetDEC * M_PI / 180.0) *
+                sin(((range24(point->aligndata.targetRA - point->aligndata.lst) * 360) / 24.0) * M_PI / 180.0);
+            celestialMatrix[2][i] = sin(point->aligndata.targetDEC * M_PI / 180.0);
+
+            telescopeMatrix[0][i] = cos(point->telescopeALT * M_PI / 180.0) *
+                                    cos(range360(-180.0 - point->telescopeAZ) * M_PI / 180.0);
+            telescopeMatrix[1][i] = cos(point->telescopeALT * M_PI / 180.0) *
+                                    sin(range360(-180.0 - point->telescopeAZ) * M_PI / 180.0);
+            telescopeMatrix[2][i] = sin(point->telescopeALT * M_PI / 180.0);
+        }
+        inverse_matrix_3x3(celestialMatrix, invcelestialMatrix);
+        mult_matrix_3x3(telescopeMatrix, invcelestialMatrix, entry.T);
+        inverse_matrix_3x3(entry.T, entry.invT);
+        faceTable.push_back(entry);
+    }
+
+    buildFaceIndex(0);
+    buildFaceIndex(1);
+    currentFaceIndex = -1;
+    faceTableValid   = true;
+}
+
+const std::vector<PointSet::FaceEntry> &PointSet::getFaceTable()
+{
+    if (!faceTableValid)
+        buildFaceTable();
+    return faceTable;
+}
+
+const PointSet::FaceEntry *PointSet::locateFace(double pointalt, double pointaz, bool ingoto)
+{
+    double p[3];
+    int which = ingoto ? 1 : 0;
+    uint64 cell;
+    uint32_t first, last;
+
+    if (!faceTableValid)
+        buildFaceTable();
+
+    altAzVector(pointalt, pointaz, p);
+
+    if (currentFaceIndex >= 0 &&
+            isInsideFace(p, ingoto ? faceTable[currentFaceIndex].celestial : faceTable[currentFaceIndex].telescope))
+        return &faceTable[currentFaceIndex];
+
+    cell = cc_vector2ID(p[0], p[1], p[2], HTM_INDEX_LEVEL) - HTM_INDEX_FIRST_ID;
+    if (cell < HTM_INDEX_CELLS)
+    {
+        first = cellStart[which][cell];
+        last  = cellStart[which][cell + 1];
+    }
+    else
+    {
+        /* not located in the mesh (rounding), no index for it */
+        first = 0;
+        last  = faceTable.size();
+    }
+
+    for (uint32_t i = first; i < last; i++)
+    {
+        uint32_t f = (cell < HTM_INDEX_CELLS) ? cellFaces[which][i] : i;
+        if (isInsideFace(p, ingoto ? faceTable[f].celestial : faceTable[f].telescope))
+        {
+            currentFaceIndex = f;
+            LOGF_INFO("Align: current face is {%d, %d, %d}", PointSetMap->at(faceTable[f].v[0]).index,
+                      PointSetMap->at(faceTable[f].v[1]).index, PointSetMap->at(faceTable[f].v[2]).index);
+            return &faceTable[f];
+        }
+    }
+    if (currentFaceIndex >= 0)
+        LOG_INFO("Align: current face is empty");
+    currentFaceIndex = -1;
+    return nullptr;
+}
+
 std::vector<HtmID> PointSet::findFace(double currentRA, double currentDEC, double jd, double pointalt, double pointaz,
                                       INDI::IGeographicCoordinates *position, bool ingoto)
 {
     INDI_UNUSED(pointalt);
     INDI_UNUSED(pointaz);
-    Point point;
-    double horangle = 0, altangle = 0;
-    std::vector<Face *> faces;
-    std::vector<Face *>::iterator it;
-
-    point.aligndata.jd        = jd;
-    point.aligndata.targetRA  = currentRA;
-    point.aligndata.targetDEC = currentDEC;
-    AltAzFromRaDec(point.aligndata.targetRA, point.aligndata.targetDEC, point.aligndata.jd, &point.celestialALT,
-                   &point.celestialAZ, position);
-
-    horangle = range360(-180.0 - point.celestialAZ) * M_PI / 180.0;
-    altangle = point.celestialALT * M_PI / 180.0;
-    point.cx = cos(altangle) * cos(horangle);
-    point.cy = cos(altangle) * sin(horangle);
-    point.cz = sin(altangle);
-
-    if (Triangulation->isValid() && isPointInside(&point, current, ingoto))
-        return current;
-    faces = Triangulation->getFaces();
-    it    = faces.begin();
-    while (it < faces.end())
-    {
-        if (isPointInside(&point, (*it)->v, ingoto))
+    double alt, az;
+    const FaceEntry *face;
+
+    AltAzFromRaDec(currentRA, currentDEC, jd, &alt, &az, position);
+    face = locateFace(alt, az, ingoto);
+    if (!face)
+        return std::vector<HtmID>();
+    return std::vector<HtmID>(face->v, face->v + 3);
+}
+
+void PointSet::buildPointTable()
+{
+    size_t n = PointSetMap->size();
+    uint32_t i = 0;
+
+    pointIDs.resize(n);
+    pointVectors[0].resize(3 * n);
+    pointVectors[1].resize(3 * n);
+    for (auto &it : *PointSetMap)
+    {
+        pointIDs[i]               = it.first;
+        pointVectors[0][3 * i]     = it.second.tx;
+        pointVectors[0][3 * i + 1] = it.second.ty;
+        pointVectors[0][3 * i + 2] = it.second.tz;
+        pointVectors[1][3 * i]     = it.second.cx;
+        pointVectors[1][3 * i + 1] = it.second.cy;
+        pointVectors[1][3 * i + 2] = it.second.cz;
+        i++;
+    }
+
+    /* counting sort by trixel, a point out of the mesh (rounding) disables the index */
+    for (int which = 0; which < 2; which++)
+    {
+        const double *v = pointVectors[which].data();
+        std::vector<uint32_t> cell(n);
+
+        pointCellStart[which].assign(HTM_INDEX_CELLS + 1, 0);
+        pointCells[which].clear();
+        for (i = 0; i < n; i++)
         {
-            currentFace = *it;
-            current     = (*it)->v;
-            LOGF_INFO("Align: current face is {%d, %d, %d}", PointSetMap->at(current[0]).index,
-                      PointSetMap->at(current[1]).index, PointSetMap->at(current[2]).index);
-            return current;
+            uint64 id = cc_vector2ID(v[3 * i], v[3 * i + 1], v[3 * i + 2], HTM_INDEX_LEVEL) - HTM_INDEX_FIRST_ID;
+            if (id >= HTM_INDEX_CELLS)
+                break;
+            cell[i] = id;
+            pointCellStart[which][cell[i] + 1]++;
         }
-        it++;
+        if (i < n)
+        {
+            pointCellStart[which].clear();
+            continue;
+        }
+        for (uint32_t c = 0; c < HTM_INDEX_CELLS; c++)
+            pointCellStart[which][c + 1] += pointCellStart[which][c];
+        pointCells[which].resize(n);
+        std::vector<uint32_t> fill(pointCellStart[which].begin(), pointCellStart[which].end() - 1);
+        for (i = 0; i < n; i++)
+            pointCells[which][fill[cell[i]]++] = i;
     }
-    if (current.size() > 0)
-        LOG_INFO("Align: current face is empty");
-    current.clear();
-    return current;
+
+    pointTableValid = true;
+}
+
+int PointSet::findNearest(double alt, double az, bool ingoto, int k, std::vector<Distance> &nearest, double maxdistance)
+{
+    double p[3];
+    int which = ingoto ? 1 : 0;
+    const double *v;
+    /* points farther than maxdistance have a smaller dot product */
+    double mindot = (maxdistance > 0.0) ? cos(std::min(maxdistance, M_PI)) : -2.0;
+
+    nearest.clear();
+    if (!PointSetMap || k <= 0)
+        return 0;
+    if (!pointTableValid)
+        buildPointTable();
+
+    altAzVector(alt, az, p);
+    v = pointVectors[which].data();
+
+    /* candidates sorted on (-dot, index): nearest first, ties in PointSetMap order like ComputeDistances */
+    nearestCandidates.clear();
+    if (maxdistance > 0.0 && maxdistance < M_PI / 2 && !pointCellStart[which].empty())
+    {
+        Cap cap;
+        cap.c[0] = p[0];
+        cap.c[1] = p[1];
+        cap.c[2] = p[2];
+        cap.r    = maxdistance;
+        nearestCells.clear();
+        for (HtmID id = 8; id < 16; id++)
+            collectCapCells(cap, id, 0, trixelCaps().data(), nearestCells);
+        for (uint32_t c : nearestCells)
+        {
+            for (uint32_t j = pointCellStart[which][c]; j < pointCellStart[which][c + 1]; j++)
+            {
+                uint32_t i = pointCells[which][j];
+                double dot = p[0] * v[3 * i] + p[1] * v[3 * i + 1] + p[2] * v[3 * i + 2];
+                if (dot >= mindot)
+                    nearestCandidates.push_back(std::make_pair(-dot, i));
+            }
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < pointIDs.size(); i++)
+        {
+            double dot = p[0] * v[3 * i] + p[1] * v[3 * i + 1] + p[2] * v[3 * i + 2];
+            if (dot >= mindot)
+                nearestCandidates.push_back(std::make_pair(-dot, i));
+        }
+    }
+
+    if (nearestCandidates.size() > static_cast<size_t>(k))
+    {
+        std::nth_element(nearestCandidates.begin(), nearestCandidates.begin() + k, nearestCandidates.end());
+        nearestCandidates.resize(k);
+    }
+    std::sort(nearestCandidates.begin(), nearestCandidates.end());
+
+    for (auto &candidate : nearestCandidates)
+    {
+        uint32_t i = candidate.second;
+        Distance d;
+        /* angle from the chord, acos(dot) is not accurate for close points */
+        double dx = p[0] - v[3 * i], dy = p[1] - v[3 * i + 1], dz = p[2] - v[3 * i + 2];
+        d.htmID = pointIDs[i];
+        d.value = 2 * asin(std::min(1.0, sqrt(dx * dx + dy * dy + dz * dz) / 2));
+        nearest.push_back(d);
+    }
+    return nearest.size();
 }
@@ -19,6 +19,7 @@
 
 #include "htm.h"
 
+#include <cstdint>
 #include <map>
 #include <set>
 #include <vector>
@@ -34,6 +35,9 @@ typedef struct AlignData
     double telescopeRA, telescopeDEC;
 } AlignData;
 
+void inverse_matrix_3x3(double in[3][3], double out[3][3]);
+void mult_matrix_3x3(double in1[3][3], double in2[3][3], double out[3][3]);
+
 //class Triangulate;
 class TriangulateCHull;
 class Face;
@@ -56,6 +60,15 @@ class PointSet
             HtmID htmID;
             double value;
         } Distance;
+        /* A face of the triangulation with everything N-star alignment needs, computed once per triangulation */
+        typedef struct FaceEntry
+        {
+            HtmID v[3];
+            double celestial[3][3]; // unit vectors of the vertices, one per row
+            double telescope[3][3];
+            double T[3][3];         // celestial to telescope transformation (Taki)
+            double invT[3][3];
+        } FaceEntry;
         typedef enum PointFilter { None, SameQuadrant } PointFilter;
         PointSet(INDI::Telescope *);
         const char *getDeviceName();
@@ -76,6 +89,12 @@ class PointSet
                 bool ingoto);
         std::vector<HtmID> findFace(double currentRA, double currentDEC, double jd, double pointalt, double pointaz,
                                     INDI::IGeographicCoordinates *position, bool ingoto);
+        const FaceEntry *locateFace(double pointalt, double pointaz, bool ingoto);
+        const std::vector<FaceEntry> &getFaceTable();
+        /* The k sync points nearest to alt/az, nearest first, telescope positions or celestial ones in goto.
+           With maxdistance > 0 (radians) only closer points are returned, searched in the HTM cells around alt/az.
+           nearest is reused between calls, returns the number of points found */
+        int findNearest(double alt, double az, bool ingoto, int k, std::vector<Distance> &nearest, double maxdistance = 0.0);
         double lat, lon, alt;
         void AltAzFromRaDec(double ra, double dec, double jd, double *alt, double *az, INDI::IGeographicCoordinates *pos);
         void AltAzFromRaDecSidereal(double ra, double dec, double lst, double *alt, double *az, INDI::IGeographicCoordinates *pos);
@@ -89,8 +108,25 @@ class PointSet
         std::map<HtmID, Point> *PointSetMap;
         bool PointSetInitialized;
         TriangulateCHull *Triangulation;
-        Face *currentFace;
-        std::vector<HtmID> current;
+        void buildFaceTable();
+        void buildFaceIndex(int which);
+        std::vector<FaceEntry> faceTable;
+        // Faces overlapping each HTM trixel, in face table order: [0] telescope, [1] celestial vertices
+        std::vector<uint32_t> cellStart[2];
+        std::vector<uint32_t> cellFaces[2];
+        bool faceTableValid {false};
+        int currentFaceIndex {-1};
+        void buildPointTable();
+        // Unit vectors of the sync points in PointSetMap order, x y z each: [0] telescope, [1] celestial
+        std::vector<double> pointVectors[2];
+        std::vector<HtmID> pointIDs;
+        // Sync points in each HTM trixel
+        std::vector<uint32_t> pointCellStart[2];
+        std::vector<uint32_t> pointCells[2];
+        bool pointTableValid {false};
+        // findNearest scratch space, kept to avoid allocations
+        std::vector<std::pair<double, uint32_t>> nearestCandidates;
+        std::vector<uint32_t> nearestCells;
         // to get access to lat/long data
         INDI::Telescope *telescope;
         // from align data file
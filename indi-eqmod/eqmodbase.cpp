@@ -34,6 +34,7 @@
 
 #include "mach_gettime.h"
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
 #include <cstring>
@@ -62,6 +63,7 @@ using namespace INDI::AlignmentSubsystem;
 #define FINE_SLEW_LIMIT 0.5 /* Move at FINE_SLEW_RATE until distance from target is FINE_SLEW_LIMIT degrees */
 
 #define GOTO_ITERATIVE_LIMIT 5 /* Max GOTO Iterations */
+#define GOTO_PATH_STEP       1 /* Degrees between the points of a goto path checked against horizon limits */
 #define RAGOTORESOLUTION     5 /* GOTO Resolution in arcsecs */
 #define DEGOTORESOLUTION     5 /* GOTO Resolution in arcsecs */
 
@@ -318,6 +320,7 @@ void EQMod::ISGetProperties(const char *dev)
         defineProperty(SteppersNP);
         defineProperty(CurrentSteppersNP);
         defineProperty(PeriodsNP);
+        defineProperty(MountLatencyNP);
         defineProperty(JulianNP);
         defineProperty(TimeLSTNP);
         defineProperty(RAStatusLP);
@@ -332,6 +335,7 @@ void EQMod::ISGetProperties(const char *dev)
         defineProperty(SyncManageSP);
         defineProperty(BacklashNP);
         defineProperty(UseBacklashSP);
+        defineProperty(MountIONP);
         defineProperty(TrackDefaultSP);
         defineProperty(ST4GuideRateNSSP);
         defineProperty(ST4GuideRateWESP);
@@ -420,6 +424,8 @@ bool EQMod::loadProperties()
     SyncManageSP        = getSwitch("SYNCMANAGE");
     BacklashNP          = getNumber("BACKLASH");
     UseBacklashSP       = getSwitch("USEBACKLASH");
+    MountIONP           = getNumber("MOUNT_IO");
+    MountLatencyNP      = getNumber("MOUNT_LATENCY");
     AutoHomeSP          = getSwitch("AUTOHOME");
     AuxEncoderSP        = getSwitch("AUXENCODER");
     AuxEncoderNP        = getNumber("AUXENCODERVALUES");
@@ -473,6 +479,7 @@ bool EQMod::updateProperties()
         defineProperty(SteppersNP);
         defineProperty(CurrentSteppersNP);
         defineProperty(PeriodsNP);
+        defineProperty(MountLatencyNP);
         defineProperty(JulianNP);
         defineProperty(TimeLSTNP);
         defineProperty(RAStatusLP);
@@ -487,6 +494,7 @@ bool EQMod::updateProperties()
         defineProperty(SyncManageSP);
         defineProperty(BacklashNP);
         defineProperty(UseBacklashSP);
+        defineProperty(MountIONP);
         defineProperty(TrackDefaultSP);
         defineProperty(ST4GuideRateNSSP);
         defineProperty(ST4GuideRateWESP);
@@ -561,6 +569,8 @@ bool EQMod::updateProperties()
             mount->SetBacklashRA((uint32_t)(IUFindNumber(BacklashNP, "BACKLASHRA")->value));
             mount->SetBacklashDE((uint32_t)(IUFindNumber(BacklashNP, "BACKLASHDE")->value));
 
+            mount->SetPipelineDepth((uint32_t)(IUFindNumber(MountIONP, "PIPELINE_DEPTH")->value));
+
             if (mount->HasSnapPort1())
             {
                 defineProperty(SNAPPORT1SP);
@@ -612,6 +622,7 @@ bool EQMod::updateProperties()
         deleteProperty(SteppersNP->name);
         deleteProperty(CurrentSteppersNP->name);
         deleteProperty(PeriodsNP->name);
+        deleteProperty(MountLatencyNP->name);
         deleteProperty(JulianNP->name);
         deleteProperty(TimeLSTNP->name);
         deleteProperty(RAStatusLP->name);
@@ -628,6 +639,7 @@ bool EQMod::updateProperties()
         deleteProperty(TrackDefaultSP->name);
         deleteProperty(BacklashNP->name);
         deleteProperty(UseBacklashSP->name);
+        deleteProperty(MountIONP->name);
         deleteProperty(ST4GuideRateNSSP->name);
         deleteProperty(ST4GuideRateWESP->name);
         deleteProperty(LEDBrightnessNP->name);
@@ -819,6 +831,7 @@ bool EQMod::ReadScopeStatus()
     try
     {
         TelescopePierSide pierSide;
+        mount->PollStatus();
         currentRAEncoder = mount->GetRAEncoder();
         currentDEEncoder = mount->GetDEEncoder();
         DEBUGF(DBG_SCOPE_STATUS, "Current encoders RA=%ld DE=%ld", static_cast<long>(currentRAEncoder),
@@ -930,6 +943,11 @@ bool EQMod::ReadScopeStatus()
         IUUpdateNumber(PeriodsNP, periods, (char **)periodsnames, 2);
         IDSetNumber(PeriodsNP, nullptr);
 
+        mount->GetLatency(&IUFindNumber(MountLatencyNP, "LAST")->value, &IUFindNumber(MountLatencyNP, "MEAN")->value,
+                          &IUFindNumber(MountLatencyNP, "MAX")->value, &IUFindNumber(MountLatencyNP, "POLL")->value);
+        MountLatencyNP->s = IPS_OK;
+        IDSetNumber(MountLatencyNP, nullptr);
+
         // Log all coords
         {
             char CurrentRAString[64] = {0}, CurrentDEString[64] = {0},
@@ -1641,6 +1659,36 @@ void EQMod::EncoderTarget(GotoParams *g)
     g->detargetencoder = targetdecencoder;
 }
 
+#ifdef WITH_SCOPE_LIMITS
+void EQMod::GotoPath(GotoParams *g, double jd, double lst, std::vector<INDI::IHorizontalCoordinates> &path)
+{
+    // Both axes slew at the same angular rate, the shorter move ends first
+    int64_t const radelta = static_cast<int64_t>(g->ratargetencoder) - g->racurrentencoder;
+    int64_t const dedelta = static_cast<int64_t>(g->detargetencoder) - g->decurrentencoder;
+    double const radegrees = std::abs(radelta) * 360.0 / totalRAEncoder;
+    double const dedegrees = std::abs(dedelta) * 360.0 / totalDEEncoder;
+    int const steps = std::max(1, static_cast<int>(ceil(std::max(radegrees, dedegrees) / GOTO_PATH_STEP)));
+
+    path.clear();
+    path.reserve(steps + 1);
+    for (int i = 0; i <= steps; i++)
+    {
+        double const moved = std::max(radegrees, dedegrees) * i / steps;
+        double const rapart = (radegrees > 0.0) ? std::min(1.0, moved / radegrees) : 0.0;
+        double const depart = (dedegrees > 0.0) ? std::min(1.0, moved / dedegrees) : 0.0;
+        uint32_t const raencoder = g->racurrentencoder + llround(radelta * rapart);
+        uint32_t const deencoder = g->decurrentencoder + llround(dedelta * depart);
+        INDI::IEquatorialCoordinates radec;
+        INDI::IHorizontalCoordinates altaz;
+        double ha;
+
+        EncodersToRADec(raencoder, deencoder, lst, &radec.rightascension, &radec.declination, &ha, nullptr);
+        INDI::EquatorialToHorizontal(&radec, &m_Location, jd, &altaz);
+        path.push_back(altaz);
+    }
+}
+#endif
+
 double EQMod::GetRATrackRate()
 {
     double rate = 0.0;
@@ -1930,6 +1978,26 @@ bool EQMod::Goto(double r, double d)
         return false;
     }
 
+#ifdef WITH_SCOPE_LIMITS
+    if (horizon)
+    {
+        // Telescope positions, not aligned ones: close enough to find obstacles on the way
+        std::vector<INDI::IHorizontalCoordinates> path;
+        GotoPath(&gotoparams, juliandate, lst, path);
+        int const out = horizon->checkPath(path);
+        if (out >= 0)
+        {
+            if (horizon->abortsGoto())
+            {
+                LOGF_WARN("Goto path crosses Horizon Limits at AZ=%3.3lf ALT=%3.3lf, not slewing.", path[out].azimuth,
+                          path[out].altitude);
+                return false;
+            }
+            LOGF_WARN("Goto path crosses Horizon Limits at AZ=%3.3lf ALT=%3.3lf.", path[out].azimuth, path[out].altitude);
+        }
+    }
+#endif
+
     try
     {
         // stop motor
@@ -2532,6 +2600,16 @@ bool EQMod::ISNewNumber(const char *dev, const char *name, double values[], char
             return true;
         }
 
+        if (strcmp(name, "MOUNT_IO") == 0)
+        {
+            IUUpdateNumber(MountIONP, values, names, n);
+            MountIONP->s = IPS_OK;
+            IDSetNumber(MountIONP, nullptr);
+            mount->SetPipelineDepth((uint32_t)(IUFindNumber(MountIONP, "PIPELINE_DEPTH")->value));
+            LOGF_INFO("Setting mount I/O - up to %.0f pipelined commands", IUFindNumber(MountIONP, "PIPELINE_DEPTH")->value);
+            return true;
+        }
+
         if (mount->HasPolarLed())
         {
             if (strcmp(name, "LED_BRIGHTNESS") == 0)
@@ -3621,6 +3699,8 @@ bool EQMod::saveConfigItems(FILE *fp)
         IUSaveConfigNumber(fp, BacklashNP);
     if (UseBacklashSP)
         IUSaveConfigSwitch(fp, UseBacklashSP);
+    if (MountIONP)
+        IUSaveConfigNumber(fp, MountIONP);
     if (GuideRateNP)
         IUSaveConfigNumber(fp, GuideRateNP);
     if (PulseLimitsNP)
@@ -110,6 +110,8 @@ class EQMod : public INDI::Telescope, public INDI::GuiderInterface
         ISwitchVectorProperty *TargetPierSideSP    = nullptr;
         INumberVectorProperty *BacklashNP          = nullptr;
         ISwitchVectorProperty *UseBacklashSP       = nullptr;
+        INumberVectorProperty *MountIONP           = nullptr;
+        INumberVectorProperty *MountLatencyNP      = nullptr;
         INumberVectorProperty *LEDBrightnessNP     = nullptr;
 #if defined WITH_ALIGN && defined WITH_ALIGN_GEEHALEL
         ISwitch AlignMethodS[2];
@@ -172,6 +174,10 @@ class EQMod : public INDI::Telescope, public INDI::GuiderInterface
         double EncoderFromDec(double detarget, TelescopePierSide p, uint32_t initstep, uint32_t totalstep,
                               enum Hemisphere h);
         void EncoderTarget(GotoParams *g);
+#ifdef WITH_SCOPE_LIMITS
+        // Positions of the scope along a goto, every GOTO_PATH_STEP degrees
+        void GotoPath(GotoParams *g, double jd, double lst, std::vector<INDI::IHorizontalCoordinates> &path);
+#endif
         void SetSouthernHemisphere(bool southern);
         void UpdateDEInverted();
         double GetRATrackRate();
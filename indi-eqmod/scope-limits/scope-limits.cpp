@@ -24,8 +24,13 @@
 #include <cstring>
 
 #include <algorithm> // std::sort
+#include <cmath>
 #include <wordexp.h>
 
+// Azimuth bins of the horizon lookup table per horizon point, and at least
+#define HORIZON_TABLE_BINS_PER_POINT 4
+#define HORIZON_TABLE_MIN_BINS       360
+
 // Predicate ordering horizon points per increasing azimuth
 bool HorizonLimits::cmp(INDI::IHorizontalCoordinates const &h1, INDI::IHorizontalCoordinates const &h2)
 {
@@ -37,6 +42,14 @@ HorizonLimits::HorizonLimits(INDI::Telescope *t)
     telescope    = t;
     horizon      = new std::vector<INDI::IHorizontalCoordinates>;
     horizonindex = -1;
+    horizontablestart = 0.0;
+    horizontablescale = 0.0;
+    horizontablevalid = false;
+    horizoncursor     = 0;
+    HorizonLimitsAbortTrackS  = nullptr;
+    HorizonLimitsAbortSlewS   = nullptr;
+    HorizonLimitsAbortGotoS   = nullptr;
+    HorizonLimitsGotoDisableS = nullptr;
     strcpy(errorline, "Bad number format line     ");
     sline = errorline + 23;
     HorizonInitialized = false;
@@ -57,6 +70,7 @@ void HorizonLimits::Reset()
 {
     if (horizon)
         horizon->erase(horizon->begin(), horizon->end());
+    horizontablevalid = false;
 }
 void HorizonLimits::Init()
 {
@@ -92,6 +106,11 @@ bool HorizonLimits::initProperties()
     HorizonLimitsOnLimitSP       = telescope->getSwitch("HORIZONLIMITSONLIMIT");
     HorizonLimitsLimitGotoSP     = telescope->getSwitch("HORIZONLIMITSLIMITGOTO");
 
+    HorizonLimitsAbortTrackS  = IUFindSwitch(HorizonLimitsOnLimitSP, "HORIZONLIMITSONLIMITTRACK");
+    HorizonLimitsAbortSlewS   = IUFindSwitch(HorizonLimitsOnLimitSP, "HORIZONLIMITSONLIMITSLEW");
+    HorizonLimitsAbortGotoS   = IUFindSwitch(HorizonLimitsOnLimitSP, "HORIZONLIMITSONLIMITGOTO");
+    HorizonLimitsGotoDisableS = IUFindSwitch(HorizonLimitsLimitGotoSP, "HORIZONLIMITSLIMITGOTODISABLE");
+
     return true;
 }
 
@@ -166,6 +185,7 @@ bool HorizonLimits::ISNewNumber(const char *dev, const char *name, double values
             }
             horizon->push_back(hp);
             std::sort(horizon->begin(), horizon->end(), HorizonLimits::cmp);
+            horizontablevalid = false;
             low          = std::lower_bound(horizon->begin(), horizon->end(), hp, HorizonLimits::cmp);
             horizonindex = std::distance(horizon->begin(), low);
             DEBUGF(INDI::Logger::DBG_SESSION,
@@ -266,6 +286,7 @@ bool HorizonLimits::ISNewSwitch(const char *dev, const char *name, ISState *stat
                 }
                 horizon->push_back(hp);
                 std::sort(horizon->begin(), horizon->end(), HorizonLimits::cmp);
+                horizontablevalid = false;
                 low          = std::lower_bound(horizon->begin(), horizon->end(), hp, HorizonLimits::cmp);
                 horizonindex = std::distance(horizon->begin(), low);
                 DEBUGF(INDI::Logger::DBG_SESSION,
@@ -289,6 +310,7 @@ bool HorizonLimits::ISNewSwitch(const char *dev, const char *name, ISState *stat
                 LOGF_INFO("Horizon Limits: Deleted point Az = %f, Alt  = %f, Rank=%d",
                           horizon->at(horizonindex).azimuth, horizon->at(horizonindex).altitude, horizonindex);
                 horizon->erase(horizon->begin() + horizonindex);
+                horizontablevalid = false;
                 if (horizonindex >= (int)horizon->size())
                     horizonindex = horizon->size() - 1;
                 az->value               = horizon->at(horizonindex).azimuth;
@@ -304,6 +326,7 @@ bool HorizonLimits::ISNewSwitch(const char *dev, const char *name, ISState *stat
                 LOG_INFO("Horizon Limits: List cleared");
                 if (horizon)
                     horizon->erase(horizon->begin(), horizon->end());
+                horizontablevalid       = false;
                 horizonindex            = -1;
                 az->value               = 0.0;
                 alt->value              = 0.0;
@@ -503,6 +526,9 @@ char *HorizonLimits::LoadDataFile(const char *filename)
         nline++;
         pos = 0;
     }
+    // Lookups need the points per increasing azimuth, as added from the properties
+    std::sort(horizon->begin(), horizon->end(), HorizonLimits::cmp);
+    horizontablevalid = false;
 
     horizonindex            = -1;
     az->value               = 0.0;
@@ -530,13 +556,10 @@ bool HorizonLimits::inLimits(double raw_az, double raw_alt)
     if (horizon->size() == 1)
         return scope.altitude >= horizon->begin()->altitude;
 
-    // Search for the horizon point just after which the tested point may be inserted - see std::lower_bound documentation
-    std::vector<INDI::IHorizontalCoordinates>::iterator next = std::lower_bound(horizon->begin(), horizon->end(), scope,
-            HorizonLimits::cmp);
-
+    // Search for the horizon point just after which the tested point may be inserted - as std::lower_bound would
     // If the tested point would be inserted at the end of the horizon list, loop next point back to first
-    if (next == horizon->end())
-        next = horizon->begin();
+    size_t const index = horizonSegment(scope.azimuth);
+    std::vector<INDI::IHorizontalCoordinates>::iterator next = horizon->begin() + (index < horizon->size() ? index : 0);
 
     // If the tested azimuth is identical to the next point, test altitude directly
     if (next->azimuth == scope.azimuth)
@@ -560,19 +583,95 @@ bool HorizonLimits::inLimits(double raw_az, double raw_alt)
     return (scope.altitude >= h);
 }
 
+void HorizonLimits::compileHorizon()
+{
+    horizontable.clear();
+    horizoncursor     = 0;
+    horizontablevalid = true;
+
+    if (horizon == nullptr || horizon->size() < 2)
+        return;
+
+    // Bins span the azimuths of the horizon points, lookups outside are resolved before
+    double const span = horizon->back().azimuth - horizon->front().azimuth;
+    if (!(span > 0.0))
+        return;
+
+    size_t const bins = std::max<size_t>(HORIZON_TABLE_MIN_BINS, HORIZON_TABLE_BINS_PER_POINT * horizon->size());
+    horizontablestart = horizon->front().azimuth;
+    horizontablescale = bins / span;
+
+    // Count points per bin with the very computation used for lookups, then accumulate
+    horizontable.assign(bins, 0);
+    for (auto const &point : *horizon)
+    {
+        size_t const bin = std::min<size_t>((point.azimuth - horizontablestart) * horizontablescale, bins - 1);
+        if (bin + 1 < bins)
+            horizontable[bin + 1]++;
+    }
+    for (size_t bin = 1; bin < bins; bin++)
+        horizontable[bin] += horizontable[bin - 1];
+}
+
+size_t HorizonLimits::horizonSegment(double az)
+{
+    std::vector<INDI::IHorizontalCoordinates> const &h = *horizon;
+    size_t const n = h.size();
+
+    if (!horizontablevalid)
+        compileHorizon();
+
+    // Number of horizon points with an azimuth lower than az, first check the result of the last lookup
+    if ((horizoncursor == 0 || h[horizoncursor - 1].azimuth < az) && (horizoncursor == n || az <= h[horizoncursor].azimuth))
+        return horizoncursor;
+
+    size_t index;
+    if (az <= h.front().azimuth)
+        index = 0;
+    else if (az > h.back().azimuth)
+        index = n;
+    else if (horizontable.empty() || std::isnan(az))
+        index = std::distance(h.begin(), std::lower_bound(h.begin(), h.end(), INDI::IHorizontalCoordinates{az, 0.0},
+                              HorizonLimits::cmp));
+    else
+    {
+        size_t const bin = std::min<size_t>((az - horizontablestart) * horizontablescale, horizontable.size() - 1);
+        // Points before the bin are lower, only those within the bin are left to check
+        index = horizontable[bin];
+        while (index < n && h[index].azimuth < az)
+            index++;
+    }
+
+    horizoncursor = index;
+    return index;
+}
+
 bool HorizonLimits::inGotoLimits(double az, double alt)
 {
-    ISwitch *swlimitgotodisable = IUFindSwitch(HorizonLimitsLimitGotoSP, "HORIZONLIMITSLIMITGOTODISABLE");
-    return (inLimits(az, alt) || (swlimitgotodisable->s == ISS_ON));
+    return (inLimits(az, alt) || (HorizonLimitsGotoDisableS->s == ISS_ON));
+}
+
+int HorizonLimits::checkPath(const std::vector<INDI::IHorizontalCoordinates> &path)
+{
+    // Consecutive path points mostly hit the cursor or the same table bin
+    for (size_t i = 0; i < path.size(); i++)
+        if (!inLimits(path[i].azimuth, path[i].altitude))
+            return i;
+    return -1;
+}
+
+bool HorizonLimits::abortsGoto()
+{
+    return (HorizonLimitsAbortGotoS->s == ISS_ON);
 }
 
 bool HorizonLimits::checkLimits(double az, double alt, INDI::Telescope::TelescopeStatus status, bool ingoto)
 {
     static bool warningMessageDispatched = false;
     bool abortscope = false;
-    ISwitch *swaborttrack = IUFindSwitch(HorizonLimitsOnLimitSP, "HORIZONLIMITSONLIMITTRACK");
-    ISwitch *swabortslew  = IUFindSwitch(HorizonLimitsOnLimitSP, "HORIZONLIMITSONLIMITSLEW");
-    ISwitch *swabortgoto  = IUFindSwitch(HorizonLimitsOnLimitSP, "HORIZONLIMITSONLIMITGOTO");
+    ISwitch *swaborttrack = HorizonLimitsAbortTrackS;
+    ISwitch *swabortslew  = HorizonLimitsAbortSlewS;
+    ISwitch *swabortgoto  = HorizonLimitsAbortGotoS;
     if (!(inLimits(az, alt)))
     {
         if ((status == INDI::Telescope::SCOPE_TRACKING) && (swaborttrack->s == ISS_ON))
@@ -35,9 +35,23 @@ class HorizonLimits
     ISwitchVectorProperty *HorizonLimitsOnLimitSP;
     ISwitchVectorProperty *HorizonLimitsLimitGotoSP;
 
+    ISwitch *HorizonLimitsAbortTrackS;
+    ISwitch *HorizonLimitsAbortSlewS;
+    ISwitch *HorizonLimitsAbortGotoS;
+    ISwitch *HorizonLimitsGotoDisableS;
+
     std::vector<INDI::IHorizontalCoordinates> *horizon;
     int horizonindex;
 
+    // Uniform azimuth bins over the horizon, each with the number of horizon points before it
+    std::vector<uint32_t> horizontable;
+    double horizontablestart, horizontablescale;
+    bool horizontablevalid;
+    // Result of the last lookup, a tracking scope stays between the same two points for a while
+    size_t horizoncursor;
+    void compileHorizon();
+    size_t horizonSegment(double az);
+
     char *WriteDataFile(const char *filename);
     char *LoadDataFile(const char *filename);
     char errorline[128];
@@ -64,6 +78,9 @@ class HorizonLimits
     virtual bool inLimits(double az, double alt);
     virtual bool inGotoLimits(double az, double alt);
     virtual bool checkLimits(double az, double alt, INDI::Telescope::TelescopeStatus status, bool ingoto);
+    // Index of the first point of path outside limits, -1 if the whole path is inside
+    virtual int checkPath(const std::vector<INDI::IHorizontalCoordinates> &path);
+    bool abortsGoto();
     virtual bool saveConfigItems(FILE *fp);
 
     static bool cmp(INDI::IHorizontalCoordinates const &h1, INDI::IHorizontalCoordinates const &h2);
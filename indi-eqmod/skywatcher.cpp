@@ -22,21 +22,44 @@
 #include <indicom.h>
 
 #include <termios.h>
+#include <chrono>
 #include <cmath>
 #include <cstring>
+#include <vector>
 
 Skywatcher::Skywatcher(EQMod *t)
 {
     debug         = false;
-    debugnextread = false;
     simulation    = false;
     telescope     = t;
     reconnect     = false;
+
+    SkywatcherQueue::Link link;
+    link.write   = [this](const std::string & cmd)
+    {
+        write_eqmod(cmd);
+    };
+    link.read    = [this]()
+    {
+        return read_eqmod();
+    };
+    link.flush   = [this]()
+    {
+        if (!isSimulation())
+            tcflush(PortFD, TCIOFLUSH);
+    };
+    link.retried = [this](const std::string &, int retries)
+    {
+        LOGF_WARN("%s() : serial port read failed for %dms (%d retries), verify mount link.", "dispatch_command",
+                  (retries * EQMOD_TIMEOUT) / 1000, retries);
+    };
+    queue.reset(new SkywatcherQueue(link, EQMOD_MAX_RETRY, 100000));
 }
 
 Skywatcher::~Skywatcher(void)
 {
     Disconnect();
+    queue->stop();
 }
 
 void Skywatcher::setDebug(bool enable)
@@ -113,15 +136,12 @@ bool Skywatcher::Disconnect()
 uint32_t Skywatcher::GetRAEncoder()
 {
     // Axis Position
-    dispatch_command(GetAxisPosition, Axis1, nullptr);
-
-    uint32_t steps = Revu24str2long(response + 1);
-    if (steps & 0x80000000)
-        DEBUGF(telescope->DBG_SCOPE_STATUS, "%s() = Ignoring invalid response %s", __FUNCTION__, response);
-    else
-        RAStep = steps;
+    if (!UsePolled(polledPosition[Axis1]))
+    {
+        dispatch_command(GetAxisPosition, Axis1, nullptr);
+        ParsePosition(Axis1);
+    }
 
-    gettimeofday(&lastreadmotorposition[Axis1], nullptr);
     if (RAStep != lastRAStep)
     {
         DEBUGF(telescope->DBG_SCOPE_STATUS, "%s() = %ld", __FUNCTION__, static_cast<long>(RAStep));
@@ -133,14 +153,12 @@ uint32_t Skywatcher::GetRAEncoder()
 uint32_t Skywatcher::GetDEEncoder()
 {
     // Axis Position
-    dispatch_command(GetAxisPosition, Axis2, nullptr);
+    if (!UsePolled(polledPosition[Axis2]))
+    {
+        dispatch_command(GetAxisPosition, Axis2, nullptr);
+        ParsePosition(Axis2);
+    }
 
-    uint32_t steps = Revu24str2long(response + 1);
-    if (steps & 0x80000000)
-        DEBUGF(telescope->DBG_SCOPE_STATUS, "%s() = Ignoring invalid response %s", __FUNCTION__, response);
-    else
-        DEStep = steps;
-    gettimeofday(&lastreadmotorposition[Axis2], nullptr);
     if (DEStep != lastDEStep)
     {
         DEBUGF(telescope->DBG_SCOPE_STATUS, "%s() = %ld", __FUNCTION__, static_cast<long>(DEStep));
@@ -708,8 +726,16 @@ bool Skywatcher::IsDERunning()
 
 void Skywatcher::ReadMotorStatus(SkywatcherAxis axis)
 {
+    if (UsePolled(polledStatus[axis]))
+        return;
+
     dispatch_command(GetAxisStatus, axis, nullptr);
     //read_eqmod();
+    ParseMotorStatus(axis);
+}
+
+void Skywatcher::ParseMotorStatus(SkywatcherAxis axis)
+{
     switch (axis)
     {
         case Axis1:
@@ -1268,6 +1294,9 @@ void Skywatcher::TurnDEEncoder(bool on)
 
 uint32_t Skywatcher::ReadEncoder(SkywatcherAxis axis)
 {
+    if (UsePolled(polledAuxEncoder[axis]))
+        return auxEncoder[axis];
+
     dispatch_command(InquireAuxEncoder, axis, nullptr);
     //read_eqmod();
     return Revu24str2long(response + 1);
@@ -1691,119 +1720,167 @@ double Skywatcher::get_max_rate()
     return MAX_RATE;
 }
 
-bool Skywatcher::dispatch_command(SkywatcherCommand cmd, SkywatcherAxis axis, char *command_arg)
+std::string Skywatcher::build_command(SkywatcherCommand cmd, SkywatcherAxis axis, const char *command_arg)
 {
-    for (uint8_t i = 0; i < EQMOD_MAX_RETRY; i++)
-    {
-        // Clear string
-        command[0] = '\0';
+    char buf[SKYWATCHER_MAX_CMD];
 
-        if (command_arg == nullptr)
-            snprintf(command, SKYWATCHER_MAX_CMD, "%c%c%c%c", SkywatcherLeadingChar, cmd, AxisCmd[axis], SkywatcherTrailingChar);
-        else
-            snprintf(command, SKYWATCHER_MAX_CMD, "%c%c%c%s%c", SkywatcherLeadingChar, cmd, AxisCmd[axis], command_arg,
-                     SkywatcherTrailingChar);
+    if (command_arg == nullptr)
+        snprintf(buf, SKYWATCHER_MAX_CMD, "%c%c%c", SkywatcherLeadingChar, cmd, AxisCmd[axis]);
+    else
+        snprintf(buf, SKYWATCHER_MAX_CMD, "%c%c%c%s", SkywatcherLeadingChar, cmd, AxisCmd[axis], command_arg);
 
-        int nbytes_written = 0;
-        if (!isSimulation())
-        {
-            int err_code = 0;
-            tcflush(PortFD, TCIOFLUSH);
+    return buf;
+}
 
-            if ((err_code = tty_write_string(PortFD, command, &nbytes_written)) != TTY_OK)
-            {
-                if (i == EQMOD_MAX_RETRY - 1)
-                {
-                    char ttyerrormsg[ERROR_MSG_LENGTH];
-                    tty_error_msg(err_code, ttyerrormsg, ERROR_MSG_LENGTH);
-                    throw EQModError(EQModError::ErrDisconnect, "tty write failed, check connection: %s", ttyerrormsg);
-                }
-                else
-                {
-                    struct timespec wait;
-                    wait.tv_sec  = 0;
-                    wait.tv_nsec = 100000000; // 100ms
-                    nanosleep(nullptr, &wait);
-                    continue;
-                }
-            }
-        }
-        else
-        {
-            telescope->simulator->receive_cmd(command, &nbytes_written);
-        }
+bool Skywatcher::dispatch_command(SkywatcherCommand cmd, SkywatcherAxis axis, char *command_arg)
+{
+    std::string request = build_command(cmd, axis, command_arg);
+    snprintf(command, SKYWATCHER_MAX_CMD, "%s", request.c_str());
 
-        //if (INDI::Logger::debugSerial(cmd)) {
-        command[nbytes_written - 1] = '\0'; //hmmm, remove \r, the  SkywatcherTrailingChar
-        DEBUGF(telescope->DBG_COMM, "dispatch_command: \"%s\", %d bytes written", command, nbytes_written);
-        debugnextread = true;
+    // Retries happen on the I/O thread, get() rethrows the EQModError of a failed command.
+    std::string reply = queue->submit(request).get();
+    snprintf(response, SKYWATCHER_MAX_CMD, "%s", reply.c_str());
 
-        try
-        {
-            if (read_eqmod())
-            {
-                if (i > 0)
-                {
-                    LOGF_WARN("%s() : serial port read failed for %dms (%d retries), verify mount link.", __FUNCTION__, (i*EQMOD_TIMEOUT)/1000, i);
-                }
-                return true;
-            }
-        }
-        catch (EQModError)
+    return true;
+}
+
+/* Runs on the queue thread */
+void Skywatcher::write_eqmod(const std::string &cmd)
+{
+    char buf[SKYWATCHER_MAX_CMD];
+    snprintf(buf, SKYWATCHER_MAX_CMD, "%s%c", cmd.c_str(), SkywatcherTrailingChar);
+
+    int nbytes_written = 0;
+    if (!isSimulation())
+    {
+        int err_code = 0;
+        if ((err_code = tty_write_string(PortFD, buf, &nbytes_written)) != TTY_OK)
         {
-            // By this time, we just rethrow the error
-            // JM 2018-05-07 immediately rethrow if GET_FEATURES_CMD
-            if (i == EQMOD_MAX_RETRY - 1 || cmd == GetFeatureCmd)
-                throw;
+            char ttyerrormsg[ERROR_MSG_LENGTH];
+            tty_error_msg(err_code, ttyerrormsg, ERROR_MSG_LENGTH);
+            throw EQModError(EQModError::ErrDisconnect, "tty write failed, check connection: %s", ttyerrormsg);
         }
-
-        DEBUG(telescope->DBG_COMM, "read error, will retry again...");
+    }
+    else
+    {
+        telescope->simulator->receive_cmd(buf, &nbytes_written);
     }
 
-    return true;
+    DEBUGF(telescope->DBG_COMM, "dispatch_command: \"%s\", %d bytes written", cmd.c_str(), nbytes_written);
 }
 
-bool Skywatcher::read_eqmod()
+/* Runs on the queue thread */
+std::string Skywatcher::read_eqmod()
 {
     int err_code = 0, nbytes_read = 0;
+    char buf[SKYWATCHER_MAX_CMD] = {0};
 
-    // Clear string
-    response[0] = '\0';
     if (!isSimulation())
     {
         //Have to onsider cases when we read ! (error) or 0x01 (buffer overflow)
         // Read until encountring a CR
-        if ((err_code = tty_read_section_expanded(PortFD, response, 0x0D, 0, EQMOD_TIMEOUT, &nbytes_read)) != TTY_OK)
+        if ((err_code = tty_read_section_expanded(PortFD, buf, 0x0D, 0, EQMOD_TIMEOUT, &nbytes_read)) != TTY_OK)
         {
             char ttyerrormsg[ERROR_MSG_LENGTH];
             tty_error_msg(err_code, ttyerrormsg, ERROR_MSG_LENGTH);
             throw EQModError(EQModError::ErrDisconnect, "tty read failed, check connection: %s", ttyerrormsg);
-            //return false;
         }
     }
     else
     {
-        telescope->simulator->send_reply(response, &nbytes_read);
+        telescope->simulator->send_reply(buf, &nbytes_read);
     }
     // Remove CR
-    response[nbytes_read - 1] = '\0';
+    if (nbytes_read > 0)
+        buf[nbytes_read - 1] = '\0';
+
+    DEBUGF(telescope->DBG_COMM, "read_eqmod: \"%s\", %d bytes read", buf, nbytes_read);
+
+    return buf;
+}
 
-    if (debugnextread)
+void Skywatcher::PollStatus()
+{
+    bool aux = HasAuxEncoders();
+    std::vector<std::string> commands =
     {
-        DEBUGF(telescope->DBG_COMM, "read_eqmod: \"%s\", %d bytes read", response, nbytes_read);
-        debugnextread = false;
+        build_command(GetAxisPosition, Axis1, nullptr), build_command(GetAxisPosition, Axis2, nullptr),
+        build_command(GetAxisStatus, Axis1, nullptr), build_command(GetAxisStatus, Axis2, nullptr)
+    };
+    if (aux)
+    {
+        commands.push_back(build_command(InquireAuxEncoder, Axis1, nullptr));
+        commands.push_back(build_command(InquireAuxEncoder, Axis2, nullptr));
     }
-    switch (response[0])
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<std::string>> replies = queue->submit(commands);
+
+    for (size_t i = 0; i < replies.size(); i++)
     {
-        case '=':
-            break;
-        case '!':
-            throw EQModError(EQModError::ErrCmdFailed, "Failed command %s - Reply %s", command, response);
-        default:
-            throw EQModError(EQModError::ErrInvalidCmd, "Invalid response to command %s - Reply %s", command, response);
+        SkywatcherAxis axis = (i % 2 == 0) ? Axis1 : Axis2;
+        snprintf(response, SKYWATCHER_MAX_CMD, "%s", replies[i].get().c_str());
+
+        if (i < 2)
+        {
+            ParsePosition(axis);
+            polledPosition[axis] = true;
+        }
+        else if (i < 4)
+        {
+            ParseMotorStatus(axis);
+            polledStatus[axis] = true;
+        }
+        else
+        {
+            auxEncoder[axis] = Revu24str2long(response + 1);
+            polledAuxEncoder[axis] = true;
+        }
     }
+    gettimeofday(&lastpoll, nullptr);
 
-    return true;
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    pollLatency = elapsed.count();
+    DEBUGF(telescope->DBG_SCOPE_STATUS, "%s() : %zu commands in %.1f ms", __FUNCTION__, commands.size(), pollLatency);
+}
+
+bool Skywatcher::UsePolled(bool &polled)
+{
+    if (!polled)
+        return false;
+    polled = false;
+
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    return ((now.tv_sec - lastpoll.tv_sec) + ((now.tv_usec - lastpoll.tv_usec) / 1e6)) < SKYWATCHER_POLL_VALIDITY;
+}
+
+void Skywatcher::ParsePosition(SkywatcherAxis axis)
+{
+    uint32_t steps = Revu24str2long(response + 1);
+    if (steps & 0x80000000)
+        DEBUGF(telescope->DBG_SCOPE_STATUS, "%s() = Ignoring invalid response %s", __FUNCTION__, response);
+    else if (axis == Axis1)
+        RAStep = steps;
+    else
+        DEStep = steps;
+
+    gettimeofday(&lastreadmotorposition[axis], nullptr);
+}
+
+void Skywatcher::SetPipelineDepth(uint32_t depth)
+{
+    // The simulator answers one command at a time.
+    queue->setPipelineDepth(isSimulation() ? 1 : depth);
+}
+
+void Skywatcher::GetLatency(double *last, double *mean, double *max, double *poll)
+{
+    SkywatcherQueue::Latency latency = queue->getLatency();
+    *last = latency.last;
+    *mean = latency.mean;
+    *max  = latency.max;
+    *poll = pollLatency;
 }
 
 uint32_t Skywatcher::Revu24str2long(char *s)
@@ -18,11 +18,14 @@
 #pragma once
 
 #include "eqmoderror.h"
+#include "skywatcherqueue.h"
 
 #include <inditelescope.h>
 
 #include <lilxml.h>
 
+#include <memory>
+#include <string>
 #include <time.h>
 #include <sys/time.h>
 
@@ -41,6 +44,8 @@ class EQMod; // TODO
 
 #define SKYWATCHER_LOWSPEED_RATE 128
 #define SKYWATCHER_MAXREFRESH    0.5
+// Replies of a status poll stand in for the next reads within this time (s)
+#define SKYWATCHER_POLL_VALIDITY 0.2
 
 #define SKYWATCHER_BACKLASH_SPEED_RA 64
 #define SKYWATCHER_BACKLASH_SPEED_DE 64
@@ -131,6 +136,13 @@ class Skywatcher
 
         void setPortFD(int value);
 
+        // Encoders, motor status (and aux encoders) of both axes in one batch. The Get/Is calls
+        // following it use those replies once instead of asking the mount again.
+        void PollStatus();
+        void SetPipelineDepth(uint32_t depth);
+        // Round trip per command and for the last PollStatus() in ms
+        void GetLatency(double *last, double *mean, double *max, double *poll);
+
     private:
         // Official Skywatcher Protocol
         // See http://code.google.com/p/skywatcher/wiki/SkyWatcherProtocol
@@ -269,7 +281,13 @@ class Skywatcher
         void SetAxisPosition(SkywatcherAxis axis, uint32_t step);
         void TurnSnapPort(SkywatcherAxis axis, bool on);
 
-        bool read_eqmod();
+        bool UsePolled(bool &polled);
+        void ParsePosition(SkywatcherAxis axis);
+        void ParseMotorStatus(SkywatcherAxis axis);
+
+        void write_eqmod(const std::string &cmd);
+        std::string read_eqmod();
+        std::string build_command(SkywatcherCommand cmd, SkywatcherAxis axis, const char *arg);
         bool dispatch_command(SkywatcherCommand cmd, SkywatcherAxis axis, char *arg);
 
         uint32_t Revu24str2long(char *);
@@ -319,7 +337,6 @@ class Skywatcher
         char response[SKYWATCHER_MAX_CMD];
 
         bool debug;
-        bool debugnextread;
         EQMod *telescope;
         bool reconnect;
 
@@ -334,8 +351,19 @@ class Skywatcher
 
         uint32_t lastreadIndexer[NUMBER_OF_SKYWATCHERAXIS];
 
+        // Replies of the last PollStatus() not used yet
+        bool polledPosition[NUMBER_OF_SKYWATCHERAXIS] {false, false};
+        bool polledStatus[NUMBER_OF_SKYWATCHERAXIS] {false, false};
+        bool polledAuxEncoder[NUMBER_OF_SKYWATCHERAXIS] {false, false};
+        uint32_t auxEncoder[NUMBER_OF_SKYWATCHERAXIS] {0, 0};
+        struct timeval lastpoll;
+        double pollLatency {0};
+
         bool snapportstatus[NUMBER_OF_SKYWATCHERAXIS];
 
         const long EQMOD_TIMEOUT = 200000; // us
         const uint8_t EQMOD_MAX_RETRY = 10;
+
+        // All mount I/O runs on the queue's thread
+        std::unique_ptr<SkywatcherQueue> queue;
 };
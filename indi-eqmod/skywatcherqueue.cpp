@@ -0,0 +1,270 @@
+/* Copyright 2012 Geehalel (geehalel AT gmail DOT com) */
+/* This file is part of the Skywatcher Protocol INDI driver.
+
+    The Skywatcher Protocol INDI driver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Skywatcher Protocol INDI driver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Skywatcher Protocol INDI driver.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "skywatcherqueue.h"
+
+#include "eqmoderror.h"
+
+#include <algorithm>
+#include <unistd.h>
+
+SkywatcherQueue::SkywatcherQueue(Link link, uint8_t maxRetry, long retryDelayUs)
+    : link(link), maxRetry(maxRetry), retryDelayUs(retryDelayUs)
+{
+}
+
+SkywatcherQueue::~SkywatcherQueue()
+{
+    stop();
+}
+
+void SkywatcherQueue::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    condition.notify_all();
+    if (thread.joinable())
+        thread.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    quit = false;
+}
+
+void SkywatcherQueue::setPipelineDepth(size_t value)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    depth = std::max<size_t>(value, 1);
+}
+
+size_t SkywatcherQueue::getPipelineDepth()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return depth;
+}
+
+std::future<std::string> SkywatcherQueue::submit(const std::string &command)
+{
+    return std::move(submit(std::vector<std::string> { command })[0]);
+}
+
+std::vector<std::future<std::string>> SkywatcherQueue::submit(const std::vector<std::string> &commands)
+{
+    Batch batch(commands.size());
+    std::vector<std::future<std::string>> replies;
+    for (size_t i = 0; i < commands.size(); i++)
+    {
+        batch[i].command = commands[i];
+        replies.push_back(batch[i].reply.get_future());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(batch));
+        if (!thread.joinable())
+            thread = std::thread(&SkywatcherQueue::run, this);
+    }
+    condition.notify_one();
+
+    return replies;
+}
+
+SkywatcherQueue::Latency SkywatcherQueue::getLatency()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return latency;
+}
+
+void SkywatcherQueue::resetLatency()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    latency = Latency();
+}
+
+void SkywatcherQueue::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        condition.wait(lock, [this]()
+        {
+            return quit || !pending.empty();
+        });
+
+        // Answer what was queued before leaving, nobody waits forever on a future.
+        if (pending.empty())
+            return;
+
+        Batch batch = std::move(pending.front());
+        pending.pop_front();
+
+        lock.unlock();
+        process(batch);
+        lock.lock();
+    }
+}
+
+void SkywatcherQueue::process(Batch &batch)
+{
+    size_t first = 0;
+    while (first < batch.size())
+    {
+        size_t count = std::min(getPipelineDepth(), batch.size() - first);
+        size_t done  = count > 1 ? pipeline(batch, first, count) : 0;
+        first += done;
+
+        // First command without a proper reply goes the slow way, with retries.
+        if (done < count)
+        {
+            Request &request = batch[first++];
+            try
+            {
+                answered(request, transact(request));
+            }
+            catch (...)
+            {
+                request.reply.set_exception(std::current_exception());
+            }
+        }
+    }
+}
+
+size_t SkywatcherQueue::pipeline(Batch &batch, size_t first, size_t count)
+{
+    size_t sent = 0;
+    try
+    {
+        link.flush();
+        for (; sent < count; sent++)
+        {
+            batch[first + sent].sent = std::chrono::steady_clock::now();
+            link.write(batch[first + sent].command);
+        }
+    }
+    catch (EQModError &)
+    {
+        discard(sent);
+        return 0;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        std::string reply;
+        try
+        {
+            reply = link.read();
+        }
+        catch (EQModError &)
+        {
+            // The reply to this command may still come, late
+            discard(count - i);
+            return i;
+        }
+
+        if (reply.empty() || reply[0] != '=')
+        {
+            discard(count - i - 1);
+            return i;
+        }
+
+        answered(batch[first + i], reply);
+    }
+
+    return count;
+}
+
+void SkywatcherQueue::discard(size_t outstanding)
+{
+    // Replies to the rest of a broken batch are still on the wire. Read them before anything is sent
+    // again or the next command would take one of them for its own reply. A timeout means none left.
+    for (; outstanding > 0; outstanding--)
+    {
+        try
+        {
+            link.read();
+        }
+        catch (EQModError &)
+        {
+            break;
+        }
+    }
+}
+
+std::string SkywatcherQueue::transact(Request &request)
+{
+    for (uint8_t i = 0; i < maxRetry; i++)
+    {
+        try
+        {
+            link.flush();
+            request.sent = std::chrono::steady_clock::now();
+            link.write(request.command);
+        }
+        catch (EQModError &)
+        {
+            if (i == maxRetry - 1)
+                throw;
+            usleep(retryDelayUs);
+            continue;
+        }
+
+        try
+        {
+            std::string reply = link.read();
+            check(request.command, reply);
+            if (i > 0 && link.retried)
+                link.retried(request.command, i);
+            return reply;
+        }
+        catch (EQModError &)
+        {
+            // JM 2018-05-07 immediately rethrow if GET_FEATURES_CMD
+            if (i == maxRetry - 1 || (request.command.size() > 1 && request.command[1] == 'q'))
+                throw;
+        }
+    }
+
+    throw EQModError(EQModError::ErrDisconnect, "No reply to command %s", request.command.c_str());
+}
+
+void SkywatcherQueue::check(const std::string &command, const std::string &reply)
+{
+    switch (reply.empty() ? '\0' : reply[0])
+    {
+        case '=':
+            break;
+        case '!':
+            throw EQModError(EQModError::ErrCmdFailed, "Failed command %s - Reply %s", command.c_str(), reply.c_str());
+        default:
+            throw EQModError(EQModError::ErrInvalidCmd, "Invalid response to command %s - Reply %s", command.c_str(),
+                             reply.c_str());
+    }
+}
+
+void SkywatcherQueue::answered(Request &request, const std::string &reply)
+{
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - request.sent;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        latency.last = elapsed.count();
+        latency.max  = std::max(latency.max, latency.last);
+        latency.count++;
+        latency.mean += (latency.last - latency.mean) / latency.count;
+    }
+    request.reply.set_value(reply);
+}
@@ -0,0 +1,110 @@
+/* Copyright 2012 Geehalel (geehalel AT gmail DOT com) */
+/* This file is part of the Skywatcher Protocol INDI driver.
+
+    The Skywatcher Protocol INDI driver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Skywatcher Protocol INDI driver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Skywatcher Protocol INDI driver.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Command queue for the Skywatcher motor controller.
+ *
+ * All traffic with the mount goes through one I/O thread. Callers get a future per command
+ * which holds the reply (starting with '=') or the EQModError the command failed with.
+ * The protocol has no request ids, replies come back in the order commands were sent: a batch
+ * may have up to the pipeline depth commands in flight and replies are matched by position.
+ * Whenever a pipelined reply is missing or not a plain '=' reply, the replies still outstanding for
+ * the batch are read and dropped, then that command goes through the usual one at a time path with
+ * its retries.
+ *
+ * Only batch inquiries: a command in flight when the link fails is sent again.
+ */
+class SkywatcherQueue
+{
+    public:
+        struct Link
+        {
+            // Send a command (without the trailing CR), throw EQModError on failure
+            std::function<void(const std::string &)> write;
+            // Read one reply (without the trailing CR), throw EQModError on failure
+            std::function<std::string()> read;
+            // Drop anything pending on the link
+            std::function<void()> flush;
+            // Command succeeded after retries
+            std::function<void(const std::string &, int)> retried;
+        };
+
+        struct Latency
+        {
+            double last { 0 };
+            double mean { 0 };
+            double max { 0 };
+            uint64_t count { 0 };
+        };
+
+        SkywatcherQueue(Link link, uint8_t maxRetry, long retryDelayUs);
+        ~SkywatcherQueue();
+
+        void setPipelineDepth(size_t depth);
+        size_t getPipelineDepth();
+
+        std::future<std::string> submit(const std::string &command);
+        std::vector<std::future<std::string>> submit(const std::vector<std::string> &commands);
+
+        // Round trip per command in ms
+        Latency getLatency();
+        void resetLatency();
+
+        void stop();
+
+    private:
+        struct Request
+        {
+            std::string command;
+            std::promise<std::string> reply;
+            std::chrono::steady_clock::time_point sent;
+        };
+        typedef std::vector<Request> Batch;
+
+        void run();
+        void process(Batch &batch);
+        size_t pipeline(Batch &batch, size_t first, size_t count);
+        void discard(size_t outstanding);
+        std::string transact(Request &request);
+        void check(const std::string &command, const std::string &reply);
+        void answered(Request &request, const std::string &reply);
+
+        Link link;
+        const uint8_t maxRetry;
+        const long retryDelayUs;
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<Batch> pending;
+        std::thread thread;
+        bool quit { false };
+        size_t depth { 1 };
+        Latency latency;
+};
@@ -1,8 +1,14 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <random>
+
 #include "config.h"
 #include "eqmodbase.h"
+#include "skywatcherqueue.h"
 
 
 using ::testing::_;
@@ -451,8 +457,372 @@ TEST(EqmodTest, scope_limits_altaz)
 
     ASSERT_TRUE(hl->ISNewSwitch(eqmod.getDeviceName(), "HORIZONLIMITSMANAGE", iss_on, (char**) manage_clear, 1));
 }
+
+// Horizon evaluation by binary search, as HorizonLimits did before its lookup table
+static bool horizonReference(const std::vector<INDI::IHorizontalCoordinates> &horizon, double az, double alt)
+{
+    INDI::IHorizontalCoordinates const scope{az, alt};
+    auto next = std::lower_bound(horizon.begin(), horizon.end(), scope, HorizonLimits::cmp);
+    if (next == horizon.end())
+        next = horizon.begin();
+    if (next->azimuth == scope.azimuth)
+        return (scope.altitude >= next->altitude);
+    auto const prev = ((next == horizon.begin()) ? horizon.end() : next) - 1;
+    if (prev->altitude == next->altitude)
+        return (scope.altitude >= next->altitude);
+    double const delta_horizon_az = (next->azimuth - prev->azimuth) + ((next->azimuth >= prev->azimuth) ? 0.0 : 360.0);
+    double const delta_scope_az = (scope.azimuth - prev->azimuth) + ((scope.azimuth >= prev->azimuth) ? 0.0 : 360.0);
+    return (scope.altitude >= prev->altitude + (next->altitude - prev->altitude) * delta_scope_az / delta_horizon_az);
+}
+
+TEST(EqmodTest, scope_limits_table)
+{
+    TestEQMod eqmod;
+    HorizonLimits * const hl = eqmod.horizon;
+    ASSERT_NE(hl, nullptr);
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> az(0.0, 360.0), alt(0.0, 30.0);
+    const char * names[] = { "HORIZONLIMITS_POINT_AZ", "HORIZONLIMITS_POINT_ALT" };
+    std::vector<INDI::IHorizontalCoordinates> horizon;
+    for (int i = 0; i < 2000; i++)
+    {
+        double values[] = { az(rng), alt(rng) };
+        ASSERT_TRUE(hl->ISNewNumber(eqmod.getDeviceName(), "HORIZONLIMITSPOINT", values, (char**) names, 2));
+        horizon.push_back({ values[0], values[1] });
+    }
+    std::sort(horizon.begin(), horizon.end(), HorizonLimits::cmp);
+
+    // Random positions, horizon points themselves and a tracking-like sweep
+    std::vector<INDI::IHorizontalCoordinates> queries;
+    for (int i = 0; i < 100000; i++)
+        queries.push_back({ az(rng), alt(rng) });
+    for (auto const &point : horizon)
+        queries.push_back(point);
+    for (double a = -5.0; a < 365.0; a += 0.1)
+        queries.push_back({ a, 15.0 });
+
+    for (auto const &q : queries)
+        ASSERT_EQ(hl->inLimits(q.azimuth, q.altitude), horizonReference(horizon, q.azimuth, q.altitude)) << "az=" << q.azimuth;
+
+    // The first point below the horizon is reported
+    std::vector<INDI::IHorizontalCoordinates> path;
+    for (double a = 10.0; a < 50.0; a += 1.0)
+        path.push_back({ a, 45.0 });
+    EXPECT_EQ(hl->checkPath(path), -1);
+    path[17].altitude = -1.0;
+    path[23].altitude = -1.0;
+    EXPECT_EQ(hl->checkPath(path), 17);
+}
+#endif
+
+#ifdef WITH_ALIGN_GEEHALEL
+// Sync points scattered over the sky, each telescope position a few arcminutes off its target
+static void addRandomPoints(PointSet &pointset, int npoints, std::mt19937 &rng, INDI::IGeographicCoordinates *pos)
+{
+    std::uniform_real_distribution<double> ra(0.0, 24.0), sindec(-0.5, 1.0), offset(-0.3, 0.3);
+
+    pointset.Init();
+    for (int i = 0; i < npoints; i++)
+    {
+        AlignData data;
+        data.jd           = 2460000.5;
+        data.lst          = 0.0;
+        data.targetRA     = ra(rng);
+        data.targetDEC    = asin(sindec(rng)) * 180.0 / M_PI;
+        data.telescopeRA  = range24(data.targetRA + offset(rng) / 15.0);
+        data.telescopeDEC = data.targetDEC + offset(rng);
+        pointset.AddPoint(data, pos);
+    }
+}
+
+static PointSet::Point skyPoint(double alt, double az)
+{
+    PointSet::Point p;
+    double horangle = range360(-180.0 - az) * M_PI / 180.0;
+    double altangle = alt * M_PI / 180.0;
+    p.cx = cos(altangle) * cos(horangle);
+    p.cy = cos(altangle) * sin(horangle);
+    p.cz = sin(altangle);
+    return p;
+}
+
+// Linear scan over all faces, what locateFace did before the index
+static bool insideAnyFace(PointSet &pointset, double alt, double az, bool ingoto)
+{
+    PointSet::Point p = skyPoint(alt, az);
+    for (const PointSet::FaceEntry &face : pointset.getFaceTable())
+    {
+        if (pointset.isPointInside(&p, std::vector<HtmID>(face.v, face.v + 3), ingoto))
+            return true;
+    }
+    return false;
+}
+
+// The indexed face lookup must find the same faces as a linear scan
+TEST(EqmodTest, align_face_lookup)
+{
+    TestEQMod eqmod;
+    INDI::IGeographicCoordinates pos { 15.0, 50.0, 0.0 };
+    const int nqueries = 5000;
+
+    for (int npoints : { 100, 300, 1000 })
+    {
+        std::mt19937 rng(npoints);
+        std::uniform_real_distribution<double> alt(-20.0, 90.0), az(0.0, 360.0);
+
+        PointSet pointset(&eqmod);
+        addRandomPoints(pointset, npoints, rng, &pos);
+        ASSERT_GT(pointset.getFaceTable().size(), 0u);
+
+        std::vector<double> qalt(nqueries), qaz(nqueries);
+        for (int i = 0; i < nqueries; i++)
+        {
+            qalt[i] = alt(rng);
+            qaz[i]  = az(rng);
+        }
+
+        for (bool ingoto : { false, true })
+        {
+            for (int i = 0; i < nqueries; i++)
+            {
+                const PointSet::FaceEntry *found = pointset.locateFace(qalt[i], qaz[i], ingoto);
+                ASSERT_EQ(found != nullptr, insideAnyFace(pointset, qalt[i], qaz[i], ingoto));
+                if (found)
+                {
+                    PointSet::Point p = skyPoint(qalt[i], qaz[i]);
+                    ASSERT_TRUE(pointset.isPointInside(&p, std::vector<HtmID>(found->v, found->v + 3), ingoto));
+                }
+            }
+        }
+    }
+}
+
+// Face lookup timings, not run by default: test_eqmod --gtest_also_run_disabled_tests --gtest_filter=*benchmark*
+TEST(EqmodTest, DISABLED_align_face_lookup_benchmark)
+{
+    TestEQMod eqmod;
+    INDI::IGeographicCoordinates pos { 15.0, 50.0, 0.0 };
+    const int nqueries = 5000;
+
+    for (int npoints : { 100, 300, 1000 })
+    {
+        std::mt19937 rng(npoints);
+        std::uniform_real_distribution<double> alt(-20.0, 90.0), az(0.0, 360.0);
+
+        PointSet pointset(&eqmod);
+        addRandomPoints(pointset, npoints, rng, &pos);
+
+        std::vector<double> qalt(nqueries), qaz(nqueries);
+        for (int i = 0; i < nqueries; i++)
+        {
+            qalt[i] = alt(rng);
+            qaz[i]  = az(rng);
+        }
+
+        for (bool ingoto : { false, true })
+        {
+            int hits = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < nqueries; i++)
+                hits += pointset.locateFace(qalt[i], qaz[i], ingoto) != nullptr;
+            std::chrono::duration<double, std::micro> indexed = std::chrono::steady_clock::now() - start;
+
+            int scanned = 0;
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < nqueries; i++)
+                scanned += insideAnyFace(pointset, qalt[i], qaz[i], ingoto);
+            std::chrono::duration<double, std::micro> linear = std::chrono::steady_clock::now() - start;
+
+            EXPECT_EQ(hits, scanned);
+            printf("%4d points, %4zu faces, %s: indexed %.2f us, linear %.2f us per lookup\n", npoints,
+                   pointset.getFaceTable().size(), ingoto ? "goto" : "sync", indexed.count() / nqueries,
+                   linear.count() / nqueries);
+        }
+    }
+}
+
+// The k nearest points must be the first ones ComputeDistances orders, with or without the HTM prefilter
+TEST(EqmodTest, align_nearest_points)
+{
+    TestEQMod eqmod;
+    INDI::IGeographicCoordinates pos { 15.0, 50.0, 0.0 };
+    const int nqueries = 1000;
+    const int k = 5;
+    const double radius = 10.0 * M_PI / 180.0;
+
+    for (int npoints : { 100, 1000 })
+    {
+        std::mt19937 rng(npoints);
+        std::uniform_real_distribution<double> alt(-20.0, 90.0), az(0.0, 360.0);
+
+        PointSet pointset(&eqmod);
+        addRandomPoints(pointset, npoints, rng, &pos);
+
+        for (bool ingoto : { false, true })
+        {
+            std::vector<PointSet::Distance> nearest, close;
+
+            for (int q = 0; q < nqueries; q++)
+            {
+                double qalt = alt(rng), qaz = az(rng);
+
+                std::set<PointSet::Distance, bool (*)(PointSet::Distance, PointSet::Distance)> *distances =
+                    pointset.ComputeDistances(qalt, qaz, PointSet::None, ingoto);
+                ASSERT_EQ(pointset.findNearest(qalt, qaz, ingoto, k, nearest), k);
+                int nclose = pointset.findNearest(qalt, qaz, ingoto, k, close, radius);
+
+                auto it = distances->begin();
+                for (int i = 0; i < k; i++, it++)
+                {
+                    ASSERT_EQ(nearest[i].htmID, it->htmID);
+                    EXPECT_NEAR(nearest[i].value, it->value, 1e-9);
+                    if (i < nclose)
+                        ASSERT_EQ(close[i].htmID, it->htmID);
+                    else
+                        ASSERT_GT(it->value, radius - 1e-9);
+                }
+                delete distances;
+            }
+        }
+    }
+}
 #endif
 
+// Mount side of a SkywatcherQueue, replies to what was written in order
+struct FakeMountLink
+{
+    // Commands whose reply has not been read yet
+    std::deque<std::string> written;
+    // Scripted replies in command order: "" is lost, "~..." arrives only after the read timed out
+    std::deque<std::string> replies;
+    // Late replies, delivered to the next reads whatever was flushed in between
+    std::deque<std::string> late;
+    size_t maxInFlight { 0 };
+    int retries { 0 };
+
+    SkywatcherQueue::Link link()
+    {
+        SkywatcherQueue::Link link;
+        link.write = [this](const std::string & cmd)
+        {
+            written.push_back(cmd);
+            maxInFlight = std::max(maxInFlight, written.size());
+        };
+        link.read = [this]()
+        {
+            if (!late.empty())
+            {
+                std::string reply = late.front();
+                late.pop_front();
+                return reply;
+            }
+            if (written.empty())
+                throw EQModError(EQModError::ErrDisconnect, "timeout");
+            std::string cmd = written.front();
+            written.pop_front();
+            if (replies.empty())
+                return "=" + cmd.substr(1);
+            std::string reply = replies.front();
+            replies.pop_front();
+            if (!reply.empty() && reply[0] == '~')
+                late.push_back(reply.substr(1));
+            if (reply.empty() || reply[0] == '~')
+                throw EQModError(EQModError::ErrDisconnect, "timeout");
+            return reply;
+        };
+        link.flush = []()
+        {
+            // Only drops what was already received, replies still in flight come afterwards
+        };
+        link.retried = [this](const std::string &, int count)
+        {
+            retries = count;
+        };
+        return link;
+    }
+};
+
+TEST(SkywatcherQueueTest, pipelined_replies_in_order)
+{
+    FakeMountLink mount;
+    SkywatcherQueue queue(mount.link(), 10, 0);
+    queue.setPipelineDepth(4);
+
+    std::vector<std::future<std::string>> replies = queue.submit({ ":j1", ":j2", ":f1", ":f2", ":d1", ":d2" });
+    ASSERT_EQ(replies.size(), 6u);
+    EXPECT_EQ(replies[0].get(), "=j1");
+    EXPECT_EQ(replies[1].get(), "=j2");
+    EXPECT_EQ(replies[2].get(), "=f1");
+    EXPECT_EQ(replies[3].get(), "=f2");
+    EXPECT_EQ(replies[4].get(), "=d1");
+    EXPECT_EQ(replies[5].get(), "=d2");
+    EXPECT_EQ(mount.maxInFlight, 4u);
+    EXPECT_EQ(queue.getLatency().count, 6u);
+}
+
+TEST(SkywatcherQueueTest, failed_reply_is_retried)
+{
+    FakeMountLink mount;
+    // "=x" answers :f1 of the broken batch and must not reach anybody
+    mount.replies = { "=A", "!0", "=x", "!0", "=B", "=C" };
+    SkywatcherQueue queue(mount.link(), 10, 0);
+    queue.setPipelineDepth(3);
+
+    std::vector<std::future<std::string>> replies = queue.submit({ ":j1", ":j2", ":f1" });
+    EXPECT_EQ(replies[0].get(), "=A");
+    EXPECT_EQ(replies[1].get(), "=B");
+    EXPECT_EQ(replies[2].get(), "=C");
+    EXPECT_EQ(mount.retries, 1);
+}
+
+TEST(SkywatcherQueueTest, outstanding_replies_are_dropped)
+{
+    FakeMountLink mount;
+    // :j1 fails while the replies to :j2 and :f1 are already on their way
+    mount.replies = { "!0", "=B", "=C", "=A" };
+    SkywatcherQueue queue(mount.link(), 10, 0);
+    queue.setPipelineDepth(3);
+
+    std::vector<std::future<std::string>> replies = queue.submit({ ":j1", ":j2", ":f1" });
+    EXPECT_EQ(replies[0].get(), "=A");
+    EXPECT_EQ(replies[1].get(), "=j2");
+    EXPECT_EQ(replies[2].get(), "=f1");
+    EXPECT_TRUE(mount.written.empty());
+}
+
+TEST(SkywatcherQueueTest, late_reply_is_not_taken_by_retry)
+{
+    FakeMountLink mount;
+    // The reply to :j2 only comes after its read timed out, with the one to :f1 behind it
+    mount.replies = { "=A", "~=B", "=C", "=D" };
+    SkywatcherQueue queue(mount.link(), 10, 0);
+    queue.setPipelineDepth(3);
+
+    std::vector<std::future<std::string>> replies = queue.submit({ ":j1", ":j2", ":f1" });
+    EXPECT_EQ(replies[0].get(), "=A");
+    EXPECT_EQ(replies[1].get(), "=D");
+    EXPECT_EQ(replies[2].get(), "=f1");
+
+    // Nothing stale left on the link
+    EXPECT_EQ(queue.submit(":j3").get(), "=j3");
+    EXPECT_TRUE(mount.written.empty());
+    EXPECT_TRUE(mount.late.empty());
+}
+
+TEST(SkywatcherQueueTest, read_error_reaches_caller)
+{
+    FakeMountLink mount;
+    mount.replies = { "", "", "" };
+    SkywatcherQueue queue(mount.link(), 3, 0);
+
+    std::future<std::string> reply = queue.submit(":j1");
+    EXPECT_THROW(reply.get(), EQModError);
+
+    // Still usable afterwards
+    EXPECT_EQ(queue.submit(":j2").get(), "=j2");
+}
+
 int main(int argc, char **argv)
 {
     INDI::Logger::getInstance().configure("", INDI::Logger::file_off,
@@ -39,6 +39,7 @@
 #define MAX_X_BIN      16   /* Max Horizontal binning */
 #define MAX_Y_BIN      16   /* Max Vertical binning */
 #define TEMP_THRESHOLD .25  /* Differential temperature threshold (C)*/
+#define READOUT_BATCH  32   /* Rows grabbed per ccdBufferLock */
 
 static std::unique_ptr<FLICCD> fliCCD(new FLICCD());
 
@@ -51,6 +52,7 @@ FLICCD::FLICCD()
 
 FLICCD::~FLICCD()
 {
+    m_Readout.stop();
     delete [] CameraModeS;
 }
 
@@ -94,6 +96,17 @@ bool FLICCD::initProperties()
     IUFillSwitchVector(&BackgroundFlushSP, BackgroundFlushS, 2, getDeviceName(), "CCD_BACKGROUND_FLUSH", "BKG. Flush",
                        OPTIONS_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
 
+    // Statistics of the last download
+    IUFillNumber(&ReadoutStatsN[STATS_ROWS], "ROWS", "Rows", "%.f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_MIN], "MIN", "Min", "%.f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_MAX], "MAX", "Max", "%.f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_MEAN], "MEAN", "Mean", "%.1f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_MEDIAN], "MEDIAN", "Median", "%.f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_CHECKSUM], "CHECKSUM", "Checksum", "%.f", 0, 4294967295., 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_DURATION], "DURATION", "Duration (ms)", "%.f", 0, 1e6, 0, 0);
+    IUFillNumberVector(&ReadoutStatsNP, ReadoutStatsN, 7, getDeviceName(), "CCD_READOUT_STATS", "Last readout",
+                       IMAGE_INFO_TAB, IP_RO, 0, IPS_IDLE);
+
     SetCCDCapability(CCD_CAN_ABORT | CCD_CAN_BIN | CCD_CAN_SUBFRAME | CCD_HAS_COOLER | CCD_HAS_SHUTTER);
 
     PrimaryCCD.setMinMaxStep("CCD_EXPOSURE", "CCD_EXPOSURE_VALUE", 0.04, 3600, 1, false);
@@ -120,6 +133,7 @@ bool FLICCD::updateProperties()
         defineProperty(&CoolerNP);
         defineProperty(&FlushNP);
         defineProperty(&BackgroundFlushSP);
+        defineProperty(&ReadoutStatsNP);
 
         setupParams();
 
@@ -134,6 +148,7 @@ bool FLICCD::updateProperties()
         deleteProperty(CoolerNP.name);
         deleteProperty(FlushNP.name);
         deleteProperty(BackgroundFlushSP.name);
+        deleteProperty(ReadoutStatsNP.name);
 
         if (CameraModeS != nullptr)
             deleteProperty(CameraModeSP.name);
@@ -153,6 +168,14 @@ bool FLICCD::ISNewNumber(const char *dev, const char *name, double values[], cha
             int err = 0;
             long nflushes = values[0];
 
+            if (m_Readout.isRunning())
+            {
+                LOG_ERROR("Cannot change the flushes while the image is downloading.");
+                FlushNP.s = IPS_ALERT;
+                IDSetNumber(&FlushNP, nullptr);
+                return true;
+            }
+
             if ((err = FLISetNFlushes(fli_dev, nflushes)))
             {
                 LOGF_DEBUG("Error: FLISetNFlushes() failed. %s.", strerror(-err));
@@ -191,6 +214,14 @@ bool FLICCD::ISNewSwitch(const char *dev, const char *name, ISState *states, cha
         {
             int err = 0;
             bool enabled = !strcmp(IUFindOnSwitchName(states, names, n), "ENABLED");
+
+            if (m_Readout.isRunning())
+            {
+                LOG_ERROR("Cannot change background flushing while the image is downloading.");
+                BackgroundFlushSP.s = IPS_ALERT;
+                IDSetSwitch(&BackgroundFlushSP, nullptr);
+                return true;
+            }
             if ((err = FLIControlBackgroundFlush(fli_dev, enabled ? FLI_BGFLUSH_START : FLI_BGFLUSH_STOP)))
             {
                 LOGF_ERROR("Error: FLIControlBackgroundFlush() %s failed. %s.", (enabled ? "starting" : "stopping"), strerror(-err));
@@ -211,6 +242,14 @@ bool FLICCD::ISNewSwitch(const char *dev, const char *name, ISState *states, cha
         // Camera Modes
         if (!strcmp(name, CameraModeSP.name) && CameraModeS != nullptr)
         {
+            if (m_Readout.isRunning())
+            {
+                LOG_ERROR("Cannot change the camera mode while the image is downloading.");
+                CameraModeSP.s = IPS_ALERT;
+                IDSetSwitch(&CameraModeSP, nullptr);
+                return true;
+            }
+
             int currentIndex = IUFindOnSwitchIndex(&CameraModeSP);
             LIBFLIAPI errCode = 0;
             IUUpdateSwitch(&CameraModeSP, states, names, n);
@@ -274,6 +313,8 @@ bool FLICCD::Disconnect()
 {
     int err;
 
+    m_Readout.stop();
+
     if (sim)
         return true;
 
@@ -493,6 +534,14 @@ int FLICCD::SetTemperature(double temperature)
 {
     int err = 0;
 
+    // Sent from TimerHit once the download is over
+    if (m_Readout.isRunning())
+    {
+        m_TemperaturePending = true;
+        m_PendingTemperature = temperature;
+        return 0;
+    }
+
     if (!sim && (err = FLISetTemperature(fli_dev, temperature)))
     {
         LOGF_ERROR("FLISetTemperature() failed. %s.", strerror(-err));
@@ -509,6 +558,12 @@ bool FLICCD::StartExposure(float duration)
 {
     int err = 0;
 
+    if (m_Readout.isRunning())
+    {
+        LOG_ERROR("Previous image is still downloading.");
+        return false;
+    }
+
     if (PrimaryCCD.getFrameType() == INDI::CCDChip::BIAS_FRAME)
     {
         // TODO check if this work with the SDK
@@ -543,6 +598,10 @@ bool FLICCD::AbortExposure()
 {
     int err = 0;
 
+    // Stop the download between batches, cancelling below resets the camera
+    if (m_Readout.isRunning())
+        m_Readout.stop();
+
     if (!sim && (err = FLICancelExposure(fli_dev)))
     {
         LOGF_ERROR("FLICancelExposure() failed. %s.", strerror(-err));
@@ -559,6 +618,12 @@ bool FLICCD::UpdateCCDFrameType(INDI::CCDChip::CCD_FRAME fType)
         return true;
 
     int err = 0;
+
+    if (m_Readout.isRunning())
+    {
+        LOG_ERROR("Cannot change the frame type while the image is downloading.");
+        return false;
+    }
     switch (fType)
     {
         case INDI::CCDChip::BIAS_FRAME:
@@ -587,6 +652,12 @@ bool FLICCD::UpdateCCDFrame(int x, int y, int w, int h)
 {
     int err = 0;
 
+    if (m_Readout.isRunning())
+    {
+        LOG_ERROR("Cannot change the frame while the image is downloading.");
+        return false;
+    }
+
     long bin_right  = x + (w / PrimaryCCD.getBinX());
     long bin_bottom = y + (h / PrimaryCCD.getBinY());
 
@@ -624,6 +695,12 @@ bool FLICCD::UpdateCCDBin(int binx, int biny)
 {
     int err = 0;
 
+    if (m_Readout.isRunning())
+    {
+        LOG_ERROR("Cannot change the binning while the image is downloading.");
+        return false;
+    }
+
     /* X horizontal binning */
     if (!sim && (err = FLISetHBin(fli_dev, binx)))
     {
@@ -643,48 +720,80 @@ bool FLICCD::UpdateCCDBin(int binx, int biny)
     return UpdateCCDFrame(PrimaryCCD.getSubX(), PrimaryCCD.getSubY(), PrimaryCCD.getSubW(), PrimaryCCD.getSubH());
 }
 
-// Downloads the image from the CCD.
+// Downloads the image from the CCD on the download thread, ccdBufferLock is released between batches of rows.
 bool FLICCD::grabImage()
 {
-    std::unique_lock<std::mutex> guard(ccdBufferLock);
-    int err        = 0;
-    uint8_t *image = PrimaryCCD.getFrameBuffer();
-    int row_size   = PrimaryCCD.getSubW() / PrimaryCCD.getBinX() * PrimaryCCD.getBPP() / 8;
-    int width      = PrimaryCCD.getSubW() / PrimaryCCD.getBinX();
-    int height     = PrimaryCCD.getSubH() / PrimaryCCD.getBinY();
+    int width  = PrimaryCCD.getSubW() / PrimaryCCD.getBinX();
+    int height = PrimaryCCD.getSubH() / PrimaryCCD.getBinY();
 
-    if (sim)
+    m_Readout.setFrame(PrimaryCCD.getFrameBuffer(), width, height, PrimaryCCD.getBPP() / 8);
+    m_Readout.setBatch(READOUT_BATCH);
+    m_Readout.setLock(&ccdBufferLock);
+    m_Readout.start([this](PixelShuffle::RowReadout & readout)
     {
-        for (int i = 0; i < height; i++)
-            for (int j = 0; j < row_size; j++)
-                image[i * row_size + j] = rand() % 255;
-    }
-    else
+        return readRows(readout);
+    },
+    [this](bool ok)
     {
-        bool success = true;
-        for (int i = 0; i < height; i++)
+        readoutDone(ok);
+    });
+
+    return true;
+}
+
+bool FLICCD::readRows(PixelShuffle::RowReadout &readout)
+{
+    int row_size = PrimaryCCD.getSubW() / PrimaryCCD.getBinX() * PrimaryCCD.getBPP() / 8;
+    int width    = PrimaryCCD.getSubW() / PrimaryCCD.getBinX();
+    bool success = true;
+
+    bool done = readout.read([&](int row, uint8_t *image)
+    {
+        int err = 0;
+
+        if (sim)
         {
-            if ((err = FLIGrabRow(fli_dev, image + (i * row_size), width)))
+            for (int j = 0; j < row_size; j++)
+                image[j] = rand() % 255;
+        }
+        else if ((err = FLIGrabRow(fli_dev, image, width)))
+        {
+            /* print this error once but read to the end to flush the array */
+            if (success)
             {
-                /* print this error once but read to the end to flush the array */
-                if (success)
-                {
-                    LOGF_ERROR("FLIGrabRow() failed at row %d. %s.", i, strerror(-err));
-                    success = false;
-                }
+                LOGF_ERROR("FLIGrabRow() failed at row %d. %s.", row, strerror(-err));
+                success = false;
             }
         }
+        return true;
+    });
 
-        if (!success)
-            return false;
+    return done && success;
+}
+
+void FLICCD::readoutDone(bool ok)
+{
+    if (!ok)
+    {
+        if (!m_Readout.isAborted())
+            PrimaryCCD.setExposureFailed();
+        return;
     }
-    guard.unlock();
+
+    const PixelShuffle::ReadoutStats &stats = m_Readout.stats();
+    ReadoutStatsN[STATS_ROWS].value     = stats.rows;
+    ReadoutStatsN[STATS_MIN].value      = stats.min;
+    ReadoutStatsN[STATS_MAX].value      = stats.max;
+    ReadoutStatsN[STATS_MEAN].value     = stats.mean;
+    ReadoutStatsN[STATS_MEDIAN].value   = stats.median();
+    ReadoutStatsN[STATS_CHECKSUM].value = stats.checksum;
+    ReadoutStatsN[STATS_DURATION].value = stats.duration;
+    ReadoutStatsNP.s = IPS_OK;
+    IDSetNumber(&ReadoutStatsNP, nullptr);
 
     LOG_INFO("Download complete.");
 
     ExposureComplete(&PrimaryCCD);
-
-    return true;
 }
 
 void FLICCD::TimerHit()
@@ -745,6 +854,24 @@ void FLICCD::TimerHit()
         }
     }
 
+    // The camera is busy with the download, poll the temperature next time
+    if (m_Readout.isRunning())
+    {
+        if (timerID == -1)
+            SetTimer(getCurrentPollingPeriod());
+        return;
+    }
+
+    if (m_TemperaturePending)
+    {
+        m_TemperaturePending = false;
+        if (SetTemperature(m_PendingTemperature) < 0)
+        {
+            TemperatureNP.s = IPS_ALERT;
+            IDSetNumber(&TemperatureNP, nullptr);
+        }
+    }
+
     switch (TemperatureNP.s)
     {
         case IPS_IDLE:
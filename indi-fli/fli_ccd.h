@@ -25,6 +25,7 @@
 
 #include <libfli.h>
 #include <indiccd.h>
+#include <rowreadout.h>
 #include <iostream>
 
 using namespace std;
@@ -67,8 +68,10 @@ class FLICCD : public INDI::CCD
         // Calculate Time until exposure is complete
         float calcTimeLeft();
 
-        // Fetch image row by row from the CCD
+        // Fetch image row by row from the CCD on the download thread
         bool grabImage();
+        bool readRows(PixelShuffle::RowReadout &readout);
+        void readoutDone(bool ok);
 
         // Get initial CCD values upon connection
         bool setupParams();
@@ -107,6 +110,24 @@ class FLICCD : public INDI::CCD
         ISwitch *CameraModeS = nullptr;
         ISwitchVectorProperty CameraModeSP;
 
+        INumber ReadoutStatsN[7];
+        INumberVectorProperty ReadoutStatsNP;
+        enum
+        {
+            STATS_ROWS,
+            STATS_MIN,
+            STATS_MAX,
+            STATS_MEAN,
+            STATS_MEDIAN,
+            STATS_CHECKSUM,
+            STATS_DURATION
+        };
+
+        PixelShuffle::RowReadout m_Readout;
+        // libfli is not called between the rows of a download, a set point sent meanwhile waits here
+        bool m_TemperaturePending = false;
+        double m_PendingTemperature = 0;
+
         int timerID = 0;
 
         // Exposure timing
@@ -22,14 +22,26 @@
 #ifndef _GNU_SOURCE
 #define _GNU_SOURCE
 #endif
+#include <stdlib.h>
 #include <string.h>
 
 #define BLACKFLY_MODEL "BFLY-PGE-31S4M"
+#define FAKE_CAMERA_ENV "INDI_GIGE_FAKE_CAMERA"
+#define FAKE_CAMERA_ID  "Fake_1"
 
 arv::ArvCamera *ArvFactory::find_first_available(void)
 {
     GError *error = NULL;
-    ::ArvCamera *camera    = arv_camera_new(nullptr, &error);
+
+    /* aravis' built-in fake camera, to test the driver without hardware */
+    const char *device_id = nullptr;
+    if (getenv(FAKE_CAMERA_ENV) != nullptr)
+    {
+        arv_enable_interface("Fake");
+        device_id = FAKE_CAMERA_ID;
+    }
+
+    ::ArvCamera *camera    = arv_camera_new(device_id, &error);
     const char *model_name = arv_camera_get_model_name(camera, &error);
 
     if ((camera == nullptr) || (model_name == nullptr))
@@ -136,7 +136,7 @@ bool ArvGeneric::connect()
         this->cam.vendor_name = arv_camera_get_vendor_name(this->camera, &(this->error));
         this->cam.device_id   = arv_camera_get_device_id(this->camera, &(this->error));
     }
-    return true;
+    return this->_configure();
 }
 
 bool ArvGeneric::_configure(void)
@@ -151,6 +151,8 @@ void ArvGeneric::_init()
     this->buffer        = nullptr;
     this->stream        = nullptr;
     this->stream_active = false;
+    this->video_stream  = nullptr;
+    this->error         = nullptr;
 
     /* Don't clear device_id, its needed to re-attach with connect() */
 }
@@ -160,6 +162,7 @@ bool ArvGeneric::disconnect()
     if (this->is_connected())
     {
         this->_test_exposure_and_abort();
+        this->video_stop();
         g_clear_object(&this->camera);
     }
     this->_init();
@@ -171,8 +174,10 @@ bool ArvGeneric::_set_initial_config()
      *      (1) disable auto exposure
      *      (2) disable auto framerate (to enable maximum possible exposure time)
      *      (3) set binning to 1x1
-     *      (4) set software trigger */
+     *      (4) set software trigger
+     *      (5) set 16 bit mono pixels, which get_bpp() reports */
     arv_camera_set_binning(camera, 1, 1, &error);
+    arv_camera_set_pixel_format(camera, ARV_PIXEL_FORMAT_MONO_16, &error);
     arv_camera_set_gain_auto(camera, ARV_AUTO_OFF, &error);
     arv_camera_set_exposure_time_auto(camera, ARV_AUTO_OFF, &error);
     arv_camera_set_trigger(camera, "Software", &error);
@@ -263,6 +268,10 @@ void ArvGeneric::set_exposure_time(double const val)
 {
     this->_set_cam_exposure_property(arv_camera_set_exposure_time, &this->cam.exposure, val);
 }
+void ArvGeneric::set_frame_rate(double const val)
+{
+    this->_set_cam_exposure_property(arv_camera_set_frame_rate, &this->cam.frame_rate, val);
+}
 
 ::ArvBuffer *ArvGeneric::_buffer_create(void)
 {
@@ -382,3 +391,100 @@ ARV_EXPOSURE_STATUS ArvGeneric::exposure_poll(void (*fn_image_callback)(void *co
             return ARV_EXPOSURE_UNKNOWN;
     }
 }
+
+bool ArvGeneric::_check_error(const char *what)
+{
+    if (this->error == nullptr)
+        return true;
+
+    printf("%s: %s\n", what, this->error->message);
+    g_clear_error(&this->error);
+    return false;
+}
+
+bool ArvGeneric::is_video_active(void)
+{
+    return (this->video_stream ? true : false);
+}
+
+bool ArvGeneric::video_start(size_t const n_buffers)
+{
+    this->_test_exposure_and_abort();
+    this->video_stop();
+    g_clear_error(&this->error);
+
+    this->video_stream = this->_stream_create();
+    if (!this->_check_error("arv_camera_create_stream") || !this->video_stream)
+    {
+        g_clear_object(&this->video_stream);
+        return false;
+    }
+
+    /* Pre-queue the whole pool, buffers only go back and forth between stream and driver from now on */
+    gint const payload = arv_camera_get_payload(this->camera, &(this->error));
+    for (size_t i = 0; i < n_buffers; i++)
+        arv_stream_push_buffer(this->video_stream, arv_buffer_new(payload, nullptr));
+
+    /* Free running, the frame rate follows the exposure time */
+    arv_camera_clear_triggers(this->camera, &(this->error));
+    arv_camera_set_acquisition_mode(this->camera, ARV_ACQUISITION_MODE_CONTINUOUS, &(this->error));
+    arv_camera_start_acquisition(this->camera, &(this->error));
+    if (!this->_check_error("arv_camera_start_acquisition"))
+    {
+        this->video_stop();
+        return false;
+    }
+    return true;
+}
+
+void ArvGeneric::video_stop(void)
+{
+    if (!this->is_video_active())
+        return;
+
+    arv_camera_stop_acquisition(this->camera, &(this->error));
+    /* Releases the buffers still queued in the stream as well */
+    g_clear_object(&this->video_stream);
+
+    /* Back to triggered single frames */
+    arv_camera_set_trigger(this->camera, "Software", &(this->error));
+    g_clear_error(&this->error);
+}
+
+ARV_EXPOSURE_STATUS ArvGeneric::video_poll(void (*fn_image_callback)(void *const, uint8_t const *const, size_t),
+                                           void *const usr_ptr, uint64_t const timeout_us)
+{
+    if (!this->is_video_active())
+        return ARV_EXPOSURE_UNKNOWN;
+
+    ArvBuffer *const popped_buf = arv_stream_timeout_pop_buffer(this->video_stream, timeout_us);
+    if (popped_buf == nullptr)
+        return ARV_EXPOSURE_BUSY;
+
+    ARV_EXPOSURE_STATUS result = ARV_EXPOSURE_FAILED;
+    if (arv_buffer_get_status(popped_buf) == ARV_BUFFER_STATUS_SUCCESS)
+    {
+        if (fn_image_callback != nullptr)
+        {
+            size_t size;
+            uint8_t const *const data = (uint8_t const *const)arv_buffer_get_data(popped_buf, &size);
+            fn_image_callback(usr_ptr, data, size);
+        }
+        result = ARV_EXPOSURE_FINISHED;
+    }
+
+    /* Recycle, the buffer is queued for a later frame again */
+    arv_stream_push_buffer(this->video_stream, popped_buf);
+    return result;
+}
+
+void ArvGeneric::video_statistics(uint64_t *completed, uint64_t *failures, uint64_t *underruns)
+{
+    guint64 n_completed = 0, n_failures = 0, n_underruns = 0;
+    if (this->is_video_active())
+        arv_stream_get_statistics(this->video_stream, &n_completed, &n_failures, &n_underruns);
+
+    *completed = n_completed;
+    *failures  = n_failures;
+    *underruns = n_underruns;
+}
@@ -60,12 +60,20 @@ class ArvGeneric : public arv::ArvCamera
     void update_geometry(void);
     void set_exposure_time(double const val);
     void set_gain(double const val);
+    void set_frame_rate(double const val);
 
     void exposure_start(void);
     void exposure_abort(void);
     ARV_EXPOSURE_STATUS exposure_poll(void (*fn_image_callback)(void *const, uint8_t const *const, size_t),
                                       void *const usr_ptr);
 
+    bool video_start(size_t const n_buffers);
+    void video_stop(void);
+    bool is_video_active(void);
+    ARV_EXPOSURE_STATUS video_poll(void (*fn_image_callback)(void *const, uint8_t const *const, size_t),
+                                   void *const usr_ptr, uint64_t const timeout_us);
+    void video_statistics(uint64_t *completed, uint64_t *failures, uint64_t *underruns);
+
   protected:
     void _init(void);
     bool _configure(void);
@@ -76,8 +84,9 @@ class ArvGeneric : public arv::ArvCamera
     void _set_cam_exposure_property(void (*arv_set)(::ArvCamera *, T, GError**), min_max_property<T> *prop, T const new_val);
 
     const char *_str_val(const char *s);
-    bool _get_initial_config();
-    bool _set_initial_config();
+    /* Camera specific subclasses extend these, _configure() runs them on connect */
+    virtual bool _get_initial_config();
+    virtual bool _set_initial_config();
     void _get_image(void (*fn_image_callback)(void *const, uint8_t const *const, size_t), void *const usr_ptr);
 
     /* aravis library state variables */
@@ -97,6 +106,10 @@ class ArvGeneric : public arv::ArvCamera
 
     bool stream_active;
 
+    /* continuous acquisition, the stream owns the buffer pool */
+    ::ArvStream *video_stream;
+    bool _check_error(const char *what);
+
     /* Camera properties */
     struct
     {
@@ -104,11 +104,22 @@ class ArvCamera
     /* Set exposure */
     virtual void set_exposure_time(double const val) = 0;
     virtual void set_gain(double const val)          = 0;
+    virtual void set_frame_rate(double const val)    = 0;
 
     virtual void exposure_start(void)                      = 0;
     virtual void exposure_abort(void)                      = 0;
     virtual ARV_EXPOSURE_STATUS exposure_poll(void (*fn_image_callback)(void *const, uint8_t const *const, size_t),
                                               void *const) = 0;
+
+    /* Continuous acquisition: a stream with a pool of n_buffers pre-queued buffers, each frame is
+     * handed to the callback and its buffer recycled to the stream. video_poll() waits up to
+     * timeout_us for the next frame. */
+    virtual bool video_start(size_t const n_buffers) = 0;
+    virtual void video_stop(void)                    = 0;
+    virtual bool is_video_active(void)               = 0;
+    virtual ARV_EXPOSURE_STATUS video_poll(void (*fn_image_callback)(void *const, uint8_t const *const, size_t),
+                                           void *const, uint64_t const timeout_us) = 0;
+    virtual void video_statistics(uint64_t *completed, uint64_t *failures, uint64_t *underruns) = 0;
 };
 
 class ArvFactory
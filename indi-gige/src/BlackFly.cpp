@@ -72,12 +72,8 @@ error:
 bool BlackFly::connect(void)
 {
     printf("%s\n", __PRETTY_FUNCTION__);
-    bool const ret = ArvGeneric::connect();
-    if (ret)
-    {
-        this->_configure();
-    }
-    return ret;
+    /* Also applies the BlackFly initial configuration */
+    return ArvGeneric::connect();
 }
 
 void BlackFly::_fixup(void)
@@ -115,13 +111,6 @@ void BlackFly::exposure_start(void)
     ArvGeneric::exposure_start();
 }
 
-bool BlackFly::_configure(void)
-{
-    printf("%s\n", __PRETTY_FUNCTION__);
-    this->_set_initial_config();
-    return this->_get_initial_config();
-}
-
 bool BlackFly::_get_initial_config(void)
 {
     printf("%s\n", __PRETTY_FUNCTION__);
@@ -133,11 +122,12 @@ bool BlackFly::_get_initial_config(void)
     /* Probably can find this somewhere in genicam, too, but it depends on framerate
      * and the maximum exposure is consequently not published */
     this->cam.exposure.update(5000, 11900000);
+    return true;
 }
 
 bool BlackFly::_set_initial_config(void)
 {
     printf("%s\n", __PRETTY_FUNCTION__);
     ArvGeneric::_set_initial_config();
-    this->_custom_settings();
+    return this->_custom_settings();
 }
@@ -27,7 +27,6 @@ class BlackFly : public ArvGeneric
     void exposure_start(void);
 
   protected:
-    bool _configure(void);
     bool _get_initial_config();
     bool _set_initial_config();
 
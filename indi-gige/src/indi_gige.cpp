@@ -25,6 +25,7 @@
 
 #include "indidevapi.h"
 #include "eventloop.h"
+#include "stream/streammanager.h"
 
 #include "indi_gige.h"
 
@@ -43,7 +44,11 @@
 #define TIMER_US_TO_MS (1000)
 #define TIMER_US_TO_S  (1000000)
 #define TIMER_TICK_MS  (100)
-#define CAPS           (CCD_CAN_ABORT | CCD_CAN_BIN | CCD_CAN_SUBFRAME)
+#define CAPS           (CCD_CAN_ABORT | CCD_CAN_BIN | CCD_CAN_SUBFRAME | CCD_HAS_STREAMING)
+
+#define STREAM_POLL_TIMEOUT_US (100000UL) /* Lets the streaming thread notice a stop request */
+#define STREAM_STATS_TICKS     (10)       /* Publish video statistics once per second */
+#define STREAM_TAB             "Streaming"
 
 static class Loader
 {
@@ -71,12 +76,26 @@ GigECCD::GigECCD(arv::ArvCamera *camera)
 
 GigECCD::~GigECCD()
 {
+    if (this->stream_thread.joinable())
+        this->StopStreaming();
 }
 
 bool GigECCD::initProperties()
 {
     INDI::CCD::initProperties();
     this->SetCCDCapability((CAPS));
+
+    IUFillNumber(&this->indiprop_video_buffers[0], "Count", "", "%.f", 2., 64., 1., 8.);
+    IUFillNumberVector(&this->indiprop_video_buffers_prop, this->indiprop_video_buffers, 1, getDeviceName(),
+                       "Video Buffers", "", STREAM_TAB, IP_RW, 60, IPS_IDLE);
+
+    IUFillNumber(&this->indiprop_video_stats[0], "Completed", "", "%.f", 0., 1e12, 0., 0.);
+    IUFillNumber(&this->indiprop_video_stats[1], "Failures", "", "%.f", 0., 1e12, 0., 0.);
+    IUFillNumber(&this->indiprop_video_stats[2], "Underruns", "", "%.f", 0., 1e12, 0., 0.);
+    IUFillNumber(&this->indiprop_video_stats[3], "Bad Size", "", "%.f", 0., 1e12, 0., 0.);
+    IUFillNumberVector(&this->indiprop_video_stats_prop, this->indiprop_video_stats, 4, getDeviceName(),
+                       "Video Statistics", "", STREAM_TAB, IP_RO, 60, IPS_IDLE);
+
     this->addConfigurationControl();
     this->addDebugControl();
     return true;
@@ -127,12 +146,16 @@ void GigECCD::_update_indi_properties(void)
 
     defineProperty(&indiprop_info_prop);
     defineProperty(&this->indiprop_gain_prop);
+    defineProperty(&this->indiprop_video_buffers_prop);
+    defineProperty(&this->indiprop_video_stats_prop);
 }
 
 void GigECCD::_delete_indi_properties(void)
 {
     this->deleteProperty(this->indiprop_gain_prop.name);
     this->deleteProperty(this->indiprop_info_prop.name);
+    this->deleteProperty(this->indiprop_video_buffers_prop.name);
+    this->deleteProperty(this->indiprop_video_stats_prop.name);
 }
 
 //Initial call
@@ -198,6 +221,80 @@ bool GigECCD::AbortExposure()
     return true;
 }
 
+bool GigECCD::StartStreaming()
+{
+    LOGF_INFO("%s", __PRETTY_FUNCTION__);
+
+    Streamer->setPixelFormat(INDI_MONO, this->camera->get_bpp().val());
+    Streamer->setSize(PrimaryCCD.getSubW(), PrimaryCCD.getSubH());
+
+    /* Free running at the target rate, the camera clamps both */
+    double const fps = Streamer->getTargetFPS();
+    this->camera->set_exposure_time(1000000.0 / fps);
+    this->camera->set_frame_rate(fps);
+
+    if (!this->camera->video_start((size_t)this->indiprop_video_buffers[0].value))
+    {
+        LOG_ERROR("Failed to start continuous acquisition");
+        return false;
+    }
+
+    this->stream_bad_frames = 0;
+    this->stream_stat_ticks = 0;
+    this->stream_run        = true;
+    this->stream_thread     = std::thread(&GigECCD::_stream_loop, this);
+    return true;
+}
+
+bool GigECCD::StopStreaming()
+{
+    LOGF_INFO("%s", __PRETTY_FUNCTION__);
+
+    this->stream_run = false;
+    if (this->stream_thread.joinable())
+        this->stream_thread.join();
+
+    this->_update_video_statistics(true);
+    this->camera->video_stop();
+    return true;
+}
+
+void GigECCD::_stream_loop(void)
+{
+    while (this->stream_run)
+        this->camera->video_poll(this->_receive_frame_hook, this, STREAM_POLL_TIMEOUT_US);
+}
+
+void GigECCD::_receive_frame_hook(void *const class_ptr, uint8_t const *const data, size_t size)
+{
+    GigECCD *const cls = static_cast<GigECCD *const>(class_ptr);
+
+    /* Straight from the aravis buffer, it goes back to the pool when we return */
+    if (size != (size_t)cls->PrimaryCCD.getFrameBufferSize())
+    {
+        cls->stream_bad_frames++;
+        return;
+    }
+    cls->Streamer->newFrame(data, size);
+}
+
+void GigECCD::_update_video_statistics(bool force)
+{
+    if (!force && (++this->stream_stat_ticks < STREAM_STATS_TICKS))
+        return;
+    this->stream_stat_ticks = 0;
+
+    uint64_t completed, failures, underruns;
+    this->camera->video_statistics(&completed, &failures, &underruns);
+
+    this->indiprop_video_stats[0].value = completed;
+    this->indiprop_video_stats[1].value = failures;
+    this->indiprop_video_stats[2].value = underruns;
+    this->indiprop_video_stats[3].value = this->stream_bad_frames;
+    this->indiprop_video_stats_prop.s   = (failures || underruns) ? IPS_ALERT : IPS_OK;
+    IDSetNumber(&this->indiprop_video_stats_prop, nullptr);
+}
+
 void GigECCD::_update_image(uint8_t const *const data, size_t size)
 {
     LOGF_INFO("Receiving %i bytes image", size);
@@ -263,6 +360,9 @@ void GigECCD::_handle_timeout(struct timeval *const tv, uint32_t timeout_us)
 void GigECCD::TimerHit()
 {
     this->timer_id = this->SetTimer(TIMER_TICK_MS);
+    if (this->camera->is_connected() && this->camera->is_video_active())
+        this->_update_video_statistics(false);
+
     if (!this->camera->is_connected() || !this->camera->is_exposing())
         return;
 
@@ -302,6 +402,16 @@ bool GigECCD::ISNewNumber(const char *dev, const char *name, double values[], ch
             IDSetNumber(&this->indiprop_gain_prop, nullptr);
             return true;
         }
+
+        if (!strcmp(name, this->indiprop_video_buffers_prop.name))
+        {
+            IUUpdateNumber(&this->indiprop_video_buffers_prop, values, names, n);
+            this->indiprop_video_buffers_prop.s = IPS_OK;
+            IDSetNumber(&this->indiprop_video_buffers_prop, nullptr);
+            if (this->camera->is_video_active())
+                LOG_INFO("The new buffer count applies when streaming is restarted");
+            return true;
+        }
     }
 
     return INDI::CCD::ISNewNumber(dev, name, values, names, n);
@@ -311,6 +421,13 @@ bool GigECCD::UpdateCCDFrame(int x, int y, int w, int h)
 {
     LOGF_INFO("%s x=%i y=%i w=%i h=%i", __PRETTY_FUNCTION__, x, y, w, h);
 
+    /* The buffer pool is sized for the current payload */
+    if (this->camera->is_video_active())
+    {
+        LOG_ERROR("Cannot change the frame while streaming");
+        return false;
+    }
+
     this->camera->set_geometry(x, y, w, h);
     return this->_update_geometry();
 }
@@ -328,3 +445,10 @@ bool GigECCD::UpdateCCDFrameType(INDI::CCDChip::CCD_FRAME fType)
     PrimaryCCD.setFrameType(fType);
     return true;
 }
+
+bool GigECCD::saveConfigItems(FILE *fp)
+{
+    INDI::CCD::saveConfigItems(fp);
+    IUSaveConfigNumber(fp, &this->indiprop_video_buffers_prop);
+    return true;
+}
@@ -21,7 +21,9 @@
 #define GENERIC_CCD_H
 
 #include <indiccd.h>
+#include <atomic>
 #include <iostream>
+#include <thread>
 
 #include "ArvInterface.h"
 
@@ -44,11 +46,15 @@ class GigECCD : public INDI::CCD
     bool StartExposure(float duration);
     bool AbortExposure();
 
+    bool StartStreaming();
+    bool StopStreaming();
+
   protected:
     void TimerHit();
     virtual bool UpdateCCDFrame(int x, int y, int w, int h);
     virtual bool UpdateCCDBin(int binx, int biny);
     virtual bool UpdateCCDFrameType(INDI::CCDChip::CCD_FRAME fType);
+    virtual bool saveConfigItems(FILE *fp);
 
   private:
     void _delete_indi_properties(void);
@@ -56,6 +62,9 @@ class GigECCD : public INDI::CCD
     bool _update_geometry(void);
     void _update_image(uint8_t const *const data, size_t size);
     static void _receive_image_hook(void *const class_ptr, uint8_t const *const data, size_t size);
+    static void _receive_frame_hook(void *const class_ptr, uint8_t const *const data, size_t size);
+    void _stream_loop(void);
+    void _update_video_statistics(bool force);
 
     void _handle_failed(void);
     void _handle_timeout(struct timeval *const tv, uint32_t timeout_us);
@@ -66,12 +75,22 @@ class GigECCD : public INDI::CCD
     struct timeval exposure_start_time;
     struct timeval exposure_transfer_time;
 
+    /* Video streaming, frames are polled from the camera's buffer pool on their own thread */
+    std::thread stream_thread;
+    std::atomic<bool> stream_run { false };
+    std::atomic<uint32_t> stream_bad_frames { 0 };
+    int stream_stat_ticks { 0 };
+
     /* Indi properties */
 
     INumber indiprop_gain[1];
     INumberVectorProperty indiprop_gain_prop;
     IText indiprop_info[3] {};
     ITextVectorProperty indiprop_info_prop;
+    INumber indiprop_video_buffers[1];
+    INumberVectorProperty indiprop_video_buffers_prop;
+    INumber indiprop_video_stats[4];
+    INumberVectorProperty indiprop_video_stats_prop;
 
     virtual bool ISNewNumber(const char *dev, const char *name, double values[], char *names[], int n);
 
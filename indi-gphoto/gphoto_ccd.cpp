@@ -27,6 +27,7 @@
 #include "gphoto_readimage.h"
 
 #include <algorithm>
+#include <chrono>
 #include <stream/streammanager.h>
 
 #include <deque>
@@ -38,6 +39,7 @@
 #include <sys/stat.h>
 
 #define FOCUS_TAB    "Focus"
+#define STREAM_TAB   "Streaming"
 #define MAX_DEVICES  5 /* Max device cameraCount */
 #define FOCUS_TIMER  50
 #define MAX_RETRIES  3
@@ -219,6 +221,8 @@ GPhotoCCD::GPhotoCCD(const char * model, const char * port) : FI(this)
 //==========================================================================
 GPhotoCCD::~GPhotoCCD()
 {
+    stopDecodeWorker();
+    IDSharedBlobFree(decodeBuffer);
     free(on_off[0]);
     free(on_off[1]);
     expTID = 0;
@@ -266,6 +270,18 @@ bool GPhotoCCD::initProperties()
     IUFillSwitchVector(&livePreviewSP, livePreviewS, 2, getDeviceName(), "AUX_VIDEO_STREAM", "Preview",
                        MAIN_CONTROL_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
 
+    IUFillSwitch(&liveViewModeS[LIVE_VIEW_PASSTHROUGH], "PASSTHROUGH", "JPEG", ISS_ON);
+    IUFillSwitch(&liveViewModeS[LIVE_VIEW_DECODE], "DECODE", "Decode", ISS_OFF);
+    IUFillSwitchVector(&liveViewModeSP, liveViewModeS, 2, getDeviceName(), "LIVE_VIEW_MODE", "Live View", STREAM_TAB,
+                       IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
+
+    IUFillSwitch(&jpegScaleS[0], "SCALE_1", "1:1", ISS_ON);
+    IUFillSwitch(&jpegScaleS[1], "SCALE_2", "1:2", ISS_OFF);
+    IUFillSwitch(&jpegScaleS[2], "SCALE_4", "1:4", ISS_OFF);
+    IUFillSwitch(&jpegScaleS[3], "SCALE_8", "1:8", ISS_OFF);
+    IUFillSwitchVector(&jpegScaleSP, jpegScaleS, 4, getDeviceName(), "CCD_JPEG_SCALE", "JPEG Scale", IMAGE_SETTINGS_TAB,
+                       IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
+
     // Nikon should use SD card by default
     const bool isNikon = strstr(getDeviceName(), "Nikon");
     IUFillSwitch(&captureTargetS[CAPTURE_INTERNAL_RAM], "RAM", "RAM", isNikon ? ISS_OFF : ISS_ON);
@@ -290,6 +306,17 @@ bool GPhotoCCD::initProperties()
     IUFillTextVector(&UploadFileTP, UploadFileT, 1, getDeviceName(), "CCD_UPLOAD_FILE", "Upload File", OPTIONS_TAB, IP_RW, 0,
                      IPS_IDLE);
 
+    // Decode pipeline, off by default: frames are decoded and published in the exposure loop
+    IUFillNumber(&DecodeQueueN[0], "DEPTH", "Frames", "%.f", 0, 4, 1, 0);
+    IUFillNumberVector(&DecodeQueueNP, DecodeQueueN, 1, getDeviceName(), "CCD_DECODE_QUEUE", "Decode Queue", OPTIONS_TAB,
+                       IP_RW, 60, IPS_IDLE);
+
+    IUFillNumber(&PipelineTimingN[TIMING_DOWNLOAD], "DOWNLOAD", "Download (ms)", "%.f", 0, 1e6, 0, 0);
+    IUFillNumber(&PipelineTimingN[TIMING_DECODE], "DECODE", "Decode (ms)", "%.f", 0, 1e6, 0, 0);
+    IUFillNumber(&PipelineTimingN[TIMING_PUBLISH], "PUBLISH", "Publish (ms)", "%.f", 0, 1e6, 0, 0);
+    IUFillNumberVector(&PipelineTimingNP, PipelineTimingN, 3, getDeviceName(), "CCD_PIPELINE_TIMING", "Frame Timing",
+                       OPTIONS_TAB, IP_RO, 60, IPS_IDLE);
+
     PrimaryCCD.setMinMaxStep("CCD_EXPOSURE", "CCD_EXPOSURE_VALUE", 0.001, 3600, 1, false);
 
     // Most cameras have this by default, so let's set it as default.
@@ -374,6 +401,8 @@ bool GPhotoCCD::updateProperties()
             defineProperty(&mIsoSP);
 
         defineProperty(&livePreviewSP);
+        defineProperty(&liveViewModeSP);
+        defineProperty(&jpegScaleSP);
         defineProperty(&autoFocusSP);
 
         if (m_CanFocus)
@@ -412,6 +441,8 @@ bool GPhotoCCD::updateProperties()
         }
 
         defineProperty(&forceBULBSP);
+        defineProperty(&DecodeQueueNP);
+        defineProperty(&PipelineTimingNP);
 
         //timerID = SetTimer(getCurrentPollingPeriod());
     }
@@ -424,6 +455,8 @@ bool GPhotoCCD::updateProperties()
 
         deleteProperty(mMirrorLockNP.name);
         deleteProperty(livePreviewSP.name);
+        deleteProperty(liveViewModeSP.name);
+        deleteProperty(jpegScaleSP.name);
         deleteProperty(autoFocusSP.name);
 
         if (m_CanFocus)
@@ -440,6 +473,8 @@ bool GPhotoCCD::updateProperties()
         deleteProperty(SDCardImageSP.name);
 
         deleteProperty(forceBULBSP.name);
+        deleteProperty(DecodeQueueNP.name);
+        deleteProperty(PipelineTimingNP.name);
 
         HideExtendedOptions();
     }
@@ -537,6 +572,40 @@ bool GPhotoCCD::ISNewSwitch(const char * dev, const char * name, ISState * state
         // This force driver to _always_ capture in bulb mode and never use predefined exposures unless the exposures are less
         // than a second.
         ///////////////////////////////////////////////////////////////////////////////////////////////
+        // Live view mode
+        if (!strcmp(name, liveViewModeSP.name))
+        {
+            if (Streamer->isBusy())
+            {
+                liveViewModeSP.s = IPS_ALERT;
+                LOG_WARN("Cannot change live view mode while video streaming is active.");
+                IDSetSwitch(&liveViewModeSP, nullptr);
+                return true;
+            }
+
+            IUUpdateSwitch(&liveViewModeSP, states, names, n);
+            liveViewModeSP.s = IPS_OK;
+            if (liveViewModeS[LIVE_VIEW_PASSTHROUGH].s == ISS_ON)
+                LOG_INFO("Live view streams the camera JPEG frames as they are.");
+            else
+                LOG_INFO("Live view frames are decoded to raw pixels before streaming.");
+            IDSetSwitch(&liveViewModeSP, nullptr);
+            return true;
+        }
+
+        // JPEG scale
+        if (!strcmp(name, jpegScaleSP.name))
+        {
+            IUUpdateSwitch(&jpegScaleSP, states, names, n);
+            jpegScaleSP.s = IPS_OK;
+            if (jpegScale() > 1)
+                LOGF_INFO("JPEG images are decoded at 1/%d size, subframing is disabled.", jpegScale());
+            else
+                LOG_INFO("JPEG images are decoded at full size.");
+            IDSetSwitch(&jpegScaleSP, nullptr);
+            return true;
+        }
+
         if (!strcmp(name, forceBULBSP.name))
         {
             if (IUUpdateSwitch(&forceBULBSP, states, names, n) < 0)
@@ -774,6 +843,18 @@ bool GPhotoCCD::ISNewNumber(const char * dev, const char * name, double values[]
             return true;
         }
 
+        if (!strcmp(name, DecodeQueueNP.name))
+        {
+            IUUpdateNumber(&DecodeQueueNP, values, names, n);
+            DecodeQueueNP.s = IPS_OK;
+            IDSetNumber(&DecodeQueueNP, nullptr);
+            if (DecodeQueueN[0].value > 0)
+                LOGF_INFO("Decoding in the background, up to %.f frames in flight.", DecodeQueueN[0].value);
+            else
+                LOG_INFO("Decoding each frame before the next exposure can start.");
+            return true;
+        }
+
         if (CamOptions.find(name) != CamOptions.end())
         {
             cam_opt * opt = CamOptions[name];
@@ -962,6 +1043,9 @@ bool GPhotoCCD::Connect()
 
 bool GPhotoCCD::Disconnect()
 {
+    // Publish whatever was already downloaded before the camera goes away
+    stopDecodeWorker();
+
     if (isSimulation())
         return true;
     gphoto_close(gphotodrv);
@@ -1035,6 +1119,8 @@ bool GPhotoCCD::UpdateCCDFrame(int x, int y, int w, int h)
         return false;
     }
 
+    // The decode thread publishes frames with the chip geometry under ccdBufferLock
+    std::unique_lock<std::mutex> guard(ccdBufferLock);
     PrimaryCCD.setFrame(x, y, w, h);
     return true;
 }
@@ -1174,8 +1260,6 @@ bool GPhotoCCD::grabImage()
     }
     else if (EncodeFormatSP[FORMAT_FITS].getState() == ISS_ON)
     {
-        char filename[MAXRBUF] = "/tmp/indi_XXXXXX";
-        const char *extension = "unknown";
         if (isSimulation())
         {
             if (UploadFileT[0].text == nullptr || !UploadFileT[0].text[0])
@@ -1184,191 +1268,65 @@ bool GPhotoCCD::grabImage()
                 return false;
             }
 
-            strncpy(filename, UploadFileT[0].text, MAXRBUF);
-            const char *found = strchr(filename, '.');
+            const char *found = strchr(UploadFileT[0].text, '.');
             if (found == nullptr)
             {
                 LOGF_ERROR("Upload filename %s is invalid.", UploadFileT[0].text);
                 return false;
             }
-            extension =  found + 1;
-        }
-        else
-        {
-            int fd = mkstemp(filename);
-            int ret = gphoto_read_exposure_fd(gphotodrv, fd);
-            if (ret != GP_OK || fd == -1)
-            {
-                if (fd == -1)
-                    LOGF_ERROR("Exposure failed to save image. Cannot create temp file %s", tmpfile);
-                else
-                {
-                    LOGF_ERROR("Exposure failed to save image... %s", gp_result_as_string(ret));
-                    // As suggested on INDI forums, this result could be misleading.
-                    if (ret == GP_ERROR_DIRECTORY_NOT_FOUND)
-                        LOG_INFO("Make sure BULB switch is ON in the camera. Try setting AF switch to OFF.");
-                }
-                unlink(filename);
-                return false;
-            }
 
-            extension = gphoto_get_file_extension(gphotodrv);
-        }
-
-        if (!strcmp(extension, "unknown"))
-        {
-            LOG_ERROR("Exposure failed.");
-            return false;
+            return processFITS(UploadFileT[0].text, nullptr, 0, found + 1, currentFrameRequest());
         }
 
         // We're done exposing
         if (ExposureRequest > 3)
             LOG_INFO("Exposure done, downloading image...");
 
-        if (strcasecmp(extension, "jpg") == 0 || strcasecmp(extension, "jpeg") == 0)
-        {
-            if (read_jpeg(filename, &memptr, &memsize, &naxis, &w, &h))
-            {
-                LOG_ERROR("Exposure failed to parse jpeg.");
-                if (!isSimulation())
-                    unlink(filename);
-                return false;
-            }
-
-            LOGF_DEBUG("read_jpeg: memsize (%d) naxis (%d) w (%d) h (%d) bpp (%d)", memsize, naxis, w, h, bpp);
+        auto downloadStart = std::chrono::steady_clock::now();
 
-            SetCCDCapability(GetCCDCapability() & ~CCD_HAS_BAYER);
-        }
-        else
+        int ret = gphoto_read_exposure(gphotodrv);
+        if (ret != GP_OK)
         {
-            char bayer_pattern[8] = {};
-
-            if (read_libraw(filename, &memptr, &memsize, &naxis, &w, &h, &bpp, bayer_pattern))
-            {
-                LOG_ERROR("Exposure failed to parse raw image.");
-                if (!isSimulation())
-                    unlink(filename);
-                return false;
-            }
-
-            LOGF_DEBUG("read_libraw: memsize (%d) naxis (%d) w (%d) h (%d) bpp (%d) bayer pattern (%s)",
-                       memsize, naxis, w, h, bpp, bayer_pattern);
-
-            if (!isSimulation())
-                unlink(filename);
-
-            IUSaveText(&BayerT[2], bayer_pattern);
-            IDSetText(&BayerTP, nullptr);
-            SetCCDCapability(GetCCDCapability() | CCD_HAS_BAYER);
+            LOGF_ERROR("Exposure failed to save image... %s", gp_result_as_string(ret));
+            // As suggested on INDI forums, this result could be misleading.
+            if (ret == GP_ERROR_DIRECTORY_NOT_FOUND)
+                LOG_INFO("Make sure BULB switch is ON in the camera. Try setting AF switch to OFF.");
+            return false;
         }
 
-        PrimaryCCD.setImageExtension("fits");
-
-        uint16_t subW = PrimaryCCD.getSubW();
-        uint16_t subH = PrimaryCCD.getSubH();
-
-        // If subframing is requested
-        // If either axis is less than the image resolution
-        // then we subframe, given the OTHER axis is within range as well.
-        if ( (subW > 0 && subH > 0) && ((subW < w && subH <= h) || (subH < h && subW <= w)))
+        // The camera file stays in gphoto memory and is decoded from there, no temporary file involved
+        const char *gphotoFileData = nullptr;
+        unsigned long gphotoFileSize = 0;
+        gphoto_get_buffer(gphotodrv, &gphotoFileData, &gphotoFileSize);
+        if (gphotoFileData == nullptr || gphotoFileSize == 0)
         {
+            LOG_ERROR("Exposure failed to download image from camera.");
+            return false;
+        }
 
-            uint16_t subX = PrimaryCCD.getSubX();
-            uint16_t subY = PrimaryCCD.getSubY();
-
-            // Align all boundaries to be even
-            // This should fix issues with subframed bayered images.
-            //            subX -= subX % 2;
-            //            subY -= subY % 2;
-            //            subW -= subW % 2;
-            //            subH -= subH % 2;
-
-            int subFrameSize     = subW * subH * bpp / 8 * ((naxis == 3) ? 3 : 1);
-            int oneFrameSize     = subW * subH * bpp / 8;
-
-            int lineW  = subW * bpp / 8;
-
-            LOGF_DEBUG("Subframing... subFrameSize: %d - oneFrameSize: %d - subX: %d - subY: %d - subW: %d - subH: %d",
-                       subFrameSize, oneFrameSize,
-                       subX, subY, subW, subH);
-
-            if (naxis == 2)
-            {
-                // JM 2020-08-29: Using memmove since regions are overlaping
-                // as proposed by Camiel Severijns on INDI forums.
-                for (int i = subY; i < subY + subH; i++)
-                    memmove(memptr + (i - subY) * lineW, memptr + (i * w + subX) * bpp / 8, lineW);
-            }
-            else
-            {
-                uint8_t * subR = memptr;
-                uint8_t * subG = memptr + oneFrameSize;
-                uint8_t * subB = memptr + oneFrameSize * 2;
-
-                uint8_t * startR = memptr;
-                uint8_t * startG = memptr + (w * h * bpp / 8);
-                uint8_t * startB = memptr + (w * h * bpp / 8 * 2);
-
-                for (int i = subY; i < subY + subH; i++)
-                {
-                    memcpy(subR + (i - subY) * lineW, startR + (i * w + subX) * bpp / 8, lineW);
-                    memcpy(subG + (i - subY) * lineW, startG + (i * w + subX) * bpp / 8, lineW);
-                    memcpy(subB + (i - subY) * lineW, startB + (i * w + subX) * bpp / 8, lineW);
-                }
-            }
-
-            PrimaryCCD.setFrameBuffer(memptr);
-            PrimaryCCD.setFrameBufferSize(memsize, false);
-            PrimaryCCD.setResolution(w, h);
-            PrimaryCCD.setFrame(subX, subY, subW, subH);
-            PrimaryCCD.setNAxis(naxis);
-            PrimaryCCD.setBPP(bpp);
-
-            // binning if needed
-            if(binning)
-            {
-
-                // binBayerFrame implemented since 1.9.4
-#if INDI_VERSION_MAJOR >= 1 && INDI_VERSION_MINOR >= 9 && INDI_VERSION_RELEASE >=4
-                PrimaryCCD.binBayerFrame();
-#else
-                PrimaryCCD.binFrame();
-#endif
-            }
+        const char *extension = gphoto_get_file_extension(gphotodrv);
+        if (!strcmp(extension, "unknown"))
+        {
+            LOG_ERROR("Exposure failed.");
+            return false;
+        }
 
-            ExposureComplete(&PrimaryCCD);
+        std::chrono::duration<double, std::milli> downloadTime = std::chrono::steady_clock::now() - downloadStart;
 
-            // Restore old pointer and release memory
-            //PrimaryCCD.setFrameBuffer(memptr);
-            //PrimaryCCD.setFrameBufferSize(memsize, false);
-            //delete [] (subframeBuf);
-        }
-        else
-        {
-            if (PrimaryCCD.getSubW() != 0 && (w > PrimaryCCD.getSubW() || h > PrimaryCCD.getSubH()))
-                LOGF_WARN("Camera image size (%dx%d) is less than requested size (%d,%d). Purge configuration and update frame size to match camera size.",
-                          w, h, PrimaryCCD.getSubW(), PrimaryCCD.getSubH());
+        // Let the decoder thread finish this frame while the camera is free for the next exposure
+        if (DecodeQueueN[0].value > 0)
+            return queueFITS(extension, downloadTime.count(), currentFrameRequest());
 
-            PrimaryCCD.setFrameBuffer(memptr);
-            PrimaryCCD.setFrameBufferSize(memsize, false);
-            PrimaryCCD.setResolution(w, h);
-            PrimaryCCD.setFrame(0, 0, w, h);
-            PrimaryCCD.setNAxis(naxis);
-            PrimaryCCD.setBPP(bpp);
+        // The queue was turned off, frames still queued are published before this one and never
+        // decoded at the same time
+        stopDecodeWorker();
 
-            // binning if needed
-            if(binning)
-            {
-                // binBayerFrame implemented since 1.9.4
-#if INDI_VERSION_MAJOR >= 1 && INDI_VERSION_MINOR >= 9 && INDI_VERSION_RELEASE >=4
-                PrimaryCCD.binBayerFrame();
-#else
-                PrimaryCCD.binFrame();
-#endif
-            }
+        PipelineTimingN[TIMING_DOWNLOAD].value = downloadTime.count();
+        bool rc = processFITS(nullptr, gphotoFileData, gphotoFileSize, extension, currentFrameRequest());
 
-            ExposureComplete(&PrimaryCCD);
-        }
+        // The camera file is decoded, release it now rather than holding it until the next exposure
+        gphoto_free_buffer(gphotodrv);
+        return rc;
     }
 
     // Read Native image AS IS
@@ -1470,6 +1428,282 @@ bool GPhotoCCD::grabImage()
     return true;
 }
 
+GPhotoCCD::FrameRequest GPhotoCCD::currentFrameRequest()
+{
+    std::unique_lock<std::mutex> guard(ccdBufferLock);
+    FrameRequest frame;
+    frame.subX    = PrimaryCCD.getSubX();
+    frame.subY    = PrimaryCCD.getSubY();
+    frame.subW    = PrimaryCCD.getSubW();
+    frame.subH    = PrimaryCCD.getSubH();
+    frame.binning = binning;
+    return frame;
+}
+
+bool GPhotoCCD::processFITS(const char * filename, const char * data, unsigned long size, const char * extension,
+                            const FrameRequest &frame)
+{
+    // Decode into our own buffer, the chip frame buffer may be in use by the live view or an upload
+    uint8_t * memptr = decodeBuffer;
+    size_t memsize = 0;
+    int naxis = 2, w = 0, h = 0, bpp = 8;
+
+    // Reduced size JPEG previews do not match the sensor coordinates any longer
+    bool scaled = false;
+    // Applied to the chip with the image, the decode may run on the decode thread
+    bool bayer = false;
+    char bayer_pattern[8] = {};
+
+    auto decodeStart = std::chrono::steady_clock::now();
+
+    if (strcasecmp(extension, "jpg") == 0 || strcasecmp(extension, "jpeg") == 0)
+    {
+        const int scale = jpegScale();
+        scaled = scale > 1;
+        int rc = filename ? read_jpeg(filename, &memptr, &memsize, &naxis, &w, &h, scale) :
+                 read_jpeg_planar_mem(data, size, &memptr, &memsize, &naxis, &w, &h, scale);
+        decodeBuffer = memptr;
+        if (rc)
+        {
+            LOG_ERROR("Exposure failed to parse jpeg.");
+            return false;
+        }
+
+        LOGF_DEBUG("read_jpeg: memsize (%d) naxis (%d) w (%d) h (%d) bpp (%d)", memsize, naxis, w, h, bpp);
+    }
+    else
+    {
+        int rc = filename ? read_libraw(filename, &memptr, &memsize, &naxis, &w, &h, &bpp, bayer_pattern) :
+                 read_libraw_mem(data, size, &memptr, &memsize, &naxis, &w, &h, &bpp, bayer_pattern);
+        decodeBuffer = memptr;
+        if (rc)
+        {
+            LOG_ERROR("Exposure failed to parse raw image.");
+            return false;
+        }
+
+        LOGF_DEBUG("read_libraw: memsize (%d) naxis (%d) w (%d) h (%d) bpp (%d) bayer pattern (%s)",
+                   memsize, naxis, w, h, bpp, bayer_pattern);
+
+        bayer = true;
+    }
+
+    std::chrono::duration<double, std::milli> decodeTime = std::chrono::steady_clock::now() - decodeStart;
+    auto publishStart = std::chrono::steady_clock::now();
+
+    uint16_t subX = 0, subY = 0;
+    uint16_t subW = frame.subW;
+    uint16_t subH = frame.subH;
+
+    // If subframing is requested
+    // If either axis is less than the image resolution
+    // then we subframe, given the OTHER axis is within range as well.
+    if (!scaled && (subW > 0 && subH > 0) && ((subW < w && subH <= h) || (subH < h && subW <= w)))
+    {
+        subX = frame.subX;
+        subY = frame.subY;
+
+        // Align all boundaries to be even
+        // This should fix issues with subframed bayered images.
+        //            subX -= subX % 2;
+        //            subY -= subY % 2;
+        //            subW -= subW % 2;
+        //            subH -= subH % 2;
+
+        int subFrameSize     = subW * subH * bpp / 8 * ((naxis == 3) ? 3 : 1);
+        int oneFrameSize     = subW * subH * bpp / 8;
+
+        int lineW  = subW * bpp / 8;
+
+        LOGF_DEBUG("Subframing... subFrameSize: %d - oneFrameSize: %d - subX: %d - subY: %d - subW: %d - subH: %d",
+                   subFrameSize, oneFrameSize,
+                   subX, subY, subW, subH);
+
+        if (naxis == 2)
+        {
+            // JM 2020-08-29: Using memmove since regions are overlaping
+            // as proposed by Camiel Severijns on INDI forums.
+            for (int i = subY; i < subY + subH; i++)
+                memmove(memptr + (i - subY) * lineW, memptr + (i * w + subX) * bpp / 8, lineW);
+        }
+        else
+        {
+            uint8_t * subR = memptr;
+            uint8_t * subG = memptr + oneFrameSize;
+            uint8_t * subB = memptr + oneFrameSize * 2;
+
+            uint8_t * startR = memptr;
+            uint8_t * startG = memptr + (w * h * bpp / 8);
+            uint8_t * startB = memptr + (w * h * bpp / 8 * 2);
+
+            for (int i = subY; i < subY + subH; i++)
+            {
+                memcpy(subR + (i - subY) * lineW, startR + (i * w + subX) * bpp / 8, lineW);
+                memcpy(subG + (i - subY) * lineW, startG + (i * w + subX) * bpp / 8, lineW);
+                memcpy(subB + (i - subY) * lineW, startB + (i * w + subX) * bpp / 8, lineW);
+            }
+        }
+    }
+    else
+    {
+        if (!scaled && subW != 0 && (w > subW || h > subH))
+            LOGF_WARN("Camera image size (%dx%d) is less than requested size (%d,%d). Purge configuration and update frame size to match camera size.",
+                      w, h, subW, subH);
+
+        subW = w;
+        subH = h;
+    }
+
+    // Swap the decoded image with the chip frame buffer, the old one is reused for the next decode
+    std::unique_lock<std::mutex> guard(ccdBufferLock);
+    decodeBuffer = PrimaryCCD.getFrameBuffer();
+    PrimaryCCD.setFrameBuffer(memptr);
+    PrimaryCCD.setFrameBufferSize(memsize, false);
+    PrimaryCCD.setImageExtension("fits");
+
+    // A scaled preview only changes the image dimensions. The sensor resolution and the requested
+    // frame are kept, the preview size is put in the frame for the upload and restored afterwards.
+    const int chipX = PrimaryCCD.getSubX(), chipY = PrimaryCCD.getSubY();
+    const int chipW = PrimaryCCD.getSubW(), chipH = PrimaryCCD.getSubH();
+    if (!scaled)
+        PrimaryCCD.setResolution(w, h);
+    PrimaryCCD.setFrame(subX, subY, subW, subH);
+    PrimaryCCD.setNAxis(naxis);
+    PrimaryCCD.setBPP(bpp);
+
+    if (bayer)
+    {
+        IUSaveText(&BayerT[2], bayer_pattern);
+        IDSetText(&BayerTP, nullptr);
+        SetCCDCapability(GetCCDCapability() | CCD_HAS_BAYER);
+    }
+    else
+        SetCCDCapability(GetCCDCapability() & ~CCD_HAS_BAYER);
+
+    // binning if needed
+    if (frame.binning)
+    {
+        // binBayerFrame implemented since 1.9.4
+#if INDI_VERSION_MAJOR >= 1 && INDI_VERSION_MINOR >= 9 && INDI_VERSION_RELEASE >=4
+        PrimaryCCD.binBayerFrame();
+#else
+        PrimaryCCD.binFrame();
+#endif
+    }
+    guard.unlock();
+
+    ExposureComplete(&PrimaryCCD);
+
+    if (scaled)
+    {
+        guard.lock();
+        PrimaryCCD.setFrame(chipX, chipY, chipW, chipH);
+        guard.unlock();
+    }
+
+    std::chrono::duration<double, std::milli> publishTime = std::chrono::steady_clock::now() - publishStart;
+
+    PipelineTimingN[TIMING_DECODE].value  = decodeTime.count();
+    PipelineTimingN[TIMING_PUBLISH].value = publishTime.count();
+    PipelineTimingNP.s = IPS_OK;
+    IDSetNumber(&PipelineTimingNP, nullptr);
+
+    LOGF_DEBUG("Frame timing: download %.0f ms, decode %.0f ms, publish %.0f ms",
+               PipelineTimingN[TIMING_DOWNLOAD].value, decodeTime.count(), publishTime.count());
+
+    return true;
+}
+
+bool GPhotoCCD::queueFITS(const char * extension, double downloadTime, const FrameRequest &frame)
+{
+    PendingImage image;
+    image.file         = gphoto_take_file(gphotodrv);
+    image.extension    = extension;
+    image.downloadTime = downloadTime;
+    image.frame        = frame;
+
+    if (image.file == nullptr)
+    {
+        LOG_ERROR("Exposure failed to download image from camera.");
+        return false;
+    }
+
+    std::unique_lock<std::mutex> guard(decodeMutex);
+
+    if (!decodeThread.joinable())
+    {
+        decodeQuit   = false;
+        decodeThread = std::thread(&GPhotoCCD::decodeWorker, this);
+    }
+
+    // Frames in flight include the one being decoded. When the queue is full the frame is dropped
+    // rather than blocking the driver until the decoder catches up.
+    size_t depth = static_cast<size_t>(DecodeQueueN[0].value);
+    if (decodeQueue.size() + (decodeBusy ? 1 : 0) >= depth)
+    {
+        guard.unlock();
+        gp_file_unref(image.file);
+        LOGF_ERROR("Decode queue is full (%.f frames), frame dropped. Increase the queue depth or the exposure interval.",
+                   DecodeQueueN[0].value);
+        return false;
+    }
+
+    decodeQueue.push_back(image);
+    guard.unlock();
+    decodeCondition.notify_all();
+
+    return true;
+}
+
+void GPhotoCCD::decodeWorker()
+{
+    std::unique_lock<std::mutex> guard(decodeMutex);
+
+    while (true)
+    {
+        decodeCondition.wait(guard, [this]()
+        {
+            return decodeQuit || !decodeQueue.empty();
+        });
+
+        // Frames already downloaded are still published when stopping
+        if (decodeQueue.empty())
+            break;
+
+        PendingImage image = decodeQueue.front();
+        decodeQueue.pop_front();
+        decodeBusy = true;
+        guard.unlock();
+
+        const char * data = nullptr;
+        unsigned long size = 0;
+        gp_file_get_data_and_size(image.file, &data, &size);
+
+        PipelineTimingN[TIMING_DOWNLOAD].value = image.downloadTime;
+        if (data == nullptr || size == 0 || processFITS(nullptr, data, size, image.extension.c_str(), image.frame) == false)
+            PrimaryCCD.setExposureFailed();
+
+        gp_file_unref(image.file);
+
+        guard.lock();
+        decodeBusy = false;
+        decodeCondition.notify_all();
+    }
+}
+
+void GPhotoCCD::stopDecodeWorker()
+{
+    if (!decodeThread.joinable())
+        return;
+
+    {
+        std::unique_lock<std::mutex> guard(decodeMutex);
+        decodeQuit = true;
+    }
+    decodeCondition.notify_all();
+    decodeThread.join();
+}
+
 ISwitch * GPhotoCCD::create_switch(const char * basestr, char ** options, int max_opts, int setidx)
 {
     int i;
@@ -1786,7 +2020,9 @@ bool GPhotoCCD::StartStreaming()
 
     if (gphoto_start_preview(gphotodrv) == GP_OK)
     {
-        Streamer->setPixelFormat(INDI_RGB);
+        // Pixel format of decoded frames is known once the first one is in
+        Streamer->setPixelFormat(liveViewModeS[LIVE_VIEW_PASSTHROUGH].s == ISS_ON ? INDI_JPG : INDI_RGB);
+        liveVideoWidth = liveVideoHeight = -1;
         std::unique_lock<std::mutex> guard(liveStreamMutex);
         m_RunLiveStream = true;
         guard.unlock();
@@ -1850,19 +2086,27 @@ void GPhotoCCD::streamLiveView()
 
         uint8_t * inBuffer = reinterpret_cast<uint8_t *>(const_cast<char *>(previewData));
 
-        //        if (streamSubframeS[1].s == ISS_ON)
-        //        {
-        //            if (liveVideoWidth <= 0)
-        //            {
-        //                read_jpeg_size(inBuffer, previewSize, &liveVideoWidth, &liveVideoHeight);
-        //                Streamer->setSize(liveVideoWidth, liveVideoHeight);
-        //            }
+        // Passthrough: the preview JPEG goes to the streamer as is, only its header is parsed.
+        if (liveViewModeS[LIVE_VIEW_PASSTHROUGH].s == ISS_ON)
+        {
+            int w = 0, h = 0;
+            if (read_jpeg_size(inBuffer, previewSize, &w, &h) != 0 || w <= 0 || h <= 0)
+            {
+                LOG_ERROR("Error getting live video frame.");
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+
+            if (w != liveVideoWidth || h != liveVideoHeight)
+            {
+                liveVideoWidth = w;
+                liveVideoHeight = h;
+                Streamer->setSize(liveVideoWidth, liveVideoHeight);
+            }
 
-        //            std::unique_lock<std::mutex> ccdguard(ccdBufferLock);
-        //            Streamer->newFrame(inBuffer, previewSize);
-        //            ccdguard.unlock();
-        //            continue;
-        //        }
+            Streamer->newFrame(inBuffer, previewSize);
+            continue;
+        }
 
         uint8_t * ccdBuffer      = PrimaryCCD.getFrameBuffer();
         size_t size             = 0;
@@ -1870,7 +2114,7 @@ void GPhotoCCD::streamLiveView()
 
         // Read jpeg from memory
         std::unique_lock<std::mutex> ccdguard(ccdBufferLock);
-        rc = read_jpeg_mem(inBuffer, previewSize, &ccdBuffer, &size, &naxis, &w, &h);
+        rc = read_jpeg_mem(inBuffer, previewSize, &ccdBuffer, &size, &naxis, &w, &h, jpegScale());
 
         if (rc != 0)
         {
@@ -2002,6 +2246,10 @@ bool GPhotoCCD::saveConfigItems(FILE * fp)
     // Mirror Locking
     IUSaveConfigNumber(fp, &mMirrorLockNP);
 
+    // Live view
+    IUSaveConfigSwitch(fp, &liveViewModeSP);
+    IUSaveConfigSwitch(fp, &jpegScaleSP);
+
     // Capture Target
     if (captureTargetSP.s == IPS_OK)
     {
@@ -2021,6 +2269,9 @@ bool GPhotoCCD::saveConfigItems(FILE * fp)
     // Force BULB Mode
     IUSaveConfigSwitch(fp, &forceBULBSP);
 
+    // Decode pipeline
+    IUSaveConfigNumber(fp, &DecodeQueueNP);
+
     return true;
 }
 
@@ -27,9 +27,14 @@
 #include <indiccd.h>
 #include <indifocuserinterface.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <future>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #define MAXEXPERR 10 /* max err in exp time we allow, secs */
 #define OPENDT    5  /* open retry delay, secs */
@@ -148,6 +153,26 @@ class GPhotoCCD : public INDI::CCD, public INDI::FocuserInterface
         double CalcTimeLeft();
         bool grabImage();
 
+        // Frame and binning requested for an exposure, taken when the exposure is downloaded
+        struct FrameRequest
+        {
+            uint16_t subX { 0 };
+            uint16_t subY { 0 };
+            uint16_t subW { 0 };
+            uint16_t subH { 0 };
+            bool binning { false };
+        };
+        FrameRequest currentFrameRequest();
+
+        // Decodes a downloaded image (from filename if set, else from data) and publishes it
+        bool processFITS(const char * filename, const char * data, unsigned long size, const char * extension,
+                         const FrameRequest &frame);
+
+        // Hands the downloaded camera file to the decode thread so the next exposure can start
+        bool queueFITS(const char * extension, double downloadTime, const FrameRequest &frame);
+        void decodeWorker();
+        void stopDecodeWorker();
+
         char name[MAXINDIDEVICE];
         char model[MAXINDINAME];
         char port[MAXINDINAME];
@@ -214,6 +239,23 @@ class GPhotoCCD : public INDI::CCD, public INDI::FocuserInterface
         ISwitch livePreviewS[2];
         ISwitchVectorProperty livePreviewSP;
 
+        // Live video: stream the camera preview JPEG as is, or decode it to raw pixels
+        ISwitch liveViewModeS[2];
+        ISwitchVectorProperty liveViewModeSP;
+        enum
+        {
+            LIVE_VIEW_PASSTHROUGH,
+            LIVE_VIEW_DECODE
+        };
+
+        // JPEGs (captures and decoded live view) can be decoded at 1/2, 1/4 or 1/8 size for previews
+        ISwitch jpegScaleS[4];
+        ISwitchVectorProperty jpegScaleSP;
+        int jpegScale() const
+        {
+            return 1 << std::max(0, IUFindOnSwitchIndex(&jpegScaleSP));
+        }
+
         ISwitch * mExposurePresetS = nullptr;
         ISwitchVectorProperty mExposurePresetSP;
 
@@ -237,6 +279,36 @@ class GPhotoCCD : public INDI::CCD, public INDI::FocuserInterface
         // Threading
         std::thread liveViewThread;
 
+        // Decode pipeline
+        INumber DecodeQueueN[1];
+        INumberVectorProperty DecodeQueueNP;
+
+        INumber PipelineTimingN[3];
+        INumberVectorProperty PipelineTimingNP;
+        enum
+        {
+            TIMING_DOWNLOAD,
+            TIMING_DECODE,
+            TIMING_PUBLISH
+        };
+
+        struct PendingImage
+        {
+            CameraFile * file { nullptr };
+            std::string extension;
+            double downloadTime { 0 };
+            FrameRequest frame;
+        };
+
+        std::deque<PendingImage> decodeQueue;
+        std::mutex decodeMutex;
+        std::condition_variable decodeCondition;
+        std::thread decodeThread;
+        bool decodeBusy { false };
+        bool decodeQuit { false };
+        // Images are decoded here and swapped with the chip frame buffer under ccdBufferLock
+        uint8_t * decodeBuffer { nullptr };
+
         std::map <uint8_t, uint8_t> m_CaptureFormatMap;
 
         static constexpr double MINUMUM_CAMERA_TEMPERATURE = -60.0;
@@ -2086,6 +2086,15 @@ void gphoto_free_buffer(gphoto_driver *gphoto)
     }
 }
 
+CameraFile *gphoto_take_file(gphoto_driver *gphoto)
+{
+    pthread_mutex_lock(&gphoto->mutex);
+    CameraFile *file = gphoto->camerafile;
+    gphoto->camerafile = nullptr;
+    pthread_mutex_unlock(&gphoto->mutex);
+    return file;
+}
+
 const char *gphoto_get_file_extension(gphoto_driver *gphoto)
 {
     if (gphoto->filename[0])
@@ -99,6 +99,9 @@ gphoto_driver *gphoto_open(Camera *camera, GPContext *context, const char *model
 int gphoto_close(gphoto_driver *gphoto);
 void gphoto_get_buffer(gphoto_driver *gphoto, const char **buffer, unsigned long *size);
 void gphoto_free_buffer(gphoto_driver *gphoto);
+// Hands the last downloaded camera file over to the caller, who must release it with gp_file_unref().
+// The next exposure then downloads into a new file instead of freeing this one.
+CameraFile *gphoto_take_file(gphoto_driver *gphoto);
 const char *gphoto_get_file_extension(gphoto_driver *gphoto);
 void gphoto_show_options(gphoto_driver *gphoto);
 gphoto_widget_list *gphoto_find_all_widgets(gphoto_driver *gphoto);
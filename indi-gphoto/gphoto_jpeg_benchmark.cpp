@@ -0,0 +1,115 @@
+/*
+    GPhoto JPEG decode benchmark
+
+    Decodes every JPEG given on the command line at full, 1/2, 1/4 and 1/8 size,
+    interleaved (live view) and planar (FITS), and prints the time per decode.
+
+    Usage: gphoto_jpeg_benchmark [-n iterations] image.jpg...
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this library; if not, write to the Free Software Foundation,
+    Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include "gphoto_readimage.h"
+
+#include <indidevapi.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+static bool loadFile(const char *filename, std::vector<char> &data)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        return false;
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !data.empty();
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = 5;
+    int first = 1;
+    if (argc > 2 && !strcmp(argv[1], "-n"))
+    {
+        iterations = std::max(1, atoi(argv[2]));
+        first = 3;
+    }
+
+    if (first >= argc)
+    {
+        fprintf(stderr, "Usage: %s [-n iterations] image.jpg...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    gphoto_read_set_debug("gphoto_jpeg_benchmark");
+
+    int failures = 0;
+    for (int i = first; i < argc; i++)
+    {
+        std::vector<char> data;
+        if (!loadFile(argv[i], data))
+        {
+            fprintf(stderr, "%s: cannot read file\n", argv[i]);
+            failures++;
+            continue;
+        }
+
+        printf("%s (%zu kB)\n", argv[i], data.size() / 1024);
+
+        for (int planar = 0; planar < 2; planar++)
+        {
+            for (int scale = 1; scale <= 8; scale *= 2)
+            {
+                uint8_t *memptr = nullptr;
+                size_t memsize = 0;
+                int naxis = 0, w = 0, h = 0, rc = 0;
+
+                auto start = std::chrono::steady_clock::now();
+                for (int n = 0; n < iterations && rc == 0; n++)
+                {
+                    if (planar)
+                        rc = read_jpeg_planar_mem(data.data(), data.size(), &memptr, &memsize, &naxis, &w, &h, scale);
+                    else
+                        rc = read_jpeg_mem(reinterpret_cast<unsigned char *>(data.data()), data.size(), &memptr, &memsize,
+                                           &naxis, &w, &h, scale);
+                }
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+                if (rc != 0)
+                {
+                    printf("  %-11s 1/%d  failed\n", planar ? "planar" : "interleaved", scale);
+                    failures++;
+                }
+                else
+                {
+                    // Throughput in megapixels of the full size image
+                    double ms = elapsed.count() / iterations;
+                    printf("  %-11s 1/%d  %5dx%-5d %9.2f ms %8.1f MP/s\n", planar ? "planar" : "interleaved", scale, w, h,
+                           ms, static_cast<double>(w) * h * scale * scale / ms / 1e3);
+                }
+
+                IDSharedBlobFree(memptr);
+            }
+        }
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -2,6 +2,7 @@
 #include "gphoto_readimage.h"
 
 #include <indilogger.h>
+#include <pixelshuffle.h>
 
 #include <jpeglib.h>
 #include <fitsio.h>
@@ -12,6 +13,9 @@
 #pragma GCC diagnostic pop
 
 
+#include <algorithm>
+#include <vector>
+
 #include <unistd.h>
 #include <arpa/inet.h>
 
@@ -136,40 +140,23 @@ int dcraw_parse_header_info(const char *filename, struct dcraw_header *header)
     return 0;
 }
 
-int read_libraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_axis, int *w, int *h, int *bitsperpixel,
-                char *bayer_pattern)
+// Copies the visible area of an unpacked raw frame into a shared blob.
+// Only the Bayer data in rawdata.raw_image is used, so raw2image() is skipped as it would
+// allocate and fill a second four-channel copy of the whole sensor for nothing.
+static int copy_libraw_visible(LibRaw &RawProcessor, const char *source, uint8_t **memptr, size_t *memsize, int *n_axis,
+                               int *w, int *h, int *bitsperpixel, char *bayer_pattern)
 {
-    int ret = 0;
-    // Creation of image processing object
-    LibRaw RawProcessor;
-
-    // Let us open the file
-    if ((ret = RawProcessor.open_file(filename)) != LIBRAW_SUCCESS)
-    {
-        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot open %s: %s", filename, libraw_strerror(ret));
-        RawProcessor.recycle();
-        return -1;
-    }
-
-    // Let us unpack the image
-    if ((ret = RawProcessor.unpack()) != LIBRAW_SUCCESS)
-    {
-        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot unpack %s: %s", filename, libraw_strerror(ret));
-        RawProcessor.recycle();
-        return -1;
-    }
+    const libraw_rawdata_t &rawdata = RawProcessor.imgdata.rawdata;
 
-    // Covert to image
-    if ((ret = RawProcessor.raw2image()) != LIBRAW_SUCCESS)
+    if (rawdata.raw_image == nullptr)
     {
-        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot convert %s : %s", filename, libraw_strerror(ret));
-        RawProcessor.recycle();
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot read %s: only Bayer raw images are supported.", source);
         return -1;
     }
 
     *n_axis       = 2;
-    *w            = RawProcessor.imgdata.rawdata.sizes.width;
-    *h            = RawProcessor.imgdata.rawdata.sizes.height;
+    *w            = rawdata.sizes.width;
+    *h            = rawdata.sizes.height;
     *bitsperpixel = 16;
     // cdesc contains counter-clock wise e.g. RGBG CFA pattern while we want it sequential as RGGB
     bayer_pattern[0] = RawProcessor.imgdata.idata.cdesc[RawProcessor.COLOR(0, 0)];
@@ -178,15 +165,15 @@ int read_libraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_
     bayer_pattern[3] = RawProcessor.imgdata.idata.cdesc[RawProcessor.COLOR(1, 1)];
     bayer_pattern[4] = '\0';
 
-    int first_visible_pixel = RawProcessor.imgdata.rawdata.sizes.raw_width * RawProcessor.imgdata.sizes.top_margin +
+    int first_visible_pixel = rawdata.sizes.raw_width * RawProcessor.imgdata.sizes.top_margin +
                               RawProcessor.imgdata.sizes.left_margin;
 
     DEBUGFDEVICE(device, INDI::Logger::DBG_DEBUG,
                  "read_libraw: raw_width: %d top_margin %d left_margin %d first_visible_pixel %d",
-                 RawProcessor.imgdata.rawdata.sizes.raw_width, RawProcessor.imgdata.sizes.top_margin,
+                 rawdata.sizes.raw_width, RawProcessor.imgdata.sizes.top_margin,
                  RawProcessor.imgdata.sizes.left_margin, first_visible_pixel);
 
-    *memsize = RawProcessor.imgdata.rawdata.sizes.width * RawProcessor.imgdata.rawdata.sizes.height * sizeof(uint16_t);
+    *memsize = rawdata.sizes.width * rawdata.sizes.height * sizeof(uint16_t);
     *memptr  = static_cast<uint8_t *>(IDSharedBlobRealloc(*memptr, *memsize));
     if (*memptr == nullptr)
         *memptr = static_cast<uint8_t *>(IDSharedBlobAlloc(*memsize));
@@ -198,168 +185,212 @@ int read_libraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_
 
     DEBUGFDEVICE(device, INDI::Logger::DBG_DEBUG,
                  "read_libraw: rawdata.sizes.width: %d rawdata.sizes.height %d memsize %d bayer_pattern %s",
-                 RawProcessor.imgdata.rawdata.sizes.width, RawProcessor.imgdata.rawdata.sizes.height, *memsize,
-                 bayer_pattern);
+                 rawdata.sizes.width, rawdata.sizes.height, *memsize, bayer_pattern);
 
     uint16_t *image = reinterpret_cast<uint16_t *>(*memptr);
-    uint16_t *src   = RawProcessor.imgdata.rawdata.raw_image + first_visible_pixel;
+    const uint16_t *src = rawdata.raw_image + first_visible_pixel;
 
-    for (int i = 0; i < RawProcessor.imgdata.rawdata.sizes.height; i++)
+    // No margins: the visible area is one contiguous block
+    if (rawdata.sizes.raw_width == rawdata.sizes.width)
     {
-        memcpy(image, src, RawProcessor.imgdata.rawdata.sizes.width * 2);
-        image += RawProcessor.imgdata.rawdata.sizes.width;
-        src += RawProcessor.imgdata.rawdata.sizes.raw_width;
+        memcpy(image, src, *memsize);
+        return 0;
+    }
+
+    for (int i = 0; i < rawdata.sizes.height; i++)
+    {
+        memcpy(image, src, rawdata.sizes.width * 2);
+        image += rawdata.sizes.width;
+        src += rawdata.sizes.raw_width;
     }
 
     return 0;
 }
 
-int read_jpeg(const char *filename, uint8_t **memptr, size_t *memsize, int *naxis, int *w, int *h)
+int read_libraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_axis, int *w, int *h, int *bitsperpixel,
+                char *bayer_pattern)
 {
-    unsigned char *r_data = nullptr, *g_data = nullptr, *b_data = nullptr;
+    int ret = 0;
+    // Creation of image processing object
+    LibRaw RawProcessor;
 
-    /* these are standard libjpeg structures for reading(decompression) */
-    struct jpeg_decompress_struct cinfo;
-    struct jpeg_error_mgr jerr;
-    /* libjpeg data structure for storing one row, that is, scanline of an image */
-    JSAMPROW row_pointer[1] = { nullptr };
+    // Let us open the file
+    if ((ret = RawProcessor.open_file(filename)) != LIBRAW_SUCCESS)
+    {
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot open %s: %s", filename, libraw_strerror(ret));
+        RawProcessor.recycle();
+        return -1;
+    }
 
-    FILE *infile = fopen(filename, "rb");
+    // Let us unpack the image
+    if ((ret = RawProcessor.unpack()) != LIBRAW_SUCCESS)
+    {
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot unpack %s: %s", filename, libraw_strerror(ret));
+        RawProcessor.recycle();
+        return -1;
+    }
 
-    if (!infile)
+    return copy_libraw_visible(RawProcessor, filename, memptr, memsize, n_axis, w, h, bitsperpixel, bayer_pattern);
+}
+
+int read_libraw_mem(const char *inBuffer, unsigned long inSize, uint8_t **memptr, size_t *memsize, int *n_axis, int *w,
+                    int *h, int *bitsperpixel, char *bayer_pattern)
+{
+    int ret = 0;
+    LibRaw RawProcessor;
+
+    // LibRaw decodes straight from the gphoto buffer, it does not take a copy
+    if ((ret = RawProcessor.open_buffer(const_cast<char *>(inBuffer), inSize)) != LIBRAW_SUCCESS)
     {
-        DEBUGFDEVICE(device, INDI::Logger::DBG_DEBUG, "Error opening jpeg file %s!", filename);
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot open raw buffer: %s", libraw_strerror(ret));
+        RawProcessor.recycle();
         return -1;
     }
-    /* here we set up the standard libjpeg error handler */
-    cinfo.err = jpeg_std_error(&jerr);
-    /* setup decompression process and source, then read JPEG header */
-    jpeg_create_decompress(&cinfo);
-    /* this makes the library read from infile */
-    jpeg_stdio_src(&cinfo, infile);
+
+    if ((ret = RawProcessor.unpack()) != LIBRAW_SUCCESS)
+    {
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot unpack raw buffer: %s", libraw_strerror(ret));
+        RawProcessor.recycle();
+        return -1;
+    }
+
+    return copy_libraw_visible(RawProcessor, "raw buffer", memptr, memsize, n_axis, w, h, bitsperpixel, bayer_pattern);
+}
+
+// Decompresses a jpeg whose source is already set up straight into shared blob memory, as many scanlines per call as
+// libjpeg hands out. Interleaved output (RGBRGB... or mono) lands in place; planar output (R, G, B planes for FITS)
+// goes through a strip of rows that is split into the planes. scale is the DCT scaling denominator: 1, 2, 4 or 8.
+static int read_jpeg_scanlines(struct jpeg_decompress_struct *cinfo, uint8_t **memptr, size_t *memsize, int *naxis,
+                               int *w, int *h, int scale, bool planar)
+{
     /* reading the image header which contains image information */
-    jpeg_read_header(&cinfo, (boolean)TRUE);
+    jpeg_read_header(cinfo, (boolean)TRUE);
+
+    if (scale != 1 && scale != 2 && scale != 4 && scale != 8)
+    {
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Unsupported jpeg scale 1/%d", scale);
+        jpeg_destroy_decompress(cinfo);
+        return -1;
+    }
+    cinfo->scale_num   = 1;
+    cinfo->scale_denom = scale;
+    // Reduced size decodes are previews, trade a little accuracy for speed there
+    if (scale > 1)
+        cinfo->dct_method = JDCT_IFAST;
 
     /* Start decompression jpeg here */
-    jpeg_start_decompress(&cinfo);
+    jpeg_start_decompress(cinfo);
 
-    *memsize = cinfo.output_width * cinfo.output_height * cinfo.num_components;
+    const size_t width = cinfo->output_width, height = cinfo->output_height;
+    const int components = cinfo->output_components;
+    const size_t rowSize = width * components;
+
+    *memsize = rowSize * height;
     *memptr  = static_cast<uint8_t *>(IDSharedBlobRealloc(*memptr, *memsize));
     if (*memptr == nullptr)
         *memptr = static_cast<uint8_t *>(IDSharedBlobAlloc(*memsize));
     if (*memptr == nullptr)
     {
         DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "%s: Failed to allocate %d bytes of memory!", __PRETTY_FUNCTION__, *memsize);
+        jpeg_destroy_decompress(cinfo);
         return -1;
     }
-    // if you do some ugly pointer math, remember to restore the original pointer or some random crashes will happen. This is why I do not like pointers!!
-    uint8_t *oldmem = *memptr;
-    *naxis = cinfo.num_components;
-    *w     = cinfo.output_width;
-    *h     = cinfo.output_height;
-
-    /* now actually read the jpeg into the raw buffer */
-    row_pointer[0] = (unsigned char *)malloc(cinfo.output_width * cinfo.num_components);
-    if (cinfo.num_components)
-    {
-        r_data = (unsigned char *)*memptr;
-        g_data = r_data + cinfo.output_width * cinfo.output_height;
-        b_data = r_data + 2 * cinfo.output_width * cinfo.output_height;
-    }
-    /* read one scan line at a time */
-    for (unsigned int row = 0; row < cinfo.image_height; row++)
+
+    *naxis = components;
+    *w     = width;
+    *h     = height;
+
+    // Mono is planar already, only color has to be split
+    planar = planar && components == 3;
+
+    const int stripRows = cinfo->rec_outbuf_height > 0 ? cinfo->rec_outbuf_height : 1;
+    std::vector<uint8_t> strip(planar ? rowSize * stripRows : 0);
+    std::vector<JSAMPROW> rows(stripRows);
+
+    while (cinfo->output_scanline < height)
     {
-        unsigned char *ppm8 = row_pointer[0];
-        jpeg_read_scanlines(&cinfo, row_pointer, 1);
+        const size_t first = cinfo->output_scanline;
+        const size_t count = std::min<size_t>(stripRows, height - first);
+        for (size_t i = 0; i < count; i++)
+            rows[i] = planar ? strip.data() + i * rowSize : *memptr + (first + i) * rowSize;
 
-        if (cinfo.num_components == 3)
-        {
-            for (unsigned int i = 0; i < cinfo.output_width; i++)
-            {
-                *r_data++ = *ppm8++;
-                *g_data++ = *ppm8++;
-                *b_data++ = *ppm8++;
-            }
-        }
-        else
+        JDIMENSION read = jpeg_read_scanlines(cinfo, rows.data(), count);
+        if (read == 0)
+            break;
+
+        if (planar)
         {
-            memcpy(*memptr, ppm8, cinfo.output_width);
-            *memptr += cinfo.output_width;
+            uint8_t *plane = *memptr + first * width;
+            PixelShuffle::split24(strip.data(), plane, plane + width * height, plane + 2 * width * height, read * width);
         }
     }
 
-    /* wrap up decompression, destroy objects, free pointers and close open files */
-    jpeg_finish_decompress(&cinfo);
-    jpeg_destroy_decompress(&cinfo);
-
-    if (row_pointer[0])
-        free(row_pointer[0]);
-    if (infile)
-        fclose(infile);
-
-    *memptr = oldmem;
+    /* wrap up decompression, destroy objects */
+    jpeg_finish_decompress(cinfo);
+    jpeg_destroy_decompress(cinfo);
 
     return 0;
 }
 
-int read_jpeg_mem(unsigned char *inBuffer, unsigned long inSize, uint8_t **memptr, size_t *memsize, int *naxis, int *w,
-                  int *h)
+int read_jpeg(const char *filename, uint8_t **memptr, size_t *memsize, int *naxis, int *w, int *h, int scale)
 {
     /* these are standard libjpeg structures for reading(decompression) */
     struct jpeg_decompress_struct cinfo;
     struct jpeg_error_mgr jerr;
-    /* libjpeg data structure for storing one row, that is, scanline of an image */
-    JSAMPROW row_pointer[1] = { nullptr };
 
+    FILE *infile = fopen(filename, "rb");
+
+    if (!infile)
+    {
+        DEBUGFDEVICE(device, INDI::Logger::DBG_DEBUG, "Error opening jpeg file %s!", filename);
+        return -1;
+    }
     /* here we set up the standard libjpeg error handler */
     cinfo.err = jpeg_std_error(&jerr);
     /* setup decompression process and source, then read JPEG header */
     jpeg_create_decompress(&cinfo);
     /* this makes the library read from infile */
-    jpeg_mem_src(&cinfo, inBuffer, inSize);
-
-    /* reading the image header which contains image information */
-    jpeg_read_header(&cinfo, (boolean)TRUE);
+    jpeg_stdio_src(&cinfo, infile);
 
-    /* Start decompression jpeg here */
-    jpeg_start_decompress(&cinfo);
+    int ret = read_jpeg_scanlines(&cinfo, memptr, memsize, naxis, w, h, scale, true);
 
-    *memsize = cinfo.output_width * cinfo.output_height * cinfo.num_components;
-    *memptr  = static_cast<uint8_t *>(IDSharedBlobRealloc(*memptr, *memsize));
-    if (*memptr == nullptr)
-        *memptr = static_cast<uint8_t *>(IDSharedBlobAlloc(*memsize));
-    if (*memptr == nullptr)
-    {
-        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "%s: Failed to allocate %d bytes of memory!", __PRETTY_FUNCTION__, *memsize);
-        return -1;
-    }
+    fclose(infile);
 
-    uint8_t *destmem = *memptr;
+    return ret;
+}
 
-    *naxis = cinfo.num_components;
-    *w     = cinfo.output_width;
-    *h     = cinfo.output_height;
+int read_jpeg_planar_mem(const char *inBuffer, unsigned long inSize, uint8_t **memptr, size_t *memsize, int *naxis, int *w,
+                         int *h, int scale)
+{
+    /* these are standard libjpeg structures for reading(decompression) */
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
 
-    /* now actually read the jpeg into the raw buffer */
-    row_pointer[0] = (unsigned char *)malloc(cinfo.output_width * cinfo.num_components);
+    /* here we set up the standard libjpeg error handler */
+    cinfo.err = jpeg_std_error(&jerr);
+    /* setup decompression process and source, then read JPEG header */
+    jpeg_create_decompress(&cinfo);
+    /* this makes the library read straight from the gphoto buffer */
+    jpeg_mem_src(&cinfo, reinterpret_cast<unsigned char *>(const_cast<char *>(inBuffer)), inSize);
 
-    /* read one scan line at a time */
-    for (unsigned int row = 0; row < cinfo.image_height; row++)
-    {
-        unsigned char *ppm8 = row_pointer[0];
-        jpeg_read_scanlines(&cinfo, row_pointer, 1);
-        memcpy(destmem, ppm8, cinfo.output_width * cinfo.num_components);
-        destmem += cinfo.output_width * cinfo.num_components;
-    }
+    return read_jpeg_scanlines(&cinfo, memptr, memsize, naxis, w, h, scale, true);
+}
 
-    /* wrap up decompression, destroy objects, free pointers and close open files */
-    jpeg_finish_decompress(&cinfo);
-    jpeg_destroy_decompress(&cinfo);
+int read_jpeg_mem(unsigned char *inBuffer, unsigned long inSize, uint8_t **memptr, size_t *memsize, int *naxis, int *w,
+                  int *h, int scale)
+{
+    /* these are standard libjpeg structures for reading(decompression) */
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
 
-    if (row_pointer[0])
-        free(row_pointer[0]);
+    /* here we set up the standard libjpeg error handler */
+    cinfo.err = jpeg_std_error(&jerr);
+    /* setup decompression process and source, then read JPEG header */
+    jpeg_create_decompress(&cinfo);
+    /* this makes the library read from memory */
+    jpeg_mem_src(&cinfo, inBuffer, inSize);
 
-    return 0;
+    return read_jpeg_scanlines(&cinfo, memptr, memsize, naxis, w, h, scale, false);
 }
 
 int read_jpeg_size(unsigned char *inBuffer, unsigned long inSize, int *w, int *h)
@@ -6,8 +6,17 @@
 
 int read_libraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_axis, int *w, int *h, int *bitsperpixel,
                 char *bayer_pattern);
-int read_jpeg(const char *filename, uint8_t **memptr, size_t *memsize, int *n_axis, int *w, int *h);
+// Same as read_libraw, but decodes a raw file already held in memory, e.g. the gphoto camera file.
+int read_libraw_mem(const char *inBuffer, unsigned long inSize, uint8_t **memptr, size_t *memsize, int *n_axis, int *w,
+                    int *h, int *bitsperpixel, char *bayer_pattern);
+// JPEG decoders write the shared blob memory directly. scale selects libjpeg's DCT domain downscaling, 1/scale of the
+// full size with scale 1, 2, 4 or 8: a cheap preview of large camera JPEGs.
+int read_jpeg(const char *filename, uint8_t **memptr, size_t *memsize, int *n_axis, int *w, int *h, int scale = 1);
+// Same as read_jpeg (planar output for FITS), but decodes a jpeg already held in memory.
+int read_jpeg_planar_mem(const char *inBuffer, unsigned long inSize, uint8_t **memptr, size_t *memsize, int *naxis, int *w,
+                         int *h, int scale = 1);
+// Interleaved output (RGBRGB... or mono), e.g. for streaming.
 int read_jpeg_mem(unsigned char *inBuffer, unsigned long inSize, uint8_t **memptr, size_t *memsize, int *naxis, int *w,
-                  int *h);
+                  int *h, int scale = 1);
 int read_jpeg_size(unsigned char *inBuffer, unsigned long inSize, int *w, int *h);
 void gphoto_read_set_debug(const char *name);
@@ -37,6 +37,10 @@
 #define MIN_FRAME_SIZE (512)
 #define MAX_FRAME_SIZE (SUBFRAME_SIZE * 16)
 #define SPECTRUM_SIZE  (256)
+#define RING_SECONDS   (2)
+#define RING_BYTES     (256 * 1024 * 1024) /* Memory budget of the sample ring */
+#define STREAM_FIFO    (1024 * 1024)
+#define RECV_TIMEOUT   (100)
 
 static class Loader
 {
@@ -73,6 +77,11 @@ LIMESDR::LIMESDR(uint32_t index)
     setDeviceName(name);
 }
 
+LIMESDR::~LIMESDR()
+{
+    stopStream();
+}
+
 /**************************************************************************************
 ** Client is asking us to establish connection to the device
 ***************************************************************************************/
@@ -100,6 +109,7 @@ bool LIMESDR::Connect()
 bool LIMESDR::Disconnect()
 {
     InIntegration = false;
+    stopStream();
     LMS_Close(lime_dev);
     setBufferSize(1);
     LOG_INFO("LIME-SDR Receiver disconnected successfully!");
@@ -142,6 +152,34 @@ bool LIMESDR::initProperties()
     IUFillBLOB(&TFitsB[4], "TRMT", "Transmit5", "");
     IUFillBLOBVector(&TFitsBP, TFitsB, 5, getDeviceName(), "LIME_TRMT", "Transmit Data", INTEGRATION_INFO_TAB, IP_WO, 60, IPS_IDLE);
 */
+    // Receive stream health, all counted since connection
+    IUFillNumber(&StreamStatsN[STATS_LOST_SAMPLES], "LOST_SAMPLES", "Lost samples", "%.f", 0, 1e15, 0, 0);
+    IUFillNumber(&StreamStatsN[STATS_FIFO_OVERRUNS], "FIFO_OVERRUNS", "FIFO overruns", "%.f", 0, 1e15, 0, 0);
+    IUFillNumber(&StreamStatsN[STATS_DROPPED_PACKETS], "DROPPED_PACKETS", "Dropped packets", "%.f", 0, 1e15, 0, 0);
+    IUFillNumber(&StreamStatsN[STATS_UNDERRUNS], "UNDERRUNS", "Underruns", "%.f", 0, 1e15, 0, 0);
+    IUFillNumberVector(&StreamStatsNP, StreamStatsN, 4, getDeviceName(), "LIME_STREAM_STATS", "Stream", MAIN_CONTROL_TAB,
+                       IP_RO, 60, IPS_IDLE);
+
+    // Integration output, raw IQ samples or the averaged power spectrum
+    IUFillSwitch(&OutputS[OUTPUT_IQ], "OUTPUT_IQ", "IQ samples", ISS_ON);
+    IUFillSwitch(&OutputS[OUTPUT_SPECTRUM], "OUTPUT_SPECTRUM", "Spectrum", ISS_OFF);
+    IUFillSwitchVector(&OutputSP, OutputS, 2, getDeviceName(), "LIME_OUTPUT", "Output", OPTIONS_TAB, IP_RW, ISR_1OFMANY, 60,
+                       IPS_IDLE);
+
+    unsigned int threads = std::thread::hardware_concurrency();
+    IUFillNumber(&SpectrumN[SPECTRUM_FFT_SIZE], "FFT_SIZE", "FFT size", "%.f", 16, 65536, 16, 1024);
+    IUFillNumber(&SpectrumN[SPECTRUM_DECIMATION], "DECIMATION", "Bins per channel", "%.f", 1, 256, 1, 1);
+    IUFillNumber(&SpectrumN[SPECTRUM_THREADS], "THREADS", "Threads", "%.f", 1, 32, 1, threads > 0 ? threads : 1);
+    IUFillNumberVector(&SpectrumNP, SpectrumN, 3, getDeviceName(), "LIME_SPECTRUM", "Spectrum", OPTIONS_TAB, IP_RW, 60,
+                       IPS_IDLE);
+
+    IUFillSwitch(&WindowS[SpectrumEngine::WINDOW_NONE], "WINDOW_NONE", "None", ISS_OFF);
+    IUFillSwitch(&WindowS[SpectrumEngine::WINDOW_HANN], "WINDOW_HANN", "Hann", ISS_ON);
+    IUFillSwitch(&WindowS[SpectrumEngine::WINDOW_BLACKMAN_HARRIS], "WINDOW_BLACKMAN_HARRIS", "Blackman-Harris", ISS_OFF);
+    IUFillSwitchVector(&WindowSP, WindowS, 3, getDeviceName(), "LIME_SPECTRUM_WINDOW", "Window", OPTIONS_TAB, IP_RW,
+                       ISR_1OFMANY, 60, IPS_IDLE);
+
+
     // Add Debug, Simulator, and Configuration controls
     addAuxControls();
 
@@ -165,14 +203,64 @@ bool LIMESDR::updateProperties()
         setupParams(1000000, 1420000000, 10000, 10);
         //defineProperty(&TFitsBP);
 
+        lostSamples = 0;
+        fifoOverruns = 0;
+        droppedPackets = 0;
+        underruns = 0;
+        for (auto &number : StreamStatsN)
+            number.value = 0;
+        defineProperty(&StreamStatsNP);
+
+        defineProperty(&OutputSP);
+        defineProperty(&SpectrumNP);
+        defineProperty(&WindowSP);
+        configureSpectrum();
+
+        if (!startStream())
+            LOG_ERROR("Failed to start the receive stream.");
+
         // Start the timer
         SetTimer(getCurrentPollingPeriod());
     }
     else
     {
         //deleteProperty(TFitsBP.name);
+        deleteProperty(StreamStatsNP.name);
+        deleteProperty(OutputSP.name);
+        deleteProperty(SpectrumNP.name);
+        deleteProperty(WindowSP.name);
+    }
+
+    return true;
+}
+
+bool LIMESDR::saveConfigItems(FILE *fp)
+{
+    INDI::Receiver::saveConfigItems(fp);
+
+    IUSaveConfigSwitch(fp, &OutputSP);
+    IUSaveConfigNumber(fp, &SpectrumNP);
+    IUSaveConfigSwitch(fp, &WindowSP);
+
+    return true;
+}
+
+/**************************************************************************************
+** Set up the spectral engine from the spectrum properties
+***************************************************************************************/
+bool LIMESDR::configureSpectrum()
+{
+    int window = IUFindOnSwitchIndex(&WindowSP);
+    if (!spectrum.configure(SpectrumN[SPECTRUM_FFT_SIZE].value, static_cast<SpectrumEngine::Window>(window),
+                            SpectrumN[SPECTRUM_DECIMATION].value, SpectrumN[SPECTRUM_THREADS].value))
+    {
+        LOG_ERROR("Invalid spectrum settings, bins per channel must divide the FFT size.");
+        return false;
     }
 
+    // Report the size actually used, it is rounded up to a power of two.
+    SpectrumN[SPECTRUM_FFT_SIZE].value = spectrum.fftSize();
+    LOGF_DEBUG("Spectrum: %zu point FFT, %zu channels.", spectrum.fftSize(), spectrum.channels());
     return true;
 }
 
@@ -186,19 +274,38 @@ bool LIMESDR::StartIntegration(double duration)
     // Since we have only have one Receiver with one chip, we set the exposure duration of the primary Receiver
     setIntegrationTime(duration);
     b_read  = 0;
-    to_read = getSampleRate() * getIntegrationTime();
+    to_read = streamSampleRate * getIntegrationTime();
 
-    setBufferSize(to_read * sizeof(float));
+    if (!recvThread.joinable())
+    {
+        LOG_ERROR("Receive stream is not running.");
+        return false;
+    }
 
     if (to_read > 0)
     {
-        lime_stream.channel             = 0;
-        lime_stream.isTx                = false;
-        lime_stream.fifoSize            = to_read;
-        lime_stream.dataFmt             = lms_stream_t::LMS_FMT_F32;
-        lime_stream.throughputVsLatency = 0.5;
-        LMS_SetupStream(lime_dev, &lime_stream);
-        LMS_StartStream(&lime_stream);
+        if (OutputS[OUTPUT_SPECTRUM].s == ISS_ON)
+        {
+            spectrum.reset();
+            spectrumChunk.resize(MAX_FRAME_SIZE * 2);
+            setBufferSize(spectrum.channels() * sizeof(float));
+        }
+        else
+        {
+            // Complex samples, I and Q as float each
+            setBufferSize(to_read * 2 * sizeof(float));
+        }
+
+        // Carry on where the last integration ended while the ring still has those samples,
+        // otherwise start with the samples arriving from now on.
+        uint64_t head = ring.head();
+        if (windowContinues && windowEnd >= ring.oldest(head))
+            windowStart = windowEnd;
+        else
+            windowStart = head;
+        windowPos = windowStart;
+        windowEnd = windowStart + to_read;
+
         gettimeofday(&CapStart, nullptr);
         InIntegration = true;
         LOG_INFO("Integration started...");
@@ -215,6 +322,19 @@ bool LIMESDR::StartIntegration(double duration)
 void LIMESDR::setupParams(float sr, float freq, float bw, float gain)
 {
     setBPS(-32);
+
+    // The ring is sized for the sample rate, restart the stream around a rate change.
+    bool restart = recvThread.joinable() && sr != streamSampleRate;
+    if (restart)
+    {
+        if (InIntegration)
+        {
+            LOG_WARN("Sample rate changed, integration aborted.");
+            AbortIntegration();
+        }
+        stopStream();
+    }
+
     int r = 0;
     r |= LMS_SetAntenna(lime_dev, LMS_CH_RX, 0, 0);
     r |= LMS_SetNormalizedGain(lime_dev, LMS_CH_RX, 0, gain);
@@ -226,6 +346,123 @@ void LIMESDR::setupParams(float sr, float freq, float bw, float gain)
     {
         LOG_INFO("Error(s) setting parameters.");
     }
+
+    streamSampleRate = sr;
+    if (restart && !startStream())
+        LOG_ERROR("Failed to restart the receive stream.");
+}
+
+/**************************************************************************************
+** Open the receive stream and start draining it into the ring
+***************************************************************************************/
+bool LIMESDR::startStream()
+{
+    if (recvThread.joinable())
+        return true;
+
+    lime_stream.channel             = 0;
+    lime_stream.isTx                = false;
+    lime_stream.fifoSize            = STREAM_FIFO;
+    lime_stream.dataFmt             = lms_stream_t::LMS_FMT_F32;
+    lime_stream.throughputVsLatency = 1.0;
+    if (LMS_SetupStream(lime_dev, &lime_stream) != 0)
+        return false;
+
+    // A couple of seconds of samples, less at the highest sample rates to stay within the budget
+    uint64_t capacity = min(static_cast<uint64_t>(streamSampleRate * RING_SECONDS),
+                            static_cast<uint64_t>(RING_BYTES / (2 * sizeof(float))));
+    if (!ring.reset(capacity, SUBFRAME_SIZE))
+    {
+        LOGF_ERROR("Failed to allocate the receive ring (%llu samples).", static_cast<unsigned long long>(capacity));
+        LMS_DestroyStream(lime_dev, &lime_stream);
+        return false;
+    }
+    windowContinues = false;
+
+    if (LMS_StartStream(&lime_stream) != 0)
+    {
+        LMS_DestroyStream(lime_dev, &lime_stream);
+        return false;
+    }
+
+    recvQuit = false;
+    recvThread = std::thread(&LIMESDR::receiveThread, this);
+    LOGF_DEBUG("Receive stream started, ring holds %llu samples.", static_cast<unsigned long long>(ring.capacity()));
+    return true;
+}
+
+void LIMESDR::stopStream()
+{
+    if (!recvThread.joinable())
+        return;
+
+    recvQuit = true;
+    recvThread.join();
+    LMS_StopStream(&lime_stream);
+    LMS_DestroyStream(lime_dev, &lime_stream);
+    windowContinues = false;
+}
+
+/**************************************************************************************
+** Receive thread: the only writer of the ring
+***************************************************************************************/
+void LIMESDR::receiveThread()
+{
+    struct timeval lastStatus;
+    gettimeofday(&lastStatus, nullptr);
+
+    while (!recvQuit)
+    {
+        uint64_t count;
+        float *samples = ring.reserve(count);
+        int received = LMS_RecvStream(&lime_stream, samples, count, nullptr, RECV_TIMEOUT);
+        if (received > 0)
+            ring.commit(received);
+        else if (received < 0)
+        {
+            underruns++;
+            usleep(1000);
+        }
+
+        // Overrun and drop counters are reset by every status read, collect them once a second.
+        struct timeval now;
+        gettimeofday(&now, nullptr);
+        if (now.tv_sec != lastStatus.tv_sec)
+        {
+            lastStatus = now;
+            lms_stream_status_t status;
+            if (LMS_GetStreamStatus(&lime_stream, &status) == 0)
+            {
+                fifoOverruns += status.overrun;
+                droppedPackets += status.droppedPackets;
+                underruns += status.underrun;
+            }
+        }
+    }
+}
+
+void LIMESDR::updateStreamStats()
+{
+    double values[4] = { static_cast<double>(lostSamples), static_cast<double>(fifoOverruns.load()),
+                         static_cast<double>(droppedPackets.load()), static_cast<double>(underruns.load())
+                       };
+
+    bool changed = false;
+    for (int i = 0; i < 4; i++)
+    {
+        if (StreamStatsN[i].value != values[i])
+        {
+            StreamStatsN[i].value = values[i];
+            changed = true;
+        }
+    }
+
+    if (changed)
+    {
+        StreamStatsNP.s = (values[STATS_LOST_SAMPLES] > 0 || values[STATS_FIFO_OVERRUNS] > 0 ||
+                           values[STATS_DROPPED_PACKETS] > 0) ? IPS_ALERT : IPS_OK;
+        IDSetNumber(&StreamStatsNP, nullptr);
+    }
 }
 
 bool LIMESDR::ISNewNumber(const char *dev, const char *name, double values[], char *names[], int n)
@@ -245,25 +482,59 @@ bool LIMESDR::ISNewNumber(const char *dev, const char *name, double values[], ch
         }
         IDSetNumber(&ReceiverSettingsNP, nullptr);
     }
+
+    if (dev && !strcmp(dev, getDeviceName()) && !strcmp(name, SpectrumNP.name))
+    {
+        if (InIntegration)
+        {
+            LOG_WARN("Cannot change the spectrum settings while integrating.");
+            SpectrumNP.s = IPS_ALERT;
+            IDSetNumber(&SpectrumNP, nullptr);
+            return false;
+        }
+
+        IUUpdateNumber(&SpectrumNP, values, names, n);
+        SpectrumNP.s = configureSpectrum() ? IPS_OK : IPS_ALERT;
+        IDSetNumber(&SpectrumNP, nullptr);
+        return true;
+    }
+
     return processNumber(dev, name, values, names, n) & !r;
 }
 
-/**************************************************************************************
-** Client is asking us to abort a capture
-***************************************************************************************/
-bool LIMESDR::AbortIntegration()
+bool LIMESDR::ISNewSwitch(const char *dev, const char *name, ISState *states, char *names[], int n)
 {
-    if (InIntegration)
+    if (dev && !strcmp(dev, getDeviceName()))
     {
-        lms_stream_status_t status;
-        LMS_GetStreamStatus(&lime_stream, &status);
-        if (status.fifoFilledCount <= 0)
+        if (!strcmp(name, OutputSP.name) || !strcmp(name, WindowSP.name))
         {
-            InIntegration = false;
-            LMS_StopStream(&lime_stream);
-            LMS_DestroyStream(lime_dev, &lime_stream);
+            ISwitchVectorProperty *svp = !strcmp(name, OutputSP.name) ? &OutputSP : &WindowSP;
+            if (InIntegration)
+            {
+                LOGF_WARN("Cannot change %s while integrating.", svp->label);
+                svp->s = IPS_ALERT;
+                IDSetSwitch(svp, nullptr);
+                return false;
+            }
+
+            IUUpdateSwitch(svp, states, names, n);
+            svp->s = (svp == &WindowSP && !configureSpectrum()) ? IPS_ALERT : IPS_OK;
+            IDSetSwitch(svp, nullptr);
+            return true;
         }
     }
+
+    return INDI::Receiver::ISNewSwitch(dev, name, states, names, n);
+}
+
+/**************************************************************************************
+** Client is asking us to abort a capture
+***************************************************************************************/
+bool LIMESDR::AbortIntegration()
+{
+    // The stream keeps running, the next integration starts afresh.
+    InIntegration = false;
+    windowContinues = false;
     return true;
 }
 
@@ -297,29 +568,30 @@ void LIMESDR::TimerHit()
 
     if (InIntegration)
     {
-        timeleft = CalcTimeLeft();
-        if (timeleft < 0.1)
+        // Copy what has arrived so far, the ring only holds a couple of seconds at most.
+        grabData();
+
+        if (InIntegration)
         {
-            /* We're done capturing */
-            LOG_INFO("Integration done, expecting data...");
-            lms_stream_status_t status;
-            LMS_GetStreamStatus(&lime_stream, &status);
-            if (status.active)
-            {
-                if (status.fifoFilledCount >= status.fifoSize)
-                {
-                    n_read = status.fifoFilledCount;
-                    grabData();
-                }
-            }
-            timeleft = 0.0;
+            timeleft = CalcTimeLeft();
+            if (timeleft < 0)
+                timeleft = 0;
+            setIntegrationLeft(timeleft);
         }
+    }
+
+    updateStreamStats();
 
-        // This is an over simplified timing method, check ReceiverSimulator and limesdrReceiver for better timing checks
-        setIntegrationLeft(timeleft);
+    // Drain the ring at least twice per lap while integrating, it holds well under a second
+    // of samples at the highest rates
+    uint32_t period = getCurrentPollingPeriod();
+    if (InIntegration && streamSampleRate > 0)
+    {
+        uint32_t lap = static_cast<uint32_t>(ring.capacity() * 1000 / streamSampleRate);
+        period = min(period, static_cast<uint32_t>(lap / 2 > 10 ? lap / 2 : 10));
     }
 
-    SetTimer(getCurrentPollingPeriod());
+    SetTimer(period);
     return;
 }
 
@@ -331,13 +603,53 @@ void LIMESDR::grabData()
     if (InIntegration)
     {
         continuum = getBuffer();
-        LOG_INFO("Downloading...");
-        LMS_RecvStream(&lime_stream, continuum, n_read, NULL, 1000);
-        LMS_StopStream(&lime_stream);
-        LMS_DestroyStream(lime_dev, &lime_stream);
-        InIntegration = false;
+        uint64_t lost = 0;
 
-        LOG_INFO("Download complete.");
-        IntegrationComplete();
+        if (OutputS[OUTPUT_SPECTRUM].s == ISS_ON)
+        {
+            // Feed the spectral engine a chunk at a time, only the spectrum goes to the client.
+            const uint64_t chunk = spectrumChunk.size() / 2;
+            do
+            {
+                uint64_t chunkLost;
+                n_read = ring.read(windowPos, min(windowEnd, windowPos + chunk), spectrumChunk.data(), chunkLost);
+                if (chunkLost > 0)
+                    spectrum.dropPartial();
+                spectrum.accumulate(spectrumChunk.data() + chunkLost * 2, n_read - chunkLost);
+                windowPos += n_read;
+                b_read += n_read;
+                lost += chunkLost;
+            }
+            while (n_read == static_cast<int>(chunk));
+        }
+        else
+        {
+            float *samples = reinterpret_cast<float *>(continuum) + (windowPos - windowStart) * 2;
+            n_read = ring.read(windowPos, windowEnd, samples, lost);
+            windowPos += n_read;
+            b_read += n_read;
+        }
+
+        if (lost > 0)
+        {
+            lostSamples += lost;
+            LOGF_WARN("%llu samples overwritten before they were read, %s.", static_cast<unsigned long long>(lost),
+                      OutputS[OUTPUT_SPECTRUM].s == ISS_ON ? "left out of the spectrum" : "zeroed in the integration");
+        }
+
+        if (windowPos >= windowEnd)
+        {
+            InIntegration = false;
+            windowContinues = true;
+
+            if (OutputS[OUTPUT_SPECTRUM].s == ISS_ON)
+            {
+                spectrum.spectrum(reinterpret_cast<float *>(continuum));
+                LOGF_DEBUG("Spectrum averaged over %zu frames.", spectrum.frames());
+            }
+
+            LOG_INFO("Download complete.");
+            IntegrationComplete();
+        }
     }
 }
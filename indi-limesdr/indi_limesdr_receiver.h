@@ -21,6 +21,11 @@
 
 #include <lime/LimeSuite.h>
 #include "indireceiver.h"
+#include "samplering.h"
+#include "spectrumengine.h"
+
+#include <atomic>
+#include <thread>
 
 enum Settings
 {
@@ -33,8 +38,10 @@ class LIMESDR : public INDI::Receiver
 {
   public:
     LIMESDR(uint32_t index);
+    ~LIMESDR() override;
 
     bool ISNewNumber(const char *dev, const char *name, double values[], char *names[], int n) override;
+    bool ISNewSwitch(const char *dev, const char *name, ISState *states, char *names[], int n) override;
 
   protected:
 	// General device functions
@@ -43,6 +50,7 @@ class LIMESDR : public INDI::Receiver
 	const char *getDefaultName() override;
 	bool initProperties() override;
 	bool updateProperties() override;
+    bool saveConfigItems(FILE *fp) override;
 
     // Receiver specific functions
     bool StartIntegration(double duration) override;
@@ -52,14 +60,33 @@ class LIMESDR : public INDI::Receiver
 
     void grabData();
 
+    // Continuous acquisition
+    bool startStream();
+    void stopStream();
+    void receiveThread();
+    void updateStreamStats();
+
+    // Spectrum output
+    bool configureSpectrum();
+
   private:
     lms_device_t *lime_dev = { nullptr };
 	// Utility functions
 	float CalcTimeLeft();
     void setupParams(float sr, float freq, float bw, float gain);
     lms_stream_t lime_stream;
+    // Stream stays open while connected, the receive thread fills the ring
+    SampleRing ring;
+    std::thread recvThread;
+    std::atomic<bool> recvQuit { false };
+    float streamSampleRate { 0 };
 	// Are we exposing?
     bool InIntegration;
+    // Integration window in ring samples, windows follow each other without gaps
+    uint64_t windowStart { 0 };
+    uint64_t windowPos { 0 };
+    uint64_t windowEnd { 0 };
+    bool windowContinues { false };
 	// Struct to keep timing
 	struct timeval CapStart;
     int to_read;
@@ -71,6 +98,45 @@ class LIMESDR : public INDI::Receiver
 
     uint32_t receiverIndex = { 0 };
 
+    // Stream health
+    INumber StreamStatsN[4];
+    INumberVectorProperty StreamStatsNP;
+    enum
+    {
+        STATS_LOST_SAMPLES,
+        STATS_FIFO_OVERRUNS,
+        STATS_DROPPED_PACKETS,
+        STATS_UNDERRUNS,
+    };
+    uint64_t lostSamples { 0 };
+    std::atomic<uint32_t> fifoOverruns { 0 };
+    std::atomic<uint32_t> droppedPackets { 0 };
+    std::atomic<uint32_t> underruns { 0 };
+
+    // Publish averaged spectra instead of IQ samples
+    ISwitch OutputS[2];
+    ISwitchVectorProperty OutputSP;
+    enum
+    {
+        OUTPUT_IQ,
+        OUTPUT_SPECTRUM,
+    };
+
+    INumber SpectrumN[3];
+    INumberVectorProperty SpectrumNP;
+    enum
+    {
+        SPECTRUM_FFT_SIZE,
+        SPECTRUM_DECIMATION,
+        SPECTRUM_THREADS,
+    };
+
+    ISwitch WindowS[3];
+    ISwitchVectorProperty WindowSP;
+
+    SpectrumEngine spectrum;
+    std::vector<float> spectrumChunk;
+
     IBLOB TFitsB[5];
     IBLOBVectorProperty TFitsBP;
 };
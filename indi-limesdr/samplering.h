@@ -0,0 +1,132 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+    Copyright (C) 2017  Ilia Platone
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+/**
+ * Ring of complex float samples (interleaved I/Q) filled by a single receive thread.
+ *
+ * The writer never waits: it keeps overwriting the oldest samples. Readers address samples
+ * by their absolute index since the ring was reset, copy them out and then check whether
+ * the writer lapped them during the copy. Lapped samples are zeroed and reported as lost.
+ */
+class SampleRing
+{
+    public:
+        // Capacity is rounded up to a power of two, maxChunk is the largest single write.
+        // False if the samples could not be allocated, the ring is then empty.
+        bool reset(uint64_t capacity, uint64_t maxChunk)
+        {
+            m_Head.store(0, std::memory_order_relaxed);
+            // Let the old samples go first, both rings may not fit at once
+            std::vector<float>().swap(m_Samples);
+
+            m_Capacity = 1;
+            while (m_Capacity < capacity || m_Capacity < 2 * maxChunk)
+                m_Capacity <<= 1;
+            m_MaxChunk = maxChunk;
+            try
+            {
+                m_Samples.assign(m_Capacity * 2, 0.0f);
+            }
+            catch (const std::exception &)
+            {
+                m_Capacity = 0;
+                m_MaxChunk = 0;
+                return false;
+            }
+            return true;
+        }
+
+        uint64_t capacity() const
+        {
+            return m_Capacity;
+        }
+
+        // Number of samples written since reset.
+        uint64_t head() const
+        {
+            return m_Head.load(std::memory_order_acquire);
+        }
+
+        // Oldest sample still readable for a given head, the writer may be filling up to
+        // maxChunk samples past it.
+        uint64_t oldest(uint64_t head) const
+        {
+            return head + m_MaxChunk > m_Capacity ? head + m_MaxChunk - m_Capacity : 0;
+        }
+
+        // Writer: contiguous space at the head, at most maxChunk samples.
+        float *reserve(uint64_t &count)
+        {
+            uint64_t index = m_Head.load(std::memory_order_relaxed) & (m_Capacity - 1);
+            count = std::min(m_MaxChunk, m_Capacity - index);
+            return m_Samples.data() + index * 2;
+        }
+
+        // Writer: publish count samples written to the reserved space.
+        void commit(uint64_t count)
+        {
+            m_Head.store(m_Head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+
+        /**
+         * Copies the samples of [pos, end) written so far to dst (2 floats per sample) and
+         * returns how many were taken. Of those, the first lost samples had already been
+         * overwritten and are zeroed in dst.
+         */
+        uint64_t read(uint64_t pos, uint64_t end, float *dst, uint64_t &lost) const
+        {
+            lost = 0;
+            uint64_t head = m_Head.load(std::memory_order_acquire);
+            end = std::min(end, head);
+            if (end <= pos)
+                return 0;
+
+            uint64_t first = std::min(std::max(pos, oldest(head)), end);
+            for (uint64_t i = first; i < end;)
+            {
+                uint64_t index = i & (m_Capacity - 1);
+                uint64_t n = std::min(end - i, m_Capacity - index);
+                memcpy(dst + (i - pos) * 2, m_Samples.data() + index * 2, n * 2 * sizeof(float));
+                i += n;
+            }
+
+            // Anything the writer reached while we were copying is garbage.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t valid = std::min(std::max(first, oldest(m_Head.load(std::memory_order_relaxed))), end);
+
+            lost = valid - pos;
+            memset(dst, 0, lost * 2 * sizeof(float));
+            return end - pos;
+        }
+
+    private:
+        std::vector<float> m_Samples;
+        uint64_t m_Capacity { 0 };
+        uint64_t m_MaxChunk { 0 };
+        std::atomic<uint64_t> m_Head { 0 };
+};
@@ -0,0 +1,189 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+    Copyright (C) 2017  Ilia Platone
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "spectrumengine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+SpectrumEngine::~SpectrumEngine()
+{
+    release();
+}
+
+void SpectrumEngine::release()
+{
+    if (m_Plan)
+        fftw_destroy_plan(m_Plan);
+    m_Plan = nullptr;
+
+    for (auto &worker : m_Workers)
+    {
+        fftw_free(worker.in);
+        fftw_free(worker.out);
+    }
+    m_Workers.clear();
+}
+
+bool SpectrumEngine::configure(size_t fftSize, Window window, size_t decimation, size_t threads)
+{
+    size_t size = 2;
+    while (size < fftSize)
+        size <<= 1;
+
+    if (decimation == 0 || size % decimation != 0 || threads == 0)
+        return false;
+
+    release();
+    m_FFTSize = size;
+    m_Decimation = decimation;
+
+    // All workers have their own fftw_malloc'ed buffers, so they share one plan.
+    m_Workers.resize(threads);
+    for (auto &worker : m_Workers)
+    {
+        worker.in = static_cast<fftw_complex *>(fftw_malloc(sizeof(fftw_complex) * size));
+        worker.out = static_cast<fftw_complex *>(fftw_malloc(sizeof(fftw_complex) * size));
+        worker.power.assign(size, 0);
+        if (worker.in == nullptr || worker.out == nullptr)
+        {
+            release();
+            return false;
+        }
+    }
+    m_Plan = fftw_plan_dft_1d(size, m_Workers[0].in, m_Workers[0].out, FFTW_FORWARD, FFTW_ESTIMATE);
+
+    m_Window.resize(size);
+    m_WindowPower = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        double x = 2 * M_PI * i / size;
+        switch (window)
+        {
+            case WINDOW_HANN:
+                m_Window[i] = 0.5 - 0.5 * cos(x);
+                break;
+            case WINDOW_BLACKMAN_HARRIS:
+                m_Window[i] = 0.35875 - 0.48829 * cos(x) + 0.14128 * cos(2 * x) - 0.01168 * cos(3 * x);
+                break;
+            default:
+                m_Window[i] = 1;
+                break;
+        }
+        m_WindowPower += m_Window[i] * m_Window[i];
+    }
+
+    m_Pending.resize(size * 2);
+    reset();
+    return m_Plan != nullptr;
+}
+
+void SpectrumEngine::reset()
+{
+    for (auto &worker : m_Workers)
+        std::fill(worker.power.begin(), worker.power.end(), 0);
+    m_PendingCount = 0;
+    m_Frames = 0;
+}
+
+void SpectrumEngine::transform(Worker &worker, const float *iq, size_t frames)
+{
+    for (; frames; frames--, iq += m_FFTSize * 2)
+    {
+        for (size_t i = 0; i < m_FFTSize; i++)
+        {
+            worker.in[i][0] = iq[i * 2] * m_Window[i];
+            worker.in[i][1] = iq[i * 2 + 1] * m_Window[i];
+        }
+
+        fftw_execute_dft(m_Plan, worker.in, worker.out);
+
+        for (size_t i = 0; i < m_FFTSize; i++)
+            worker.power[i] += worker.out[i][0] * worker.out[i][0] + worker.out[i][1] * worker.out[i][1];
+    }
+}
+
+void SpectrumEngine::accumulate(const float *iq, size_t samples)
+{
+    if (m_Plan == nullptr)
+        return;
+
+    // Complete the frame left over from last time first.
+    if (m_PendingCount > 0)
+    {
+        size_t n = std::min(samples, m_FFTSize - m_PendingCount);
+        memcpy(m_Pending.data() + m_PendingCount * 2, iq, n * 2 * sizeof(float));
+        m_PendingCount += n;
+        iq += n * 2;
+        samples -= n;
+
+        if (m_PendingCount < m_FFTSize)
+            return;
+
+        transform(m_Workers[0], m_Pending.data(), 1);
+        m_PendingCount = 0;
+        m_Frames++;
+    }
+
+    size_t frames = samples / m_FFTSize;
+    size_t threads = std::min(m_Workers.size(), frames);
+
+    if (threads <= 1)
+    {
+        transform(m_Workers[0], iq, frames);
+    }
+    else
+    {
+        std::vector<std::thread> pool;
+        size_t first = 0;
+        for (size_t t = 0; t < threads; t++)
+        {
+            size_t count = frames / threads + (t < frames % threads ? 1 : 0);
+            pool.emplace_back(&SpectrumEngine::transform, this, std::ref(m_Workers[t]), iq + first * m_FFTSize * 2, count);
+            first += count;
+        }
+        for (auto &thread : pool)
+            thread.join();
+    }
+    m_Frames += frames;
+
+    m_PendingCount = samples - frames * m_FFTSize;
+    memcpy(m_Pending.data(), iq + frames * m_FFTSize * 2, m_PendingCount * 2 * sizeof(float));
+}
+
+void SpectrumEngine::spectrum(float *out) const
+{
+    const size_t channels = m_FFTSize / m_Decimation;
+    const double scale = m_Frames > 0 ? 1.0 / (m_Frames * m_WindowPower * m_Decimation) : 0;
+
+    for (size_t c = 0; c < channels; c++)
+    {
+        double sum = 0;
+        for (size_t d = 0; d < m_Decimation; d++)
+        {
+            // FFT order is DC first, negative frequencies in the upper half.
+            size_t bin = (c * m_Decimation + d + m_FFTSize / 2) % m_FFTSize;
+            for (auto &worker : m_Workers)
+                sum += worker.power[bin];
+        }
+        out[c] = static_cast<float>(sum * scale);
+    }
+}
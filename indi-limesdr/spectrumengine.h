@@ -0,0 +1,108 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+    Copyright (C) 2017  Ilia Platone
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <fftw3.h>
+
+/**
+ * Averaged power spectrum of complex float samples (interleaved I/Q).
+ *
+ * Samples are cut into consecutive frames of fftSize, windowed and transformed; the power
+ * of every frame is summed per bin. The frames of one accumulate() call are shared between
+ * the worker threads, each with its own buffers and sum, and merged afterwards.
+ */
+class SpectrumEngine
+{
+    public:
+        enum Window
+        {
+            WINDOW_NONE,
+            WINDOW_HANN,
+            WINDOW_BLACKMAN_HARRIS,
+        };
+
+        SpectrumEngine() = default;
+        ~SpectrumEngine();
+
+        /**
+         * fftSize is rounded up to a power of two, decimation adjacent bins are averaged into
+         * one output channel and must divide fftSize. Not to be called while accumulating.
+         */
+        bool configure(size_t fftSize, Window window, size_t decimation, size_t threads);
+
+        // Start a new average.
+        void reset();
+
+        // Forget a partial frame, e.g. after samples were lost.
+        void dropPartial()
+        {
+            m_PendingCount = 0;
+        }
+
+        void accumulate(const float *iq, size_t samples);
+
+        size_t frames() const
+        {
+            return m_Frames;
+        }
+
+        size_t fftSize() const
+        {
+            return m_FFTSize;
+        }
+
+        size_t channels() const
+        {
+            return m_FFTSize / m_Decimation;
+        }
+
+        /**
+         * Average power per channel into out (channels() values), lowest frequency first
+         * with the tuned frequency in the middle.
+         */
+        void spectrum(float *out) const;
+
+    private:
+        struct Worker
+        {
+            fftw_complex *in { nullptr };
+            fftw_complex *out { nullptr };
+            std::vector<double> power;
+        };
+
+        void release();
+        void transform(Worker &worker, const float *iq, size_t frames);
+
+        size_t m_FFTSize { 0 };
+        size_t m_Decimation { 1 };
+        std::vector<double> m_Window;
+        double m_WindowPower { 1 };
+        fftw_plan m_Plan { nullptr };
+        std::vector<Worker> m_Workers;
+
+        // Samples of a frame not complete at the end of the last accumulate() call
+        std::vector<float> m_Pending;
+        size_t m_PendingCount { 0 };
+        size_t m_Frames { 0 };
+};
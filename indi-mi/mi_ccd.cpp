@@ -34,6 +34,7 @@
 #define TEMP_COOLER_OFF 100  /* High enough temperature for the camera cooler to turn off (°C) */
 #define MAX_DEVICES     4    /* Max device cameraCount */
 #define MAX_ERROR_LEN   64   /* Max length of error buffer */
+#define READOUT_BATCH   64   /* Rows copied per ccdBufferLock */
 
 // There is _one_ binary for USB and ETH driver, but each binary is renamed
 // to its variant (indi_mi_ccd_usb and indi_mi_ccd_eth). The main function will
@@ -140,6 +141,7 @@ MICCD::MICCD(int camId, bool eth) : FilterInterface(this)
 
 MICCD::~MICCD()
 {
+    readout.stop();
     gxccd_release(cameraHandle);
 }
 
@@ -204,6 +206,17 @@ bool MICCD::initProperties()
     IUFillNumberVector(&PreflashNP, PreflashN, 2, getDeviceName(), "NIR_PRE_FLASH", "NIR Preflash",
                        MAIN_CONTROL_TAB, IP_RW, 60, IPS_IDLE);
 
+    // Statistics of the last download
+    IUFillNumber(&ReadoutStatsN[STATS_ROWS], "ROWS", "Rows", "%.f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_MIN], "MIN", "Min", "%.f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_MAX], "MAX", "Max", "%.f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_MEAN], "MEAN", "Mean", "%.1f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_MEDIAN], "MEDIAN", "Median", "%.f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_CHECKSUM], "CHECKSUM", "Checksum", "%.f", 0, 4294967295., 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_DURATION], "DURATION", "Duration (ms)", "%.f", 0, 1e6, 0, 0);
+    IUFillNumberVector(&ReadoutStatsNP, ReadoutStatsN, 7, getDeviceName(), "CCD_READOUT_STATS", "Last readout",
+                       IMAGE_INFO_TAB, IP_RO, 0, IPS_IDLE);
+
     addAuxControls();
 
     setDriverInterface(getDriverInterface() | FILTER_INTERFACE);
@@ -273,6 +286,8 @@ bool MICCD::updateProperties()
         if (canDoPreflash)
             defineProperty(&PreflashNP);
 
+        defineProperty(&ReadoutStatsNP);
+
         if (numFilters > 0)
         {
             INDI::FilterInterface::updateProperties();
@@ -307,6 +322,8 @@ bool MICCD::updateProperties()
         if (canDoPreflash)
             deleteProperty(PreflashNP.name);
 
+        deleteProperty(ReadoutStatsNP.name);
+
         if (numFilters > 0)
         {
             INDI::FilterInterface::updateProperties();
@@ -395,6 +412,7 @@ bool MICCD::Connect()
 
 bool MICCD::Disconnect()
 {
+    readout.stop();
     LOGF_INFO("Disconnected from %s.", name);
     gxccd_release(cameraHandle);
     cameraHandle = nullptr;
@@ -469,6 +487,13 @@ int MICCD::SetTemperature(double temperature)
 
     TemperatureRequest = temperature;
 
+    // Sent once the download is over
+    if (downloading)
+    {
+        temperaturePending = true;
+        return 0;
+    }
+
     if (!isSimulation() && gxccd_set_temperature(cameraHandle, temperature) < 0)
     {
         char errorStr[MAX_ERROR_LEN];
@@ -482,6 +507,12 @@ int MICCD::SetTemperature(double temperature)
 
 bool MICCD::StartExposure(float duration)
 {
+    if (readout.isRunning())
+    {
+        LOG_ERROR("Previous image is still downloading.");
+        return false;
+    }
+
     imageFrameType = PrimaryCCD.getFrameType();
     useShutter = (imageFrameType == INDI::CCDChip::LIGHT_FRAME || imageFrameType == INDI::CCDChip::FLAT_FRAME);
 
@@ -513,6 +544,10 @@ bool MICCD::StartExposure(float duration)
 
 bool MICCD::AbortExposure()
 {
+    // An image read in progress completes, its copy to the frame buffer is skipped
+    if (readout.isRunning())
+        readout.stop();
+
     if (InExposure && !isSimulation())
     {
         if (gxccd_abort_exposure(cameraHandle, false) < 0)
@@ -532,6 +567,12 @@ bool MICCD::AbortExposure()
 
 bool MICCD::UpdateCCDFrame(int x, int y, int w, int h)
 {
+    if (readout.isRunning())
+    {
+        LOG_ERROR("Cannot change the frame while the image is downloading.");
+        return false;
+    }
+
     /* Add the X and Y offsets */
     long x_1 = x / PrimaryCCD.getBinX();
     long y_1 = y / PrimaryCCD.getBinY();
@@ -563,6 +604,12 @@ bool MICCD::UpdateCCDFrame(int x, int y, int w, int h)
 
 bool MICCD::UpdateCCDBin(int hor, int ver)
 {
+    if (readout.isRunning())
+    {
+        LOG_ERROR("Cannot change the binning while the image is downloading.");
+        return false;
+    }
+
     if (hor < 1 || hor > maxBinX || ver < 1 || ver > maxBinY)
     {
         LOGF_ERROR("Binning (%dx%d) are out of range. Range from (1x1) to (%dx%d)",
@@ -590,67 +637,87 @@ float MICCD::calcTimeLeft()
     return ExposureRequest - timesince / 1000.0;
 }
 
-static void mirror_image(void *buf, size_t w, size_t d)
+/* Downloads the image from the CCD on the download thread, ccdBufferLock is released between batches of rows. */
+int MICCD::grabImage()
 {
-    size_t w2     = w * 2;
-    size_t half_d = d / 2;
+    int width  = PrimaryCCD.getSubW() / PrimaryCCD.getBinX();
+    int height = PrimaryCCD.getSubH() / PrimaryCCD.getBinY();
 
-    for (size_t line = 1; line <= half_d; line++)
+    // libgxccd has 0 on the bottom, rows are stored bottom up
+    readout.setFrame(PrimaryCCD.getFrameBuffer(), width, height, PrimaryCCD.getBPP() / 8);
+    readout.setFlip(false, true);
+    readout.setBatch(READOUT_BATCH);
+    readout.setLock(&ccdBufferLock);
+    readout.start([this](PixelShuffle::RowReadout & r)
     {
-        uint16_t *sa = (uint16_t *)((char *)buf + (line - 1) * w2);
-        uint16_t *da = (uint16_t *)((char *)buf + (d - line) * w2);
-        for (size_t index = 1; index <= w; index++)
-        {
-            uint16_t tmp = *sa;
-            *sa          = *da;
-            *da          = tmp;
-            ++sa;
-            ++da;
-        }
-    }
+        return readImage(r);
+    },
+    [this](bool ok)
+    {
+        readoutDone(ok);
+    });
+
+    return 0;
 }
 
-/* Downloads the image from the CCD. */
-int MICCD::grabImage()
+bool MICCD::readImage(PixelShuffle::RowReadout &r)
 {
-    std::unique_lock<std::mutex> guard(ccdBufferLock);
-    int ret              = 0;
-    unsigned char *image = (unsigned char *)PrimaryCCD.getFrameBuffer();
-    int width  = PrimaryCCD.getSubW() / PrimaryCCD.getBinX();
-    int height = PrimaryCCD.getSubH() / PrimaryCCD.getBinY();
+    size_t rowSize = PrimaryCCD.getSubW() / PrimaryCCD.getBinX() * PrimaryCCD.getBPP() / 8;
 
     if (isSimulation())
     {
-        uint16_t *buffer = (uint16_t *)image;
-
-        for (int i = 0; i < height; i++)
-            for (int j = 0; j < width; j++)
-                buffer[i * width + j] = rand() % UINT16_MAX;
+        return r.read([&](int, uint8_t *row)
+        {
+            uint16_t *buffer = reinterpret_cast<uint16_t *>(row);
+            for (size_t j = 0; j < rowSize / 2; j++)
+                buffer[j] = rand() % UINT16_MAX;
+            return true;
+        });
     }
-    else
+
+    // The whole image comes in one call, read it without holding the frame buffer
+    rawImage.resize(PrimaryCCD.getFrameBufferSize());
+    if (gxccd_read_image(cameraHandle, rawImage.data(), rawImage.size()) < 0)
     {
-        ret = gxccd_read_image(cameraHandle, image, PrimaryCCD.getFrameBufferSize());
-        if (ret < 0)
-        {
-            char errorStr[MAX_ERROR_LEN];
-            gxccd_get_last_error(cameraHandle, errorStr, sizeof(errorStr));
-            LOGF_ERROR("Error getting image: %s.", errorStr);
-        }
-        else
-        {
-            mirror_image(image, width, height);
-        }
+        char errorStr[MAX_ERROR_LEN];
+        gxccd_get_last_error(cameraHandle, errorStr, sizeof(errorStr));
+        LOGF_ERROR("Error getting image: %s.", errorStr);
+        return false;
     }
 
-    guard.unlock();
+    return r.read([&](int y, uint8_t *row)
+    {
+        memcpy(row, rawImage.data() + y * rowSize, rowSize);
+        return true;
+    });
+}
+
+void MICCD::readoutDone(bool ok)
+{
+    downloading = false;
+
+    if (!ok)
+    {
+        if (!readout.isAborted())
+            PrimaryCCD.setExposureFailed();
+        return;
+    }
 
-    if (ExposureRequest > 5 && !ret)
+    const PixelShuffle::ReadoutStats &stats = readout.stats();
+    ReadoutStatsN[STATS_ROWS].value     = stats.rows;
+    ReadoutStatsN[STATS_MIN].value      = stats.min;
+    ReadoutStatsN[STATS_MAX].value      = stats.max;
+    ReadoutStatsN[STATS_MEAN].value     = stats.mean;
+    ReadoutStatsN[STATS_MEDIAN].value   = stats.median();
+    ReadoutStatsN[STATS_CHECKSUM].value = stats.checksum;
+    ReadoutStatsN[STATS_DURATION].value = stats.duration;
+    ReadoutStatsNP.s = IPS_OK;
+    IDSetNumber(&ReadoutStatsNP, nullptr);
+
+    if (ExposureRequest > 5)
         LOG_INFO("Download complete.");
 
-    downloading = false;
     ExposureComplete(&PrimaryCCD);
-
-    return ret;
 }
 
 void MICCD::TimerHit()
@@ -658,6 +725,8 @@ void MICCD::TimerHit()
     if (!isConnected())
         return; // No need to reset timer if we are not connected anymore
 
+    applyPendingSettings();
+
     if (InExposure)
     {
         float timeleft = calcTimeLeft();
@@ -693,6 +762,43 @@ void MICCD::TimerHit()
     SetTimer(getCurrentPollingPeriod());
 }
 
+bool MICCD::isDownloading(const char *setting)
+{
+    if (!downloading)
+        return false;
+
+    LOGF_ERROR("Cannot change the %s while the image is downloading.", setting);
+    return true;
+}
+
+/* Temperature and filter requests that came in during a download */
+void MICCD::applyPendingSettings()
+{
+    if (downloading)
+        return;
+
+    if (temperaturePending)
+    {
+        temperaturePending = false;
+        if (SetTemperature(TemperatureRequest) < 0)
+        {
+            TemperatureNP.s = IPS_ALERT;
+            IDSetNumber(&TemperatureNP, nullptr);
+        }
+    }
+
+    if (pendingFilter > 0)
+    {
+        int position = pendingFilter;
+        pendingFilter = 0;
+        if (!SelectFilter(position))
+        {
+            FilterSlotNP.s = IPS_ALERT;
+            IDSetNumber(&FilterSlotNP, nullptr);
+        }
+    }
+}
+
 int MICCD::QueryFilter()
 {
     return CurrentFilter;
@@ -700,6 +806,13 @@ int MICCD::QueryFilter()
 
 bool MICCD::SelectFilter(int position)
 {
+    // Moved once the download is over, SelectFilterDone() follows then
+    if (downloading)
+    {
+        pendingFilter = position;
+        return true;
+    }
+
     if (!isSimulation() && gxccd_set_filter(cameraHandle, position - 1) < 0)
     {
         char errorStr[MAX_ERROR_LEN];
@@ -775,6 +888,12 @@ bool MICCD::ISNewSwitch(const char *dev, const char *name, ISState *states, char
         }
         else if (!strcmp(name, CoolerSP.name))
         {
+            if (isDownloading("cooler"))
+            {
+                CoolerSP.s = IPS_ALERT;
+                IDSetSwitch(&CoolerSP, nullptr);
+                return true;
+            }
 
             IUUpdateSwitch(&CoolerSP, states, names, n);
             CoolerSP.s = IPS_OK;
@@ -827,6 +946,13 @@ bool MICCD::ISNewNumber(const char *dev, const char *name, double values[], char
 
         if (!strcmp(name, FanNP.name))
         {
+            if (isDownloading("fan"))
+            {
+                FanNP.s = IPS_ALERT;
+                IDSetNumber(&FanNP, nullptr);
+                return true;
+            }
+
             IUUpdateNumber(&FanNP, values, names, n);
 
             if (!isSimulation() && gxccd_set_fan(cameraHandle, FanN[0].value) < 0)
@@ -847,6 +973,13 @@ bool MICCD::ISNewNumber(const char *dev, const char *name, double values[], char
 
         if (!strcmp(name, WindowHeatingNP.name))
         {
+            if (isDownloading("window heating"))
+            {
+                WindowHeatingNP.s = IPS_ALERT;
+                IDSetNumber(&WindowHeatingNP, nullptr);
+                return true;
+            }
+
             IUUpdateNumber(&WindowHeatingNP, values, names, n);
 
             if (!isSimulation() && gxccd_set_window_heating(cameraHandle, WindowHeatingN[0].value) < 0)
@@ -867,6 +1000,13 @@ bool MICCD::ISNewNumber(const char *dev, const char *name, double values[], char
 
         if (!strcmp(name, PreflashNP.name))
         {
+            if (isDownloading("preflash"))
+            {
+                PreflashNP.s = IPS_ALERT;
+                IDSetNumber(&PreflashNP, nullptr);
+                return true;
+            }
+
             IUUpdateNumber(&PreflashNP, values, names, n);
 
             // set NIR pre-flash if available.
@@ -891,6 +1031,13 @@ bool MICCD::ISNewNumber(const char *dev, const char *name, double values[], char
 
         if (!strcmp(name, GainNP.name))
         {
+            if (isDownloading("gain"))
+            {
+                GainNP.s = IPS_ALERT;
+                IDSetNumber(&GainNP, nullptr);
+                return true;
+            }
+
             IUUpdateNumber(&GainNP, values, names, n);
 
             if (!isSimulation() && gxccd_set_gain(cameraHandle, static_cast<uint16_t>(GainN[0].value)) < 0)
@@ -925,6 +1072,13 @@ void MICCD::updateTemperature()
     float ccdpower = 0;
     int err        = 0;
 
+    // The camera is busy with the download, poll it next time
+    if (downloading)
+    {
+        temperatureID = IEAddTimer(getCurrentPollingPeriod(), MICCD::updateTemperatureHelper, this);
+        return;
+    }
+
     if (isSimulation())
     {
         ccdtemp = TemperatureN[0].value;
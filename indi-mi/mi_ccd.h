@@ -25,6 +25,10 @@
 
 #include <indiccd.h>
 #include <indifilterinterface.h>
+#include <rowreadout.h>
+
+#include <atomic>
+#include <vector>
 
 class MICCD : public INDI::CCD, public INDI::FilterInterface
 {
@@ -89,6 +93,19 @@ class MICCD : public INDI::CCD, public INDI::FilterInterface
         INumber PreflashN[2];
         INumberVectorProperty PreflashNP;
 
+        INumber ReadoutStatsN[7];
+        INumberVectorProperty ReadoutStatsNP;
+        enum
+        {
+            STATS_ROWS,
+            STATS_MIN,
+            STATS_MAX,
+            STATS_MEAN,
+            STATS_MEDIAN,
+            STATS_CHECKSUM,
+            STATS_DURATION
+        };
+
     private:
         char name[MAXINDIDEVICE];
 
@@ -111,7 +128,14 @@ class MICCD : public INDI::CCD, public INDI::FilterInterface
         int temperatureID;
         int timerID;
 
-        bool downloading;
+        // gxccd_read_image() runs on the download thread, other camera calls wait until it is over
+        std::atomic<bool> downloading { false };
+        bool temperaturePending { false };
+        int pendingFilter { 0 };
+
+        // gxccd_read_image() lands here, rows are copied flipped into the frame buffer
+        std::vector<uint8_t> rawImage;
+        PixelShuffle::RowReadout readout;
 
         bool canDoPreflash;
 
@@ -125,6 +149,11 @@ class MICCD : public INDI::CCD, public INDI::FilterInterface
 
         float calcTimeLeft();
         int grabImage();
+        bool readImage(PixelShuffle::RowReadout &readout);
+        void readoutDone(bool ok);
+
+        bool isDownloading(const char *setting);
+        void applyPendingSettings();
 
         void updateTemperature();
         static void updateTemperatureHelper(void *);
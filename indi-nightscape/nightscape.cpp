@@ -250,6 +250,12 @@ bool NightscapeCCD::initProperties()
 
     defineProperty(&CamNumNP);
 
+    IUFillNumber(&DownloadN[0], "DOWNLOAD_RATE", "Rate (kB/s)", "%8.0f", 0.0, 1000000.0, 0.0, 0.0);
+    IUFillNumber(&DownloadN[1], "DOWNLOAD_STALLS", "Stalls", "%6.0f", 0.0, 1000000.0, 0.0, 0.0);
+    IUFillNumber(&DownloadN[2], "DOWNLOAD_TOTAL_STALLS", "Total stalls", "%6.0f", 0.0, 1000000.0, 0.0, 0.0);
+    IUFillNumberVector(&DownloadNP, DownloadN, 3, getDeviceName(), "CCD_DOWNLOAD", "Download",
+                       IMAGE_INFO_TAB, IP_RO, 60, IPS_IDLE);
+
     IUFillSwitch(&D2xxS[0], "USEFTDI", "libftdi", useD2xx == 0 ? ISS_ON : ISS_OFF);
 #ifdef HAVE_D2XX
     IUFillSwitch(&D2xxS[1], "USED2XX", "libd2xx", useD2xx == 1 ? ISS_ON : ISS_OFF);
@@ -316,6 +322,7 @@ bool NightscapeCCD::updateProperties()
         setupParams();
         defineProperty(&CoolerSP);
         defineProperty(&FanSP);
+        defineProperty(&DownloadNP);
 
         // Start the timer
         SetTimer(getCurrentPollingPeriod());
@@ -324,6 +331,7 @@ bool NightscapeCCD::updateProperties()
     {
         deleteProperty(FanSP.name);
         deleteProperty(CoolerSP.name);
+        deleteProperty(DownloadNP.name);
     }
 
     return true;
@@ -375,6 +383,7 @@ bool NightscapeCCD::StartExposure(float duration)
     dn->setImgSize(m->getRawImgSize(zonestart, zonelen, framediv));
     dn->setFrameYBinning(framediv);
     dn->setFrameXBinning(PrimaryCCD.getBinX());
+    dn->setFrameX(PrimaryCCD.getSubX(), PrimaryCCD.getSubW());
     m->sendzone(zonestart, zonelen, framediv);
     INDI::CCDChip::CCD_FRAME ft = PrimaryCCD.getFrameType();
     if (ft == INDI::CCDChip::DARK_FRAME || ft == INDI::CCDChip::BIAS_FRAME) dark = true;
@@ -586,6 +595,12 @@ void NightscapeCCD::grabImage()
     dn->freeBuf();
     LOGF_DEBUG( "Download %d lines complete.", dn->getActWriteLines());
 
+    DownloadN[0].value = dn->getDownloadRate() / 1000.0;
+    DownloadN[1].value = dn->getDownloadStalls();
+    DownloadN[2].value = dn->getTotalStalls();
+    DownloadNP.s = IPS_OK;
+    IDSetNumber(&DownloadNP, nullptr);
+
     // Let INDI::CCD know we're done filling the image buffer
     ExposureComplete(&PrimaryCCD);
 }
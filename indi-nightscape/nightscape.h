@@ -67,6 +67,9 @@ class NightscapeCCD : public INDI::CCD
 		INumber CamNumN[1];
     INumberVectorProperty CamNumNP;
 
+		INumber DownloadN[3];
+    INumberVectorProperty DownloadNP;
+
 #ifdef HAVE_D2XX
 #ifdef HAVE_SERIAL
  		ISwitch  D2xxS [3];
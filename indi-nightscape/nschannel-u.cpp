@@ -1,8 +1,54 @@
 #include <stdio.h>
+#include <string.h>
+#include <chrono>
 
 #include "nschannel-u.h"
 #include  "nsdebug.h"
 
+// Bulk transfers kept queued while streaming, and max size packets per transfer
+#define NS_STREAM_TRANSFERS 8
+#define NS_STREAM_PACKETS 64
+// ms, event loop tick, and silence that ends a download once data came in
+#define NS_STREAM_TICK 20
+#define NS_STREAM_IDLE 500
+
+struct ns_stream {
+	unsigned char * buf;
+	size_t size;
+	size_t nread;
+	int packetsize;
+	int active;
+	int transfers;
+	int error;
+	bool done;
+};
+
+static void LIBUSB_CALL stream_cb(struct libusb_transfer * xfer)
+{
+	struct ns_stream * st = (struct ns_stream *) xfer->user_data;
+
+	if (xfer->status == LIBUSB_TRANSFER_COMPLETED) {
+		st->transfers++;
+		// Every packet starts with the two FTDI modem status bytes
+		for (int off = 0; off < xfer->actual_length && st->nread < st->size; off += st->packetsize) {
+			int len = xfer->actual_length - off;
+			if (len > st->packetsize) len = st->packetsize;
+			len -= 2;
+			if (len <= 0) continue;
+			if ((size_t)len > st->size - st->nread) len = st->size - st->nread;
+			memcpy(st->buf + st->nread, xfer->buffer + off + 2, len);
+			st->nread += len;
+		}
+		if (st->nread >= st->size) st->done = true;
+		// Resubmitting behind the others keeps the data in order
+		if (!st->done && libusb_submit_transfer(xfer) == 0) return;
+	} else if (xfer->status != LIBUSB_TRANSFER_CANCELLED) {
+		st->error = xfer->status;
+		st->done = true;
+	}
+	st->active--;
+}
+
 struct ftdi_context * NsChannelU::getDataChannel(void) {
 		return &data_channel;	
 }
@@ -265,6 +311,118 @@ int NsChannelU::readData(unsigned char *buf, size_t size) {
   }
 }
 
+int NsChannelU::streamData(unsigned char *buf, size_t size, ns_stream_cb cb, void * user, ns_stream_stats_t * stats) {
+  struct ftdi_context * ftdid = &data_channel;
+  // The data channel was opened on a device of the scan context, its events are handled there
+  libusb_context * usbctx = scan_channel.usb_ctx;
+  struct libusb_transfer * xfers[NS_STREAM_TRANSFERS] = { NULL };
+  struct ns_stream st;
+  int xfersize = ftdid->max_packet_size * NS_STREAM_PACKETS;
+
+  st.buf = buf;
+  st.size = size;
+  st.nread = 0;
+  st.packetsize = ftdid->max_packet_size;
+  st.active = 0;
+  st.transfers = 0;
+  st.error = 0;
+  st.done = false;
+
+  // Whatever libftdi has read ahead comes first
+  if (ftdid->readbuffer_remaining > 0) {
+  	size_t n = ftdid->readbuffer_remaining;
+  	if (n > size) n = size;
+  	memcpy(buf, ftdid->readbuffer + ftdid->readbuffer_offset, n);
+  	ftdid->readbuffer_offset += n;
+  	ftdid->readbuffer_remaining -= n;
+  	st.nread = n;
+  }
+
+  for (int i = 0; i < NS_STREAM_TRANSFERS && st.nread < size; i++) {
+  	xfers[i] = libusb_alloc_transfer(0);
+  	unsigned char * xbuf = (unsigned char *) malloc(xfersize);
+  	if (xfers[i] == NULL || xbuf == NULL) {
+  		free(xbuf);
+  		DO_ERR("%s\n", "unable to allocate stream transfers");
+  		st.error = LIBUSB_ERROR_NO_MEM;
+  		break;
+  	}
+  	libusb_fill_bulk_transfer(xfers[i], ftdid->usb_dev, ftdid->out_ep, xbuf, xfersize, stream_cb, &st, 0);
+  	int rc = libusb_submit_transfer(xfers[i]);
+  	if (rc < 0) {
+  		DO_ERR( "unable to submit stream transfer: %d (%s)\n", rc, libusb_error_name(rc));
+  		st.error = rc;
+  		break;
+  	}
+  	st.active++;
+  }
+
+  typedef std::chrono::steady_clock clock;
+  clock::time_point first, last = clock::now();
+  size_t seen = 0;
+  int stalls = 0;
+  bool stalled = false;
+  if (st.error) st.done = true;
+
+  while (!st.done) {
+  	struct timeval tv = { 0, NS_STREAM_TICK * 1000 };
+  	int rc = libusb_handle_events_timeout_completed(usbctx, &tv, NULL);
+  	if (rc < 0 && rc != LIBUSB_ERROR_INTERRUPTED) {
+  		DO_ERR( "stream event handling failed: %d (%s)\n", rc, libusb_error_name(rc));
+  		st.error = rc;
+  		break;
+  	}
+
+  	clock::time_point now = clock::now();
+  	if (st.nread > seen) {
+  		if (seen == 0) first = now;
+  		seen = st.nread;
+  		last = now;
+  		stalled = false;
+  		if (cb && !cb(user, seen)) break;
+  	} else {
+  		// Before the first byte the readout may still be going on
+  		long idle = std::chrono::duration_cast<std::chrono::milliseconds>(now - last).count();
+  		if (seen > 0 && !stalled) {
+  			stalled = true;
+  			stalls++;
+  		}
+  		if (idle > (seen > 0 ? NS_STREAM_IDLE : ftdid->usb_read_timeout)) break;
+  	}
+  }
+
+  // Cancel what is still queued and wait for it before freeing
+  st.done = true;
+  for (int i = 0; i < NS_STREAM_TRANSFERS; i++) {
+  	if (xfers[i]) libusb_cancel_transfer(xfers[i]);
+  }
+  while (st.active > 0) {
+  	struct timeval tv = { 0, NS_STREAM_TICK * 1000 };
+  	if (libusb_handle_events_timeout_completed(usbctx, &tv, NULL) < 0) break;
+  }
+  for (int i = 0; i < NS_STREAM_TRANSFERS; i++) {
+  	if (xfers[i] == NULL) continue;
+  	free(xfers[i]->buffer);
+  	libusb_free_transfer(xfers[i]);
+  }
+
+  // The tail may have come in with the cancelled transfers
+  if (st.nread > seen && cb) cb(user, st.nread);
+
+  if (stats) {
+  	stats->nread = st.nread;
+  	stats->transfers = st.transfers;
+  	stats->stalls = stalls;
+  	stats->seconds = seen > 0 ? std::chrono::duration<double>(last - first).count() : 0;
+  }
+
+  if (st.error) {
+  	DO_ERR( "unable to stream data: %d (%s)\n", st.error, libusb_error_name(st.error));
+  	return -1;
+  }
+  return st.nread;
+}
+
 int NsChannelU::purgeData(void) {
   struct ftdi_context * ftdid = &data_channel;
 	int rc2;
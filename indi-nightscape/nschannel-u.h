@@ -26,6 +26,7 @@ class NsChannelU : public NsChannel {
 		int readCommand(unsigned char * buf, size_t n);
 		int writeCommand(const unsigned char * buf, size_t n);
 		int readData(unsigned char * buf, size_t n);
+		int streamData(unsigned char * buf, size_t n, ns_stream_cb cb, void * user, ns_stream_stats_t * stats);
 		int purgeData(void);
 		int setDataRts(void);
 		int resetcontrol (void);
@@ -5,6 +5,19 @@
 #define DEFAULT_OLD_CHUNK_SIZE  63448
 #define DEFAULT_CHUNK_SIZE 65536
 
+// streamData() of channels without streaming
+#define NS_STREAM_UNSUPPORTED (-2)
+
+typedef struct ns_stream_stats {
+	size_t nread;
+	int transfers;	// completed USB transfers
+	int stalls;		// waits without data once the download was flowing
+	double seconds;	// from the first to the last byte
+} ns_stream_stats_t;
+
+// Called by streamData() whenever data came in, returning false stops the stream
+typedef bool (*ns_stream_cb)(void * user, size_t nread);
+
 class NsChannel {
 	public:
 		NsChannel() {
@@ -25,6 +38,10 @@ class NsChannel {
 		virtual int readCommand(unsigned char * buf, size_t n) = 0;
 		virtual int writeCommand(const unsigned char * buf, size_t n) = 0;
 		virtual int readData(unsigned char * buf, size_t n)= 0;
+		virtual int streamData(unsigned char * buf, size_t n, ns_stream_cb cb, void * user, ns_stream_stats_t * stats) {
+			(void)buf; (void)n; (void)cb; (void)user; (void)stats;
+			return NS_STREAM_UNSUPPORTED;
+		}
 		virtual int purgeData(void)= 0;
 		virtual int setDataRts(void)= 0;
 		virtual int resetcontrol (void)= 0;
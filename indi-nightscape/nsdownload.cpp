@@ -8,6 +8,43 @@
 #include "nsdebug.h"
 #include <math.h>
 
+// Unpads one raw row into dst, binning xbin pixels across
+static void decoderow(const uint8_t * rowp, uint8_t * dst, int xstart, int xlen, int binning, bool rms)
+{
+	unsigned char linebuf[KAF8300_MAX_X*2];
+	const uint8_t * lbufp = rowp + (KAF8300_POSTAMBLE*2) + xstart*2;
+
+	if (binning <= 1) {
+		memcpy (dst, lbufp, xlen * 2);
+		return;
+	}
+	int len = xlen * 2;
+	int linelen = 0;
+	while (len > 0) {
+		short px[4];
+		long long pxsq =0;
+		long pxav =0;
+		short pxa;
+		memcpy(px, lbufp,binning * 2);
+		for (int a = 0; a < binning; a++) {
+			pxav += px[a];
+			pxsq	+= px[a]*px[a];
+		}
+		pxav /= binning;
+		pxsq /= binning;
+		if(rms) {
+			pxa = round(sqrt((double)	pxsq));
+		} else {
+			pxa = pxav;
+		}
+		memcpy (linebuf + linelen, &pxa, 2);
+		linelen += 2;
+		lbufp += 2*binning;
+		len -= 2* binning;
+	}
+	memcpy (dst, linebuf, (xlen*2)/binning);
+}
+
 void NsDownload::setFrameYBinning(int binning) {
 			ctx->imgp->ybinning = binning;	
 
@@ -17,6 +54,11 @@ void NsDownload::setFrameXBinning(int binning) {
 			ctx->imgp->xbinning = binning;	
 
 }
+void NsDownload::setFrameX(int xstart, int xlen) {
+			ctx->imgp->xstart = xstart;
+			ctx->imgp->xlen = xlen;
+}
+
 void NsDownload::setImgSize(int siz) {
 	rd->imgsz = siz;
 }
@@ -93,7 +135,9 @@ void NsDownload::setImgWrite(bool w) {
 void NsDownload::freeBuf() {
 	if (!retrBuf) return;
 	if (retrBuf->buffer) free(retrBuf->buffer);
+	if (retrBuf->frame) free(retrBuf->frame);
 	retrBuf->buffer = NULL;
+	retrBuf->frame = NULL;
 	retrBuf = NULL;
 }
 
@@ -110,6 +154,18 @@ void NsDownload::setZeroReads(int zeroes){
 		 return writelines;	
 }
 
+double NsDownload::getDownloadRate(){
+	return dlrate;
+}
+
+int NsDownload::getDownloadStalls(){
+	return dlstalls;
+}
+
+int NsDownload::getTotalStalls(){
+	return totstalls;
+}
+
 int NsDownload::downloader() 
 {
 			//struct ftdi_context * ftdid = cn->->getDataChannel();
@@ -144,6 +200,7 @@ int NsDownload::downloader()
 				return (-1);
 			}
 			rd->nread += rc2;
+			decoderows();
 			if (rc2 != cn->getMaxXfer()) {
 				DO_INFO("short! %d %d\n", rd->nblks, rc2);
 			}		
@@ -161,6 +218,7 @@ int NsDownload::downloader()
 				rb = rdd;
 				retrBuf = &rb;
 				rd->buffer = NULL;
+				rd->frame = NULL;
 			}	
 			return download;		
 }
@@ -304,7 +362,6 @@ void NsDownload::writedownload(int pad, int cooked)
 
 void NsDownload::copydownload(unsigned char *buf, int xstart, int xlen, int xbin, int pad, int cooked)
 {
-	unsigned char linebuf[KAF8300_MAX_X*2];
 	bool forwards = true;
 	bool rms = false;
 	int binning = xbin;
@@ -330,6 +387,14 @@ void NsDownload::copydownload(unsigned char *buf, int xstart, int xlen, int xbin
 	  //int rem = nwrite % (KAF8300_MAX_X*2);
 	  nwrite = retrBuf->nread;
 		int nwriteleft = nwrite;
+		// Rows already decoded during the download
+		if (forwards && !rms && retrBuf->frame && retrBuf->fxstart == xstart && retrBuf->fxlen == xlen && retrBuf->fxbin == binning
+		    && retrBuf->flines == nwrite / (KAF8300_MAX_X*2)) {
+			writelines = retrBuf->flines;
+			memcpy (dbufp, retrBuf->frame, (size_t)writelines * ((xlen*2)/binning));
+			DO_INFO( "wrote %d decoded lines\n", writelines);
+			return;
+		}
 		if (forwards) {
 			bufp = retrBuf->buffer;
 			//dbufp =  (dbufp +(KAF8300_ACTIVE_X*2*IMG_Y)) - (KAF8300_ACTIVE_X*2);
@@ -341,38 +406,7 @@ void NsDownload::copydownload(unsigned char *buf, int xstart, int xlen, int xbin
 	  while (nwriteleft >= (KAF8300_MAX_X*2)) {
 	  //swab (bufp + (KAF8300_POSTAMBLE*2),  linebuf, KAF8300_ACTIVE_X*2 );
 	   //memcpy (dbufp, linebuf, KAF8300_ACTIVE_X*2);
-	    if (binning > 1) {
-	    	uint8_t * lbufp = bufp + (KAF8300_POSTAMBLE*2) + xstart*2;
-	    	int len = xlen * 2;
-	    	int linelen = 0;
-	    	while (len > 0) {
-	    		short px[4];
-	    		long long pxsq =0;
-	    		long pxav =0;
-	    		short pxa;
-	    		memcpy(px, lbufp,binning * 2);
-	    		for (int a = 0; a < binning; a++) {
-	    			pxav += px[a];
-	    			pxsq	+= px[a]*px[a];
-	    		}
-	    		pxav /= binning;
-	    		pxsq /= binning;
-	    		if(rms) {
-	    			pxa = round(sqrt((double)	pxsq));
-	    			
-	    		} else {
-	    			pxa = pxav;	
-	    		}
-	    		memcpy (linebuf + linelen, &pxa, 2);
-	    		linelen += 2;
-	    		lbufp += 2*binning;
-	    		len -= 2* binning;
-				}
-				memcpy (dbufp, linebuf, (xlen*2)/binning);
-
-	    } else {
-	  		memcpy (dbufp, bufp + (KAF8300_POSTAMBLE*2) + xstart*2, xlen * 2 ); //KAF8300_ACTIVE_X*2 );
-	  	}
+	    decoderow(bufp, dbufp, xstart, xlen, binning, rms);
 			if (forwards) { 
 				bufp +=  KAF8300_MAX_X*2;
 				dbufp +=(xlen*2)/binning;
@@ -407,6 +441,53 @@ int NsDownload::purgedownload()
 }
 
 
+bool NsDownload::streamprogress(void * user, size_t nread)
+{
+		NsDownload * d = (NsDownload *) user;
+		d->rd->nread = nread;
+		d->decoderows();
+		return !d->interrupted;
+}
+
+void NsDownload::decoderows()
+{
+		int rowsz = KAF8300_MAX_X*2;
+		if (rd->frame == NULL || rd->fxlen == 0) return;
+		int maxlines = rd->bufsiz / rowsz;
+		int outsz = (rd->fxlen*2)/rd->fxbin;
+		while (rd->flines < maxlines && (rd->flines + 1) * rowsz <= rd->nread) {
+			decoderow(rd->buffer + rd->flines * rowsz, rd->frame + rd->flines * outsz, rd->fxstart, rd->fxlen, rd->fxbin, false);
+			rd->flines++;
+		}
+}
+
+int NsDownload::streamdownload()
+{
+		ns_stream_stats_t stats;
+		int want = rd->imgsz < rd->bufsiz ? rd->imgsz : rd->bufsiz;
+
+		int rc2 = cn->streamData(rd->buffer, want, streamprogress, this, &stats);
+		if (rc2 == NS_STREAM_UNSUPPORTED) {
+			DO_INFO("%s\n", "no streaming, polling for download");
+			streaming = false;
+			return 0;
+		}
+		if (rc2 < 0 ) {
+			DO_ERR( "unable to stream: %d\n", rc2);
+			return (-1);
+		}
+		rd->nread = rc2;
+		decoderows();
+		rd->nblks = stats.transfers;
+		if (rc2 > 0) {
+			dlrate = stats.seconds > 0 ? rc2 / stats.seconds : 0;
+			dlstalls = stats.stalls;
+			totstalls += stats.stalls;
+			DO_INFO("streamed %d in %d transfers, %.0f bytes/s, %d stalls\n", rc2, stats.transfers, dlrate, stats.stalls);
+		}
+		return rc2;
+}
+
 int NsDownload::fulldownload() 
 {
 		int rc2;
@@ -420,6 +501,7 @@ int NsDownload::fulldownload()
 			DO_INFO("read %d\n", rc2);
 		  rd->nread += rc2;
 		  rd->nblks += rc2/65536;
+		  decoderows();
 		  DO_INFO("read %d tot %d\n", rc2, rd->nread);
 
 		}	
@@ -439,6 +521,17 @@ void NsDownload::initdownload()
 
 		rd->bufsiz = imgszmax;
 		rd->nblks = 0;	
+
+		rd->flines = 0;
+		rd->fxstart = ctx->imgp->xstart;
+		rd->fxlen = ctx->imgp->xlen;
+		rd->fxbin = ctx->imgp->xbinning;
+		if (rd->fxlen <= 0 || rd->fxstart < 0 || rd->fxstart + rd->fxlen > KAF8300_ACTIVE_X || rd->fxbin < 1 || rd->fxbin > 4) {
+			rd->fxlen = 0;
+			rd->fxbin = 1;
+		} else if (!rd->frame) {
+			rd->frame = (unsigned char *)malloc((imgszmax / (KAF8300_MAX_X*2)) * KAF8300_ACTIVE_X*2);
+		}
 }
 
 
@@ -477,7 +570,11 @@ void NsDownload::trun()
       //  		DO_ERR( "unable to set rts: %d\n", rc2);
     	//}	
     	int down = 0;
-	    if (zero_reads > 1) 
+    	bool streamed = false;
+	    if (streaming) {
+	    	down = streamdownload();
+	    	streamed = down > 0;
+	    } else if (zero_reads > 1) 
 	  		down = fulldownload();
 	  	else
 	  		down = downloader();
@@ -487,7 +584,8 @@ void NsDownload::trun()
 	  		in_download = 0;
 	  		continue;
 	  	}
-	  	if (rd->nread < rd->imgsz) {
+	  	// A stream only returns once the data stopped coming
+	  	if (rd->nread < rd->imgsz && !streamed) {
 	  		if (down == 0 && rd->nread > 0) {
     			zeroes++;
 	  		}
@@ -505,10 +603,11 @@ void NsDownload::trun()
 	    lastread = down;
 	    	   // IDLog("foop\n");
 
-	    if (zero_reads > 1) {
+	    if (zero_reads > 1 || streamed) {
 	    	rb = rdd;
 	    	retrBuf = &rb;
 	    	rd->buffer = NULL;
+	    	rd->frame = NULL;
 	    }
 	    //IDLog("retr %p buf %p \n", retrBuf, rb.buffer);
 	    if(write_it) writedownload(pad, 0);
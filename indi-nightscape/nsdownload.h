@@ -13,7 +13,12 @@ typedef struct ns_readdata {
 	unsigned char * buffer;
 	int nblks;
 	int imgsz;
-
+	// rows decoded while streaming, fxstart/fxlen/fxbin as in copydownload()
+	unsigned char * frame;
+	int flines;
+	int fxstart;
+	int fxlen;
+	int fxbin;
 } ns_readdata_t;
 
 
@@ -24,6 +29,8 @@ struct img_params {
 	time_t expdate;	
 	int ybinning;
 	int xbinning;
+	int xstart;
+	int xlen;
 };
 
 struct download_params {
@@ -50,6 +57,8 @@ class NsDownload {
 
 			 //strcpy(ctx->fbase, "");
 			 rd->buffer = NULL;
+			 rd->frame = NULL;
+			 ctx->imgp->xlen = 0;
 				in_download = 0;
 		 		do_download = 0;
 		 		write_it = 0;
@@ -70,6 +79,8 @@ class NsDownload {
 
 			 //strcpy(ctx->fbase, "");
 			 rd->buffer = NULL;
+			 rd->frame = NULL;
+			 ctx->imgp->xlen = 0;
 		 		cn = chn;
 		 		in_download = 0;
 		 		do_download = 0;
@@ -79,6 +90,7 @@ class NsDownload {
 		 }
 		 void setFrameYBinning(int  binning);
 		 void setFrameXBinning(int  binning);
+		 void setFrameX(int xstart, int xlen);
 
 		 void setSetTemp (float temp);
 		 void setActTemp(float temp);
@@ -106,10 +118,16 @@ class NsDownload {
 		void copydownload(unsigned char *buf, int xstart, int xlen, int xbin, int pad, int cooked);
 		void writedownload(int pad, int cooked);
 		void setZeroReads(int zeroes);
+		double getDownloadRate();
+		int getDownloadStalls();
+		int getTotalStalls();
 	private:
 
 	  void fitsheader(int x, int y, char * fbase, struct img_params * ip);
 		int fulldownload(); 
+		int streamdownload();
+		static bool streamprogress(void * user, size_t nread);
+		void decoderows();
 		bool getDoDownload();
 		struct download_params dp;
 		struct img_params ip;
@@ -136,5 +154,9 @@ class NsDownload {
 		ns_readdata_t * retrBuf;
 		int zero_reads { 1 };
 		int writelines{0};
+		bool streaming { true };
+		double dlrate { 0 };
+		int dlstalls { 0 };
+		int totstalls { 0 };
 };
 #endif
\ No newline at end of file
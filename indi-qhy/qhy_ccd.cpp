@@ -145,6 +145,12 @@ QHYCCD::QHYCCD(const char *name) : FilterInterface(this)
     SetQHYCCDLogLevel(2);
 }
 
+QHYCCD::~QHYCCD()
+{
+    if (m_BackBuffer)
+        IDSharedBlobFree(m_BackBuffer);
+}
+
 const char *QHYCCD::getDefaultName()
 {
     return "QHY CCD";
@@ -207,6 +213,15 @@ bool QHYCCD::initProperties()
     IUFillNumberVector(&HumidityNP, HumidityN, 1, getDeviceName(), "CCD_HUMIDITY", "Humidity", MAIN_CONTROL_TAB,
                        IP_RO, 60, IPS_IDLE);
 
+    // Readout latency
+    IUFillNumber(&ReadoutStatsN[READOUT_LAST], "LAST", "Last (ms)", "%.2f", 0, 1e6, 0, 0);
+    IUFillNumber(&ReadoutStatsN[READOUT_MIN], "MIN", "Min (ms)", "%.2f", 0, 1e6, 0, 0);
+    IUFillNumber(&ReadoutStatsN[READOUT_MEAN], "MEAN", "Mean (ms)", "%.2f", 0, 1e6, 0, 0);
+    IUFillNumber(&ReadoutStatsN[READOUT_MAX], "MAX", "Max (ms)", "%.2f", 0, 1e6, 0, 0);
+    IUFillNumber(&ReadoutStatsN[READOUT_FRAMES], "FRAMES", "Frames", "%.f", 0, 1e9, 0, 0);
+    IUFillNumberVector(&ReadoutStatsNP, ReadoutStatsN, 5, getDeviceName(), "CCD_READOUT_STATS", "Readout", IMAGE_INFO_TAB,
+                       IP_RO, 60, IPS_IDLE);
+
     // Cooler Mode
     IUFillSwitch(&CoolerModeS[COOLER_AUTOMATIC], "COOLER_AUTOMATIC", "Auto", ISS_ON);
     IUFillSwitch(&CoolerModeS[COOLER_MANUAL], "COOLER_MANUAL", "Manual", ISS_OFF);
@@ -459,6 +474,10 @@ bool QHYCCD::updateProperties()
 
             defineProperty(&HumidityNP);
         }
+
+        resetReadoutStats();
+        defineProperty(&ReadoutStatsNP);
+
         double min = 0, max = 0, step = 0;
         if (HasUSBSpeed)
         {
@@ -647,6 +666,8 @@ bool QHYCCD::updateProperties()
         if (HasHumidity)
             deleteProperty(HumidityNP.name);
 
+        deleteProperty(ReadoutStatsNP.name);
+
         if (HasUSBSpeed)
         {
             deleteProperty(SpeedNP.name);
@@ -1163,6 +1184,15 @@ bool QHYCCD::Disconnect()
 
     tState = StateNone;
 
+    // Imaging thread is gone, nothing reads into these any more.
+    if (m_BackBuffer)
+    {
+        IDSharedBlobFree(m_BackBuffer);
+        m_BackBuffer = nullptr;
+        m_BackBufferSize = 0;
+    }
+    std::vector<uint8_t>().swap(m_StreamFrame);
+
     LOG_INFO("Camera is offline.");
 
     return true;
@@ -1445,7 +1475,11 @@ bool QHYCCD::UpdateCCDFrame(int x, int y, int w, int h)
     PrimaryCCD.setFrame(x, y, w, h);
     // Total bytes required for image buffer
     uint32_t nbuf = (PrimaryCCD.getSubW() * PrimaryCCD.getSubH() * PrimaryCCD.getBPP() / 8);
-    PrimaryCCD.setFrameBufferSize(nbuf);
+    {
+        // The imaging thread may be swapping in a new frame buffer.
+        std::unique_lock<std::mutex> guard(ccdBufferLock);
+        PrimaryCCD.setFrameBufferSize(nbuf);
+    }
 
     // Streamer is always updated with BINNED size.
     if (HasStreaming())
@@ -1506,15 +1540,104 @@ double QHYCCD::calcTimeLeft()
     return timeleft;
 }
 
+bool QHYCCD::reserveBackBuffer(size_t size)
+{
+    if (m_BackBuffer && m_BackBufferSize >= size)
+        return true;
+
+    uint8_t *buffer = static_cast<uint8_t *>(IDSharedBlobRealloc(m_BackBuffer, size));
+    if (buffer == nullptr)
+        buffer = static_cast<uint8_t *>(IDSharedBlobAlloc(size));
+    if (buffer == nullptr)
+        return false;
+
+    m_BackBuffer = buffer;
+    m_BackBufferSize = size;
+    return true;
+}
+
+QHYCCD::ReadoutFrame QHYCCD::currentReadoutFrame()
+{
+    ReadoutFrame frame;
+    frame.width  = PrimaryCCD.getSubW() / PrimaryCCD.getBinX();
+    frame.height = PrimaryCCD.getSubH() / PrimaryCCD.getBinY();
+    frame.bpp    = PrimaryCCD.getBPP();
+    frame.size   = PrimaryCCD.getFrameBufferSize();
+    return frame;
+}
+
+bool QHYCCD::publishBackBuffer(const ReadoutFrame &frame)
+{
+    std::unique_lock<std::mutex> guard(ccdBufferLock);
+
+    // Frame, binning or depth changed during the readout, the image does not match the chip any more.
+    if (!(currentReadoutFrame() == frame))
+        return false;
+
+    size_t frontSize = PrimaryCCD.getFrameBufferSize();
+
+    uint8_t *front = PrimaryCCD.getFrameBuffer();
+    PrimaryCCD.setFrameBuffer(m_BackBuffer);
+    m_BackBuffer = front;
+    m_BackBufferSize = frontSize;
+    return true;
+}
+
+void QHYCCD::resetReadoutStats()
+{
+    for (auto &number : ReadoutStatsN)
+        number.value = 0;
+    m_ReadoutTotal = 0;
+    m_ReadoutFrames = 0;
+    ReadoutStatsNP.s = IPS_IDLE;
+}
+
+void QHYCCD::updateReadoutStats(double milliseconds, bool force)
+{
+    m_ReadoutFrames++;
+    m_ReadoutTotal += milliseconds;
+
+    ReadoutStatsN[READOUT_LAST].value = milliseconds;
+    if (m_ReadoutFrames == 1 || milliseconds < ReadoutStatsN[READOUT_MIN].value)
+        ReadoutStatsN[READOUT_MIN].value = milliseconds;
+    if (milliseconds > ReadoutStatsN[READOUT_MAX].value)
+        ReadoutStatsN[READOUT_MAX].value = milliseconds;
+    ReadoutStatsN[READOUT_MEAN].value = m_ReadoutTotal / m_ReadoutFrames;
+    ReadoutStatsN[READOUT_FRAMES].value = m_ReadoutFrames;
+    ReadoutStatsNP.s = IPS_OK;
+
+    // Live frames arrive far too often to send every update to the client.
+    auto now = std::chrono::steady_clock::now();
+    if (force || now - m_ReadoutStatsUpdate >= std::chrono::seconds(1))
+    {
+        m_ReadoutStatsUpdate = now;
+        IDSetNumber(&ReadoutStatsNP, nullptr);
+    }
+}
+
 /* Downloads the image from the CCD. */
 int QHYCCD::grabImage()
 {
-    std::unique_lock<std::mutex> guard(ccdBufferLock);
+    // Read out into the back buffer without ccdBufferLock, the chip frame buffer stays
+    // usable by everyone else until the complete image is swapped in below.
+    ReadoutFrame frame;
+    {
+        std::unique_lock<std::mutex> guard(ccdBufferLock);
+        frame = currentReadoutFrame();
+    }
+
+    if (!reserveBackBuffer(frame.size))
+    {
+        LOGF_ERROR("Failed to allocate %zu bytes for the image.", frame.size);
+        PrimaryCCD.setExposureFailed();
+        return -1;
+    }
+
     if (isSimulation())
     {
-        uint8_t *image = PrimaryCCD.getFrameBuffer();
-        int width      = PrimaryCCD.getSubW() / PrimaryCCD.getBinX() * PrimaryCCD.getBPP() / 8;
-        int height     = PrimaryCCD.getSubH() / PrimaryCCD.getBinY();
+        uint8_t *image = m_BackBuffer;
+        int width      = frame.width * frame.bpp / 8;
+        int height     = frame.height;
 
         for (int i = 0; i < height; i++)
             for (int j = 0; j < width; j++)
@@ -1525,8 +1648,10 @@ int QHYCCD::grabImage()
         uint32_t ret, w, h, bpp, channels;
 
         LOG_DEBUG("GetQHYCCDSingleFrame Blocking read call.");
-        ret = GetQHYCCDSingleFrame(m_CameraHandle, &w, &h, &bpp, &channels, PrimaryCCD.getFrameBuffer());
-        LOG_DEBUG("GetQHYCCDSingleFrame Blocking read call complete.");
+        auto start = std::chrono::steady_clock::now();
+        ret = GetQHYCCDSingleFrame(m_CameraHandle, &w, &h, &bpp, &channels, m_BackBuffer);
+        std::chrono::duration<double, std::milli> readout = std::chrono::steady_clock::now() - start;
+        LOGF_DEBUG("GetQHYCCDSingleFrame Blocking read call complete (%.2f ms).", readout.count());
 
         if (ret != QHYCCD_SUCCESS)
         {
@@ -1534,8 +1659,16 @@ int QHYCCD::grabImage()
             PrimaryCCD.setExposureFailed();
             return -1;
         }
+
+        updateReadoutStats(readout.count(), true);
+    }
+
+    if (!publishBackBuffer(frame))
+    {
+        LOG_ERROR("Frame size changed during readout, image discarded.");
+        PrimaryCCD.setExposureFailed();
+        return -1;
     }
-    guard.unlock();
 
     // Perform software binning if necessary
     //if (useSoftBin)
@@ -1547,7 +1680,7 @@ int QHYCCD::grabImage()
         LOG_DEBUG("Download complete.");
 
     if (HasGPS && GPSControlS[INDI_ENABLED].s == ISS_ON)
-        decodeGPSHeader();
+        decodeGPSHeader(PrimaryCCD.getFrameBuffer());
 
     ExposureComplete(&PrimaryCCD);
 
@@ -2370,6 +2503,7 @@ bool QHYCCD::StartStreaming()
 
     int ret = 0;
     m_ExposureRequest = 1.0 / Streamer->getTargetFPS();
+    resetReadoutStats();
 
     //NEW CODE - Add support for overscan/calibration area
     uint32_t subX = (PrimaryCCD.getSubX() + (IgnoreOverscanArea ? effectiveROI.subX : 0)) / PrimaryCCD.getBinX();
@@ -2495,6 +2629,9 @@ bool QHYCCD::StopStreaming()
     pthread_mutex_unlock(&condMutex);
     StopQHYCCDLive(m_CameraHandle);
 
+    // Updates are throttled while streaming, send the final figures.
+    IDSetNumber(&ReadoutStatsNP, nullptr);
+
     //LOG_INFO("stopped live mode"); //DEBUG
 
     //if (HasUSBSpeed)
@@ -2578,24 +2715,39 @@ void QHYCCD::streamVideo()
     {
         pthread_mutex_unlock(&condMutex);
         uint32_t retries = 0;
-        std::unique_lock<std::mutex> guard(ccdBufferLock);
-        uint8_t *buffer = PrimaryCCD.getFrameBuffer();
+
+        size_t size;
+        {
+            std::unique_lock<std::mutex> guard(ccdBufferLock);
+            size = PrimaryCCD.getFrameBufferSize();
+        }
+
+        // Live frames never touch the chip frame buffer, so a running exposure download or
+        // frame change does not wait on the stream.
+        std::vector<uint8_t> &frame = m_StreamFrame;
+        if (frame.size() < size)
+            frame.resize(size);
+
+        auto start = std::chrono::steady_clock::now();
         while (retries++ < 10)
         {
 
-            ret = GetQHYCCDLiveFrame(m_CameraHandle, &w, &h, &bpp, &channels, buffer);
+            ret = GetQHYCCDLiveFrame(m_CameraHandle, &w, &h, &bpp, &channels, frame.data());
             if (ret == QHYCCD_ERROR)
                 usleep(1000);
             else
                 break;
         }
-        guard.unlock();
         if (ret == QHYCCD_SUCCESS)
         {
-            Streamer->newFrame(buffer, w * h * bpp / 8 * channels);
+            std::chrono::duration<double, std::milli> readout = std::chrono::steady_clock::now() - start;
+
+            Streamer->newFrame(frame.data(), w * h * bpp / 8 * channels);
 
             if (HasGPS && GPSControlS[INDI_ENABLED].s == ISS_ON)
-                decodeGPSHeader();
+                decodeGPSHeader(frame.data());
+
+            updateReadoutStats(readout.count(), false);
 
             //DEBUG
             //if(!frames)
@@ -2817,12 +2969,12 @@ void QHYCCD::setLEDStartPosNP(const INumberVectorProperty &value)
     GPSLEDStartPosNP = value;
 }
 
-void QHYCCD::decodeGPSHeader()
+void QHYCCD::decodeGPSHeader(const uint8_t *frame)
 {
     char ts[64] = {0}, iso8601[64] = {0}, data[64] = {0};
 
     uint8_t gpsarray[64] = {0};
-    memcpy(gpsarray, PrimaryCCD.getFrameBuffer(), 64);
+    memcpy(gpsarray, frame, 64);
 
     // Sequence Number
     GPSHeader.seqNumber = gpsarray[0] << 24 | gpsarray[1] << 16 | gpsarray[2] << 8 | gpsarray[3];
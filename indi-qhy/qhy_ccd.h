@@ -25,8 +25,10 @@
 #include <indiccd.h>
 #include <indifilterinterface.h>
 #include <unistd.h>
+#include <chrono>
 #include <functional>
 #include <pthread.h>
+#include <vector>
 
 #define DEVICE struct usb_device *
 
@@ -34,7 +36,7 @@ class QHYCCD : public INDI::CCD, public INDI::FilterInterface
 {
     public:
         QHYCCD(const char *m_Name);
-        virtual ~QHYCCD() override = default;
+        virtual ~QHYCCD() override;
 
         virtual void ISGetProperties(const char *dev) override;
         virtual bool ISNewNumber(const char *dev, const char *m_Name, double values[], char *names[], int n) override;
@@ -179,6 +181,18 @@ class QHYCCD : public INDI::CCD, public INDI::FilterInterface
         // Humidity Readout
         INumber HumidityN[1];
         INumberVectorProperty HumidityNP;
+
+        // Readout latency of the SDK frame calls
+        INumber ReadoutStatsN[5];
+        INumberVectorProperty ReadoutStatsNP;
+        enum
+        {
+            READOUT_LAST,
+            READOUT_MIN,
+            READOUT_MEAN,
+            READOUT_MAX,
+            READOUT_FRAMES,
+        };
         /////////////////////////////////////////////////////////////////////////////
         /// Properties: Utility Controls
         /////////////////////////////////////////////////////////////////////////////
@@ -392,6 +406,27 @@ class QHYCCD : public INDI::CCD, public INDI::FilterInterface
         void getExposure();
         void exposureSetRequest(ImageState request);
         int grabImage();
+        // Chip frame an exposure is read out with
+        struct ReadoutFrame
+        {
+            uint32_t width {0};
+            uint32_t height {0};
+            uint32_t bpp {0};
+            size_t size {0};
+
+            bool operator==(const ReadoutFrame &other) const
+            {
+                return width == other.width && height == other.height && bpp == other.bpp && size == other.size;
+            }
+        };
+        // Current chip frame, call with ccdBufferLock held
+        ReadoutFrame currentReadoutFrame();
+        // Make sure the back buffer holds at least size bytes
+        bool reserveBackBuffer(size_t size);
+        // Swap the back buffer with the chip frame buffer, false if the frame changed since the readout started
+        bool publishBackBuffer(const ReadoutFrame &frame);
+        void resetReadoutStats();
+        void updateReadoutStats(double milliseconds, bool force);
 
         /////////////////////////////////////////////////////////////////////////////
         /// Cooling
@@ -415,7 +450,7 @@ class QHYCCD : public INDI::CCD, public INDI::FilterInterface
         // Call when max filter count is known
         bool updateFilterProperties();
         // Decode GPS Header
-        void decodeGPSHeader();
+        void decodeGPSHeader(const uint8_t *frame);
         /**
          * @brief JStoJD Convert Julian Second to Julian Date
          * @param JS Julian Second
@@ -489,6 +524,17 @@ class QHYCCD : public INDI::CCD, public INDI::FilterInterface
         pthread_cond_t cv         = PTHREAD_COND_INITIALIZER;
         pthread_mutex_t condMutex = PTHREAD_MUTEX_INITIALIZER;
 
+        // Exposures are read out here and swapped with the chip frame buffer once complete,
+        // so ccdBufferLock is only held for the swap and not for the whole download.
+        uint8_t *m_BackBuffer {nullptr};
+        size_t m_BackBufferSize {0};
+        // Live frames are read here, the streamer copies each one before the next is read.
+        std::vector<uint8_t> m_StreamFrame;
+        // Readout statistics, updated from the imaging thread
+        double m_ReadoutTotal {0};
+        uint32_t m_ReadoutFrames {0};
+        std::chrono::steady_clock::time_point m_ReadoutStatsUpdate;
+
         void logQHYMessages(const std::string &message);
         std::function<void(const std::string &)> m_QHYLogCallback;
 
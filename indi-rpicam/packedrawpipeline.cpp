@@ -0,0 +1,133 @@
+/*
+ Raspberry Pi High Quality Camera CCD Driver for Indi.
+ Copyright (C) 2026 agent (agent@local).
+ All rights reserved.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "packedrawpipeline.h"
+#include "broadcompipeline.h"
+#include "chipwrapper.h"
+
+void PackedRawPipeline::reset()
+{
+    raw_x = 0;
+    raw_y = 0;
+    startRawX = (ccd->getSubX() / pixelsPerGroup) * groupBytes;
+    startRawY = ccd->getSubY();
+    carry_len = 0;
+}
+
+void PackedRawPipeline::store_groups(const uint8_t *src, uint32_t groups, uint16_t *row, uint32_t x, uint32_t maxX)
+{
+    if (x >= maxX)
+        return;
+
+    // Groups that fit in the row completely go straight to the frame buffer.
+    uint32_t full = std::min(groups, (maxX - x) / pixelsPerGroup);
+    unpack(src, row + x, full);
+
+    // The last group of a row may be cut by the subframe width.
+    if (full < groups && x + full * pixelsPerGroup < maxX)
+    {
+        uint16_t pixels[8];
+        unpack(src + full * groupBytes, pixels, 1);
+        x += full * pixelsPerGroup;
+        memcpy(row + x, pixels, (maxX - x) * sizeof(uint16_t));
+    }
+}
+
+uint32_t PackedRawPipeline::unpack_row(const uint8_t *data, uint32_t length, uint16_t *row, uint32_t maxX)
+{
+    // raw_x already counts the carried bytes.
+    uint32_t x = (raw_x - carry_len - startRawX) / groupBytes * pixelsPerGroup;
+    uint32_t consumed = 0;
+
+    if (carry_len > 0)
+    {
+        consumed = std::min(length, groupBytes - carry_len);
+        memcpy(carry + carry_len, data, consumed);
+        carry_len += consumed;
+        if (carry_len < groupBytes)
+            return consumed;
+
+        store_groups(carry, 1, row, x, maxX);
+        x += pixelsPerGroup;
+        carry_len = 0;
+    }
+
+    uint32_t groups = (length - consumed) / groupBytes;
+    store_groups(data + consumed, groups, row, x, maxX);
+    consumed += groups * groupBytes;
+
+    // Buffer ended in the middle of a group, keep what we have got of it.
+    carry_len = length - consumed;
+    memcpy(carry, data + consumed, carry_len);
+
+    return length;
+}
+
+void PackedRawPipeline::data_received(uint8_t *data,  uint32_t length)
+{
+    const uint32_t raw_width = bcm_pipe->header.omx_data.raw_width;
+    const uint32_t maxX = ccd->getSubW();
+    const uint32_t maxY = ccd->getSubH();
+
+    if (raw_width == 0 || maxX == 0)
+        return;
+
+    // Groups covering the subframe width, limited to what the scanline holds.
+    const uint32_t firstRawX = std::min(startRawX, raw_width);
+    const uint32_t rowGroups = std::min((maxX + pixelsPerGroup - 1) / pixelsPerGroup, (raw_width - firstRawX) / groupBytes);
+    const uint32_t endRawX = firstRawX + rowGroups * groupBytes;
+
+    uint16_t *frame_buffer = reinterpret_cast<uint16_t *>(ccd->getFrameBuffer());
+
+    while (length > 0)
+    {
+        // Rest of the frame is below the subframe.
+        if (raw_y >= startRawY + maxY)
+            return;
+
+        uint32_t n;
+        if (raw_y < startRawY || raw_x >= endRawX)
+        {
+            n = std::min(length, raw_width - raw_x);
+        }
+        else if (raw_x < firstRawX)
+        {
+            n = std::min(length, firstRawX - raw_x);
+        }
+        else
+        {
+            uint16_t *row = frame_buffer + static_cast<size_t>(raw_y - startRawY) * maxX;
+            n = unpack_row(data, std::min(length, endRawX - raw_x), row, maxX);
+        }
+
+        data += n;
+        length -= n;
+        raw_x += n;
+
+        if (raw_x >= raw_width)
+        {
+            raw_x = 0;
+            raw_y++;
+        }
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ Raspberry Pi High Quality Camera CCD Driver for Indi.
+ Copyright (C) 2026 agent (agent@local).
+ All rights reserved.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef PACKEDRAWPIPELINE_H
+#define PACKEDRAWPIPELINE_H
+
+#include <cstddef>
+#include "pipeline.h"
+
+struct BroadcomPipeline;
+class ChipWrapper;
+
+/**
+ * @brief The PackedRawPipeline class
+ * Common part of the RAW10 and RAW12 pipelines. Tracks the position in the incoming scanlines
+ * (raw_width bytes each, taken from the Broadcom header), skips everything outside the subframe
+ * and hands whole groups of packed pixels to the unpacker. A group split over two buffers is
+ * kept until the rest of it arrives.
+ *
+ * Subframes start on a group boundary: startRawX = (getSubX() / pixelsPerGroup) * groupBytes
+ */
+class PackedRawPipeline : public Pipeline
+{
+public:
+    typedef void (*Unpacker)(const uint8_t *src, uint16_t *dst, size_t groups);
+
+    PackedRawPipeline(const BroadcomPipeline *bcm_pipe, ChipWrapper *ccd, uint32_t groupBytes, uint32_t pixelsPerGroup,
+                      Unpacker unpack)
+        : Pipeline(), bcm_pipe(bcm_pipe), ccd(ccd), groupBytes(groupBytes), pixelsPerGroup(pixelsPerGroup), unpack(unpack) {}
+
+    virtual void data_received(uint8_t *data,  uint32_t length) override;
+    virtual void reset() override;
+
+private:
+    uint32_t unpack_row(const uint8_t *data, uint32_t length, uint16_t *row, uint32_t maxX);
+    void store_groups(const uint8_t *src, uint32_t groups, uint16_t *row, uint32_t x, uint32_t maxX);
+
+    const BroadcomPipeline *bcm_pipe;
+    ChipWrapper *ccd;
+    const uint32_t groupBytes;
+    const uint32_t pixelsPerGroup;
+    const Unpacker unpack;
+
+    uint32_t raw_x {0}; //! Position in the raw-data comming in.
+    uint32_t raw_y {0}; //! Position in the raw-data comming in.
+    uint32_t startRawX {0};
+    uint32_t startRawY {0};
+
+    uint8_t carry[8] {}; //! Start of a group split between two buffers.
+    uint32_t carry_len {0};
+};
+
+#endif // PACKEDRAWPIPELINE_H
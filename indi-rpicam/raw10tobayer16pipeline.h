@@ -21,11 +21,8 @@
 #ifndef RAW10TOBAYER16PIPELINE_H
 #define RAW10TOBAYER16PIPELINE_H
 
-#include <cstddef>
-#include "pipeline.h"
-
-struct BroadcomPipeline;
-class ChipWrapper;
+#include "packedrawpipeline.h"
+#include "rawunpack.h"
 
 /**
  * @brief The Raw10ToBayer16Pipeline class
@@ -33,30 +30,11 @@ class ChipWrapper;
  * Format of first line is: | B | G | B | G |  {lower 2 bits for the earlier 4 bytes} |
  * Second line is G R ...
  */
-class Raw10ToBayer16Pipeline : public Pipeline
+class Raw10ToBayer16Pipeline : public PackedRawPipeline
 {
 public:
-    Raw10ToBayer16Pipeline(const BroadcomPipeline *bcm_pipe, ChipWrapper *ccd) : Pipeline(), bcm_pipe(bcm_pipe), ccd(ccd) {}
-
-    virtual void data_received(uint8_t *data,  uint32_t length) override;
-    virtual void reset() override;
-
-private:
-    void next_line(uint32_t maxX);
-    const BroadcomPipeline *bcm_pipe;
-    ChipWrapper *ccd;
-    uint32_t x {0};
-    uint32_t y {0};
-    uint32_t raw_x {0};  // Position in the raw-data comming in.
-    uint32_t raw_y {0};  //! Position in the raw-data comming in.
-    uint32_t startRawX {0};
-    uint32_t startRawY {0};
-    uint8_t state = 0;
-    uint16_t* frame_buffer;
-    uint32_t raw_width{0};
-    uint32_t xRes, yRes = 0;
-    uint16_t* cur_row {0};
-    uint32_t bytes_consumed = 0;
+    Raw10ToBayer16Pipeline(const BroadcomPipeline *bcm_pipe, ChipWrapper *ccd)
+        : PackedRawPipeline(bcm_pipe, ccd, 5, 4, unpack_raw10) {}
 };
 
 #endif // RAW10TOBAYER16PIPELINE_H
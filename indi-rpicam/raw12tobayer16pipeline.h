@@ -21,11 +21,8 @@
 #ifndef RAW12TOBAYER16PIPELINE_H
 #define RAW12TOBAYER16PIPELINE_H
 
-#include <cstddef>
-#include "pipeline.h"
-
-struct BroadcomPipeline;
-class ChipWrapper;
+#include "packedrawpipeline.h"
+#include "rawunpack.h"
 
 /**
  * @brief The Raw12ToBayer16Pipeline class
@@ -34,23 +31,11 @@ class ChipWrapper;
  *                                   b1                                      b2                               b3
  * Odd lines are swapped R->G, G-B
  */
-class Raw12ToBayer16Pipeline : public Pipeline
+class Raw12ToBayer16Pipeline : public PackedRawPipeline
 {
 public:
-    Raw12ToBayer16Pipeline(const BroadcomPipeline *bcm_pipe, ChipWrapper *ccd) : Pipeline(), bcm_pipe(bcm_pipe), ccd(ccd) {}
-
-    virtual void data_received(uint8_t *data,  uint32_t length) override;
-    virtual void reset() override;
-
-private:
-    const BroadcomPipeline *bcm_pipe;
-    ChipWrapper *ccd;
-    int x {0};
-    int y {0};
-    int raw_x {0}; //! Position in the raw-data comming in.
-    int raw_y {0}; //! Position in the raw-data comming in.
-    int startRawX {0};
-    uint8_t state = 0; //! Which byte in the RAW12 format (see above).
+    Raw12ToBayer16Pipeline(const BroadcomPipeline *bcm_pipe, ChipWrapper *ccd)
+        : PackedRawPipeline(bcm_pipe, ccd, 3, 2, unpack_raw12) {}
 };
 
 #endif // RAW12TOBAYER16PIPELINE_H
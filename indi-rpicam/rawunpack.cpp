@@ -0,0 +1,113 @@
+/*
+ Raspberry Pi High Quality Camera CCD Driver for Indi.
+ Copyright (C) 2026 agent (agent@local).
+ All rights reserved.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cstring>
+
+#include "rawunpack.h"
+
+#if defined(__ARM_NEON) || defined(__NEON__)
+#include <arm_neon.h>
+#define RAWUNPACK_NEON
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define RAWUNPACK_WORDS
+#endif
+
+void unpack_raw12_scalar(const uint8_t *src, uint16_t *dst, size_t groups)
+{
+    for (; groups; groups--, src += 3, dst += 2)
+    {
+        dst[0] = static_cast<uint16_t>((src[0] << 8) | ((src[2] & 0x0F) << 4));
+        dst[1] = static_cast<uint16_t>((src[1] << 8) | ((src[2] & 0xF0) << 0));
+    }
+}
+
+void unpack_raw10_scalar(const uint8_t *src, uint16_t *dst, size_t groups)
+{
+    for (; groups; groups--, src += 5, dst += 4)
+    {
+        dst[0] = static_cast<uint16_t>((src[0] << 8) | (((src[4] >> 0) & 0x03) << 6));
+        dst[1] = static_cast<uint16_t>((src[1] << 8) | (((src[4] >> 2) & 0x03) << 6));
+        dst[2] = static_cast<uint16_t>((src[2] << 8) | (((src[4] >> 4) & 0x03) << 6));
+        dst[3] = static_cast<uint16_t>((src[3] << 8) | (((src[4] >> 6) & 0x03) << 6));
+    }
+}
+
+void unpack_raw12(const uint8_t *src, uint16_t *dst, size_t groups)
+{
+#ifdef RAWUNPACK_NEON
+    // 16 groups per round: vld3 splits the bytes into P0h, P1h and the shared low nibbles,
+    // zipping low and high bytes gives the little endian 16 bit pixels.
+    const uint8x16_t highNibble = vdupq_n_u8(0xF0);
+    for (; groups >= 16; groups -= 16, src += 48, dst += 32)
+    {
+        uint8x16x3_t in = vld3q_u8(src);
+        uint8x16x2_t p0 = vzipq_u8(vshlq_n_u8(in.val[2], 4), in.val[0]);
+        uint8x16x2_t p1 = vzipq_u8(vandq_u8(in.val[2], highNibble), in.val[1]);
+
+        uint16x8x2_t out;
+        out.val[0] = vreinterpretq_u16_u8(p0.val[0]);
+        out.val[1] = vreinterpretq_u16_u8(p1.val[0]);
+        vst2q_u16(dst, out);
+        out.val[0] = vreinterpretq_u16_u8(p0.val[1]);
+        out.val[1] = vreinterpretq_u16_u8(p1.val[1]);
+        vst2q_u16(dst + 16, out);
+    }
+#endif
+
+#ifdef RAWUNPACK_WORDS
+    // Two groups per 64 bit word, the third group keeps the 8 byte load inside src.
+    for (; groups >= 3; groups -= 2, src += 6, dst += 4)
+    {
+        uint64_t w;
+        memcpy(&w, src, sizeof(w));
+
+        uint64_t out = ((w <<  8) & 0xFF00) | ((w >> 12) & 0xF0);
+        out |= (((w >>  0) & 0xFF00) | ((w >> 16) & 0xF0)) << 16;
+        out |= (((w >> 16) & 0xFF00) | ((w >> 36) & 0xF0)) << 32;
+        out |= (((w >> 24) & 0xFF00) | ((w >> 40) & 0xF0)) << 48;
+        memcpy(dst, &out, sizeof(out));
+    }
+#endif
+
+    unpack_raw12_scalar(src, dst, groups);
+}
+
+void unpack_raw10(const uint8_t *src, uint16_t *dst, size_t groups)
+{
+    // There is no 5 element structure load, so RAW10 stays word at a time on NEON too.
+#ifdef RAWUNPACK_WORDS
+    // One group per 64 bit word, the next group keeps the 8 byte load inside src.
+    for (; groups >= 2; groups--, src += 5, dst += 4)
+    {
+        uint64_t w;
+        memcpy(&w, src, sizeof(w));
+
+        uint64_t out = ((w <<  8) & 0xFF00) | ((w >> 26) & 0xC0);
+        out |= (((w >>  0) & 0xFF00) | ((w >> 28) & 0xC0)) << 16;
+        out |= (((w >>  8) & 0xFF00) | ((w >> 30) & 0xC0)) << 32;
+        out |= (((w >> 16) & 0xFF00) | ((w >> 32) & 0xC0)) << 48;
+        memcpy(dst, &out, sizeof(out));
+    }
+#endif
+
+    unpack_raw10_scalar(src, dst, groups);
+}
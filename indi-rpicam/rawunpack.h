@@ -0,0 +1,45 @@
+/*
+ Raspberry Pi High Quality Camera CCD Driver for Indi.
+ Copyright (C) 2026 agent (agent@local).
+ All rights reserved.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef RAWUNPACK_H
+#define RAWUNPACK_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Block unpackers for the Broadcom packed raw formats.
+ * Both write 16 bit pixels with the significant bits moved up to bit 15.
+ *
+ * RAW12: groups of 3 bytes, 2 pixels: [ P0h ] [ P1h ] [ P1l | P0l ]
+ * RAW10: groups of 5 bytes, 4 pixels: [ P0h ] [ P1h ] [ P2h ] [ P3h ] [ P3l | P2l | P1l | P0l ]
+ *
+ * The unpackers never read past groups * group size bytes of src.
+ */
+void unpack_raw12(const uint8_t *src, uint16_t *dst, size_t groups);
+void unpack_raw10(const uint8_t *src, uint16_t *dst, size_t groups);
+
+/**
+ * One group at a time, used for the tail of a row and as reference in the unit tests.
+ */
+void unpack_raw12_scalar(const uint8_t *src, uint16_t *dst, size_t groups);
+void unpack_raw10_scalar(const uint8_t *src, uint16_t *dst, size_t groups);
+
+#endif // RAWUNPACK_H
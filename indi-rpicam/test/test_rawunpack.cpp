@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <broadcompipeline.h>
+#include <raw10tobayer16pipeline.h>
+#include <raw12tobayer16pipeline.h>
+#include <rawunpack.h>
+#include <chipwrapper.h>
+
+// {{{ FrameCCD: ChipWrapper with a subframe sized frame buffer, no camera needed.
+class FrameCCD : public ChipWrapper
+{
+public:
+    FrameCCD(int width, int height, int x, int y, int w, int h)
+        : width(width), height(height), subx(x), suby(y), subw(w), subh(h), frameBuffer(w * h * 2, 0)
+    {
+    }
+
+    virtual int getFrameBufferSize() override { return frameBuffer.size(); }
+    virtual uint8_t* getFrameBuffer() override { return frameBuffer.data(); }
+
+    virtual int getSubX() override { return subx; }
+    virtual int getSubY() override { return suby; }
+    virtual int getSubW() override { return subw; }
+    virtual int getSubH() override { return subh; }
+    virtual int getXRes() override { return width; }
+    virtual int getYRes() override { return height; }
+
+    const uint16_t *pixels() const { return reinterpret_cast<const uint16_t *>(frameBuffer.data()); }
+
+private:
+    int width, height;
+    int subx, suby, subw, subh;
+    std::vector<uint8_t> frameBuffer;
+};
+// }}}
+
+// {{{ Helpers
+struct Format
+{
+    int groupBytes;
+    int pixelsPerGroup;
+};
+
+static const Format RAW12 = { 3, 2 };
+static const Format RAW10 = { 5, 4 };
+
+static std::vector<uint8_t> random_bytes(size_t size, unsigned seed = 1)
+{
+    std::mt19937 gen(seed);
+    std::vector<uint8_t> data(size);
+    for (auto &b : data)
+        b = gen();
+    return data;
+}
+
+// Decodes one pixel straight from its group, independent of the unpackers.
+static uint16_t reference_pixel(const Format &f, const uint8_t *group, int i)
+{
+    if (f.groupBytes == 3)
+        return i == 0 ? (group[0] << 8) | ((group[2] & 0x0F) << 4) : (group[1] << 8) | (group[2] & 0xF0);
+
+    return (group[i] << 8) | (((group[4] >> (2 * i)) & 0x03) << 6);
+}
+
+static std::vector<uint16_t> reference_frame(const Format &f, const std::vector<uint8_t> &raw, int raw_width,
+                                             int subx, int suby, int subw, int subh)
+{
+    std::vector<uint16_t> out(subw * subh, 0);
+    int rows = raw.size() / raw_width;
+    int firstColumn = (subx / f.pixelsPerGroup) * f.pixelsPerGroup;
+
+    for (int y = 0; y < subh && suby + y < rows; y++)
+    {
+        const uint8_t *line = raw.data() + static_cast<size_t>(suby + y) * raw_width;
+        for (int x = 0; x < subw; x++)
+        {
+            int column = firstColumn + x;
+            int offset = (column / f.pixelsPerGroup) * f.groupBytes;
+            if (offset + f.groupBytes > raw_width)
+                break;
+            out[y * subw + x] = reference_pixel(f, line + offset, column % f.pixelsPerGroup);
+        }
+    }
+    return out;
+}
+
+// Feeds raw into the pipeline in buffers of random size between 1 and maxChunk bytes.
+static void feed(Pipeline &pipe, std::vector<uint8_t> &raw, uint32_t maxChunk, unsigned seed = 1)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<uint32_t> chunk(1, maxChunk);
+
+    pipe.reset();
+    for (size_t pos = 0; pos < raw.size();)
+    {
+        uint32_t n = std::min<size_t>(chunk(gen), raw.size() - pos);
+        pipe.data_received(raw.data() + pos, n);
+        pos += n;
+    }
+}
+
+template <class RawPipeline>
+static void check_frame(const Format &f, int raw_width, int width, int height, int subx, int suby, int subw, int subh,
+                        uint32_t maxChunk)
+{
+    BroadcomPipeline bcm;
+    bcm.header.omx_data.raw_width = raw_width;
+
+    FrameCCD ccd(width, height, subx, suby, subw, subh);
+    RawPipeline pipe(&bcm, &ccd);
+
+    std::vector<uint8_t> raw = random_bytes(static_cast<size_t>(raw_width) * height);
+    feed(pipe, raw, maxChunk);
+
+    std::vector<uint16_t> expected = reference_frame(f, raw, raw_width, subx, suby, subw, subh);
+    ASSERT_EQ(std::vector<uint16_t>(ccd.pixels(), ccd.pixels() + subw * subh), expected);
+}
+// }}}
+
+// {{{ Unpackers against the one group at a time versions, all lengths to cover every SIMD/word tail.
+TEST(RawUnpack, raw12_matches_scalar)
+{
+    std::vector<uint8_t> src = random_bytes(3 * 100);
+    for (size_t groups = 0; groups <= 100; groups++)
+    {
+        std::vector<uint16_t> expected(2 * groups + 1, 0xDEAD), actual(2 * groups + 1, 0xDEAD);
+        unpack_raw12_scalar(src.data(), expected.data(), groups);
+        unpack_raw12(src.data(), actual.data(), groups);
+        ASSERT_EQ(actual, expected) << groups << " groups";
+    }
+}
+
+TEST(RawUnpack, raw10_matches_scalar)
+{
+    std::vector<uint8_t> src = random_bytes(5 * 100);
+    for (size_t groups = 0; groups <= 100; groups++)
+    {
+        std::vector<uint16_t> expected(4 * groups + 1, 0xDEAD), actual(4 * groups + 1, 0xDEAD);
+        unpack_raw10_scalar(src.data(), expected.data(), groups);
+        unpack_raw10(src.data(), actual.data(), groups);
+        ASSERT_EQ(actual, expected) << groups << " groups";
+    }
+}
+
+TEST(RawUnpack, scalar_bit_layout)
+{
+    const uint8_t raw12[3] = { 0xAB, 0xCD, 0xEF };
+    uint16_t out12[2];
+    unpack_raw12_scalar(raw12, out12, 1);
+    EXPECT_EQ(out12[0], 0xABF0);
+    EXPECT_EQ(out12[1], 0xCDE0);
+
+    const uint8_t raw10[5] = { 0x12, 0x34, 0x56, 0x78, 0xE4 }; // low bits 00, 01, 10, 11
+    uint16_t out10[4];
+    unpack_raw10_scalar(raw10, out10, 1);
+    EXPECT_EQ(out10[0], 0x1200);
+    EXPECT_EQ(out10[1], 0x3440);
+    EXPECT_EQ(out10[2], 0x5680);
+    EXPECT_EQ(out10[3], 0x78C0);
+}
+// }}}
+
+// {{{ Pipelines: sensor geometries, subframes and groups split between buffers.
+TEST(Raw12Pipeline, imx477_full_frame)
+{
+    check_frame<Raw12ToBayer16Pipeline>(RAW12, 6112, 4056, 3040, 0, 0, 4056, 3040, 81920);
+}
+
+TEST(Raw12Pipeline, imx477_subframe)
+{
+    check_frame<Raw12ToBayer16Pipeline>(RAW12, 6112, 4056, 3040, 100, 100, 640, 480, 81920);
+}
+
+TEST(Raw12Pipeline, odd_geometry_small_buffers)
+{
+    // Scanline not a multiple of the group size, odd subframe origin and width.
+    check_frame<Raw12ToBayer16Pipeline>(RAW12, 100, 64, 40, 5, 3, 37, 20, 7);
+    check_frame<Raw12ToBayer16Pipeline>(RAW12, 100, 64, 40, 0, 0, 64, 40, 1);
+}
+
+TEST(Raw12Pipeline, subframe_past_scanline)
+{
+    // Pixels beyond the end of the scanline are left untouched.
+    check_frame<Raw12ToBayer16Pipeline>(RAW12, 100, 64, 40, 50, 30, 40, 20, 13);
+}
+
+TEST(Raw10Pipeline, imx219_full_frame)
+{
+    check_frame<Raw10ToBayer16Pipeline>(RAW10, 4128, 3280, 2464, 0, 0, 3280, 2464, 81920);
+}
+
+TEST(Raw10Pipeline, ov5647_subframe)
+{
+    check_frame<Raw10ToBayer16Pipeline>(RAW10, 3264, 2592, 1944, 100, 100, 640, 480, 81920);
+}
+
+TEST(Raw10Pipeline, odd_geometry_small_buffers)
+{
+    check_frame<Raw10ToBayer16Pipeline>(RAW10, 123, 96, 40, 7, 3, 41, 20, 9);
+    check_frame<Raw10ToBayer16Pipeline>(RAW10, 123, 96, 40, 0, 0, 96, 40, 1);
+}
+
+TEST(Raw10Pipeline, subframe_past_scanline)
+{
+    check_frame<Raw10ToBayer16Pipeline>(RAW10, 123, 96, 40, 80, 30, 30, 20, 11);
+}
+// }}}
+
+// {{{ Benchmark: full frames through the pipelines against per pixel decoding.
+template <class RawPipeline>
+static void benchmark(const char *name, const Format &f, int raw_width, int width, int height)
+{
+    const int rounds = 5;
+    const uint32_t bufferSize = 81920;
+
+    BroadcomPipeline bcm;
+    bcm.header.omx_data.raw_width = raw_width;
+    FrameCCD ccd(width, height, 0, 0, width, height);
+    RawPipeline pipe(&bcm, &ccd);
+
+    std::vector<uint8_t> raw = random_bytes(static_cast<size_t>(raw_width) * height);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        pipe.reset();
+        for (size_t pos = 0; pos < raw.size(); pos += bufferSize)
+            pipe.data_received(raw.data() + pos, std::min<size_t>(bufferSize, raw.size() - pos));
+    }
+    std::chrono::duration<double, std::milli> pipeTime = (std::chrono::steady_clock::now() - start) / rounds;
+
+    start = std::chrono::steady_clock::now();
+    std::vector<uint16_t> expected;
+    for (int i = 0; i < rounds; i++)
+        expected = reference_frame(f, raw, raw_width, 0, 0, width, height);
+    std::chrono::duration<double, std::milli> referenceTime = (std::chrono::steady_clock::now() - start) / rounds;
+
+    printf("%s %dx%d: pipeline %.1f ms (%.0f MB/s), per pixel %.1f ms, %.1fx\n",
+           name, width, height, pipeTime.count(), raw.size() / pipeTime.count() / 1e3, referenceTime.count(),
+           referenceTime.count() / pipeTime.count());
+
+    EXPECT_EQ(std::vector<uint16_t>(ccd.pixels(), ccd.pixels() + width * height), expected);
+}
+
+TEST(RawUnpackBenchmark, imx477_raw12)
+{
+    benchmark<Raw12ToBayer16Pipeline>("imx477 RAW12", RAW12, 6112, 4056, 3040);
+}
+
+TEST(RawUnpackBenchmark, imx219_raw10)
+{
+    benchmark<Raw10ToBayer16Pipeline>("imx219 RAW10", RAW10, 4128, 3280, 2464);
+}
+// }}}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -39,6 +39,8 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <deque>
 
@@ -52,6 +54,7 @@
 #define MAX_DEVICES         20   /* Max device cameraCount */
 #define MAX_THREAD_RETRIES  3
 #define MAX_THREAD_WAIT     300000
+#define READOUT_BATCH_LINES 16   /* Lines read per sbigLock in overlapped readout */
 
 static class Loader
 {
@@ -306,6 +309,7 @@ SBIGCCD::SBIGCCD() : FilterInterface(this)
 
 SBIGCCD::~SBIGCCD()
 {
+    stopReadoutThread();
     CloseDevice();
     CloseDriver();
 }
@@ -383,6 +387,25 @@ bool SBIGCCD::initProperties()
     IUFillSwitchVector(&IgnoreErrorsSP, IgnoreErrorsS, 1, getDeviceName(), "CCD_IGNORE_ERRORS", "Ignore", OPTIONS_TAB, IP_RW,
                        ISR_NOFMANY, 0, IPS_OK);
 
+    // Readout
+    IUFillSwitch(&ReadoutModeS[READOUT_BLOCKING], "BLOCKING", "Blocking", ISS_ON);
+    IUFillSwitch(&ReadoutModeS[READOUT_OVERLAPPED], "OVERLAPPED", "Overlapped", ISS_OFF);
+    IUFillSwitchVector(&ReadoutModeSP, ReadoutModeS, 2, getDeviceName(), "CCD_READOUT_MODE", "Readout", OPTIONS_TAB, IP_RW,
+                       ISR_1OFMANY, 0, IPS_IDLE);
+    IUFillNumber(&ReadoutBatchN[0], "LINES", "Lines per batch", "%.f", 1, 512, 1, READOUT_BATCH_LINES);
+    IUFillNumberVector(&ReadoutBatchNP, ReadoutBatchN, 1, getDeviceName(), "CCD_READOUT_BATCH", "Readout", OPTIONS_TAB,
+                       IP_RW, 0, IPS_IDLE);
+
+    IUFillNumber(&ReadoutStatsN[STATS_ROWS], "ROWS", "Rows", "%.f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_MIN], "MIN", "Min", "%.f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_MAX], "MAX", "Max", "%.f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_MEAN], "MEAN", "Mean", "%.1f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_MEDIAN], "MEDIAN", "Median", "%.f", 0, 65535, 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_CHECKSUM], "CHECKSUM", "Checksum", "%.f", 0, 4294967295., 0, 0);
+    IUFillNumber(&ReadoutStatsN[STATS_DURATION], "DURATION", "Duration (ms)", "%.f", 0, 1e6, 0, 0);
+    IUFillNumberVector(&ReadoutStatsNP, ReadoutStatsN, 7, getDeviceName(), "CCD_READOUT_STATS", "Last readout",
+                       IMAGE_INFO_TAB, IP_RO, 0, IPS_IDLE);
+
     // CFW PRODUCT
     IUFillText(&FilterProdcutT[0], "NAME", "Name", "");
     IUFillText(&FilterProdcutT[1], "ID", "ID", "");
@@ -530,6 +553,9 @@ bool SBIGCCD::updateProperties()
             defineProperty(&CoolerNP);
         }
         defineProperty(&IgnoreErrorsSP);
+        defineProperty(&ReadoutModeSP);
+        defineProperty(&ReadoutBatchNP);
+        defineProperty(&ReadoutStatsNP);
         if (m_hasFilterWheel)
         {
             defineProperty(&FilterConnectionSP);
@@ -572,6 +598,9 @@ bool SBIGCCD::updateProperties()
             deleteProperty(CoolerNP.name);
         }
         deleteProperty(IgnoreErrorsSP.name);
+        deleteProperty(ReadoutModeSP.name);
+        deleteProperty(ReadoutBatchNP.name);
+        deleteProperty(ReadoutStatsNP.name);
 
         if (m_hasAO)
         {
@@ -723,6 +752,14 @@ bool SBIGCCD::ISNewSwitch(const char *dev, const char *name, ISState *states, ch
             saveConfig(true);
             return true;
         }
+        // Readout mode
+        else if (!strcmp(name, ReadoutModeSP.name))
+        {
+            IUUpdateSwitch(&ReadoutModeSP, states, names, n);
+            ReadoutModeSP.s = IPS_OK;
+            IDSetSwitch(&ReadoutModeSP, nullptr);
+            return true;
+        }
         // Filter connection
         else if (!strcmp(name, FilterConnectionSP.name))
         {
@@ -761,6 +798,14 @@ bool SBIGCCD::ISNewNumber(const char *dev, const char *name, double values[], ch
             INDI::FilterInterface::processNumber(dev, name, values, names, n);
             return true;
         }
+        // Readout batch
+        else if (!strcmp(name, ReadoutBatchNP.name))
+        {
+            IUUpdateNumber(&ReadoutBatchNP, values, names, n);
+            ReadoutBatchNP.s = IPS_OK;
+            IDSetNumber(&ReadoutBatchNP, nullptr);
+            return true;
+        }
         // NS Adaptive Optics
         else if (!strcmp(name, AONSNP.name))
         {
@@ -902,6 +947,7 @@ bool SBIGCCD::Disconnect()
 {
     if (!isConnected())
         return true;
+    stopReadoutThread();
     m_useExternalTrackingCCD = false;
     m_hasGuideHead           = false;
 #ifdef ASYNC_READOUT
@@ -1137,6 +1183,12 @@ int SBIGCCD::StartExposure(INDI::CCDChip *targetChip, double duration)
 
 bool SBIGCCD::StartExposure(float duration)
 {
+    if (m_PrimaryReadout.isRunning())
+    {
+        LOG_ERROR("Primary camera readout still in progress");
+        return false;
+    }
+
     ExposureRequest = duration;
 
     if (duration >= 3)
@@ -1194,6 +1246,13 @@ int SBIGCCD::AbortExposure(INDI::CCDChip *targetChip)
 
 bool SBIGCCD::AbortExposure()
 {
+    if (m_PrimaryReadout.isRunning())
+    {
+        stopReadoutThread();
+        LOG_DEBUG("Primary camera readout aborted");
+        return true;
+    }
+
     int res = CE_NO_ERROR;
     LOG_DEBUG("Aborting primary camera exposure...");
     for (int i = 0; i < MAX_THREAD_RETRIES; i++)
@@ -1290,6 +1349,11 @@ bool SBIGCCD::updateFrameProperties(INDI::CCDChip *targetChip)
 
 bool SBIGCCD::UpdateCCDFrame(int x, int y, int w, int h)
 {
+    if (m_PrimaryReadout.isRunning())
+    {
+        LOG_ERROR("Cannot change the frame while the image is downloading.");
+        return false;
+    }
     LOGF_DEBUG("The final main camera image area is (%ld, %ld), (%ld, %ld)", x, y, w, h);
     PrimaryCCD.setFrame(x, y, w, h);
     int nbuf = (w * h * PrimaryCCD.getBPP() / 8) + 512;
@@ -1310,6 +1374,11 @@ bool SBIGCCD::UpdateGuiderFrame(int x, int y, int w, int h)
 
 bool SBIGCCD::UpdateCCDBin(int binx, int biny)
 {
+    if (m_PrimaryReadout.isRunning())
+    {
+        LOG_ERROR("Cannot change the binning while the image is downloading.");
+        return false;
+    }
     // only basic sanity checks; if the camera really supports the requested binning
     // mode is checked in getBinningMode
     if (binx > 255 || biny > 255)
@@ -1443,18 +1512,37 @@ void *SBIGCCD::grabCCD()
 }
 #endif
 
+SBIGCCD::ReadoutFrame SBIGCCD::getReadoutFrame(INDI::CCDChip *targetChip)
+{
+    ReadoutFrame frame;
+    frame.left   = targetChip->getSubX() / targetChip->getBinX();
+    frame.top    = targetChip->getSubY() / targetChip->getBinX();
+    frame.width  = targetChip->getSubW() / targetChip->getBinX();
+    frame.height = targetChip->getSubH() / targetChip->getBinY();
+    frame.buffer = targetChip->getFrameBuffer();
+    return frame;
+}
+
 bool SBIGCCD::grabImage(INDI::CCDChip *targetChip)
 {
-    uint16_t left   = targetChip->getSubX() / targetChip->getBinX();
-    uint16_t top    = targetChip->getSubY() / targetChip->getBinX();
-    uint16_t width  = targetChip->getSubW() / targetChip->getBinX();
-    uint16_t height = targetChip->getSubH() / targetChip->getBinY();
+    if (readImage(targetChip, getReadoutFrame(targetChip)) == false)
+        return false;
+
+    std::unique_lock<std::mutex> guard(completeLock);
+    ExposureComplete(targetChip);
+    return true;
+}
+
+bool SBIGCCD::readImage(INDI::CCDChip *targetChip, const ReadoutFrame &frame)
+{
+    uint16_t width  = frame.width;
+    uint16_t height = frame.height;
 
     LOGF_DEBUG("%s readout in progress...", targetChip == &PrimaryCCD ? "Primary camera" : "Guide head");
 
     if (isSimulation())
     {
-        uint8_t *image = targetChip->getFrameBuffer();
+        uint8_t *image = frame.buffer;
         for (int i = 0; i < height * 2; i++)
         {
             for (int j = 0; j < width; j++)
@@ -1465,12 +1553,12 @@ bool SBIGCCD::grabImage(INDI::CCDChip *targetChip)
     }
     else
     {
-        uint16_t *buffer = reinterpret_cast<uint16_t *>(targetChip->getFrameBuffer());
+        uint16_t *buffer = reinterpret_cast<uint16_t *>(frame.buffer);
         int res                = 0;
         for (int i = 0; i < MAX_THREAD_RETRIES; i++)
         {
-            res = readoutCCD(left, top, width, height, buffer, targetChip);
-            if (res == CE_NO_ERROR)
+            res = readoutCCD(frame.left, frame.top, width, height, buffer, targetChip);
+            if (res == CE_NO_ERROR || (targetChip == &PrimaryCCD && m_PrimaryReadout.isAborted()))
                 break;
             LOGF_DEBUG("Readout error, retrying...", res);
             usleep(MAX_THREAD_WAIT);
@@ -1483,10 +1571,37 @@ bool SBIGCCD::grabImage(INDI::CCDChip *targetChip)
         }
     }
     LOGF_DEBUG("%s readout complete", targetChip == &PrimaryCCD ? "Primary camera" : "Guide head");
-    ExposureComplete(targetChip);
     return true;
 }
 
+void SBIGCCD::startReadoutThread()
+{
+    // Frame and binning changes are refused while the download runs, the area is taken here once
+    ReadoutFrame frame = getReadoutFrame(&PrimaryCCD);
+    m_PrimaryReadout.start([this, frame](PixelShuffle::RowReadout &)
+    {
+        return readImage(&PrimaryCCD, frame);
+    },
+    [this](bool ok)
+    {
+        // Completed once the readout is no longer running so the next exposure can start from the callbacks
+        if (!ok)
+        {
+            if (!m_PrimaryReadout.isAborted())
+                PrimaryCCD.setExposureFailed();
+            return;
+        }
+
+        std::unique_lock<std::mutex> guard(completeLock);
+        ExposureComplete(&PrimaryCCD);
+    });
+}
+
+void SBIGCCD::stopReadoutThread()
+{
+    m_PrimaryReadout.stop();
+}
+
 bool SBIGCCD::saveConfigItems(FILE *fp)
 {
     INDI::CCD::saveConfigItems(fp);
@@ -1494,6 +1609,8 @@ bool SBIGCCD::saveConfigItems(FILE *fp)
     IUSaveConfigSwitch(fp, &PortSP);
     IUSaveConfigText(fp, &IpTP);
     IUSaveConfigSwitch(fp, &IgnoreErrorsSP);
+    IUSaveConfigSwitch(fp, &ReadoutModeSP);
+    IUSaveConfigNumber(fp, &ReadoutBatchNP);
 
     if (FilterNameT)
         INDI::FilterInterface::saveConfigItems(fp);
@@ -1521,7 +1638,9 @@ void SBIGCCD::TimerHit()
             LOG_DEBUG("Primay camera exposure done, downloading image...");
             targetChip->setExposureLeft(0);
             InExposure = false;
-            if (grabImage(targetChip) == false)
+            if (ReadoutModeS[READOUT_OVERLAPPED].s == ISS_ON && !isSimulation())
+                startReadoutThread();
+            else if (grabImage(targetChip) == false)
                 targetChip->setExposureFailed();
         }
         else
@@ -2644,7 +2763,7 @@ bool SBIGCCD::isExposureDone(INDI::CCDChip *targetChip)
 int SBIGCCD::readoutCCD(uint16_t left, uint16_t top, uint16_t width, uint16_t height,
                         uint16_t *buffer, INDI::CCDChip *targetChip)
 {
-    int h, ccd, binning, res;
+    int ccd, binning, res;
     if (targetChip == &PrimaryCCD)
     {
         ccd = CCD_IMAGING;
@@ -2678,20 +2797,59 @@ int SBIGCCD::readoutCCD(uint16_t left, uint16_t top, uint16_t width, uint16_t he
     rlp.readoutMode = binning;
     rlp.pixelStart  = left;
     rlp.pixelLength = width;
-    for (h = 0; h < height; h++)
+
+    // Overlapped primary readouts release sbigLock between batches, so the guide head can
+    // be polled and read out meanwhile. Statistics follow each batch outside the lock.
+    PixelShuffle::RowReadout &readout = (targetChip == &PrimaryCCD) ? m_PrimaryReadout : m_GuideReadout;
+    bool overlapped = (targetChip == &PrimaryCCD && m_PrimaryReadout.isRunning());
+    readout.setFrame(reinterpret_cast<uint8_t *>(buffer), width, height, 2);
+    readout.setBatch(overlapped ? std::max(1, static_cast<int>(ReadoutBatchN[0].value)) : 0);
+    readout.setLock(overlapped ? &sbigLock : nullptr);
+    if (overlapped)
+        guard.unlock();
+
+    bool complete = readout.read([&](int, uint8_t *line)
+    {
+        res = ReadoutLine(&rlp, reinterpret_cast<uint16_t *>(line), false);
+        return res == CE_NO_ERROR;
+    });
+    if (res != CE_NO_ERROR)
     {
-        ReadoutLine(&rlp, buffer + (h * width), false);
+        LOGF_ERROR("%s readoutCCD - ReadoutLine error! (%s)",
+                   (targetChip == &PrimaryCCD) ? "Primary" : "Guide", GetErrorString(res));
     }
+
+    if (!guard.owns_lock())
+        guard.lock();
     EndReadoutParams erp;
     erp.ccd = ccd;
-    if ((res = EndReadout(&erp)) != CE_NO_ERROR)
+    int endRes = EndReadout(&erp);
+    guard.unlock();
+
+    if (res == CE_NO_ERROR && !complete)
+        res = CE_OS_ERROR;
+    if (res != CE_NO_ERROR)
+        return res;
+    if ((res = endRes) != CE_NO_ERROR)
     {
         LOGF_ERROR("%s readoutCCD - EndReadout error! (%s)",
                    (targetChip == &PrimaryCCD) ? "Primary" : "Guide", GetErrorString(res));
-        guard.unlock();
         return res;
     }
-    guard.unlock();
+
+    if (targetChip == &PrimaryCCD)
+    {
+        const PixelShuffle::ReadoutStats &stats = readout.stats();
+        ReadoutStatsN[STATS_ROWS].value     = stats.rows;
+        ReadoutStatsN[STATS_MIN].value      = stats.min;
+        ReadoutStatsN[STATS_MAX].value      = stats.max;
+        ReadoutStatsN[STATS_MEAN].value     = stats.mean;
+        ReadoutStatsN[STATS_MEDIAN].value   = stats.median();
+        ReadoutStatsN[STATS_CHECKSUM].value = stats.checksum;
+        ReadoutStatsN[STATS_DURATION].value = stats.duration;
+        ReadoutStatsNP.s = IPS_OK;
+        IDSetNumber(&ReadoutStatsNP, nullptr);
+    }
     return res;
 }
 
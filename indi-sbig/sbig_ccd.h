@@ -37,6 +37,9 @@
 #include <sbigudrv.h>
 #endif
 
+#include <rowreadout.h>
+
+#include <mutex>
 #include <string>
 
 #define DEVICE struct usb_device *
@@ -251,6 +254,30 @@ class SBIGCCD : public INDI::CCD, public INDI::FilterInterface
         ISwitch IgnoreErrorsS[1];
         ISwitchVectorProperty IgnoreErrorsSP;
 
+        // Primary readout on the calling thread, or overlapped on the readout thread
+        ISwitch ReadoutModeS[2];
+        ISwitchVectorProperty ReadoutModeSP;
+        enum
+        {
+            READOUT_BLOCKING,
+            READOUT_OVERLAPPED
+        };
+        INumber ReadoutBatchN[1];
+        INumberVectorProperty ReadoutBatchNP;
+
+        INumber ReadoutStatsN[7];
+        INumberVectorProperty ReadoutStatsNP;
+        enum
+        {
+            STATS_ROWS,
+            STATS_MIN,
+            STATS_MAX,
+            STATS_MEAN,
+            STATS_MEDIAN,
+            STATS_CHECKSUM,
+            STATS_DURATION
+        };
+
         /////////////////////////////////////////////////////////////////////////////
         /// Filter Wheel Properties
         /////////////////////////////////////////////////////////////////////////////
@@ -277,6 +304,11 @@ class SBIGCCD : public INDI::CCD, public INDI::FilterInterface
         /// Threading Variables
         /////////////////////////////////////////////////////////////////////////////
         std::mutex sbigLock;
+        // ExposureComplete() of both chips, the primary may complete on the readout thread
+        std::mutex completeLock;
+        // Rows of each chip, the primary one also runs the overlapped readout thread
+        PixelShuffle::RowReadout m_PrimaryReadout;
+        PixelShuffle::RowReadout m_GuideReadout;
 
         /////////////////////////////////////////////////////////////////////////////
         /// Exposure Variables
@@ -407,8 +439,20 @@ class SBIGCCD : public INDI::CCD, public INDI::FilterInterface
         int getBinningMode(INDI::CCDChip *targetChip, int &binning);
         int getFrameType(INDI::CCDChip *targetChip, INDI::CCDChip::CCD_FRAME *frameType);
         int getShutterMode(INDI::CCDChip *targetChip, int &shutter);
+        // Area and buffer of a readout, taken once before the download starts
+        struct ReadoutFrame
+        {
+            uint16_t left { 0 };
+            uint16_t top { 0 };
+            uint16_t width { 0 };
+            uint16_t height { 0 };
+            uint8_t *buffer { nullptr };
+        };
+        ReadoutFrame getReadoutFrame(INDI::CCDChip *targetChip);
         int readoutCCD(unsigned short left, unsigned short top, unsigned short width, unsigned short height,
                        unsigned short *buffer, INDI::CCDChip *targetChip);
+        void startReadoutThread();
+        void stopReadoutThread();
 
         /////////////////////////////////////////////////////////////////////////////
         /// Filter Wheel Functions
@@ -434,6 +478,7 @@ class SBIGCCD : public INDI::CCD, public INDI::FilterInterface
         /// Utility Functions
         /////////////////////////////////////////////////////////////////////////////
         bool grabImage(INDI::CCDChip *targetChip);
+        bool readImage(INDI::CCDChip *targetChip, const ReadoutFrame &frame);
         bool setupParams();
         // SBIG's software interface to the Universal Driver Library function:
         int SBIGUnivDrvCommand(PAR_COMMAND, void *, void *);
@@ -3,6 +3,8 @@
 #include "config.h"
 
 #define MOUNT_TAB "Mount"
+// Polls between updates of the latency property
+#define LATENCY_UPDATE_POLLS 10
 
 template <typename Tr>
 Tr retry(int retries, std::function<Tr()> f) {
@@ -147,6 +149,14 @@ INDIStarbookTen::initProperties() {
     IUFillSwitchVector(&HomeSP, HomeS, HS_LAST, getDeviceName(), "TELESCOPE_HOME", "Homing", MAIN_CONTROL_TAB, IP_RW, ISR_ATMOST1, 60,
                        IPS_IDLE);
 
+    IUFillNumber(&LatencyN[SL_STATUS], "STATUS", "Status (ms)", "%.0f", 0, 60000, 0, 0);
+    IUFillNumber(&LatencyN[SL_TRACK], "TRACK", "Track (ms)", "%.0f", 0, 60000, 0, 0);
+    IUFillNumber(&LatencyN[SL_PIERSIDE], "PIERSIDE", "Pier Side (ms)", "%.0f", 0, 60000, 0, 0);
+    IUFillNumber(&LatencyN[SL_GUIDE], "GUIDE", "Guide (ms)", "%.0f", 0, 60000, 0, 0);
+    IUFillNumber(&LatencyN[SL_POLL], "POLL", "Poll (ms)", "%.0f", 0, 60000, 0, 0);
+    IUFillNumberVector(&LatencyNP, LatencyN, SL_LAST, getDeviceName(), "MOUNT_LATENCY",
+                       "Latency", MOUNT_TAB, IP_RO, 60, IPS_IDLE);
+
     INDI::GuiderInterface::initGuiderProperties(getDeviceName(), GUIDE_TAB);
 
     setDriverInterface(getDriverInterface() | GUIDER_INTERFACE);
@@ -169,6 +179,7 @@ INDIStarbookTen::updateProperties() {
         defineProperty(&GuideWENP);
         defineProperty(&GuideRateNP);
         defineProperty(&HomeSP);
+        defineProperty(&LatencyNP);
 
         return fetchStartupInfo();
     } else {
@@ -178,6 +189,7 @@ INDIStarbookTen::updateProperties() {
         deleteProperty(GuideWENP.name);
         deleteProperty(GuideRateNP.name);
         deleteProperty(HomeSP.name);
+        deleteProperty(LatencyNP.name);
 
         return true;
     }
@@ -243,6 +255,7 @@ INDIStarbookTen::ISNewSwitch(const char *dev, const char *name, ISState *states,
             try {
                 LOG_INFO("Find home started");
                 retry<bool>(2, &StarbookTen::findHome, starbook);
+                statusPoller.invalidate();
                 TrackState = SCOPE_SLEWING;
                 HomeS[HS_FIND_HOME].s = ISS_ON;
                 HomeSP.s = IPS_BUSY;
@@ -269,11 +282,48 @@ INDIStarbookTen::Handshake() {
     try {
         starbook->getFirmwareVersion();
         retry<bool>(2, &StarbookTen::start, starbook, true);
-        return true;
     } catch (std::exception& ex) {
         LOGF_ERROR("Handshake failed: %s", ex.what());
         return false;
     }
+
+    if (!statusPoller.connect(httpConnection->host())) {
+        LOGF_ERROR("Handshake failed: invalid address %s", httpConnection->host());
+        return false;
+    }
+
+    return true;
+}
+
+
+bool
+INDIStarbookTen::Disconnect() {
+    statusPoller.disconnect();
+
+    return INDI::Telescope::Disconnect();
+}
+
+
+void
+INDIStarbookTen::updateLatency() {
+    static const StarbookTenStatus::Endpoint eps[] = {
+        StarbookTenStatus::EP_STATUS,
+        StarbookTenStatus::EP_TRACK,
+        StarbookTenStatus::EP_PIERSIDE,
+        StarbookTenStatus::EP_GUIDE
+    };
+
+    for (int i = SL_STATUS; i <= SL_GUIDE; i++) {
+        auto l = statusPoller.getLatency(eps[i]);
+        LatencyN[i].value = l.mean;
+        LOGF_DEBUG("%s: last %.0f ms, mean %.0f ms, max %.0f ms, %llu requests, %llu errors",
+                   StarbookTenStatus::path(eps[i]), l.last, l.mean, l.max,
+                   (unsigned long long)l.count, (unsigned long long)l.errors);
+    }
+    LatencyN[SL_POLL].value = statusPoller.getPollTime();
+
+    LatencyNP.s = IPS_OK;
+    IDSetNumber(&LatencyNP, nullptr);
 }
 
 
@@ -335,8 +385,9 @@ INDIStarbookTen::fetchStartupInfo() {
 bool
 INDIStarbookTen::ReadScopeStatus() {
     try {
-        auto stat = retry<StarbookTen::MountStatus>(2, &StarbookTen::getStatus, starbook);
-        bool isTracking = retry<bool>(2, &StarbookTen::isTracking, starbook);
+        auto snap = statusPoller.poll(isPropGuidingRA || isPropGuidingDE, 2);
+        auto& stat = snap.status;
+        bool isTracking = snap.tracking;
 
         updateStarbookState(stat);
 
@@ -364,25 +415,28 @@ INDIStarbookTen::ReadScopeStatus() {
 
         NewRaDec(stat.ra, stat.dec);
 
-        auto ps = retry<StarbookTen::PierSide>(2, &StarbookTen::getPierSide, starbook);
-        setPierSide((ps == StarbookTen::PIERSIDE_EAST) ? INDI::Telescope::PIER_EAST : INDI::Telescope::PIER_WEST);
+        setPierSide((snap.pierSide == StarbookTen::PIERSIDE_EAST) ? INDI::Telescope::PIER_EAST : INDI::Telescope::PIER_WEST);
 
-        if (isPropGuidingRA || isPropGuidingDE) {
-            auto gs = retry<std::tuple<bool,bool> >(2, &StarbookTen::getGuidingRaDec, starbook);
-            LOGF_DEBUG("Prop guiding status: RA=%d, DEC=%d", !!(std::get<0>(gs)), !!(std::get<1>(gs)));
-            if (isPropGuidingRA && !std::get<0>(gs)) {
+        if (snap.hasGuide) {
+            LOGF_DEBUG("Prop guiding status: RA=%d, DEC=%d", !!snap.guidingRa, !!snap.guidingDec);
+            if (isPropGuidingRA && !snap.guidingRa) {
                 LOG_DEBUG("Prop guiding in RA finished");
                 isPropGuidingRA = false;
                 INDI::GuiderInterface::GuideComplete(AXIS_RA);
             }
 
-            if (isPropGuidingDE && !std::get<1>(gs)) {
+            if (isPropGuidingDE && !snap.guidingDec) {
                 LOG_DEBUG("Prop guiding in DE finished");
                 isPropGuidingDE = false;
                 INDI::GuiderInterface::GuideComplete(AXIS_DE);
             }
         }
 
+        if (++latencyUpdate >= LATENCY_UPDATE_POLLS) {
+            latencyUpdate = 0;
+            updateLatency();
+        }
+
         return true;
     } catch (std::exception &ex) {
         LOGF_ERROR("ReadScopeStatus failed: %s", ex.what());
@@ -395,6 +449,7 @@ bool
 INDIStarbookTen::Goto(double ra, double dec) {
     try {
         retry<bool>(2, &StarbookTen::goTo, starbook, ra, dec);
+        statusPoller.invalidate();
         TrackState = SCOPE_SLEWING;
         return true;
     } catch (std::exception &ex) {
@@ -408,6 +463,7 @@ bool
 INDIStarbookTen::Sync(double ra, double dec) {
     try {
         retry<bool>(2, &StarbookTen::sync, starbook, ra, dec);
+        statusPoller.invalidate();
         NewRaDec(ra, dec);
         return true;
     } catch (std::exception &ex) {
@@ -423,6 +479,7 @@ INDIStarbookTen::MoveNS(INDI_DIR_NS dir, TelescopeMotionCommand command) {
         if (command == MOTION_START) {
             double absrate = StarbookTen::slewRates[IUFindOnSwitchIndex(&SlewRateSP)];
             double rate = (dir == DIRECTION_NORTH) ? absrate : -absrate;
+            statusPoller.invalidate();
             return retry<bool>(2, &StarbookTen::move, starbook, StarbookTen::AXIS_SECONDARY, rate);
         } else {
             return retry<bool>(2, &StarbookTen::move, starbook, StarbookTen::AXIS_SECONDARY, 0);
@@ -440,6 +497,7 @@ INDIStarbookTen::MoveWE(INDI_DIR_WE dir, TelescopeMotionCommand command) {
         if (command == MOTION_START) {
             double absrate = StarbookTen::slewRates[IUFindOnSwitchIndex(&SlewRateSP)];
             double rate = (dir == DIRECTION_EAST) ? absrate : -absrate;
+            statusPoller.invalidate();
             return retry<bool>(2, &StarbookTen::move, starbook, StarbookTen::AXIS_PRIMARY, rate);
         } else {
             return retry<bool>(2, &StarbookTen::move, starbook, StarbookTen::AXIS_PRIMARY, 0);
@@ -455,6 +513,7 @@ bool
 INDIStarbookTen::Park() {
     try {
         retry<bool>(2, &StarbookTen::park, starbook);
+        statusPoller.invalidate();
         TrackState = SCOPE_PARKING;
         return true;
     } catch (std::exception &ex) {
@@ -468,6 +527,7 @@ bool
 INDIStarbookTen::UnPark() {
     try {
         retry<bool>(2, &StarbookTen::unpark, starbook);
+        statusPoller.invalidate();
         SetParked(false);
         retry<bool>(2, &StarbookTen::start, starbook, true);
         TrackState = SCOPE_TRACKING;
@@ -494,6 +554,7 @@ bool
 INDIStarbookTen::Abort() {
     try {
         LOG_INFO("Aborting motion");
+        statusPoller.invalidate();
         retry<bool>(2, &StarbookTen::move, starbook, StarbookTen::AXIS_PRIMARY, 0);
         retry<bool>(2, &StarbookTen::move, starbook, StarbookTen::AXIS_SECONDARY, 0);
         retry<bool>(2, &StarbookTen::stop, starbook);
@@ -5,6 +5,7 @@
 #include "indiguiderinterface.h"
 #include "connectionhttp.h"
 #include "starbook_ten.h"
+#include "starbook_ten_status.h"
 
 class INDIStarbookTen : public INDI::Telescope, INDI::GuiderInterface {
 public:
@@ -19,6 +20,7 @@ protected:
     virtual bool initProperties() override;
     virtual bool updateProperties() override;
     virtual bool Handshake() override;
+    virtual bool Disconnect() override;
     virtual bool saveConfigItems(FILE *fp) override;
 
     /***************************************************/
@@ -101,9 +103,26 @@ private:
     ISwitch HomeS[HS_LAST];
     ISwitchVectorProperty HomeSP;
 
+    /* Status latency */
+    enum {
+        SL_STATUS,
+        SL_TRACK,
+        SL_PIERSIDE,
+        SL_GUIDE,
+        SL_POLL,
+        SL_LAST
+    } LatencyProps;
+
+    INumber LatencyN[SL_LAST];
+    INumberVectorProperty LatencyNP;
+    int latencyUpdate = 0;
+
+    void updateLatency();
+
     Connection::HTTP *httpConnection = nullptr;
 
     StarbookTen *starbook;
+    StarbookTenStatus statusPoller;
 };
 
 #endif /* _INDI_STARBOOK_TEN_H_ */
@@ -43,6 +43,7 @@ StarbookTen::setHttpClient(httplib::Client *http) {
 
     this->http = http;
     destroyClient = false;
+    placeCache.clear();
 }
 
 
@@ -92,10 +93,16 @@ StarbookTen::getPierSide() {
         throw std::runtime_error("HTTP get failed");
     }
 
+    return parsePierSide(res->body);
+}
+
+
+StarbookTen::PierSide
+StarbookTen::parsePierSide(const std::string& body) {
     std::regex r(R"(PIERSIDE=([01]))");
     std::smatch sm;
 
-    if (std::regex_search(res->body, sm, r)) {
+    if (std::regex_search(body, sm, r)) {
         return static_cast<StarbookTen::PierSide>(std::stoi(sm[1]));
     } else {
         throw std::runtime_error("Could not get pier side");
@@ -156,16 +163,12 @@ StarbookTen::getDateTime() {
         throw std::runtime_error("Could not get time");
     }
 
-    res = http->Get("/getplace");
-
-    if (!res || res->status != 200) {
-        throw std::runtime_error("HTTP get failed");
-    }
+    const std::string& place = getPlace();
 
     std::regex rtz(R"(<!--.*timezone=([+-]?\d+)-->)");
     std::smatch smtz;
 
-    if (std::regex_search(res->body, smtz, rtz)) {
+    if (std::regex_search(place, smtz, rtz)) {
         zdt.gmtoff = std::stoi(smtz[1])*3600;
     } else {
         throw std::runtime_error("Could not get timezone");
@@ -204,6 +207,8 @@ StarbookTen::setLatLonTz(double lat, double lon, long utc_off_secs) {
     char buf[256];
     ln_dms lat_dms, lon_dms;
 
+    placeCache.clear();
+
     ln_deg_to_dms(lat, &lat_dms);
     ln_deg_to_dms(lon, &lon_dms);
 
@@ -217,18 +222,30 @@ StarbookTen::setLatLonTz(double lat, double lon, long utc_off_secs) {
 }
 
 
-std::tuple<double,double>
-StarbookTen::getLatLon() {
-    auto res = http->Get("/getplace");
+const std::string&
+StarbookTen::getPlace() {
+    if (placeCache.empty()) {
+        auto res = http->Get("/getplace");
 
-    if (!res || res->status != 200) {
-        throw std::runtime_error("HTTP get failed");
+        if (!res || res->status != 200) {
+            throw std::runtime_error("HTTP get failed");
+        }
+
+        placeCache = res->body;
     }
 
+    return placeCache;
+}
+
+
+std::tuple<double,double>
+StarbookTen::getLatLon() {
+    const std::string& place = getPlace();
+
     std::regex r(R"(<!--longitude=([EW])(\d+)\+(\d+)&latitude=([NS])(\d+)\+(\d+)&.*-->)");
     std::smatch sm;
 
-    if (std::regex_search(res->body, sm, r)) {
+    if (std::regex_search(place, sm, r)) {
         ln_dms lon_dms, lat_dms;
 
         lon_dms.neg = (sm[1].compare("W") == 0) ? 1 : 0;
@@ -281,10 +298,16 @@ StarbookTen::getStatus() {
         throw std::runtime_error("HTTP get failed");
     }
 
+    return parseStatus(res->body);
+}
+
+
+StarbookTen::MountStatus
+StarbookTen::parseStatus(const std::string& body) {
     std::regex r(R"(<!--RA=(\-?\d+\.\d+)&DEC=(\-?\d+\.\d+)&GOTO=([01])&STATE=([A-Z]+)-->)");
     std::smatch sm;
 
-    if (std::regex_search(res->body, sm, r)) {
+    if (std::regex_search(body, sm, r)) {
         MountStatus stat;
 
         stat.ra = std::stod(sm[1]);
@@ -309,12 +332,18 @@ StarbookTen::isTracking() {
         throw std::runtime_error("HTTP get failed");
     }
 
+    return parseTrackStatus(res->body);
+}
+
+
+bool
+StarbookTen::parseTrackStatus(const std::string& body) {
     // TRACK=2 seems to be used during gotos, but since we can already figure
     // gotos out from the getstatus2 call, there's no need to handle it here.
     std::regex r(R"(<!--TRACK=([012])-->)");
     std::smatch sm;
 
-    if (std::regex_search(res->body, sm, r)) {
+    if (std::regex_search(body, sm, r)) {
         return !(sm[1].compare("1"));
     } else {
         throw std::runtime_error("Could not get track status");
@@ -330,10 +359,16 @@ StarbookTen::getGuidingRaDec() {
         throw std::runtime_error("HTTP get failed");
     }
 
+    return parseGuideStatus(res->body);
+}
+
+
+std::tuple<bool,bool>
+StarbookTen::parseGuideStatus(const std::string& body) {
     std::regex r(R"(<!--RA\+=([01])&RA\-=([01])&DEC\+=([01])&DEC\-=([01])-->)");
     std::smatch sm;
 
-    if (std::regex_search(res->body, sm, r)) {
+    if (std::regex_search(body, sm, r)) {
         return std::tuple<bool,bool>((!(sm[1].compare("1")) || !(sm[2].compare("1"))),
                                      (!(sm[3].compare("1")) || !(sm[4].compare("1"))));
     } else {
@@ -12,8 +12,12 @@ class StarbookTen {
 private:
     httplib::Client *http;
 
+    // Body of /getplace, place and time zone only change through setLatLonTz()
+    std::string placeCache;
+
     bool sendBasicCmd(const char *cmd);
     std::string sxfmt(double x);
+    const std::string& getPlace();
 
 public:
     enum Axis {
@@ -83,6 +87,12 @@ public:
 
     std::tuple<double,double> getRaDec();
 
+    // Replies of the status requests, shared with StarbookTenStatus
+    static MountStatus parseStatus(const std::string& body);
+    static bool parseTrackStatus(const std::string& body);
+    static PierSide parsePierSide(const std::string& body);
+    static std::tuple<bool,bool> parseGuideStatus(const std::string& body);
+
     bool setPulseRate(int ra_arcsec_per_sec, int dec_arcsec_per_sec);
     bool movePulse(GuideDirection dir, uint32_t ms);
 
@@ -0,0 +1,222 @@
+#include <algorithm>
+#include "starbook_ten_status.h"
+
+// Seconds a cached pier side is trusted without a slew
+#define PIERSIDE_MAX_AGE 60
+
+StarbookTenStatus::StarbookTenStatus(size_t workers) : workers(std::max<size_t>(workers, 1)) {
+}
+
+
+StarbookTenStatus::~StarbookTenStatus() {
+    disconnect();
+}
+
+
+const char *
+StarbookTenStatus::path(Endpoint ep) {
+    switch (ep) {
+    case EP_STATUS:   return "/getstatus2";
+    case EP_TRACK:    return "/gettrackstatus";
+    case EP_PIERSIDE: return "/get_pierside";
+    case EP_GUIDE:    return "/getguidestatus";
+    default:          return "";
+    }
+}
+
+
+bool
+StarbookTenStatus::connect(const std::string& base_url) {
+    disconnect();
+
+    for (size_t i = 0; i < workers; i++) {
+        std::unique_ptr<httplib::Client> client(new httplib::Client(base_url.c_str()));
+        if (!client->is_valid()) {
+            clients.clear();
+            return false;
+        }
+
+        // Same settings as the StarbookTen command connection
+        client->set_connection_timeout(2, 0);
+        client->set_read_timeout(3, 0);
+        client->set_write_timeout(3, 0);
+        client->set_keep_alive(true);
+        client->set_url_encode(false);
+
+        clients.push_back(std::move(client));
+    }
+
+    for (auto& client : clients) {
+        threads.emplace_back(&StarbookTenStatus::run, this, client.get());
+    }
+
+    pierSideValid = false;
+    for (auto& l : latency) {
+        l = Latency();
+    }
+
+    return true;
+}
+
+
+void
+StarbookTenStatus::disconnect() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    condition.notify_all();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+    clients.clear();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    quit = false;
+    queue.clear();
+}
+
+
+void
+StarbookTenStatus::invalidate() {
+    pierSideValid = false;
+}
+
+
+StarbookTenStatus::Latency
+StarbookTenStatus::getLatency(Endpoint ep) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return latency[ep];
+}
+
+
+StarbookTenStatus::Snapshot
+StarbookTenStatus::poll(bool guiding, int retries) {
+    if (threads.empty()) {
+        throw std::runtime_error("Status poller not connected");
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    bool readPierSide = !pierSideValid ||
+                        (start - pierSideTime) > std::chrono::seconds(PIERSIDE_MAX_AGE);
+
+    std::vector<Endpoint> eps { EP_STATUS, EP_TRACK };
+    if (readPierSide) {
+        eps.push_back(EP_PIERSIDE);
+    }
+    if (guiding) {
+        eps.push_back(EP_GUIDE);
+    }
+
+    std::vector<std::future<std::string>> replies;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto ep : eps) {
+            auto request = std::make_shared<Request>();
+            request->ep = ep;
+            request->retries = retries;
+            replies.push_back(request->body.get_future());
+            queue.push_back(request);
+        }
+    }
+    condition.notify_all();
+
+    // Wait for all of them, a failed request must not leave the others running into the next poll
+    std::string bodies[EP_LAST];
+    std::exception_ptr error;
+    for (size_t i = 0; i < eps.size(); i++) {
+        try {
+            bodies[eps[i]] = replies[i].get();
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    Snapshot snap;
+    snap.status = StarbookTen::parseStatus(bodies[EP_STATUS]);
+    snap.tracking = StarbookTen::parseTrackStatus(bodies[EP_TRACK]);
+
+    if (readPierSide) {
+        pierSide = StarbookTen::parsePierSide(bodies[EP_PIERSIDE]);
+        pierSideTime = start;
+        // Still moving, the pier side may change until the goto is done
+        pierSideValid = !snap.status.goto_busy;
+    }
+    snap.pierSide = pierSide;
+
+    snap.hasGuide = guiding;
+    snap.guidingRa = snap.guidingDec = false;
+    if (guiding) {
+        std::tie(snap.guidingRa, snap.guidingDec) = StarbookTen::parseGuideStatus(bodies[EP_GUIDE]);
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    pollTime = elapsed.count();
+
+    return snap;
+}
+
+
+void
+StarbookTenStatus::run(httplib::Client *client) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (;;) {
+        condition.wait(lock, [this]() { return quit || !queue.empty(); });
+        if (quit) {
+            break;
+        }
+
+        auto request = queue.front();
+        queue.pop_front();
+        lock.unlock();
+
+        try {
+            request->body.set_value(get(client, *request));
+        } catch (...) {
+            request->body.set_exception(std::current_exception());
+        }
+
+        lock.lock();
+    }
+
+    // Nobody waits forever on a request that was not sent
+    for (auto& request : queue) {
+        request->body.set_exception(std::make_exception_ptr(std::runtime_error("Status poller stopped")));
+    }
+    queue.clear();
+}
+
+
+std::string
+StarbookTenStatus::get(httplib::Client *client, Request& request) {
+    for (int retries = request.retries;; retries--) {
+        auto start = std::chrono::steady_clock::now();
+        auto res = client->Get(path(request.ep));
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Latency& l = latency[request.ep];
+
+        if (res && res->status == 200) {
+            l.last = elapsed.count();
+            l.max = std::max(l.max, l.last);
+            l.count++;
+            l.mean += (l.last - l.mean) / l.count;
+            return res->body;
+        }
+
+        l.errors++;
+        if (retries <= 0) {
+            throw std::runtime_error("HTTP get failed");
+        }
+    }
+}
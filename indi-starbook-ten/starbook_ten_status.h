@@ -0,0 +1,96 @@
+#ifndef _STARBOOK_TEN_STATUS_H_
+#define _STARBOOK_TEN_STATUS_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "starbook_ten.h"
+
+/*
+ * Status poller for the StarbookTen.
+ *
+ * The status requests of one poll go out concurrently, each worker keeps a keep-alive
+ * connection of its own to the mount, so a poll costs one round trip instead of one per
+ * request. The pier side only changes with slews: it is read again while a goto is busy,
+ * after invalidate() and once a minute, and cached otherwise.
+ */
+class StarbookTenStatus {
+public:
+    enum Endpoint {
+        EP_STATUS,
+        EP_TRACK,
+        EP_PIERSIDE,
+        EP_GUIDE,
+        EP_LAST
+    };
+
+    struct Snapshot {
+        StarbookTen::MountStatus status;
+        bool                     tracking;
+        StarbookTen::PierSide    pierSide;
+        bool                     hasGuide;
+        bool                     guidingRa;
+        bool                     guidingDec;
+    };
+
+    // Round trip per request in ms
+    struct Latency {
+        double   last   { 0 };
+        double   mean   { 0 };
+        double   max    { 0 };
+        uint64_t count  { 0 };
+        uint64_t errors { 0 };
+    };
+
+    explicit StarbookTenStatus(size_t workers = EP_LAST);
+    ~StarbookTenStatus();
+
+    bool connect(const std::string& base_url);
+    void disconnect();
+
+    // Runs one poll, the guide status only if guiding. Throws like the StarbookTen getters.
+    Snapshot poll(bool guiding, int retries);
+
+    // The mount was told to move, forget the cached pier side.
+    void invalidate();
+
+    Latency getLatency(Endpoint ep);
+    // Duration of the last poll in ms
+    double getPollTime() const { return pollTime; }
+
+    static const char *path(Endpoint ep);
+
+private:
+    struct Request {
+        Endpoint ep;
+        int retries;
+        std::promise<std::string> body;
+    };
+
+    void run(httplib::Client *client);
+    std::string get(httplib::Client *client, Request& request);
+
+    size_t workers;
+    std::vector<std::unique_ptr<httplib::Client>> clients;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::shared_ptr<Request>> queue;
+    bool quit = false;
+    Latency latency[EP_LAST];
+
+    // Driver thread only
+    bool pierSideValid = false;
+    StarbookTen::PierSide pierSide = StarbookTen::PIERSIDE_WEST;
+    std::chrono::steady_clock::time_point pierSideTime;
+    double pollTime = 0;
+};
+
+#endif /* _STARBOOK_TEN_STATUS_H_ */
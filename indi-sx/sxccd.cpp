@@ -88,8 +88,10 @@ SXCCD::SXCCD(DEVICE device, const char *name)
     this->device          = device;
     handle                = nullptr;
     model                 = 0;
-    oddBuf                = nullptr;
     evenBuf               = nullptr;
+    transfers.count       = 8;
+    transfers.size        = 256 * 1024;
+    transfers.throughput  = 0;
     GuideStatus           = 0;
     TemperatureRequest    = 0;
     TemperatureReported   = 0;
@@ -149,6 +151,15 @@ bool SXCCD::initProperties()
     IUFillSwitchVector(&ShutterSP, ShutterS, 2, getDeviceName(), "CCD_SHUTTER", "Shutter", OPTIONS_TAB, IP_RW,
                        ISR_1OFMANY, 60, IPS_IDLE);
 
+    // Pixel download, several USB transfers in flight keep the bus busy
+    IUFillNumber(&TransfersN[0], "COUNT", "Transfers in flight", "%.f", 1, 64, 1, transfers.count);
+    IUFillNumber(&TransfersN[1], "SIZE", "Transfer size (kB)", "%.f", 16, 4096, 16, transfers.size / 1024);
+    IUFillNumberVector(&TransfersNP, TransfersN, 2, getDeviceName(), "USB_TRANSFERS", "USB Transfers", OPTIONS_TAB,
+                       IP_RW, 60, IPS_IDLE);
+    IUFillNumber(&ThroughputN[0], "RATE", "Last download (MB/s)", "%.2f", 0, 1000, 0, 0);
+    IUFillNumberVector(&ThroughputNP, ThroughputN, 1, getDeviceName(), "USB_THROUGHPUT", "USB Throughput",
+                       OPTIONS_TAB, IP_RO, 60, IPS_IDLE);
+
     //Adding switch to let user indicate whether the CCD has a Bayer filter, since I do not know which models beyond UltraStar C actually do
     //    IUFillSwitch(&BayerS[0], "BAYER_TRUE", "True", ISS_OFF);
     //    IUFillSwitch(&BayerS[1], "BAYER_FALSE", "False", ISS_ON);
@@ -189,6 +200,8 @@ bool SXCCD::updateProperties()
             defineProperty(&CoolerSP);
         if (HasShutter)
             defineProperty(&ShutterSP);
+        defineProperty(&TransfersNP);
+        defineProperty(&ThroughputNP);
     }
     else
     {
@@ -196,6 +209,8 @@ bool SXCCD::updateProperties()
             deleteProperty(CoolerSP.name);
         if (HasShutter)
             deleteProperty(ShutterSP.name);
+        deleteProperty(TransfersNP.name);
+        deleteProperty(ThroughputNP.name);
     }
     return true;
 }
@@ -329,19 +344,11 @@ void SXCCD::SetupParms()
         nbuf *= 2;
     //nbuf += 512;
     PrimaryCCD.setFrameBufferSize(nbuf);
-    if (isInterlaced)
-    {
-        if (evenBuf != nullptr)
-            delete evenBuf;
-        if (oddBuf != nullptr)
-            delete oddBuf;
-        evenBuf      = new char[nbuf / 2];
-        oddBuf       = new char[nbuf / 2];
-    }
-    else if (isICX453)
+    // Interlaced fields are read straight into their rows, only the ICX453 needs a separate buffer
+    if (isICX453)
     {
         if (evenBuf != nullptr)
-            delete evenBuf;
+            delete [] evenBuf;
         evenBuf      = new char[nbuf];
     }
 
@@ -477,7 +484,6 @@ void SXCCD::ExposureTimerHit()
             int subH          = PrimaryCCD.getSubH();
             int binX          = PrimaryCCD.getBinX();
             int binY          = PrimaryCCD.getBinY();
-            int subWW         = subW * 2;
             bool isICX453     = sxIsICX453(model);
             uint8_t *buf      = PrimaryCCD.getFrameBuffer();
             int size;
@@ -495,33 +501,26 @@ void SXCCD::ExposureTimerHit()
                     rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 0, subX, subY / binY, subW, subH / 2, binX,
                                        binY / 2);
                     if (rc)
-                        rc = sxReadPixels(handle, buf, size * 2);
+                        rc = sxReadPixels(handle, buf, size * 2, &transfers);
                 }
                 else
                 {
+                    // Odd field goes to rows 0, 2, ..., even field to rows 1, 3, ...
+                    int rowBytes = subW / binX * 2;
                     rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_EVEN | CCD_EXP_FLAGS_SPARE2, 0, subX, subY / 2, subW,
                                        subH / 2, binX, 1);
                     struct timeval tv;
                     gettimeofday(&tv, nullptr);
                     long startTime = tv.tv_sec * 1000000 + tv.tv_usec;
                     if (rc)
-                        rc = sxReadPixels(handle, evenBuf, size);
+                        rc = sxReadPixelRows(handle, buf + rowBytes, rowBytes, subH / 2, rowBytes * 2, &transfers);
                     gettimeofday(&tv, nullptr);
                     wipeDelay = tv.tv_sec * 1000000 + tv.tv_usec - startTime;
                     if (rc)
                         rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_ODD | CCD_EXP_FLAGS_SPARE2, 0, subX, subY / 2,
                                            subW, subH / 2, binX, 1);
                     if (rc)
-                        rc = sxReadPixels(handle, oddBuf, size);
-                    if (rc)
-                    {
-                        for (int i = 0, j = 0; i < subH; i += 2, j++)
-                        {
-                            memcpy(buf + i * subWW, oddBuf + (j * subWW), subWW);
-                            memcpy(buf + ((i + 1) * subWW), evenBuf + (j * subWW), subWW);
-                        }
-                        //            deinterlace((unsigned short *)buf, subW, subH);
-                    }
+                        rc = sxReadPixelRows(handle, buf, rowBytes, subH / 2, rowBytes * 2, &transfers);
                 }
             }
             else if (isICX453)
@@ -531,7 +530,7 @@ void SXCCD::ExposureTimerHit()
                 {
                     if (binX == 1 && binY == 1)
                     {
-                        rc = sxReadPixels(handle, evenBuf, size * 2);
+                        rc = sxReadPixels(handle, evenBuf, size * 2, &transfers);
                         if (rc)
                         {
                             uint16_t *buf16 = reinterpret_cast<uint16_t *>(buf);
@@ -565,7 +564,7 @@ void SXCCD::ExposureTimerHit()
                     }
                     else
                     {
-                        rc = sxReadPixels(handle, buf, size * 2);
+                        rc = sxReadPixels(handle, buf, size * 2, &transfers);
                     }
                 }
             }
@@ -573,11 +572,12 @@ void SXCCD::ExposureTimerHit()
             {
                 rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 0, subX, subY, subW, subH, binX, binY);
                 if (rc)
-                    rc = sxReadPixels(handle, buf, size * 2);
+                    rc = sxReadPixels(handle, buf, size * 2, &transfers);
             }
             DidLatch   = false;
             InExposure = false;
             PrimaryCCD.setExposureLeft(ExposureTimeLeft = 0);
+            UpdateThroughput();
             if (rc)
                 ExposureComplete(&PrimaryCCD);
         }
@@ -628,7 +628,7 @@ void SXCCD::GuideExposureTimerHit()
         DidGuideLatch        = true;
         rc                   = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 1, subX, subY, subW, subH, binX, binY);
         if (rc)
-            rc = sxReadPixels(handle, buf, size);
+            rc = sxReadPixels(handle, buf, size, &transfers);
         DidGuideLatch   = false;
         InGuideExposure = false;
         GuideCCD.setExposureLeft(GuideExposureTimeLeft = 0);
@@ -805,9 +805,31 @@ bool SXCCD::ISNewSwitch(const char *dev, const char *name, ISState *states, char
     return result;
 }
 
-//bool SXCCD::saveConfigItems(FILE *fp)
-//{
-//    INDI::CCD::saveConfigItems(fp);
-//    IUSaveConfigSwitch(fp, &BayerSP);
-//    return true;
-//}
+bool SXCCD::ISNewNumber(const char *dev, const char *name, double values[], char *names[], int n)
+{
+    if (dev != nullptr && strcmp(dev, getDeviceName()) == 0 && strcmp(name, TransfersNP.name) == 0)
+    {
+        IUUpdateNumber(&TransfersNP, values, names, n);
+        transfers.count = static_cast<int>(TransfersN[0].value);
+        transfers.size  = static_cast<int>(TransfersN[1].value) * 1024;
+        TransfersNP.s   = IPS_OK;
+        IDSetNumber(&TransfersNP, nullptr);
+        return true;
+    }
+    return INDI::CCD::ISNewNumber(dev, name, values, names, n);
+}
+
+void SXCCD::UpdateThroughput()
+{
+    ThroughputN[0].value = transfers.throughput;
+    ThroughputNP.s       = IPS_OK;
+    IDSetNumber(&ThroughputNP, nullptr);
+}
+
+bool SXCCD::saveConfigItems(FILE *fp)
+{
+    INDI::CCD::saveConfigItems(fp);
+    IUSaveConfigNumber(fp, &TransfersNP);
+    //    IUSaveConfigSwitch(fp, &BayerSP);
+    return true;
+}
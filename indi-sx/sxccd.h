@@ -47,12 +47,17 @@ class SXCCD : public INDI::CCD
         HANDLE handle;
         unsigned short model;
         char name[32];
-        char *evenBuf, *oddBuf;
+        char *evenBuf;
         long wipeDelay;
         ISwitch CoolerS[2];
         ISwitchVectorProperty CoolerSP;
         ISwitch ShutterS[2];
         ISwitchVectorProperty ShutterSP;
+        INumber TransfersN[2];
+        INumberVectorProperty TransfersNP;
+        INumber ThroughputN[1];
+        INumberVectorProperty ThroughputNP;
+        struct t_sxusb_transfers transfers;
         //    ISwitch BayerS[2];
         //    ISwitchVectorProperty BayerSP;
         float TemperatureRequest;
@@ -88,7 +93,8 @@ class SXCCD : public INDI::CCD
         void GuideExposureTimerHit();
         void WEGuiderTimerHit();
         void NSGuiderTimerHit();
-        //bool saveConfigItems(FILE *fp);
+        bool saveConfigItems(FILE *fp);
+        void UpdateThroughput();
         IPState GuideWest(uint32_t ms);
         IPState GuideEast(uint32_t ms);
         IPState GuideNorth(uint32_t ms);
@@ -106,6 +112,7 @@ class SXCCD : public INDI::CCD
         void simulationTriggered(bool enable);
         void ISGetProperties(const char *dev);
         bool ISNewSwitch(const char *dev, const char *name, ISState *states, char *names[], int n);
+        bool ISNewNumber(const char *dev, const char *name, double values[], char *names[], int n);
 
         friend void ::ExposureTimerCallback(void *p);
         friend void ::GuideExposureTimerCallback(void *p);
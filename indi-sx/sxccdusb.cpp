@@ -44,6 +44,7 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 #include <unistd.h>
 
 #include <config-usb.h>
@@ -116,6 +117,7 @@
 
 #define BULK_COMMAND_TIMEOUT 2000
 #define BULK_DATA_TIMEOUT    40000 //Older SXV-M25C takes 14s unbinned
+#define BULK_PACKET_SIZE     512
 
 #ifdef __arm__
 #define CHUNK_SIZE (4 * 1024 * 1024)
@@ -734,8 +736,11 @@ int sxExposePixelsGated(HANDLE sxHandle, unsigned short flags, unsigned short ca
     return rc >= 0;
 }
 
-int sxReadPixels(HANDLE sxHandle, void *pixels, unsigned long count)
+int sxReadPixels(HANDLE sxHandle, void *pixels, unsigned long count, struct t_sxusb_transfers *transfers)
 {
+    if (transfers != nullptr)
+        return sxReadPixelRows(sxHandle, pixels, count, 1, count, transfers);
+
     int transferred;
     unsigned long read = 0;
     int rc             = 0;
@@ -755,6 +760,186 @@ int sxReadPixels(HANDLE sxHandle, void *pixels, unsigned long count)
     return rc >= 0;
 }
 
+/*
+ * Asynchronous download.
+ *
+ * The pixel stream is split into transfers which complete in the order they were submitted, each
+ * one is resubmitted for the next piece of the stream as soon as it completes. A contiguous
+ * destination is filled by the transfers directly. Bulk IN transfers must be a multiple of the
+ * packet size, which rows usually aren't, so for a strided destination every transfer has its
+ * own buffer whose content is spread over the destination rows on completion.
+ */
+
+struct sxAsyncRead;
+
+struct sxAsyncSlot
+{
+    struct sxAsyncRead *read;
+    struct libusb_transfer *transfer;
+    unsigned char *bounce;
+    unsigned long offset;
+    bool active;
+};
+
+struct sxAsyncRead
+{
+    HANDLE handle;
+    unsigned char *pixels;
+    unsigned long rowBytes;
+    unsigned long stride;
+    unsigned long total;
+    unsigned long size;
+    unsigned long next;
+    unsigned long done;
+    int inFlight;
+    bool failed;
+};
+
+static void LIBUSB_CALL sxAsyncCallback(struct libusb_transfer *transfer);
+
+static bool sxAsyncSubmit(sxAsyncSlot *slot)
+{
+    sxAsyncRead *read  = slot->read;
+    unsigned long size = read->total - read->next;
+    if (size > read->size)
+        size = read->size;
+
+    unsigned char *data = slot->bounce ? slot->bounce : read->pixels + read->next;
+    libusb_fill_bulk_transfer(slot->transfer, read->handle, BULK_IN, data, size, sxAsyncCallback, slot,
+                              BULK_DATA_TIMEOUT);
+    int rc = libusb_submit_transfer(slot->transfer);
+    if (rc < 0)
+    {
+        DEBUG(log(true, "sxReadPixelRows: libusb_submit_transfer -> %s\n", libusb_error_name(rc)));
+        read->failed = true;
+        return false;
+    }
+    slot->offset = read->next;
+    slot->active = true;
+    read->next += size;
+    read->inFlight++;
+    return true;
+}
+
+static void sxAsyncScatter(sxAsyncRead *read, unsigned long offset, const unsigned char *data, unsigned long length)
+{
+    while (length > 0)
+    {
+        unsigned long row    = offset / read->rowBytes;
+        unsigned long column = offset % read->rowBytes;
+        unsigned long n      = read->rowBytes - column;
+        if (n > length)
+            n = length;
+        memcpy(read->pixels + row * read->stride + column, data, n);
+        offset += n;
+        data += n;
+        length -= n;
+    }
+}
+
+static void LIBUSB_CALL sxAsyncCallback(struct libusb_transfer *transfer)
+{
+    sxAsyncSlot *slot = (sxAsyncSlot *)transfer->user_data;
+    sxAsyncRead *read = slot->read;
+    slot->active      = false;
+    read->inFlight--;
+
+    if (transfer->status != LIBUSB_TRANSFER_COMPLETED)
+    {
+        if (!read->failed)
+            DEBUG(log(true, "sxReadPixelRows: transfer status %d at %lu\n", transfer->status, slot->offset));
+        read->failed = true;
+        return;
+    }
+
+    if (slot->bounce)
+        sxAsyncScatter(read, slot->offset, slot->bounce, transfer->actual_length);
+    read->done += transfer->actual_length;
+
+    // Later transfers would land at the wrong place after a short one.
+    if (transfer->actual_length < transfer->length)
+    {
+        if (slot->offset + transfer->length < read->total)
+        {
+            DEBUG(log(true, "sxReadPixelRows: short transfer at %lu\n", slot->offset));
+            read->failed = true;
+        }
+        return;
+    }
+
+    if (!read->failed && read->next < read->total)
+        sxAsyncSubmit(slot);
+}
+
+int sxReadPixelRows(HANDLE sxHandle, void *pixels, unsigned long rowBytes, unsigned long rows, unsigned long stride,
+                    struct t_sxusb_transfers *transfers)
+{
+    sxAsyncRead read;
+    read.handle   = sxHandle;
+    read.pixels   = (unsigned char *)pixels;
+    read.rowBytes = rowBytes;
+    read.stride   = stride;
+    read.total    = rowBytes * rows;
+    read.size     = transfers->size < BULK_PACKET_SIZE ? BULK_PACKET_SIZE : transfers->size;
+    read.size     = (read.size / BULK_PACKET_SIZE) * BULK_PACKET_SIZE;
+    read.next     = 0;
+    read.done     = 0;
+    read.inFlight = 0;
+    read.failed   = false;
+
+    bool direct = (rows == 1 || rowBytes == stride);
+    int count   = transfers->count < 1 ? 1 : transfers->count;
+    std::unique_ptr<sxAsyncSlot[]> slots(new sxAsyncSlot[count]);
+    for (int i = 0; i < count; i++)
+    {
+        slots[i].read     = &read;
+        slots[i].transfer = libusb_alloc_transfer(0);
+        slots[i].bounce   = direct ? nullptr : (unsigned char *)malloc(read.size);
+        slots[i].active   = false;
+        if (slots[i].transfer == nullptr || (!direct && slots[i].bounce == nullptr))
+            read.failed = true;
+    }
+
+    struct timeval start, end;
+    gettimeofday(&start, nullptr);
+
+    for (int i = 0; i < count && !read.failed && read.next < read.total; i++)
+        sxAsyncSubmit(&slots[i]);
+
+    bool cancelled = false;
+    while (read.inFlight > 0)
+    {
+        if (read.failed && !cancelled)
+        {
+            for (int i = 0; i < count; i++)
+                if (slots[i].active)
+                    libusb_cancel_transfer(slots[i].transfer);
+            cancelled = true;
+        }
+        struct timeval tv = { 1, 0 };
+        int rc = libusb_handle_events_timeout_completed(ctx, &tv, nullptr);
+        if (rc < 0 && rc != LIBUSB_ERROR_INTERRUPTED)
+        {
+            DEBUG(log(true, "sxReadPixelRows: libusb_handle_events -> %s\n", libusb_error_name(rc)));
+            read.failed = true;
+        }
+    }
+
+    gettimeofday(&end, nullptr);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+    transfers->throughput = elapsed > 0 ? read.done / elapsed / 1e6 : 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        libusb_free_transfer(slots[i].transfer);
+        free(slots[i].bounce);
+    }
+
+    DEBUG(log(true, "sxReadPixelRows: %lu of %lu bytes, %d x %lu bytes in flight, %.1f MB/s\n", read.done, read.total,
+              count, read.size, transfers->throughput));
+    return !read.failed && read.done == read.total;
+}
+
 int sxSetSTAR2000(HANDLE sxHandle, char star2k)
 {
     unsigned char setup_data[8];
@@ -135,6 +135,17 @@ struct t_sxccd_params
     char vclk_delay;
 };
 
+/*
+ * Asynchronous pixel download settings, count transfers of size bytes are kept in flight.
+ * throughput returns the rate of the last download in MB/s.
+ */
+struct t_sxusb_transfers
+{
+    int count;
+    int size;
+    double throughput;
+};
+
 /*
  * Prototypes.
  */
@@ -159,7 +170,9 @@ int sxExposePixels(HANDLE sxHandle, unsigned short flags, unsigned short camInde
 int sxExposePixelsGated(HANDLE sxHandle, unsigned short flags, unsigned short camIndex, unsigned short xoffset,
                         unsigned short yoffset, unsigned short width, unsigned short height, unsigned short xbin,
                         unsigned short ybin, unsigned long msec);
-int sxReadPixels(HANDLE sxHandle, void *pixels, unsigned long count);
+int sxReadPixels(HANDLE sxHandle, void *pixels, unsigned long count, struct t_sxusb_transfers *transfers = nullptr);
+int sxReadPixelRows(HANDLE sxHandle, void *pixels, unsigned long rowBytes, unsigned long rows, unsigned long stride,
+                    struct t_sxusb_transfers *transfers);
 int sxSetShutter(HANDLE sxHandle, unsigned short state);
 int sxSetTimer(HANDLE sxHandle, unsigned long msec);
 unsigned long sxGetTimer(HANDLE sxHandle);
@@ -24,6 +24,7 @@
 
 #include "config.h"
 
+#include <pixelshuffle.h>
 #include <stream/streammanager.h>
 
 #include <math.h>
@@ -2394,26 +2395,14 @@ void ToupBase::pushCallback(const void* pData, const XP(FrameInfoV2)* pInfo, int
 
         InExposure  = false;
         PrimaryCCD.setExposureLeft(0);
-        uint8_t *buffer = PrimaryCCD.getFrameBuffer();
-        uint32_t size = PrimaryCCD.getFrameBufferSize();
-
-        if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
-        {
-            size = PrimaryCCD.getXRes() * PrimaryCCD.getYRes() * 3;
-            buffer = static_cast<uint8_t*>(malloc(size));
-        }
 
         if (pData == nullptr)
         {
             LOG_ERROR("Failed to push image.");
             PrimaryCCD.setExposureFailed();
-            if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
-                free(buffer);
         }
         else
         {
-            memcpy(buffer, pData, size);
-
             if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
             {
                 std::unique_lock<std::mutex> guard(ccdBufferLock);
@@ -2424,19 +2413,12 @@ void ToupBase::pushCallback(const void* pData, const XP(FrameInfoV2)* pInfo, int
                 uint8_t *subR = image;
                 uint8_t *subG = image + width * height;
                 uint8_t *subB = image + width * height * 2;
-                int size      = width * height * 3 - 3;
 
                 // RGB to three sepearate R-frame, G-frame, and B-frame for color FITS
-                for (int i = 0; i <= size; i += 3)
-                {
-                    *subR++ = buffer[i];
-                    *subG++ = buffer[i + 1];
-                    *subB++ = buffer[i + 2];
-                }
-
-                guard.unlock();
-                free(buffer);
+                PixelShuffle::split24(reinterpret_cast<const uint8_t*>(pData), subR, subG, subB, width * height);
             }
+            else
+                memcpy(PrimaryCCD.getFrameBuffer(), pData, PrimaryCCD.getFrameBufferSize());
 
             LOGF_DEBUG("Image received. Width: %d Height: %d flag: %d timestamp: %ld"
                        , pInfo->width,
@@ -2501,8 +2483,12 @@ void ToupBase::eventPullCallBack(unsigned event)
                     PrimaryCCD.setExposureLeft(0);
                     uint8_t *buffer = PrimaryCCD.getFrameBuffer();
 
+                    // Packed RGB goes to a scratch buffer kept across exposures
                     if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
-                        buffer = static_cast<uint8_t*>(malloc(PrimaryCCD.getXRes() * PrimaryCCD.getYRes() * 3));
+                    {
+                        m_RGBBuffer.resize(PrimaryCCD.getXRes() * PrimaryCCD.getYRes() * 3);
+                        buffer = m_RGBBuffer.data();
+                    }
 
                     std::unique_lock<std::mutex> guard(ccdBufferLock);
                     HRESULT rc = FP(PullImageV2(m_CameraHandle, buffer, captureBits * m_Channels, &info));
@@ -2511,8 +2497,6 @@ void ToupBase::eventPullCallBack(unsigned event)
                     {
                         LOGF_ERROR("Failed to pull image. %s", errorCodes[rc].c_str());
                         PrimaryCCD.setExposureFailed();
-                        if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
-                            free(buffer);
                     }
                     else
                     {
@@ -2526,18 +2510,9 @@ void ToupBase::eventPullCallBack(unsigned event)
                             uint8_t *subR = image;
                             uint8_t *subG = image + width * height;
                             uint8_t *subB = image + width * height * 2;
-                            int size      = width * height * 3 - 3;
 
                             // RGB to three sepearate R-frame, G-frame, and B-frame for color FITS
-                            for (int i = 0; i <= size; i += 3)
-                            {
-                                *subR++ = buffer[i];
-                                *subG++ = buffer[i + 1];
-                                *subB++ = buffer[i + 2];
-                            }
-
-                            guard.unlock();
-                            free(buffer);
+                            PixelShuffle::split24(buffer, subR, subG, subB, width * height);
                         }
 
                         LOGF_DEBUG("Image received. Width: %d Height: %d flag: %d timestamp: %ld", info.width, info.height, info.flag,
@@ -2587,8 +2562,12 @@ void ToupBase::eventPullCallBack(unsigned event)
                     PrimaryCCD.setExposureLeft(0);
                     uint8_t *buffer = PrimaryCCD.getFrameBuffer();
 
+                    // Packed RGB goes to a scratch buffer kept across exposures
                     if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
-                        buffer = static_cast<uint8_t*>(malloc(PrimaryCCD.getXRes() * PrimaryCCD.getYRes() * 3));
+                    {
+                        m_RGBBuffer.resize(PrimaryCCD.getXRes() * PrimaryCCD.getYRes() * 3);
+                        buffer = m_RGBBuffer.data();
+                    }
 
                     std::unique_lock<std::mutex> guard(ccdBufferLock);
                     HRESULT rc = FP(PullStillImageV2(m_CameraHandle, buffer, captureBits * m_Channels, &info));
@@ -2597,8 +2576,6 @@ void ToupBase::eventPullCallBack(unsigned event)
                     {
                         LOGF_ERROR("Failed to pull image. %s", errorCodes[rc].c_str());
                         PrimaryCCD.setExposureFailed();
-                        if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
-                            free(buffer);
                     }
                     else
                     {
@@ -2612,18 +2589,9 @@ void ToupBase::eventPullCallBack(unsigned event)
                             uint8_t *subR = image;
                             uint8_t *subG = image + width * height;
                             uint8_t *subB = image + width * height * 2;
-                            int size      = width * height * 3 - 3;
 
                             // RGB to three sepearate R-frame, G-frame, and B-frame for color FITS
-                            for (int i = 0; i <= size; i += 3)
-                            {
-                                *subR++ = buffer[i];
-                                *subG++ = buffer[i + 1];
-                                *subB++ = buffer[i + 2];
-                            }
-
-                            guard.unlock();
-                            free(buffer);
+                            PixelShuffle::split24(buffer, subR, subG, subB, width * height);
                         }
 
                         LOGF_DEBUG("Image received. Width: %d Height: %d flag: %d timestamp: %ld", info.width, info.height, info.flag,
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <map>
+#include <vector>
 #include <indiccd.h>
 #include <inditimer.h>
 
@@ -659,6 +660,9 @@ class ToupBase : public INDI::CCD
         INDI_PIXEL_FORMAT m_CameraPixelFormat = INDI_RGB;
         eTriggerMode m_CurrentTriggerMode = TRIGGER_VIDEO;
 
+        // Scratch buffer for packed RGB frames pulled from the camera
+        std::vector<uint8_t> m_RGBBuffer;
+
         bool m_CanSnap { false };
         bool m_RAWFormatSupport { false };
         bool m_RAWHighDepthSupport { false };
@@ -0,0 +1,421 @@
+/*
+INDI Webcam CCD Driver - Frame Stacker
+
+Copyright (C) 2026 agent (agent@local)
+
+This driver is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "framestacker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+//These are the per sample kernels, a SIMD loop followed by a plain loop for the rest.
+
+static void accumulate8(uint32_t *stack, const uint8_t *frame, size_t samples)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(frame + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        __m128i *s = reinterpret_cast<__m128i *>(stack + i);
+        _mm_storeu_si128(s + 0, _mm_add_epi32(_mm_loadu_si128(s + 0), _mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), _mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_si128(s + 2, _mm_add_epi32(_mm_loadu_si128(s + 2), _mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_si128(s + 3, _mm_add_epi32(_mm_loadu_si128(s + 3), _mm_unpackhi_epi16(hi, zero)));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 16 <= samples; i += 16)
+    {
+        uint8x16_t v  = vld1q_u8(frame + i);
+        uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+        uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+        vst1q_u32(stack + i + 0,  vaddw_u16(vld1q_u32(stack + i + 0),  vget_low_u16(lo)));
+        vst1q_u32(stack + i + 4,  vaddw_u16(vld1q_u32(stack + i + 4),  vget_high_u16(lo)));
+        vst1q_u32(stack + i + 8,  vaddw_u16(vld1q_u32(stack + i + 8),  vget_low_u16(hi)));
+        vst1q_u32(stack + i + 12, vaddw_u16(vld1q_u32(stack + i + 12), vget_high_u16(hi)));
+    }
+#endif
+    for (; i < samples; i++)
+        stack[i] += frame[i];
+}
+
+static void accumulate16(uint32_t *stack, const uint16_t *frame, size_t samples)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(frame + i));
+        __m128i *s = reinterpret_cast<__m128i *>(stack + i);
+        _mm_storeu_si128(s + 0, _mm_add_epi32(_mm_loadu_si128(s + 0), _mm_unpacklo_epi16(v, zero)));
+        _mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), _mm_unpackhi_epi16(v, zero)));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8 <= samples; i += 8)
+    {
+        uint16x8_t v = vld1q_u16(frame + i);
+        vst1q_u32(stack + i + 0, vaddw_u16(vld1q_u32(stack + i + 0), vget_low_u16(v)));
+        vst1q_u32(stack + i + 4, vaddw_u16(vld1q_u32(stack + i + 4), vget_high_u16(v)));
+    }
+#endif
+    for (; i < samples; i++)
+        stack[i] += frame[i];
+}
+
+//This scales, rounds and clamps the stack into 8 or 16 bit samples.
+//Integer stacks must stay below 2^31, the caller limits the number of frames accordingly.
+template <typename S>
+static inline float stackValue(const S *stack, size_t i)
+{
+    return static_cast<float>(stack[i]);
+}
+
+#if defined(__SSE2__)
+static inline __m128 loadFloat(const uint32_t *stack)
+{
+    return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(stack)));
+}
+
+static inline __m128 loadFloat(const float *stack)
+{
+    return _mm_loadu_ps(stack);
+}
+
+template <typename S>
+static inline __m128i scaleRound(const S *stack, __m128 scale, __m128 max)
+{
+    __m128 f = _mm_mul_ps(loadFloat(stack), scale);
+    f = _mm_max_ps(_mm_min_ps(f, max), _mm_setzero_ps());
+    return _mm_cvtps_epi32(f);
+}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+static inline float32x4_t loadFloat(const uint32_t *stack)
+{
+    return vcvtq_f32_u32(vld1q_u32(stack));
+}
+
+static inline float32x4_t loadFloat(const float *stack)
+{
+    return vld1q_f32(stack);
+}
+
+template <typename S>
+static inline uint32x4_t scaleRound(const S *stack, float scale, float32x4_t max)
+{
+    float32x4_t f = vmulq_n_f32(loadFloat(stack), scale);
+    f = vmaxq_f32(vminq_f32(f, max), vdupq_n_f32(0));
+    // values are positive, so adding a half and truncating rounds to nearest
+    return vcvtq_u32_f32(vaddq_f32(f, vdupq_n_f32(0.5f)));
+}
+#endif
+
+template <typename S>
+static void normalize8(const S *stack, uint8_t *out, size_t samples, float scale)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 vmax   = _mm_set1_ps(255.0f);
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m128i a = _mm_packs_epi32(scaleRound(stack + i + 0, vscale, vmax), scaleRound(stack + i + 4, vscale, vmax));
+        __m128i b = _mm_packs_epi32(scaleRound(stack + i + 8, vscale, vmax), scaleRound(stack + i + 12, vscale, vmax));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(a, b));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t vmax = vdupq_n_f32(255.0f);
+    for (; i + 8 <= samples; i += 8)
+    {
+        uint16x8_t v = vcombine_u16(vqmovn_u32(scaleRound(stack + i, scale, vmax)),
+                                    vqmovn_u32(scaleRound(stack + i + 4, scale, vmax)));
+        vst1_u8(out + i, vqmovn_u16(v));
+    }
+#endif
+    for (; i < samples; i++)
+        out[i] = static_cast<uint8_t>(std::min(std::round(stackValue(stack, i) * scale), 255.0f));
+}
+
+template <typename S>
+static void normalize16(const S *stack, uint16_t *out, size_t samples, float scale)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128 vscale  = _mm_set1_ps(scale);
+    const __m128 vmax    = _mm_set1_ps(65535.0f);
+    const __m128i bias32 = _mm_set1_epi32(32768);
+    const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+    for (; i + 8 <= samples; i += 8)
+    {
+        // SSE2 has no unsigned 32 to 16 bit pack, shift into the signed range and back
+        __m128i a = _mm_sub_epi32(scaleRound(stack + i + 0, vscale, vmax), bias32);
+        __m128i b = _mm_sub_epi32(scaleRound(stack + i + 4, vscale, vmax), bias32);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_xor_si128(_mm_packs_epi32(a, b), bias16));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t vmax = vdupq_n_f32(65535.0f);
+    for (; i + 8 <= samples; i += 8)
+    {
+        vst1q_u16(out + i, vcombine_u16(vqmovn_u32(scaleRound(stack + i, scale, vmax)),
+                                        vqmovn_u32(scaleRound(stack + i + 4, scale, vmax))));
+    }
+#endif
+    for (; i < samples; i++)
+        out[i] = static_cast<uint16_t>(std::min(std::round(stackValue(stack, i) * scale), 65535.0f));
+}
+
+//This reduces the values of one sample in a block to a single value
+static float medianOf(float *values, int count)
+{
+    int middle = count / 2;
+    std::nth_element(values, values + middle, values + count);
+    float median = values[middle];
+    if (count % 2 == 0)
+        median = (median + *std::max_element(values, values + middle)) / 2;
+    return median;
+}
+
+static float sigmaClippedMeanOf(float *values, int count, float sigma)
+{
+    if (count < 3)
+    {
+        float sum = 0;
+        for (int i = 0; i < count; i++)
+            sum += values[i];
+        return sum / count;
+    }
+
+    float mean = 0, m2 = 0;
+    for (int i = 0; i < count; i++)
+    {
+        float delta = values[i] - mean;
+        mean += delta / (i + 1);
+        m2 += delta * (values[i] - mean);
+    }
+    float limit = sigma * std::sqrt(m2 / (count - 1));
+
+    // Clip around the median so a single outlier does not drag the center along
+    float center = medianOf(values, count);
+    float sum = 0;
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (std::fabs(values[i] - center) <= limit)
+        {
+            sum += values[i];
+            kept++;
+        }
+    }
+    return kept > 0 ? sum / kept : center;
+}
+
+FrameStacker::FrameStacker()
+{
+    worker = std::thread(&FrameStacker::run, this);
+}
+
+FrameStacker::~FrameStacker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    frameQueued.notify_all();
+    worker.join();
+}
+
+void FrameStacker::start(Mode newMode, size_t newSamples, int newBytesPerSample, int newBlockFrames, float newSigma)
+{
+    abort();
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    mode = newMode;
+    samples = newSamples;
+    bytesPerSample = newBytesPerSample == 2 ? 2 : 1;
+    blockFrames = std::max(newBlockFrames, 1);
+    sigma = newSigma;
+
+    size_t frameBytes = samples * bytesPerSample;
+    for (auto &slot : queue)
+        slot.resize(frameBytes);
+
+    if (mode == STACK_INTEGRATION || mode == STACK_AVERAGE)
+    {
+        integerStack.assign(samples, 0);
+        // keep the 32 bit sums below 2^31 for the float conversion of the final pass
+        maxFrames = std::numeric_limits<int32_t>::max() / (bytesPerSample == 2 ? 65535 : 255);
+    }
+    else
+    {
+        floatStack.assign(samples, 0);
+        block.resize(frameBytes * blockFrames);
+        blockValues.resize(blockFrames);
+        maxFrames = std::numeric_limits<int>::max();
+    }
+
+    framesInBlock = 0;
+    framesInStack = 0;
+}
+
+bool FrameStacker::addFrame(const void *data)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (samples == 0 || framesInStack + queueCount + (busy ? 1 : 0) >= maxFrames)
+        return false;
+
+    frameDone.wait(lock, [this] { return queueCount < QUEUE_SLOTS; });
+
+    std::vector<uint8_t> &slot = queue[(queueHead + queueCount) % QUEUE_SLOTS];
+    memcpy(slot.data(), data, slot.size());
+    queueCount++;
+
+    lock.unlock();
+    frameQueued.notify_one();
+    return true;
+}
+
+int FrameStacker::finish(void *destination)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    frameDone.wait(lock, [this] { return queueCount == 0 && !busy; });
+
+    if (framesInStack == 0)
+        return 0;
+
+    if (framesInBlock > 0)
+        reduceBlock();
+
+    // Integration keeps the sum, everything else is normalized to the mean
+    float scale = 1.0f;
+    if (mode != STACK_INTEGRATION)
+        scale = 1.0f / framesInStack;
+
+    if (mode == STACK_INTEGRATION || mode == STACK_AVERAGE)
+    {
+        if (bytesPerSample == 1)
+            normalize8(integerStack.data(), static_cast<uint8_t *>(destination), samples, scale);
+        else
+            normalize16(integerStack.data(), static_cast<uint16_t *>(destination), samples, scale);
+    }
+    else
+    {
+        if (bytesPerSample == 1)
+            normalize8(floatStack.data(), static_cast<uint8_t *>(destination), samples, scale);
+        else
+            normalize16(floatStack.data(), static_cast<uint16_t *>(destination), samples, scale);
+    }
+
+    return framesInStack;
+}
+
+void FrameStacker::abort()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    // Once the worker is not busy it is waiting for frames, so the queue can be dropped
+    frameDone.wait(lock, [this] { return !busy; });
+    queueHead = 0;
+    queueCount = 0;
+    framesInStack = 0;
+    framesInBlock = 0;
+    if (!integerStack.empty())
+        std::fill(integerStack.begin(), integerStack.end(), 0);
+    if (!floatStack.empty())
+        std::fill(floatStack.begin(), floatStack.end(), 0);
+}
+
+int FrameStacker::frames() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return framesInStack;
+}
+
+void FrameStacker::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        frameQueued.wait(lock, [this] { return quit || queueCount > 0; });
+        if (quit)
+            return;
+
+        // The slot stays reserved until the frame is stacked, the stack itself is only touched here and in finish/abort
+        const uint8_t *frame = queue[queueHead].data();
+        busy = true;
+        lock.unlock();
+
+        accumulate(frame);
+
+        lock.lock();
+        busy = false;
+        queueHead = (queueHead + 1) % QUEUE_SLOTS;
+        queueCount--;
+        framesInStack++;
+        frameDone.notify_all();
+    }
+}
+
+void FrameStacker::accumulate(const uint8_t *frame)
+{
+    if (mode == STACK_INTEGRATION || mode == STACK_AVERAGE)
+    {
+        if (bytesPerSample == 1)
+            accumulate8(integerStack.data(), frame, samples);
+        else
+            accumulate16(integerStack.data(), reinterpret_cast<const uint16_t *>(frame), samples);
+        return;
+    }
+
+    size_t frameBytes = samples * bytesPerSample;
+    memcpy(block.data() + frameBytes * framesInBlock, frame, frameBytes);
+    if (++framesInBlock == blockFrames)
+        reduceBlock();
+}
+
+//This reduces the frames in the block sample by sample and adds the result, weighted by the frame count, to the stack
+void FrameStacker::reduceBlock()
+{
+    float *values = blockValues.data();
+    const uint8_t *block8 = block.data();
+    const uint16_t *block16 = reinterpret_cast<const uint16_t *>(block.data());
+
+    for (size_t i = 0; i < samples; i++)
+    {
+        for (int f = 0; f < framesInBlock; f++)
+            values[f] = bytesPerSample == 1 ? block8[f * samples + i] : block16[f * samples + i];
+
+        float value = mode == STACK_MEDIAN ? medianOf(values, framesInBlock)
+                      : sigmaClippedMeanOf(values, framesInBlock, sigma);
+        floatStack[i] += value * framesInBlock;
+    }
+
+    framesInBlock = 0;
+}
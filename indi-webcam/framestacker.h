@@ -0,0 +1,103 @@
+/*
+INDI Webcam CCD Driver - Frame Stacker
+
+Copyright (C) 2026 agent (agent@local)
+
+This driver is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//This stacks the frames of a rapid stacking exposure on its own thread.
+//Frames are 8 or 16 bit samples, the layout does not matter since every sample is stacked on its own.
+//Integration and Average accumulate into 32 bit integers.
+//Sigma Clip and Median keep a block of frames, reduce it per sample and accumulate the result as float,
+//so memory stays bounded no matter how many frames go into the stack.
+//All buffers are kept between exposures of the same size.
+class FrameStacker
+{
+public:
+    enum Mode
+    {
+        STACK_INTEGRATION,
+        STACK_AVERAGE,
+        STACK_SIGMA_CLIP,
+        STACK_MEDIAN
+    };
+
+    FrameStacker();
+    ~FrameStacker();
+
+    //This prepares a new stack of samples values, each bytesPerSample (1 or 2) wide.
+    //blockFrames and sigma are only used by Sigma Clip and Median
+    void start(Mode mode, size_t samples, int bytesPerSample, int blockFrames = 16, float sigma = 2.5);
+
+    //This copies a frame into the queue and returns, the worker thread adds it to the stack.
+    //It only waits if the worker is behind by more frames than there are queue slots.
+    //Returns false if the frame was not added because the stack is full.
+    bool addFrame(const void *data);
+
+    //This waits for the queued frames, writes the final image to destination and returns the number of frames stacked.
+    int finish(void *destination);
+
+    //This drops the stack and any queued frames.
+    void abort();
+
+    int frames() const;
+
+private:
+    void run();
+    void accumulate(const uint8_t *frame);
+    void reduceBlock();
+
+private:
+    Mode mode = STACK_AVERAGE;
+    size_t samples = 0;
+    int bytesPerSample = 1;
+    int blockFrames = 16;
+    float sigma = 2.5;
+
+    //Integration and Average
+    std::vector<uint32_t> integerStack;
+    //Sigma Clip and Median
+    std::vector<float> floatStack;
+    std::vector<uint8_t> block;
+    std::vector<float> blockValues;
+    int framesInBlock = 0;
+
+    int framesInStack = 0;
+    int maxFrames = 0;
+
+    //Frames waiting for the worker thread
+    static const int QUEUE_SLOTS = 2;
+    std::vector<uint8_t> queue[QUEUE_SLOTS];
+    int queueHead = 0;
+    int queueCount = 0;
+    bool busy = false;
+    bool quit = false;
+
+    mutable std::mutex mutex;
+    std::condition_variable frameQueued;
+    std::condition_variable frameDone;
+    std::thread worker;
+};
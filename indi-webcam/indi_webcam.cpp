@@ -27,6 +27,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <eventloop.h>
+#include <pixelshuffle.h>
 
 #include "indi_webcam.h"
 #ifdef __cplusplus
@@ -193,7 +194,7 @@ indi_webcam::indi_webcam()
     frameRate = 30;
     videoSize = "640x480";
     webcamStacking = false;
-    averaging = false;
+    stackingMode = FrameStacker::STACK_AVERAGE;
     outputFormat = "8 bit RGB";
 
     protocol = "HTTP";
@@ -520,15 +521,24 @@ bool indi_webcam::initProperties()
     CaptureFormat rgb = {"INDI_RGB", "RGB", 8, true};
     addCaptureFormat(rgb);
 
-    RapidStacking = new ISwitch[3];
+    RapidStacking = new ISwitch[5];
     IUFillSwitch(&RapidStacking[0], "Integration", "Integration", ISS_OFF);
     IUFillSwitch(&RapidStacking[1], "Average", "Average", ISS_OFF);
-    IUFillSwitch(&RapidStacking[2], "Off", "Off", ISS_ON);
+    IUFillSwitch(&RapidStacking[2], "Sigma Clip", "Sigma Clip", ISS_OFF);
+    IUFillSwitch(&RapidStacking[3], "Median", "Median", ISS_OFF);
+    IUFillSwitch(&RapidStacking[4], "Off", "Off", ISS_ON);
 
-    IUFillSwitchVector(&RapidStackingSelection, RapidStacking, 3, getDeviceName(), "RAPID_STACKING_OPTION", "Rapid Stacking",
+    IUFillSwitchVector(&RapidStackingSelection, RapidStacking, 5, getDeviceName(), "RAPID_STACKING_OPTION", "Rapid Stacking",
                        MAIN_CONTROL_TAB, IP_RW, ISR_1OFMANY, 60, IPS_IDLE);
     defineProperty(&RapidStackingSelection);
 
+    //Sigma Clip and Median work on blocks of frames, the block results are averaged
+    IUFillNumber(&StackOptionsT[0], "BLOCK_FRAMES", "Block Frames", "%.0f", 3, 64, 1, 16);
+    IUFillNumber(&StackOptionsT[1], "SIGMA", "Sigma", "%.1f", 0.5, 10, 0.5, 2.5);
+    IUFillNumberVector(&StackOptionsTP, StackOptionsT, NARRAY(StackOptionsT), getDeviceName(), "STACK_OPTIONS",
+                       "Stacking", OPTIONS_TAB, IP_RW, 0, IPS_IDLE);
+    defineProperty(&StackOptionsTP);
+
     OutputFormats = new ISwitch[3];
     IUFillSwitch(&OutputFormats[0], "16 bit Grayscale", "16 bit Grayscale", ISS_OFF);
     IUFillSwitch(&OutputFormats[1], "16 bit RGB", "16 bit RGB", ISS_OFF);
@@ -667,6 +677,7 @@ bool indi_webcam::initProperties()
     SetCCDCapability(cap);
 
     loadConfig(true, RapidStackingSelection.name);
+    loadConfig(true, StackOptionsTP.name);
     loadConfig(true, OutputFormatSelection.name);
     loadConfig(true, PixelSizeTP.name);
     loadConfig(true, InputOptionsTP.name);
@@ -897,6 +908,14 @@ bool indi_webcam::ISNewNumber (const char *dev, const char *name, double values[
         return true;
     }
 
+    if (!strcmp(name, StackOptionsTP.name) )
+    {
+        IUUpdateNumber(&StackOptionsTP, values, names, n);
+        StackOptionsTP.s = IPS_OK;
+        IDSetNumber (&StackOptionsTP, nullptr);
+        return true;
+    }
+
     if (!strcmp(name, TimeoutOptionsTP.name) )
     {
         IUUpdateNumber(&TimeoutOptionsTP, values, names, n);
@@ -1042,17 +1061,26 @@ bool indi_webcam::ISNewSwitch (const char *dev, const char *name, ISState *state
             if(!strcmp(sp->name, "Integration"))
             {
                 webcamStacking = true;
-                averaging = false;
+                stackingMode = FrameStacker::STACK_INTEGRATION;
             }
             if(!strcmp(sp->name, "Average"))
             {
                 webcamStacking = true;
-                averaging = true;
+                stackingMode = FrameStacker::STACK_AVERAGE;
+            }
+            if(!strcmp(sp->name, "Sigma Clip"))
+            {
+                webcamStacking = true;
+                stackingMode = FrameStacker::STACK_SIGMA_CLIP;
+            }
+            if(!strcmp(sp->name, "Median"))
+            {
+                webcamStacking = true;
+                stackingMode = FrameStacker::STACK_MEDIAN;
             }
             if(!strcmp(sp->name, "Off"))
             {
                 webcamStacking = false;
-                averaging = false;
             }
             RapidStackingSelection.s = IPS_OK;
             IDSetSwitch(&RapidStackingSelection, nullptr);
@@ -1233,14 +1261,6 @@ bool indi_webcam::StartExposure(float duration)
         return false;
     }
 
-    //This resets the stack buffer
-    if(webcamStacking)
-    {
-        if(stackBuffer)
-            free(stackBuffer);
-        stackBuffer = nullptr;
-    }
-
     //This sets up the output format for the exposure
     if(outputFormat == "16 bit RGB")
     {
@@ -1273,6 +1293,11 @@ bool indi_webcam::StartExposure(float duration)
         return false;
     }
 
+    //This resets the stack, the frames are stacked as they come in on the stacker's thread
+    if(webcamStacking)
+        stacker.start(stackingMode, numBytes / (PrimaryCCD.getBPP() / 8), PrimaryCCD.getBPP() / 8,
+                      StackOptionsT[0].value, StackOptionsT[1].value);
+
     //This will ensure that we get the current frame, not some old frame still in the buffer
     if(!flush_frame_buffer())
         DEBUG(INDI::Logger::DBG_SESSION, "FFMPEG Issue in flushing buffer");
@@ -1299,8 +1324,7 @@ bool indi_webcam::StartExposure(float duration)
 
 bool indi_webcam::AbortExposure()
 {
-    if(stackBuffer)
-        free(stackBuffer);
+    stacker.abort();
     InExposure = false;
     return true;
 }
@@ -1370,12 +1394,13 @@ bool indi_webcam::grabImage()
 {
     if(getStreamFrame())
     {
-        if(PrimaryCCD.getNAxis() == 3)
+        //Stacked frames are converted to Fits RGB once, when the stack is done
+        if(webcamStacking)
+            addToStack();
+        else if(PrimaryCCD.getNAxis() == 3)
             convertINDI_RGBtoFITS_RGB(pFrameOUT->data[0], PrimaryCCD.getFrameBuffer());
         else
             memcpy(PrimaryCCD.getFrameBuffer(), pFrameOUT->data[0], numBytes);
-        if(webcamStacking)
-            addToStack();
         gotAnImageAlready = true;
     }
     else
@@ -1390,95 +1415,32 @@ bool indi_webcam::grabImage()
 //This adds each image to the running stack
 bool indi_webcam::addToStack()
 {
-    if(!stackBuffer)
-    {
-        stackBuffer = (float *)malloc(numBytes * sizeof(float_t));
-        numberOfFramesInStack = 0;
-    }
-
-    int w = pCodecCtx->width  * ((PrimaryCCD.getNAxis() == 3) ? 3 : 1);
-    int h = pCodecCtx->height;
-
-    for (int i = 0; i < w * h; i++)
+    if(!stacker.addFrame(pFrameOUT->data[0]))
     {
-        int x = i % w;
-        int y = i / w;
-        if(x >= 0 && y >= 0 && x < w && y < h)
-        {
-            if(numberOfFramesInStack == 0)
-                stackBuffer[i] = getImageDataFloatValue(x, y);
-            else
-                stackBuffer[i] += getImageDataFloatValue(x, y);
-        }
+        LOG_DEBUG("Stack is full, frame dropped.");
+        return false;
     }
-    numberOfFramesInStack++;
     return true;
 }
 
-//This gets the pixel value at an x, y position in the image
-float indi_webcam::getImageDataFloatValue(int x, int y)
-{
-    int w = pCodecCtx->width  * ((PrimaryCCD.getNAxis() == 3) ? 3 : 1);
-    uint8_t *primaryBuffer = PrimaryCCD.getFrameBuffer();
-    if(PrimaryCCD.getBPP() == 8)
-        return (float) primaryBuffer[y * w + x];
-    else if(PrimaryCCD.getBPP() == 16)
-    {
-        uint16_t *newBuffer = reinterpret_cast<uint16_t *>(primaryBuffer);
-        return (float) newBuffer[y * w + x];
-    }
-    else
-        return 0;
-}
-//This sets the pixel value at an x, y position in the image
-void indi_webcam::setImageDataValueFromFloat(int x, int y, float value, bool roundAnswer)
-{
-    uint8_t *primaryBuffer = PrimaryCCD.getFrameBuffer();
-    int w = pCodecCtx->width * ((PrimaryCCD.getNAxis() == 3) ? 3 : 1);
-    if(!stackBuffer)
-        return;
-    if(PrimaryCCD.getBPP() == 8)
-    {
-        int max = std::numeric_limits<uint8_t>::max();
-        if (value > max)
-            value = max;
-        if(roundAnswer)
-            primaryBuffer[y * w + x] = round(value);
-        else
-            primaryBuffer[y * w + x] = value;
-    }
-    else if(PrimaryCCD.getBPP() == 16)
-    {
-        int max = std::numeric_limits<uint16_t>::max();
-        if (value > max)
-            value = max;
-        uint16_t *newBuffer = reinterpret_cast<uint16_t *>(primaryBuffer);
-        if(roundAnswer)
-            newBuffer[y * w + x] = round(value);
-        else
-            newBuffer[y * w + x] = value;
-    }
-}
-
 //This will take the final image stack and copy it back to the primary buffer for final download.
 void indi_webcam::copyFinalStackToPrimaryFrameBuffer()
 {
-    int w = pCodecCtx->width  * ((PrimaryCCD.getNAxis() == 3) ? 3 : 1);
-    int h = pCodecCtx->height;
-    for (int i = 0; i < w * h; i++)
+    int frames = 0;
+    if(PrimaryCCD.getNAxis() == 3)
     {
-        int x = i % w;
-        int y = i / w;
-        if(x >= 0 && y >= 0 && x < w && y < h)
-        {
-            if(averaging)
-                setImageDataValueFromFloat(x, y, round(stackBuffer[i] / numberOfFramesInStack), true);
-            else //Integrating
-                setImageDataValueFromFloat(x, y, round(stackBuffer[i]), true);
-        }
+        stackedImage.resize(numBytes);
+        frames = stacker.finish(stackedImage.data());
+        if(frames > 0)
+            convertINDI_RGBtoFITS_RGB(stackedImage.data(), PrimaryCCD.getFrameBuffer());
     }
+    else
+        frames = stacker.finish(PrimaryCCD.getFrameBuffer());
 
-    LOGF_INFO("Final Image is a stack of %u exposures.", numberOfFramesInStack);
+    if(frames == 0)
+        LOG_WARN("No frames were stacked.");
+    else
+        LOGF_INFO("Final Image is a stack of %d exposures.", frames);
 }
 
 //This will crop the image to a subframe if desired.
@@ -1685,32 +1647,14 @@ bool indi_webcam::convertINDI_RGBtoFITS_RGB(uint8_t *originalImage, uint8_t *con
     if(PrimaryCCD.getBPP() == 8)
     {
         int size =  numBytes / 3;
-        uint8_t *r, *g, *b;
-        r = (convertedImage);
-        g = (convertedImage + size);
-        b = (convertedImage + size * 2);
-        for(int i = 0; i < numBytes; i += 3)
-        {
-            *r++ = *originalImage++;
-            *g++ = *originalImage++;
-            *b++ = *originalImage++;
-        }
+        PixelShuffle::split24(originalImage, convertedImage, convertedImage + size, convertedImage + size * 2, size);
     }
     else if(PrimaryCCD.getBPP() == 16)
     {
         uint16_t *bigOriginalImage = reinterpret_cast<uint16_t *>(originalImage);
         uint16_t *bigConvertedImage = reinterpret_cast<uint16_t *>(convertedImage);
         int size =  numBytes / 2 / 3;
-        uint16_t *r, *g, *b;
-        r = (bigConvertedImage);
-        g = (bigConvertedImage + size);
-        b = (bigConvertedImage + size * 2);
-        for(int i = 0; i < numBytes / 2; i += 3)
-        {
-            *r++ = *bigOriginalImage++;
-            *g++ = *bigOriginalImage++;
-            *b++ = *bigOriginalImage++;
-        }
+        PixelShuffle::split48(bigOriginalImage, bigConvertedImage, bigConvertedImage + size, bigConvertedImage + size * 2, size);
     }
     return true;
 }
@@ -1911,6 +1855,7 @@ bool indi_webcam::saveConfigItems(FILE *fp)
     INDI::CCD::saveConfigItems(fp);
     IUSaveConfigSwitch(fp, &CaptureDeviceSelection);
     IUSaveConfigSwitch(fp, &RapidStackingSelection);
+    IUSaveConfigNumber(fp, &StackOptionsTP);
     IUSaveConfigSwitch(fp, &OutputFormatSelection);
     IUSaveConfigSwitch(fp, &OnlineProtocolSelection);
     IUSaveConfigNumber(fp, &PixelSizeTP);
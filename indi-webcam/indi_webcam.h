@@ -44,6 +44,8 @@ extern "C" {
 //#include <ctime>
 #include <thread>
 
+#include "framestacker.h"
+
 //These are required to check for AVFoundation Devices
 //The reason is that we have to print and parse the output
 //These can't be in indi_webcam class declaration because the callback method has to be passed to FFMpeg
@@ -117,15 +119,11 @@ private:
     bool webcamStacking = false;
     bool gotAnImageAlready = false;
     bool loadingSettings = false;
-    bool averaging = false;
-    float *stackBuffer = nullptr;
-    int numberOfFramesInStack = 0;
+    FrameStacker::Mode stackingMode = FrameStacker::STACK_AVERAGE;
+    FrameStacker stacker;
+    std::vector<uint8_t> stackedImage;
     bool addToStack();
     void copyFinalStackToPrimaryFrameBuffer();
-    void setImageDataValueFromFloat(int x, int y, float value, bool roundAnswer);
-    void setRGBImageDataValueFromFloat(int x, int y, int channel, float value, bool roundAnswer);
-    float getImageDataFloatValue(int x, int y);
-    float getRGBImageDataFloatValue(int x, int y, int channel);
 
     //These are our device capture settings
     bool use16Bit = true;
@@ -185,6 +183,8 @@ private:
     INumberVectorProperty PixelSizeTP;
     INumber VideoAdjustmentsT[3] {};
     INumberVectorProperty VideoAdjustmentsTP;
+    INumber StackOptionsT[2] {};
+    INumberVectorProperty StackOptionsTP;
 
 
     //Webcam setup, release, and frame capture
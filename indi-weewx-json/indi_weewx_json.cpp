@@ -25,35 +25,11 @@
 #include "indi_weewx_json.h"
 #include "config.h"
 
-#include <curl/curl.h>
-
+#include <cmath>
 #include <memory>
 #include <cstring>
 #include <string>
 
-struct response_t
-{
-    char *response;
-    size_t size;
-};
-
-static size_t cb(void *data, size_t size, size_t nmemb, void *userp)
-{
-    size_t realsize        = size * nmemb;
-    struct response_t *mem = (struct response_t *)userp;
-
-    char *ptr = (char *)realloc(mem->response, mem->size + realsize + 1);
-    if (ptr == NULL)
-        return 0; /* out of memory! */
-
-    mem->response = ptr;
-    memcpy(&(mem->response[mem->size]), data, realsize);
-    mem->size += realsize;
-    mem->response[mem->size] = 0;
-
-    return realsize;
-}
-
 // We declare an auto pointer to WeewxJSON.
 std::unique_ptr<WeewxJSON> weewx_json(new WeewxJSON());
 
@@ -78,6 +54,9 @@ bool WeewxJSON::Connect()
 
 bool WeewxJSON::Disconnect()
 {
+    fetcher.stop();
+    published.clear();
+    lastRequest = std::chrono::steady_clock::time_point();
     return true;
 }
 
@@ -155,151 +134,57 @@ bool WeewxJSON::ISNewText(const char *dev, const char *name, char *texts[], char
     return INDI::Weather::ISNewText(dev, name, texts, names, n);
 }
 
-void WeewxJSON::handleTemperatureData(json value, std::string key)
-{
-    double temperatureValue = 0.0;
-    std::string units;
-
-    value["value"].get_to(temperatureValue);
-    value["units"].get_to(units);
-
-    if (strcmp(units.c_str(), "°F") == 0)
-    {
-        temperatureValue = (temperatureValue - 32.0) * 5.0 / 9.0;
-    }
-
-    setParameterValue(key, temperatureValue);
-}
-
-void WeewxJSON::handleRawData(json value, std::string key)
-{
-    double rawValue = 0.0;
-
-    value["value"].get_to(rawValue);
-
-    setParameterValue(key, rawValue);
-}
-
-void WeewxJSON::handleBarometerData(json value, std::string key)
-{
-    double pressureValue = 0.0;
-    std::string units;
-
-    value["value"].get_to(pressureValue);
-    value["units"].get_to(units);
-
-    if (strcmp(units.c_str(), "inHg") == 0)
-    {
-        pressureValue = pressureValue * 33.864;
-    }
-
-    setParameterValue(key, pressureValue);
-}
-
-void WeewxJSON::handleWindSpeedData(json value, std::string key)
-{
-    double speedValue = 0.0;
-    std::string units;
-
-    value["value"].get_to(speedValue);
-    value["units"].get_to(units);
-
-    if (strcmp(units.c_str(), "mph") == 0)
-    {
-        speedValue = speedValue * 1.609;
-    }
-
-    setParameterValue(key, speedValue);
-}
-
-void WeewxJSON::handleRainRateData(json value, std::string key)
-{
-    double rainRate = 0.0;
-    std::string units;
-
-    value["value"].get_to(rainRate);
-    value["units"].get_to(units);
-
-    if (strcmp(units.c_str(), "in/hr") == 0)
-    {
-        rainRate = rainRate * 25.4;
-    }
-
-    setParameterValue(key, rainRate);
-}
-
-void WeewxJSON::handleWeatherData(json value)
-{
-    if (value.contains("temperature"))
-        handleTemperatureData(value["temperature"], "WEATHER_TEMPERATURE");
-    if (value.contains("dewpoint"))
-        handleTemperatureData(value["dewpoint"], "WEATHER_DEW_POINT");
-    if (value.contains("humidity"))
-        handleRawData(value["humidity"], "WEATHER_HUMIDITY");
-    if (value.contains("heat index"))
-        handleTemperatureData(value["heat index"], "WEATHER_HEAT_INDEX");
-    if (value.contains("barometer"))
-        handleBarometerData(value["barometer"], "WEATHER_BAROMETER");
-    if (value.contains("wind speed"))
-        handleWindSpeedData(value["wind speed"], "WEATHER_WIND_SPEED");
-    if (value.contains("wind gust"))
-        handleWindSpeedData(value["wind gust"], "WEATHER_WIND_GUST");
-    if (value.contains("wind direction"))
-        handleRawData(value["wind direction"], "WEATHER_WIND_DIRECTION");
-    if (value.contains("wind chill"))
-        handleTemperatureData(value["wind chill"], "WEATHER_WIND_CHILL");
-    if (value.contains("rain rate"))
-        handleRainRateData(value["rain rate"], "WEATHER_RAIN_RATE");
-}
-
 IPState WeewxJSON::updateWeather()
 {
-    if (isDebug())
-        IDLog("%s: updateWeather()\n", getDeviceName());
-
-    CURL *curl;
-    CURLcode res;
-
-    curl = curl_easy_init();
-    if (curl)
+    WeewxFetcher::Report report;
+    if (!fetcher.result(report))
     {
-        struct response_t chunk = { .response = nullptr, .size = 0 };
-
-        curl_easy_setopt(curl, CURLOPT_URL, weewxJsonUrl[WEEWX_URL].text);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, cb);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &chunk);
-
-        res = curl_easy_perform(curl);
-        curl_easy_cleanup(curl);
-
-        if (res == CURLcode::CURLE_OK)
+        // Nothing new yet, fetch again once the update period is over
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - lastRequest;
+        if (!fetcher.busy() && (lastRequest == std::chrono::steady_clock::time_point() || elapsed.count() >= UpdatePeriodN[0].value))
         {
-            nlohmann::json report = nlohmann::json::parse(chunk.response);
-
-            if (report.contains("current"))
+            if (weewxJsonUrl[WEEWX_URL].text == nullptr || weewxJsonUrl[WEEWX_URL].text[0] == '\0')
             {
-                handleWeatherData(report["current"]);
-            }
-            else
-            {
-                LOG_ERROR("No current weather data found in report.");
+                LOG_ERROR("Weewx JSON URL is not set.");
                 return IPS_ALERT;
             }
 
-            return IPS_OK;
+            LOGF_DEBUG("Requesting report from %s", weewxJsonUrl[WEEWX_URL].text);
+            fetcher.request(weewxJsonUrl[WEEWX_URL].text);
+            lastRequest = std::chrono::steady_clock::now();
         }
-        else
-        {
-            LOGF_ERROR("HTTP request to %s failed.", weewxJsonUrl[WEEWX_URL].text);
+        return IPS_BUSY;
+    }
+
+    switch (report.status)
+    {
+        case WeewxFetcher::Report::REPORT_ERROR:
+            LOGF_ERROR("HTTP request to %s failed: %s", weewxJsonUrl[WEEWX_URL].text, report.error.c_str());
             return IPS_ALERT;
-        }
+
+        case WeewxFetcher::Report::REPORT_NOT_MODIFIED:
+            LOG_DEBUG("Weather report not modified.");
+            return IPS_OK;
+
+        case WeewxFetcher::Report::REPORT_OK:
+            break;
     }
-    else
+
+    int changed = 0;
+    for (const auto &value : report.values)
     {
-        LOGF_ERROR("Cannot initialize CURL, connection to HTTP server %s failed.", weewxJsonUrl[WEEWX_URL].text);
-        return IPS_ALERT;
+        auto last = published.find(value.first);
+        if (last != published.end() && std::fabs(last->second - value.second) < 1e-9)
+            continue;
+
+        setParameterValue(value.first, value.second);
+        published[value.first] = value.second;
+        changed++;
     }
 
+    LOGF_DEBUG("Weather report: %d parameter(s) changed.", changed);
+
+    // Unchanged parameters keep their last value, the report itself was fetched fine
     return IPS_OK;
 }
 
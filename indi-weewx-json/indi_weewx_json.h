@@ -25,11 +25,14 @@
 
 #pragma once
 
+#include "weewx_fetcher.h"
+
 #include <libindi/indiweather.h>
 #include <libindi/indipropertytext.h>
-#include <libindi/json.h>
 
-using json = nlohmann::json;
+#include <chrono>
+#include <map>
+#include <string>
 
 class WeewxJSON : public INDI::Weather
 {
@@ -48,13 +51,6 @@ class WeewxJSON : public INDI::Weather
     virtual bool ISNewText(const char *dev, const char *name, char *texts[], char *names[], int n) override;
 
   protected:
-    void handleTemperatureData(json value, std::string key);
-    void handleRawData(json value, std::string key);
-    void handleBarometerData(json value, std::string key);
-    void handleWindSpeedData(json value, std::string key);
-    void handleRainRateData(json value, std::string key);
-    void handleWeatherData(json value);
-
     virtual IPState updateWeather() override;
 
     virtual bool saveConfigItems(FILE *fp) override;
@@ -65,4 +61,10 @@ class WeewxJSON : public INDI::Weather
     {
         WEEWX_URL,
     };
+
+    // Reports are fetched and parsed in the background, updateWeather() only picks them up.
+    WeewxFetcher fetcher;
+    std::chrono::steady_clock::time_point lastRequest;
+    // Values as last published, only changes are set
+    std::map<std::string, double> published;
 };
@@ -0,0 +1,317 @@
+/*******************************************************************************
+  Copyright(c) 2022 Rick Bassham. All rights reserved.
+
+  INDI WeeWx JSON Weather Driver
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to
+  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  Boston, MA 02110-1301, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+*******************************************************************************/
+
+#include "weewx_fetcher.h"
+
+#include <libindi/json.h>
+
+#include <cstring>
+#include <strings.h>
+
+using json = nlohmann::json;
+
+// Seconds, a server that does not answer within this is reported as failed
+#define WEEWX_CONNECT_TIMEOUT 5
+#define WEEWX_TIMEOUT         15
+
+WeewxFetcher::WeewxFetcher()
+{
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+}
+
+WeewxFetcher::~WeewxFetcher()
+{
+    stop();
+}
+
+bool WeewxFetcher::request(const std::string &url)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (pending || ready)
+        return false;
+
+    this->url = url;
+    pending = true;
+    if (!thread.joinable())
+        thread = std::thread(&WeewxFetcher::run, this);
+    lock.unlock();
+
+    condition.notify_one();
+    return true;
+}
+
+bool WeewxFetcher::busy()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending || ready;
+}
+
+bool WeewxFetcher::result(Report &report)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!ready)
+        return false;
+
+    report = std::move(this->report);
+    ready = false;
+    return true;
+}
+
+void WeewxFetcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    condition.notify_all();
+    if (thread.joinable())
+        thread.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    quit = pending = ready = false;
+}
+
+void WeewxFetcher::run()
+{
+    curl = curl_easy_init();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        condition.wait(lock, [this]()
+        {
+            return quit || pending;
+        });
+        if (quit)
+            break;
+
+        std::string target = url;
+        lock.unlock();
+
+        Report next;
+        fetch(target, next);
+
+        lock.lock();
+        report = std::move(next);
+        pending = false;
+        ready = true;
+    }
+    lock.unlock();
+
+    if (curl)
+        curl_easy_cleanup(curl);
+    curl = nullptr;
+}
+
+void WeewxFetcher::fetch(const std::string &target, Report &next)
+{
+    if (curl == nullptr)
+    {
+        next.error = "Cannot initialize CURL";
+        return;
+    }
+
+    // Validators belong to the report they came with
+    if (target != lastUrl)
+    {
+        etag.clear();
+        lastBody.clear();
+        lastModified = -1;
+        lastUrl = target;
+    }
+
+    body.clear();
+    std::string newEtag;
+
+    curl_easy_setopt(curl, CURLOPT_URL, target.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &newEtag);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, static_cast<long>(WEEWX_CONNECT_TIMEOUT));
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, static_cast<long>(WEEWX_TIMEOUT));
+    curl_easy_setopt(curl, CURLOPT_FILETIME, 1L);
+
+    struct curl_slist *headers = nullptr;
+    if (!etag.empty())
+        headers = curl_slist_append(headers, ("If-None-Match: " + etag).c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+    if (lastModified >= 0)
+    {
+        curl_easy_setopt(curl, CURLOPT_TIMECONDITION, static_cast<long>(CURL_TIMECOND_IFMODSINCE));
+        curl_easy_setopt(curl, CURLOPT_TIMEVALUE, lastModified);
+    }
+    else
+        curl_easy_setopt(curl, CURLOPT_TIMECONDITION, static_cast<long>(CURL_TIMECOND_NONE));
+
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr);
+    curl_slist_free_all(headers);
+
+    if (res != CURLE_OK)
+    {
+        next.error = curl_easy_strerror(res);
+        return;
+    }
+
+    long code = 0, unmet = 0, filetime = -1;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+    curl_easy_getinfo(curl, CURLINFO_CONDITION_UNMET, &unmet);
+    curl_easy_getinfo(curl, CURLINFO_FILETIME, &filetime);
+
+    // curl also reports an unmet time condition on servers answering 200 to it
+    if (code == 304 || unmet)
+    {
+        next.status = Report::REPORT_NOT_MODIFIED;
+        return;
+    }
+
+    // Anything but HTTP (e.g. file://) has no status code
+    if (code != 0 && code != 200)
+    {
+        next.error = "HTTP status " + std::to_string(code);
+        return;
+    }
+
+    etag = newEtag;
+    lastModified = filetime;
+
+    if (body == lastBody)
+    {
+        next.status = Report::REPORT_NOT_MODIFIED;
+        return;
+    }
+
+    if (!parse(body, next.values, next.error))
+        return;
+
+    lastBody = body;
+    next.status = Report::REPORT_OK;
+}
+
+size_t WeewxFetcher::writeCallback(char *data, size_t size, size_t nmemb, void *userp)
+{
+    static_cast<std::string *>(userp)->append(data, size * nmemb);
+    return size * nmemb;
+}
+
+size_t WeewxFetcher::headerCallback(char *data, size_t size, size_t nmemb, void *userp)
+{
+    const size_t length = size * nmemb;
+    if (length > 5 && strncasecmp(data, "ETag:", 5) == 0)
+    {
+        std::string value(data + 5, length - 5);
+        size_t first = value.find_first_not_of(" \t");
+        size_t last  = value.find_last_not_of(" \t\r\n");
+        *static_cast<std::string *>(userp) = (first == std::string::npos) ? "" : value.substr(first, last - first + 1);
+    }
+    return length;
+}
+
+static double temperatureValue(const json &value)
+{
+    double temperature = value["value"].get<double>();
+    if (value.value("units", std::string()) == "°F")
+        temperature = (temperature - 32.0) * 5.0 / 9.0;
+    return temperature;
+}
+
+static double rawValue(const json &value)
+{
+    return value["value"].get<double>();
+}
+
+static double barometerValue(const json &value)
+{
+    double pressure = value["value"].get<double>();
+    if (value.value("units", std::string()) == "inHg")
+        pressure = pressure * 33.864;
+    return pressure;
+}
+
+static double windSpeedValue(const json &value)
+{
+    double speed = value["value"].get<double>();
+    if (value.value("units", std::string()) == "mph")
+        speed = speed * 1.609;
+    return speed;
+}
+
+static double rainRateValue(const json &value)
+{
+    double rainRate = value["value"].get<double>();
+    if (value.value("units", std::string()) == "in/hr")
+        rainRate = rainRate * 25.4;
+    return rainRate;
+}
+
+bool WeewxFetcher::parse(const std::string &body, std::map<std::string, double> &values, std::string &error)
+{
+    static const struct
+    {
+        const char *key;
+        const char *parameter;
+        double (*convert)(const json &);
+    } fields[] =
+    {
+        { "temperature", "WEATHER_TEMPERATURE", temperatureValue },
+        { "dewpoint", "WEATHER_DEW_POINT", temperatureValue },
+        { "humidity", "WEATHER_HUMIDITY", rawValue },
+        { "heat index", "WEATHER_HEAT_INDEX", temperatureValue },
+        { "barometer", "WEATHER_BAROMETER", barometerValue },
+        { "wind speed", "WEATHER_WIND_SPEED", windSpeedValue },
+        { "wind gust", "WEATHER_WIND_GUST", windSpeedValue },
+        { "wind direction", "WEATHER_WIND_DIRECTION", rawValue },
+        { "wind chill", "WEATHER_WIND_CHILL", temperatureValue },
+        { "rain rate", "WEATHER_RAIN_RATE", rainRateValue },
+    };
+
+    try
+    {
+        json report = json::parse(body);
+        if (!report.contains("current"))
+        {
+            error = "No current weather data found in report.";
+            return false;
+        }
+
+        const json &current = report["current"];
+        for (const auto &field : fields)
+        {
+            // WeeWX reports missing sensor values as null
+            if (current.contains(field.key) && current[field.key].contains("value") && !current[field.key]["value"].is_null())
+                values[field.parameter] = field.convert(current[field.key]);
+        }
+    }
+    catch (json::exception &e)
+    {
+        error = std::string("Invalid report: ") + e.what();
+        return false;
+    }
+
+    return true;
+}
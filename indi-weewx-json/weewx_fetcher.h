@@ -0,0 +1,99 @@
+/*******************************************************************************
+  Copyright(c) 2022 Rick Bassham. All rights reserved.
+
+  INDI WeeWx JSON Weather Driver
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to
+  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  Boston, MA 02110-1301, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+*******************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <curl/curl.h>
+
+/*
+ * Fetches and parses WeeWX JSON reports on a thread of its own, so a slow server never
+ * stalls the INDI event loop.
+ *
+ * One curl handle is kept for the lifetime of the fetcher, so the connection to the server
+ * stays open between polls. The ETag and Last-Modified of the last report are sent back as
+ * If-None-Match and If-Modified-Since: a server that supports them answers 304 and the report
+ * is not transferred nor parsed again. A report identical to the last one counts as unchanged
+ * as well.
+ */
+class WeewxFetcher
+{
+    public:
+        struct Report
+        {
+            enum Status
+            {
+                REPORT_OK,
+                REPORT_NOT_MODIFIED,
+                REPORT_ERROR
+            } status { REPORT_ERROR };
+
+            // Weather parameter name -> value in INDI units
+            std::map<std::string, double> values;
+            std::string error;
+        };
+
+        WeewxFetcher();
+        ~WeewxFetcher();
+
+        // Starts fetching url in the background, false if a fetch is still running.
+        bool request(const std::string &url);
+
+        // True while a fetch is running or its report was not taken yet.
+        bool busy();
+
+        // Takes the report of the last fetch, false if there is none (yet).
+        bool result(Report &report);
+
+        void stop();
+
+        // Converts the "current" section of a WeeWX JSON report to INDI parameters.
+        static bool parse(const std::string &body, std::map<std::string, double> &values, std::string &error);
+
+    private:
+        void run();
+        void fetch(const std::string &url, Report &report);
+
+        static size_t writeCallback(char *data, size_t size, size_t nmemb, void *userp);
+        static size_t headerCallback(char *data, size_t size, size_t nmemb, void *userp);
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::thread thread;
+        bool quit { false };
+        bool pending { false };
+        bool ready { false };
+        std::string url;
+        Report report;
+
+        // Fetch thread only
+        CURL *curl { nullptr };
+        std::string lastUrl, etag, body, lastBody;
+        long lastModified { -1 };
+};
@@ -0,0 +1,519 @@
+/*
+    Pixel Shuffle - packed RGB channel swap and planar split kernels
+
+    Shared by the camera drivers that receive interleaved RGB frames and have to
+    hand them either to the streamer (RGB order) or to FITS (planar R, G, B).
+    Header only, kernels are selected at runtime (SSSE3/AVX2 on x86, NEON on ARM)
+    and fall back to plain loops elsewhere. No memory is allocated.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIXELSHUFFLE_X86
+#include <immintrin.h>
+#define PIXELSHUFFLE_TARGET(isa) __attribute__((target(isa)))
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__)
+#define PIXELSHUFFLE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace PixelShuffle
+{
+
+enum Isa
+{
+    ISA_SCALAR,
+    ISA_SSSE3,
+    ISA_AVX2,
+    ISA_NEON,
+    ISA_COUNT
+};
+
+/** Kernel set for one instruction set. Element size is 1 byte for *24 and 2 bytes for *48. */
+struct Kernels
+{
+    /** In-place R <-> B swap of packed 3-channel pixels */
+    void (*swapRB24)(uint8_t *data, size_t pixels);
+    void (*swapRB48)(uint16_t *data, size_t pixels);
+
+    /** Deinterleave packed 3-channel pixels into three planes, plane N receives channel N */
+    void (*split24)(const uint8_t *src, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, size_t pixels);
+    void (*split48)(const uint16_t *src, uint16_t *dst0, uint16_t *dst1, uint16_t *dst2, size_t pixels);
+};
+
+namespace Detail
+{
+
+/* Scalar reference kernels, also used for the tail of the SIMD ones */
+
+template <typename T>
+inline void swapScalar(T *data, size_t pixels)
+{
+    for (T *end = data + pixels * 3; data != end; data += 3)
+        std::swap(data[0], data[2]);
+}
+
+template <typename T>
+inline void splitScalar(const T *src, T *dst0, T *dst1, T *dst2, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; ++i)
+    {
+        *dst0++ = *src++;
+        *dst1++ = *src++;
+        *dst2++ = *src++;
+    }
+}
+
+inline void swapRB24Scalar(uint8_t *data, size_t pixels)
+{
+    swapScalar(data, pixels);
+}
+
+inline void swapRB48Scalar(uint16_t *data, size_t pixels)
+{
+    swapScalar(data, pixels);
+}
+
+inline void split24Scalar(const uint8_t *src, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, size_t pixels)
+{
+    splitScalar(src, dst0, dst1, dst2, pixels);
+}
+
+inline void split48Scalar(const uint16_t *src, uint16_t *dst0, uint16_t *dst1, uint16_t *dst2, size_t pixels)
+{
+    splitScalar(src, dst0, dst1, dst2, pixels);
+}
+
+#ifdef PIXELSHUFFLE_X86
+
+/*
+ * Both kernels work on 48 byte blocks (16 pixels of 8 bits or 8 pixels of 16 bits)
+ * held in three 16 byte registers. Every output register is assembled with one
+ * pshufb per input register, bytes that come from another register are zeroed
+ * (0x80) and the three partial results are or'ed together.
+ */
+struct ShuffleMasks
+{
+    // [output register][input register][byte]
+    alignas(16) uint8_t split[3][3][16];
+    alignas(16) uint8_t swap[3][3][16];
+};
+
+inline ShuffleMasks makeShuffleMasks(size_t elementSize)
+{
+    ShuffleMasks masks;
+
+    for (size_t out = 0; out < 3; ++out)
+    {
+        for (size_t t = 0; t < 16; ++t)
+        {
+            // planar split: output register 'out' is channel 'out'
+            size_t element = t / elementSize;
+            size_t splitSource = (element * 3 + out) * elementSize + t % elementSize;
+
+            // swap: output register 'out' is bytes [16 * out, 16 * out + 16) of the block
+            size_t byte = out * 16 + t;
+            size_t index = byte / elementSize;
+            size_t swapSource = ((index / 3) * 3 + 2 - index % 3) * elementSize + byte % elementSize;
+
+            for (size_t in = 0; in < 3; ++in)
+            {
+                masks.split[out][in][t] = (splitSource / 16 == in) ? splitSource % 16 : 0x80;
+                masks.swap[out][in][t]  = (swapSource  / 16 == in) ? swapSource  % 16 : 0x80;
+            }
+        }
+    }
+
+    return masks;
+}
+
+template <size_t ElementSize>
+inline const ShuffleMasks &shuffleMasks()
+{
+    static const ShuffleMasks masks = makeShuffleMasks(ElementSize);
+    return masks;
+}
+
+template <size_t ElementSize>
+PIXELSHUFFLE_TARGET("ssse3")
+inline void swapSSSE3(uint8_t *data, size_t pixels)
+{
+    const ShuffleMasks &masks = shuffleMasks<ElementSize>();
+    const size_t blockPixels  = 16 / ElementSize;
+
+    __m128i m[3][3];
+    for (int o = 0; o < 3; ++o)
+        for (int i = 0; i < 3; ++i)
+            m[o][i] = _mm_load_si128(reinterpret_cast<const __m128i *>(masks.swap[o][i]));
+
+    size_t blocks = pixels / blockPixels;
+    for (size_t b = 0; b < blocks; ++b, data += 48)
+    {
+        __m128i in[3];
+        for (int i = 0; i < 3; ++i)
+            in[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i * 16));
+
+        for (int o = 0; o < 3; ++o)
+        {
+            __m128i out = _mm_or_si128(
+                              _mm_or_si128(_mm_shuffle_epi8(in[0], m[o][0]), _mm_shuffle_epi8(in[1], m[o][1])),
+                              _mm_shuffle_epi8(in[2], m[o][2]));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(data + o * 16), out);
+        }
+    }
+
+    if (ElementSize == 1)
+        swapScalar(data, pixels - blocks * blockPixels);
+    else
+        swapScalar(reinterpret_cast<uint16_t *>(data), pixels - blocks * blockPixels);
+}
+
+template <size_t ElementSize>
+PIXELSHUFFLE_TARGET("ssse3")
+inline void splitSSSE3(const uint8_t *src, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, size_t pixels)
+{
+    const ShuffleMasks &masks = shuffleMasks<ElementSize>();
+    const size_t blockPixels  = 16 / ElementSize;
+
+    __m128i m[3][3];
+    for (int o = 0; o < 3; ++o)
+        for (int i = 0; i < 3; ++i)
+            m[o][i] = _mm_load_si128(reinterpret_cast<const __m128i *>(masks.split[o][i]));
+
+    uint8_t *dst[3] = { dst0, dst1, dst2 };
+
+    size_t blocks = pixels / blockPixels;
+    for (size_t b = 0; b < blocks; ++b, src += 48)
+    {
+        __m128i in[3];
+        for (int i = 0; i < 3; ++i)
+            in[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 16));
+
+        for (int o = 0; o < 3; ++o)
+        {
+            __m128i out = _mm_or_si128(
+                              _mm_or_si128(_mm_shuffle_epi8(in[0], m[o][0]), _mm_shuffle_epi8(in[1], m[o][1])),
+                              _mm_shuffle_epi8(in[2], m[o][2]));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst[o]), out);
+            dst[o] += 16;
+        }
+    }
+
+    size_t rest = pixels - blocks * blockPixels;
+    if (ElementSize == 1)
+        splitScalar(src, dst[0], dst[1], dst[2], rest);
+    else
+        splitScalar(reinterpret_cast<const uint16_t *>(src),
+                    reinterpret_cast<uint16_t *>(dst[0]),
+                    reinterpret_cast<uint16_t *>(dst[1]),
+                    reinterpret_cast<uint16_t *>(dst[2]), rest);
+}
+
+/*
+ * AVX2 shuffles only within 128 bit lanes, so two consecutive 48 byte blocks are
+ * processed side by side: the low lane holds the first block, the high lane the second.
+ */
+PIXELSHUFFLE_TARGET("avx2")
+inline __m256i loadLanes(const uint8_t *lo, const uint8_t *hi)
+{
+    return _mm256_inserti128_si256(
+               _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lo))),
+               _mm_loadu_si128(reinterpret_cast<const __m128i *>(hi)), 1);
+}
+
+template <size_t ElementSize>
+PIXELSHUFFLE_TARGET("avx2")
+inline void swapAVX2(uint8_t *data, size_t pixels)
+{
+    const ShuffleMasks &masks = shuffleMasks<ElementSize>();
+    const size_t blockPixels  = 32 / ElementSize;
+
+    __m256i m[3][3];
+    for (int o = 0; o < 3; ++o)
+        for (int i = 0; i < 3; ++i)
+            m[o][i] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(masks.swap[o][i])));
+
+    size_t blocks = pixels / blockPixels;
+    for (size_t b = 0; b < blocks; ++b, data += 96)
+    {
+        __m256i in[3];
+        for (int i = 0; i < 3; ++i)
+            in[i] = loadLanes(data + i * 16, data + 48 + i * 16);
+
+        for (int o = 0; o < 3; ++o)
+        {
+            __m256i out = _mm256_or_si256(
+                              _mm256_or_si256(_mm256_shuffle_epi8(in[0], m[o][0]), _mm256_shuffle_epi8(in[1], m[o][1])),
+                              _mm256_shuffle_epi8(in[2], m[o][2]));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(data + o * 16), _mm256_castsi256_si128(out));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(data + 48 + o * 16), _mm256_extracti128_si256(out, 1));
+        }
+    }
+
+    swapSSSE3<ElementSize>(data, pixels - blocks * blockPixels);
+}
+
+template <size_t ElementSize>
+PIXELSHUFFLE_TARGET("avx2")
+inline void splitAVX2(const uint8_t *src, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, size_t pixels)
+{
+    const ShuffleMasks &masks = shuffleMasks<ElementSize>();
+    const size_t blockPixels  = 32 / ElementSize;
+
+    __m256i m[3][3];
+    for (int o = 0; o < 3; ++o)
+        for (int i = 0; i < 3; ++i)
+            m[o][i] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(masks.split[o][i])));
+
+    uint8_t *dst[3] = { dst0, dst1, dst2 };
+
+    size_t blocks = pixels / blockPixels;
+    for (size_t b = 0; b < blocks; ++b, src += 96)
+    {
+        __m256i in[3];
+        for (int i = 0; i < 3; ++i)
+            in[i] = loadLanes(src + i * 16, src + 48 + i * 16);
+
+        for (int o = 0; o < 3; ++o)
+        {
+            __m256i out = _mm256_or_si256(
+                              _mm256_or_si256(_mm256_shuffle_epi8(in[0], m[o][0]), _mm256_shuffle_epi8(in[1], m[o][1])),
+                              _mm256_shuffle_epi8(in[2], m[o][2]));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst[o]), out);
+            dst[o] += 32;
+        }
+    }
+
+    splitSSSE3<ElementSize>(src, dst[0], dst[1], dst[2], pixels - blocks * blockPixels);
+}
+
+inline void swapRB24SSSE3(uint8_t *data, size_t pixels)
+{
+    swapSSSE3<1>(data, pixels);
+}
+
+inline void swapRB48SSSE3(uint16_t *data, size_t pixels)
+{
+    swapSSSE3<2>(reinterpret_cast<uint8_t *>(data), pixels);
+}
+
+inline void split24SSSE3(const uint8_t *src, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, size_t pixels)
+{
+    splitSSSE3<1>(src, dst0, dst1, dst2, pixels);
+}
+
+inline void split48SSSE3(const uint16_t *src, uint16_t *dst0, uint16_t *dst1, uint16_t *dst2, size_t pixels)
+{
+    splitSSSE3<2>(reinterpret_cast<const uint8_t *>(src),
+                  reinterpret_cast<uint8_t *>(dst0),
+                  reinterpret_cast<uint8_t *>(dst1),
+                  reinterpret_cast<uint8_t *>(dst2), pixels);
+}
+
+inline void swapRB24AVX2(uint8_t *data, size_t pixels)
+{
+    swapAVX2<1>(data, pixels);
+}
+
+inline void swapRB48AVX2(uint16_t *data, size_t pixels)
+{
+    swapAVX2<2>(reinterpret_cast<uint8_t *>(data), pixels);
+}
+
+inline void split24AVX2(const uint8_t *src, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, size_t pixels)
+{
+    splitAVX2<1>(src, dst0, dst1, dst2, pixels);
+}
+
+inline void split48AVX2(const uint16_t *src, uint16_t *dst0, uint16_t *dst1, uint16_t *dst2, size_t pixels)
+{
+    splitAVX2<2>(reinterpret_cast<const uint8_t *>(src),
+                 reinterpret_cast<uint8_t *>(dst0),
+                 reinterpret_cast<uint8_t *>(dst1),
+                 reinterpret_cast<uint8_t *>(dst2), pixels);
+}
+
+#endif // PIXELSHUFFLE_X86
+
+#ifdef PIXELSHUFFLE_NEON
+
+/* NEON has structure loads/stores that (de)interleave 3 channels natively */
+
+inline void swapRB24NEON(uint8_t *data, size_t pixels)
+{
+    size_t blocks = pixels / 16;
+    for (size_t b = 0; b < blocks; ++b, data += 48)
+    {
+        uint8x16x3_t px = vld3q_u8(data);
+        uint8x16_t tmp = px.val[0];
+        px.val[0] = px.val[2];
+        px.val[2] = tmp;
+        vst3q_u8(data, px);
+    }
+    swapScalar(data, pixels - blocks * 16);
+}
+
+inline void swapRB48NEON(uint16_t *data, size_t pixels)
+{
+    size_t blocks = pixels / 8;
+    for (size_t b = 0; b < blocks; ++b, data += 24)
+    {
+        uint16x8x3_t px = vld3q_u16(data);
+        uint16x8_t tmp = px.val[0];
+        px.val[0] = px.val[2];
+        px.val[2] = tmp;
+        vst3q_u16(data, px);
+    }
+    swapScalar(data, pixels - blocks * 8);
+}
+
+inline void split24NEON(const uint8_t *src, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, size_t pixels)
+{
+    size_t blocks = pixels / 16;
+    for (size_t b = 0; b < blocks; ++b, src += 48, dst0 += 16, dst1 += 16, dst2 += 16)
+    {
+        uint8x16x3_t px = vld3q_u8(src);
+        vst1q_u8(dst0, px.val[0]);
+        vst1q_u8(dst1, px.val[1]);
+        vst1q_u8(dst2, px.val[2]);
+    }
+    splitScalar(src, dst0, dst1, dst2, pixels - blocks * 16);
+}
+
+inline void split48NEON(const uint16_t *src, uint16_t *dst0, uint16_t *dst1, uint16_t *dst2, size_t pixels)
+{
+    size_t blocks = pixels / 8;
+    for (size_t b = 0; b < blocks; ++b, src += 24, dst0 += 8, dst1 += 8, dst2 += 8)
+    {
+        uint16x8x3_t px = vld3q_u16(src);
+        vst1q_u16(dst0, px.val[0]);
+        vst1q_u16(dst1, px.val[1]);
+        vst1q_u16(dst2, px.val[2]);
+    }
+    splitScalar(src, dst0, dst1, dst2, pixels - blocks * 8);
+}
+
+#endif // PIXELSHUFFLE_NEON
+
+} // namespace Detail
+
+/** Is the instruction set available on this machine */
+inline bool isSupported(Isa isa)
+{
+    switch (isa)
+    {
+        case ISA_SCALAR:
+            return true;
+#ifdef PIXELSHUFFLE_X86
+        case ISA_SSSE3:
+            return __builtin_cpu_supports("ssse3");
+        case ISA_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#ifdef PIXELSHUFFLE_NEON
+        case ISA_NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+inline const char *toString(Isa isa)
+{
+    switch (isa)
+    {
+        case ISA_SCALAR: return "scalar";
+        case ISA_SSSE3:  return "ssse3";
+        case ISA_AVX2:   return "avx2";
+        case ISA_NEON:   return "neon";
+        default:         return "unknown";
+    }
+}
+
+/** Kernels for the given instruction set, the scalar ones if it is not available */
+inline Kernels kernels(Isa isa)
+{
+    Kernels k = { Detail::swapRB24Scalar, Detail::swapRB48Scalar, Detail::split24Scalar, Detail::split48Scalar };
+
+    if (!isSupported(isa))
+        return k;
+
+    switch (isa)
+    {
+#ifdef PIXELSHUFFLE_X86
+        case ISA_SSSE3:
+            k = { Detail::swapRB24SSSE3, Detail::swapRB48SSSE3, Detail::split24SSSE3, Detail::split48SSSE3 };
+            break;
+        case ISA_AVX2:
+            k = { Detail::swapRB24AVX2, Detail::swapRB48AVX2, Detail::split24AVX2, Detail::split48AVX2 };
+            break;
+#endif
+#ifdef PIXELSHUFFLE_NEON
+        case ISA_NEON:
+            k = { Detail::swapRB24NEON, Detail::swapRB48NEON, Detail::split24NEON, Detail::split48NEON };
+            break;
+#endif
+        default:
+            break;
+    }
+
+    return k;
+}
+
+/** Best instruction set available on this machine */
+inline Isa bestIsa()
+{
+    for (int isa = ISA_COUNT - 1; isa > ISA_SCALAR; --isa)
+        if (isSupported(static_cast<Isa>(isa)))
+            return static_cast<Isa>(isa);
+    return ISA_SCALAR;
+}
+
+/** Kernels selected once for this machine */
+inline const Kernels &best()
+{
+    static const Kernels k = kernels(bestIsa());
+    return k;
+}
+
+inline void swapRB24(uint8_t *data, size_t pixels)
+{
+    best().swapRB24(data, pixels);
+}
+
+inline void swapRB48(uint16_t *data, size_t pixels)
+{
+    best().swapRB48(data, pixels);
+}
+
+inline void split24(const uint8_t *src, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, size_t pixels)
+{
+    best().split24(src, dst0, dst1, dst2, pixels);
+}
+
+inline void split48(const uint16_t *src, uint16_t *dst0, uint16_t *dst1, uint16_t *dst2, size_t pixels)
+{
+    best().split48(src, dst0, dst1, dst2, pixels);
+}
+
+} // namespace PixelShuffle
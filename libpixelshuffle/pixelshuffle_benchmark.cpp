@@ -0,0 +1,119 @@
+/*
+    Pixel Shuffle micro-benchmark
+
+    Runs every kernel for every instruction set available on this machine,
+    checks the result against the scalar kernel and prints the throughput.
+
+    Usage: pixelshuffle_benchmark [megapixels] [iterations]
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "pixelshuffle.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+using namespace PixelShuffle;
+
+static double measure(int iterations, const std::function<void()> &kernel)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        kernel();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+static void report(const char *kernel, Isa isa, size_t bytes, double seconds, bool ok)
+{
+    printf("%-10s %-7s %9.2f ms %10.1f MB/s %s\n",
+           kernel, toString(isa), seconds * 1000.0, bytes / seconds / 1e6, ok ? "" : "MISMATCH");
+}
+
+int main(int argc, char *argv[])
+{
+    // 26 MP, a full frame of the larger color CMOS sensors; odd count to exercise the tails
+    double megapixels = argc > 1 ? atof(argv[1]) : 26.0;
+    int iterations    = argc > 2 ? atoi(argv[2]) : 10;
+    size_t pixels     = static_cast<size_t>(megapixels * 1e6) | 1;
+
+    std::vector<uint8_t>  src8(pixels * 3), ref8(pixels * 3), out8(pixels * 3);
+    std::vector<uint16_t> src16(pixels * 3), ref16(pixels * 3), out16(pixels * 3);
+
+    srand(1);
+    for (auto &v : src8)
+        v = rand();
+    for (auto &v : src16)
+        v = rand();
+
+    printf("%zu pixels, %d iterations, best: %s\n", pixels, iterations, toString(bestIsa()));
+
+    const Kernels scalar = kernels(ISA_SCALAR);
+    int failures = 0;
+
+    for (int i = 0; i < ISA_COUNT; ++i)
+    {
+        Isa isa = static_cast<Isa>(i);
+        if (!isSupported(isa))
+            continue;
+
+        const Kernels k = kernels(isa);
+        bool ok;
+        double t;
+
+        // swapRB24
+        ref8 = src8;
+        scalar.swapRB24(ref8.data(), pixels);
+        out8 = src8;
+        k.swapRB24(out8.data(), pixels);
+        ok = out8 == ref8;
+        t = measure(iterations, [&] { k.swapRB24(out8.data(), pixels); });
+        report("swapRB24", isa, pixels * 3, t, ok);
+        failures += !ok;
+
+        // swapRB48
+        ref16 = src16;
+        scalar.swapRB48(ref16.data(), pixels);
+        out16 = src16;
+        k.swapRB48(out16.data(), pixels);
+        ok = out16 == ref16;
+        t = measure(iterations, [&] { k.swapRB48(out16.data(), pixels); });
+        report("swapRB48", isa, pixels * 6, t, ok);
+        failures += !ok;
+
+        // split24
+        scalar.split24(src8.data(), &ref8[0], &ref8[pixels], &ref8[pixels * 2], pixels);
+        k.split24(src8.data(), &out8[0], &out8[pixels], &out8[pixels * 2], pixels);
+        ok = out8 == ref8;
+        t = measure(iterations, [&] { k.split24(src8.data(), &out8[0], &out8[pixels], &out8[pixels * 2], pixels); });
+        report("split24", isa, pixels * 3, t, ok);
+        failures += !ok;
+
+        // split48
+        scalar.split48(src16.data(), &ref16[0], &ref16[pixels], &ref16[pixels * 2], pixels);
+        k.split48(src16.data(), &out16[0], &out16[pixels], &out16[pixels * 2], pixels);
+        ok = out16 == ref16;
+        t = measure(iterations, [&] { k.split48(src16.data(), &out16[0], &out16[pixels], &out16[pixels * 2], pixels); });
+        report("split48", isa, pixels * 6, t, ok);
+        failures += !ok;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,309 @@
+/*
+    Row Readout - row streaming download into the frame buffer
+
+    Shared by the camera drivers whose SDK hands out the image a row at a time
+    (or can be fed to it a row at a time). Rows are written straight to their
+    final place, so vertical flips cost nothing and horizontal flips are done on
+    the row while it is still in cache. Min, max, mean, a histogram and a
+    Fletcher-32 checksum are gathered batch by batch, the caller gets frame
+    statistics without another pass over the image.
+
+    The readout can run on the calling thread or on a download thread of its
+    own. An optional lock (usually ccdBufferLock or the device lock) is held
+    while a batch of rows is read and released in between.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PixelShuffle
+{
+
+/** Statistics of the last readout, rows that failed to read are left out */
+struct ReadoutStats
+{
+    int rows { 0 };
+    uint64_t pixels { 0 };
+    uint32_t min { 0 };
+    uint32_t max { 0 };
+    double mean { 0 };
+    /** Fletcher-32 over the pixel values, rows in readout order, each one after its horizontal flip */
+    uint32_t checksum { 0 };
+    /** Milliseconds from the first row requested to the last one done */
+    double duration { 0 };
+    /** Histogram bin of a value is value >> histogramShift */
+    int histogramShift { 0 };
+    std::vector<uint32_t> histogram;
+
+    /** Median from the histogram, the middle of its bin */
+    uint32_t median() const
+    {
+        uint64_t half = (pixels + 1) / 2, count = 0;
+        for (size_t bin = 0; bin < histogram.size(); ++bin)
+        {
+            count += histogram[bin];
+            if (count >= half && count > 0)
+                return (static_cast<uint32_t>(bin) << histogramShift) + ((1u << histogramShift) >> 1);
+        }
+        return 0;
+    }
+};
+
+class RowReadout
+{
+    public:
+        /** Reads row 'row' (readout order, from 0) into 'dst', false on error */
+        typedef std::function<bool(int row, uint8_t *dst)> Reader;
+        /** Whole download run on the download thread, normally ends with read() */
+        typedef std::function<bool(RowReadout &readout)> Job;
+        /** Called on the download thread once the job returned, 'ok' is false on error or abort */
+        typedef std::function<void(bool ok)> Done;
+
+        RowReadout() = default;
+        RowReadout(const RowReadout &) = delete;
+        RowReadout &operator=(const RowReadout &) = delete;
+
+        ~RowReadout()
+        {
+            stop();
+        }
+
+        /** Destination frame, 'bytesPerPixel' is 1 or 2 */
+        void setFrame(uint8_t *frame, int width, int height, int bytesPerPixel)
+        {
+            m_Frame = frame;
+            m_Width = width;
+            m_Height = height;
+            m_BytesPerPixel = bytesPerPixel;
+        }
+
+        void setFlip(bool horizontal, bool vertical)
+        {
+            m_FlipX = horizontal;
+            m_FlipY = vertical;
+        }
+
+        /** Rows read per lock, 0 holds the lock for the whole frame */
+        void setBatch(int rows)
+        {
+            m_Batch = rows;
+        }
+
+        void setLock(std::mutex *lock)
+        {
+            m_Lock = lock;
+        }
+
+        /** Reads the frame on the calling thread, stops between batches once aborted */
+        bool read(const Reader &reader)
+        {
+            const size_t rowBytes = static_cast<size_t>(m_Width) * m_BytesPerPixel;
+            const int batch = m_Batch > 0 ? m_Batch : m_Height;
+            std::unique_lock<std::mutex> guard;
+            if (m_Lock)
+                guard = std::unique_lock<std::mutex>(*m_Lock, std::defer_lock);
+
+            beginStats();
+            auto start = std::chrono::steady_clock::now();
+            bool ok = m_Frame != nullptr;
+
+            for (int row = 0; ok && row < m_Height && !m_Abort;)
+            {
+                if (m_Lock)
+                    guard.lock();
+
+                int first = row;
+                for (; row < m_Height && row - first < batch; ++row)
+                {
+                    uint8_t *dst = rowPointer(row, rowBytes);
+                    if (!reader(row, dst))
+                    {
+                        ok = false;
+                        break;
+                    }
+                    if (m_FlipX)
+                        flipRow(dst);
+                }
+
+                if (m_Lock)
+                    guard.unlock();
+
+                // Rows of the batch are still in cache, statistics run outside the lock
+                for (int r = first; r < row; ++r)
+                    addRowStats(rowPointer(r, rowBytes));
+            }
+
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            endStats(elapsed.count());
+            return ok && !m_Abort;
+        }
+
+        /** Runs 'job' on the download thread, waits for the previous download first */
+        void start(const Job &job, const Done &done)
+        {
+            if (m_Thread.joinable())
+                m_Thread.join();
+
+            m_Abort = false;
+            m_Running = true;
+            m_Thread = std::thread([this, job, done]()
+            {
+                bool ok = job(*this) && !m_Abort;
+                m_Running = false;
+                if (done)
+                    done(ok);
+            });
+        }
+
+        /** Aborts the download between batches and waits for it, not from the Done callback */
+        void stop()
+        {
+            m_Abort = true;
+            if (m_Thread.joinable())
+                m_Thread.join();
+            m_Abort = false;
+        }
+
+        bool isRunning() const
+        {
+            return m_Running;
+        }
+
+        bool isAborted() const
+        {
+            return m_Abort;
+        }
+
+        const ReadoutStats &stats() const
+        {
+            return m_Stats;
+        }
+
+    private:
+        // Fletcher-32 sums stay below 2^32 for 359 words between reductions
+        static const int FLETCHER_BLOCK = 359;
+        static const int HISTOGRAM_BITS = 12;
+
+        uint8_t *rowPointer(int row, size_t rowBytes) const
+        {
+            return m_Frame + static_cast<size_t>(m_FlipY ? m_Height - 1 - row : row) * rowBytes;
+        }
+
+        void flipRow(uint8_t *row) const
+        {
+            if (m_BytesPerPixel == 2)
+                std::reverse(reinterpret_cast<uint16_t *>(row), reinterpret_cast<uint16_t *>(row) + m_Width);
+            else
+                std::reverse(row, row + m_Width);
+        }
+
+        void beginStats()
+        {
+            int bits = m_BytesPerPixel * 8;
+            m_Stats.rows = 0;
+            m_Stats.pixels = 0;
+            m_Stats.histogramShift = std::max(0, bits - HISTOGRAM_BITS);
+            m_Stats.histogram.assign(static_cast<size_t>(1) << (bits - m_Stats.histogramShift), 0);
+            m_Min = UINT32_MAX;
+            m_Max = 0;
+            m_Sum = 0;
+            m_Sum1 = m_Sum2 = 0xFFFF;
+            m_Pending = 0;
+        }
+
+        void addRowStats(const uint8_t *row)
+        {
+            if (m_BytesPerPixel == 2)
+                addStats(reinterpret_cast<const uint16_t *>(row));
+            else
+                addStats(row);
+            m_Stats.rows++;
+        }
+
+        template <typename T>
+        void addStats(const T *row)
+        {
+            uint32_t minValue = m_Min, maxValue = m_Max;
+            uint64_t sum = 0;
+            uint32_t *histogram = m_Stats.histogram.data();
+            const int shift = m_Stats.histogramShift;
+
+            for (int i = 0; i < m_Width; ++i)
+            {
+                uint32_t value = row[i];
+                minValue = std::min(minValue, value);
+                maxValue = std::max(maxValue, value);
+                sum += value;
+                histogram[value >> shift]++;
+
+                m_Sum1 += value;
+                m_Sum2 += m_Sum1;
+                if (++m_Pending == FLETCHER_BLOCK)
+                {
+                    m_Sum1 %= 65535;
+                    m_Sum2 %= 65535;
+                    m_Pending = 0;
+                }
+            }
+
+            m_Min = minValue;
+            m_Max = maxValue;
+            m_Sum += sum;
+            m_Stats.pixels += m_Width;
+        }
+
+        void endStats(double duration)
+        {
+            m_Stats.min = m_Stats.pixels ? m_Min : 0;
+            m_Stats.max = m_Max;
+            m_Stats.mean = m_Stats.pixels ? static_cast<double>(m_Sum) / m_Stats.pixels : 0;
+            m_Stats.checksum = ((m_Sum2 % 65535) << 16) | (m_Sum1 % 65535);
+            m_Stats.duration = duration;
+        }
+
+        uint8_t *m_Frame { nullptr };
+        int m_Width { 0 };
+        int m_Height { 0 };
+        int m_BytesPerPixel { 2 };
+        bool m_FlipX { false };
+        bool m_FlipY { false };
+        int m_Batch { 0 };
+        std::mutex *m_Lock { nullptr };
+
+        std::thread m_Thread;
+        std::atomic<bool> m_Abort { false };
+        std::atomic<bool> m_Running { false };
+
+        ReadoutStats m_Stats;
+        uint32_t m_Min { 0 };
+        uint32_t m_Max { 0 };
+        uint64_t m_Sum { 0 };
+        uint32_t m_Sum1 { 0 };
+        uint32_t m_Sum2 { 0 };
+        int m_Pending { 0 };
+};
+
+} // namespace PixelShuffle
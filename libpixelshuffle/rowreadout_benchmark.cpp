@@ -0,0 +1,226 @@
+/*
+    Row Readout micro-benchmark
+
+    Reads a frame through RowReadout for every flip combination and pixel
+    depth, checks the frame and its statistics against a naive pass over the
+    image, checks aborted and failed readouts and prints the throughput.
+
+    Usage: rowreadout_benchmark [megapixels] [iterations]
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "rowreadout.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace PixelShuffle;
+
+static const int BATCH = 32;
+
+static double measure(int iterations, const std::function<void()> &kernel)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        kernel();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+static void report(const char *name, int bytesPerPixel, size_t bytes, double seconds, bool ok)
+{
+    printf("%-14s %2d bit %9.2f ms %10.1f MB/s %s\n",
+           name, bytesPerPixel * 8, seconds * 1000.0, bytes / seconds / 1e6, ok ? "" : "MISMATCH");
+}
+
+static void report(const char *name, int bytesPerPixel, bool ok)
+{
+    printf("%-14s %2d bit %s\n", name, bytesPerPixel * 8, ok ? "ok" : "MISMATCH");
+}
+
+// Frame and statistics the slow and obvious way, rows taken in readout order
+template <typename T>
+static ReadoutStats naive(const std::vector<T> &src, std::vector<T> &dst, int width, int height, bool flipX, bool flipY)
+{
+    ReadoutStats stats;
+    uint32_t sum1 = 0xFFFF, sum2 = 0xFFFF;
+    double total = 0;
+    stats.min = UINT32_MAX;
+
+    for (int y = 0; y < height; ++y)
+    {
+        int dy = flipY ? height - 1 - y : y;
+        for (int x = 0; x < width; ++x)
+        {
+            int dx = flipX ? width - 1 - x : x;
+            dst[static_cast<size_t>(dy) * width + dx] = src[static_cast<size_t>(y) * width + x];
+        }
+
+        for (int x = 0; x < width; ++x)
+        {
+            uint32_t value = dst[static_cast<size_t>(dy) * width + x];
+            stats.min = std::min(stats.min, value);
+            stats.max = std::max(stats.max, value);
+            total += value;
+            sum1 = (sum1 + value) % 65535;
+            sum2 = (sum2 + sum1) % 65535;
+        }
+    }
+
+    stats.rows = height;
+    stats.pixels = static_cast<uint64_t>(width) * height;
+    stats.mean = total / stats.pixels;
+    stats.checksum = (sum2 << 16) | sum1;
+    return stats;
+}
+
+// Lower median, the value RowReadout reports the histogram bin of
+template <typename T>
+static uint32_t naiveMedian(std::vector<T> values)
+{
+    auto middle = values.begin() + (values.size() + 1) / 2 - 1;
+    std::nth_element(values.begin(), middle, values.end());
+    return *middle;
+}
+
+template <typename T>
+static int check(int width, int height, int iterations)
+{
+    const int bytesPerPixel = sizeof(T);
+    const size_t pixels = static_cast<size_t>(width) * height;
+    const size_t rowBytes = static_cast<size_t>(width) * bytesPerPixel;
+
+    std::vector<T> src(pixels), ref(pixels), out(pixels);
+    srand(1);
+    for (auto &v : src)
+        v = rand();
+
+    const uint32_t exactMedian = naiveMedian(src);
+    std::mutex lock;
+    RowReadout readout;
+    int failures = 0;
+
+    auto reader = [&](int row, uint8_t *dst)
+    {
+        memcpy(dst, reinterpret_cast<const uint8_t *>(src.data()) + row * rowBytes, rowBytes);
+        return true;
+    };
+
+    for (int flip = 0; flip < 4; ++flip)
+    {
+        bool flipX = flip & 1, flipY = flip & 2;
+        const ReadoutStats expected = naive(src, ref, width, height, flipX, flipY);
+
+        std::fill(out.begin(), out.end(), 0);
+        readout.setFrame(reinterpret_cast<uint8_t *>(out.data()), width, height, bytesPerPixel);
+        readout.setFlip(flipX, flipY);
+        readout.setBatch(BATCH);
+        readout.setLock(&lock);
+        bool ok = readout.read(reader);
+
+        const ReadoutStats &stats = readout.stats();
+        const int shift = stats.histogramShift;
+        ok = ok && out == ref;
+        ok = ok && stats.rows == expected.rows && stats.pixels == expected.pixels;
+        ok = ok && stats.min == expected.min && stats.max == expected.max;
+        ok = ok && std::abs(stats.mean - expected.mean) < 1e-6 * expected.mean;
+        ok = ok && stats.checksum == expected.checksum;
+        ok = ok && (stats.median() >> shift) == (exactMedian >> shift);
+
+        static const char *names[] = { "read", "read flipX", "read flipY", "read flipXY" };
+        double t = measure(iterations, [&] { readout.read(reader); });
+        report(names[flip], bytesPerPixel, pixels * bytesPerPixel, t, ok);
+        failures += !ok;
+    }
+
+    // Plain row copy with the flips, what the readout is up against
+    double t = measure(iterations, [&] { naive(src, ref, width, height, true, true); });
+    report("naive flipXY", bytesPerPixel, pixels * bytesPerPixel, t, true);
+
+    // A failed row ends the readout, the rows before it are counted
+    {
+        const int failRow = height / 3;
+        readout.setFlip(false, false);
+        bool ok = !readout.read([&](int row, uint8_t *dst)
+        {
+            return row != failRow && reader(row, dst);
+        });
+        ok = ok && readout.stats().rows == failRow;
+        report("failed row", bytesPerPixel, ok);
+        failures += !ok;
+    }
+
+    // Abort in the middle of a batch on the download thread, the batch is finished first
+    {
+        const int abortRow = height / 2 + 1;
+        std::atomic<bool> reached { false }, finished { false }, result { true };
+
+        readout.start([&](RowReadout & r)
+        {
+            return r.read([&](int row, uint8_t *dst)
+            {
+                if (row == abortRow)
+                {
+                    reached = true;
+                    while (!r.isAborted())
+                        std::this_thread::yield();
+                }
+                return reader(row, dst);
+            });
+        },
+        [&](bool ok)
+        {
+            result = ok;
+            finished = true;
+        });
+
+        while (!reached)
+            std::this_thread::yield();
+        readout.stop();
+
+        const int batchEnd = std::min(height, (abortRow / BATCH + 1) * BATCH);
+        bool ok = finished && !result && !readout.isRunning() && readout.stats().rows == batchEnd;
+        report("abort", bytesPerPixel, ok);
+        failures += !ok;
+    }
+
+    return failures;
+}
+
+int main(int argc, char *argv[])
+{
+    // 16 MP, a full frame of the larger CCD sensors; odd width to exercise the row ends
+    double megapixels = argc > 1 ? atof(argv[1]) : 16.0;
+    int iterations    = argc > 2 ? atoi(argv[2]) : 10;
+    int width         = 4655;
+    int height        = std::max(BATCH * 2, static_cast<int>(megapixels * 1e6 / width));
+
+    printf("%dx%d pixels, %d iterations, batches of %d rows\n", width, height, iterations, BATCH);
+
+    int failures = check<uint8_t>(width, height, iterations);
+    failures += check<uint16_t>(width, height, iterations);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}